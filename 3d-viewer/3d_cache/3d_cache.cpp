@@ -24,7 +24,12 @@
 
 #define GLM_FORCE_RADIANS
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <future>
 #include <mutex>
+#include <thread>
 #include <utility>
 
 #include <wx/datetime.h>
@@ -33,16 +38,9 @@
 #include <wx/log.h>
 #include <wx/stdpaths.h>
 
-#include <boost/version.hpp>
-
-#if BOOST_VERSION >= 106800
-#include <boost/uuid/detail/sha1.hpp>
-#else
-#include <boost/uuid/sha1.hpp>
-#endif
-
 #include "3d_cache.h"
 #include "3d_info.h"
+#include "3d_mesh_cache.h"
 #include "3d_plugin_manager.h"
 #include "sg/scenegraph.h"
 #include "plugins/3dapi/ifsg_api.h"
@@ -55,12 +53,29 @@
 #include <project.h>
 #include <settings/common_settings.h>
 #include <settings/settings_manager.h>
+#include <sha1_hash.h>
 
 
 #define MASK_3D_CACHE "3D_CACHE"
 
-static std::mutex mutex3D_cache;
-static std::mutex mutex3D_cacheManager;
+static std::mutex              mutex3D_cache;
+static std::mutex              mutex3D_cacheManager;
+static std::mutex              mutex3D_plugins;
+static std::mutex              mutex3D_hashes;
+static std::condition_variable cv3D_cacheLoad;
+
+
+/// The digest of a model file along with the file attributes it was computed for.
+struct S3D_FILE_HASH
+{
+    wxDateTime    modTime;
+    wxULongLong   fileSize;
+    unsigned char sha1sum[20];
+};
+
+
+/// Model file digests, shared by all the caches so they survive a project change.
+static std::map<wxString, S3D_FILE_HASH> fileHashes;
 
 
 static bool isSHA1Same( const unsigned char* shaA, const unsigned char* shaB ) noexcept
@@ -86,6 +101,29 @@ static bool checkTag( const char* aTag, void* aPluginMgrPtr )
 }
 
 
+/// Context of recordTag(), to check the plugin tag of a .3dc file and remember it.
+struct S3D_TAG_CHECK
+{
+    S3D_PLUGIN_MANAGER* m_Plugins;
+    std::string*        m_PluginInfo;
+};
+
+
+static bool recordTag( const char* aTag, void* aTagCheckPtr )
+{
+    if( nullptr == aTag || nullptr == aTagCheckPtr )
+        return false;
+
+    S3D_TAG_CHECK* tc = (S3D_TAG_CHECK*) aTagCheckPtr;
+
+    if( !checkTag( aTag, tc->m_Plugins ) )
+        return false;
+
+    *tc->m_PluginInfo = aTag;
+    return true;
+}
+
+
 static const wxString sha1ToWXString( const unsigned char* aSHA1Sum )
 {
     unsigned char uc;
@@ -130,10 +168,13 @@ public:
     const wxString GetCacheBaseName();
 
     wxDateTime    modTime;      // file modification time
+    wxULongLong   fileSize;     // file size
     unsigned char sha1sum[20];
     std::string   pluginInfo;   // PluginName:Version string
     SCENEGRAPH*   sceneData;
     S3DMODEL*     renderData;
+    bool          sceneLoaded;  // sceneData was loaded, or could not be loaded
+    bool          loading;      // a thread is loading or refreshing this entry
 
 private:
     // prohibit assignment and default copy constructor
@@ -148,6 +189,8 @@ S3D_CACHE_ENTRY::S3D_CACHE_ENTRY()
 {
     sceneData = nullptr;
     renderData = nullptr;
+    sceneLoaded = false;
+    loading = false;
     memset( sha1sum, 0, 20 );
 }
 
@@ -161,6 +204,32 @@ S3D_CACHE_ENTRY::~S3D_CACHE_ENTRY()
 }
 
 
+/**
+ * Clear the loading flag of a cache entry and wake up the threads waiting for the entry when
+ * leaving the scope, including when loading the model throws.
+ */
+class S3D_CACHE_LOADING_GUARD
+{
+public:
+    S3D_CACHE_LOADING_GUARD( S3D_CACHE_ENTRY* aEntry ) :
+            m_entry( aEntry )
+    {}
+
+    ~S3D_CACHE_LOADING_GUARD()
+    {
+        {
+            std::lock_guard<std::mutex> lock( mutex3D_cache );
+            m_entry->loading = false;
+        }
+
+        cv3D_cacheLoad.notify_all();
+    }
+
+private:
+    S3D_CACHE_ENTRY* m_entry;
+};
+
+
 void S3D_CACHE_ENTRY::SetSHA1( const unsigned char* aSHA1Sum )
 {
     if( nullptr == aSHA1Sum )
@@ -172,6 +241,7 @@ void S3D_CACHE_ENTRY::SetSHA1( const unsigned char* aSHA1Sum )
     }
 
     memcpy( sha1sum, aSHA1Sum, 20 );
+    m_CacheBaseName.clear();
 }
 
 
@@ -211,7 +281,8 @@ S3D_CACHE::~S3D_CACHE()
 }
 
 
-SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr )
+SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr,
+                             bool aBuildRenderData )
 {
     if( aCachePtr )
         *aCachePtr = nullptr;
@@ -227,57 +298,72 @@ SCENEGRAPH* S3D_CACHE::load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCach
     }
 
     // check cache if file is already loaded
-    std::lock_guard<std::mutex> lock( mutex3D_cache );
+    std::unique_lock<std::mutex> lock( mutex3D_cache );
+
+    S3D_CACHE_ENTRY* ep = nullptr;
 
     std::map< wxString, S3D_CACHE_ENTRY*, rsort_wxString >::iterator mi;
     mi = m_CacheMap.find( full3Dpath );
 
-    if( mi != m_CacheMap.end() )
+    bool cached = mi != m_CacheMap.end();
+
+    if( cached )
     {
-        wxFileName fname( full3Dpath );
+        ep = mi->second;
 
-        if( fname.FileExists() )    // Only check if file exists. If not, it will
-        {                           // use the same model in cache.
-            bool       reload = ADVANCED_CFG::GetCfg().m_Skip3DModelMemoryCache;
-            wxDateTime fmdate = fname.GetModificationTime();
+        // Another thread may be loading the same model; wait for it rather than loading the
+        // model twice.
+        cv3D_cacheLoad.wait( lock, [ep]() { return !ep->loading; } );
+    }
+    else
+    {
+        // a cache item does not exist; create it now so concurrent requests for the same file
+        // wait for this one to complete
+        ep = new S3D_CACHE_ENTRY;
+        m_CacheList.push_back( ep );
+        m_CacheMap.emplace( full3Dpath, ep );
+    }
 
-            if( fmdate != mi->second->modTime )
-            {
-                unsigned char hashSum[20];
-                getSHA1( full3Dpath, hashSum );
-                mi->second->modTime = fmdate;
+    ep->loading = true;
+    lock.unlock();
 
-                if( !isSHA1Same( hashSum, mi->second->sha1sum ) )
-                {
-                    mi->second->SetSHA1( hashSum );
-                    reload = true;
-                }
-            }
+    S3D_CACHE_LOADING_GUARD loadingGuard( ep );
 
-            if( reload )
-            {
-                if( nullptr != mi->second->sceneData )
-                {
-                    S3D::DestroyNode( mi->second->sceneData );
-                    mi->second->sceneData = nullptr;
-                }
+    if( cached )
+        checkModified( full3Dpath, ep );
+    else
+        checkCache( full3Dpath, ep );
 
-                if( nullptr != mi->second->renderData )
-                    S3D::Destroy3DModel( &mi->second->renderData );
+    if( aBuildRenderData )
+    {
+        // The render data is read from the mesh cache when possible, in which case the scene
+        // graph is not needed at all.
+        if( !ep->renderData && !ep->sceneLoaded )
+            loadMeshCacheData( ep );
 
-                mi->second->sceneData = m_Plugins->Load3DModel( full3Dpath,
-                                                                mi->second->pluginInfo );
-            }
-        }
+        if( !ep->renderData )
+        {
+            if( !ep->sceneLoaded )
+                loadSceneData( full3Dpath, ep );
 
-        if( nullptr != aCachePtr )
-            *aCachePtr = mi->second;
+            if( ep->sceneData )
+            {
+                ep->renderData = S3D::GetModel( ep->sceneData );
 
-        return mi->second->sceneData;
+                if( ep->renderData )
+                    saveMeshCacheData( ep );
+            }
+        }
+    }
+    else if( !ep->sceneLoaded )
+    {
+        loadSceneData( full3Dpath, ep );
     }
 
-    // a cache item does not exist; search the Filename->Cachename map
-    return checkCache( full3Dpath, aCachePtr );
+    if( aCachePtr )
+        *aCachePtr = ep;
+
+    return ep->sceneData;
 }
 
 
@@ -287,70 +373,127 @@ SCENEGRAPH* S3D_CACHE::Load( const wxString& aModelFile )
 }
 
 
-SCENEGRAPH* S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr )
+void S3D_CACHE::checkModified( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
 {
-    if( aCachePtr )
-        *aCachePtr = nullptr;
-
-    unsigned char    sha1sum[20];
-    S3D_CACHE_ENTRY* ep = new S3D_CACHE_ENTRY;
-    m_CacheList.push_back( ep );
     wxFileName fname( aFileName );
-    ep->modTime = fname.GetModificationTime();
 
-    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
+    // Only check if file exists. If not, it will use the same model in cache.
+    if( !fname.FileExists() )
+        return;
+
+    bool        reload = ADVANCED_CFG::GetCfg().m_Skip3DModelMemoryCache;
+    wxDateTime  fmdate = fname.GetModificationTime();
+    wxULongLong fsize = fname.GetSize();
+
+    if( fmdate != aCacheItem->modTime || fsize != aCacheItem->fileSize )
     {
-        // just in case we can't get a hash digest (for example, on access issues)
-        // or we do not have a configured cache file directory, we create an
-        // entry to prevent further attempts at loading the file
+        unsigned char hashSum[20];
+        getSHA1( aFileName, hashSum );
+        aCacheItem->modTime = fmdate;
+        aCacheItem->fileSize = fsize;
 
-        if( m_CacheMap.emplace( aFileName, ep ).second == false )
+        if( !isSHA1Same( hashSum, aCacheItem->sha1sum ) )
         {
-            wxLogTrace( MASK_3D_CACHE,
-                        wxT( "%s:%s:%d\n * [BUG] duplicate entry in map file; key = '%s'" ),
-                        __FILE__, __FUNCTION__, __LINE__, aFileName );
-
-            m_CacheList.pop_back();
-            delete ep;
+            aCacheItem->SetSHA1( hashSum );
+            reload = true;
         }
-        else
+    }
+
+    if( reload )
+    {
+        if( nullptr != aCacheItem->sceneData )
         {
-            if( aCachePtr )
-                *aCachePtr = ep;
+            S3D::DestroyNode( aCacheItem->sceneData );
+            aCacheItem->sceneData = nullptr;
         }
 
-        return nullptr;
+        if( nullptr != aCacheItem->renderData )
+            S3D::Destroy3DModel( &aCacheItem->renderData );
+
+        aCacheItem->sceneLoaded = false;
     }
+}
 
-    if( m_CacheMap.emplace( aFileName, ep ).second == false )
-    {
-        wxLogTrace( MASK_3D_CACHE,
-                    wxT( "%s:%s:%d\n * [BUG] duplicate entry in map file; key = '%s'" ),
-                    __FILE__, __FUNCTION__, __LINE__, aFileName );
 
-        m_CacheList.pop_back();
-        delete ep;
-        return nullptr;
+void S3D_CACHE::checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    unsigned char sha1sum[20];
+    wxFileName    fname( aFileName );
+
+    aCacheItem->modTime = fname.GetModificationTime();
+    aCacheItem->fileSize = fname.GetSize();
+
+    if( !getSHA1( aFileName, sha1sum ) || m_CacheDir.empty() )
+    {
+        // just in case we can't get a hash digest (for example, on access issues)
+        // or we do not have a configured cache file directory, we keep the
+        // entry without data to prevent further attempts at loading the file
+        aCacheItem->sceneLoaded = true;
+        return;
     }
 
-    if( aCachePtr )
-        *aCachePtr = ep;
+    aCacheItem->SetSHA1( sha1sum );
+}
 
-    ep->SetSHA1( sha1sum );
 
-    wxString bname = ep->GetCacheBaseName();
-    wxString cachename = m_CacheDir + bname + wxT( ".3dc" );
+void S3D_CACHE::loadSceneData( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem )
+{
+    aCacheItem->sceneLoaded = true;
+
+    wxString cachename = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dc" );
 
     if( !ADVANCED_CFG::GetCfg().m_Skip3DModelFileCache && wxFileName::FileExists( cachename )
-        && loadCacheData( ep ) )
-        return ep->sceneData;
+        && loadCacheData( aCacheItem ) )
+        return;
 
-    ep->sceneData = m_Plugins->Load3DModel( aFileName, ep->pluginInfo );
+    // The plugins and the scene graph writer are not reentrant
+    std::lock_guard<std::mutex> pluginLock( mutex3D_plugins );
 
-    if( !ADVANCED_CFG::GetCfg().m_Skip3DModelFileCache && nullptr != ep->sceneData )
-        saveCacheData( ep );
+    aCacheItem->sceneData = m_Plugins->Load3DModel( aFileName, aCacheItem->pluginInfo );
 
-    return ep->sceneData;
+    if( !ADVANCED_CFG::GetCfg().m_Skip3DModelFileCache && nullptr != aCacheItem->sceneData )
+        saveCacheData( aCacheItem );
+}
+
+
+bool S3D_CACHE::loadMeshCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( ADVANCED_CFG::GetCfg().m_Skip3DModelFileCache || m_CacheDir.empty() )
+        return false;
+
+    wxString        fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dmc" );
+    S3D_MESH_CACHE  meshCache( fname, aCacheItem->sha1sum );
+    std::string     pluginInfo;
+    S3DMODEL*       model = meshCache.Read( pluginInfo );
+
+    if( !model )
+        return false;
+
+    // the model was loaded by a plugin which is no longer available
+    if( !checkTag( pluginInfo.c_str(), m_Plugins ) )
+    {
+        S3D::Destroy3DModel( &model );
+        return false;
+    }
+
+    aCacheItem->renderData = model;
+    aCacheItem->pluginInfo = pluginInfo;
+    return true;
+}
+
+
+bool S3D_CACHE::saveMeshCacheData( S3D_CACHE_ENTRY* aCacheItem )
+{
+    if( ADVANCED_CFG::GetCfg().m_Skip3DModelFileCache || m_CacheDir.empty()
+            || nullptr == aCacheItem->renderData )
+    {
+        return false;
+    }
+
+    wxString       fname = m_CacheDir + aCacheItem->GetCacheBaseName() + wxT( ".3dmc" );
+    S3D_MESH_CACHE meshCache( fname, aCacheItem->sha1sum );
+
+    return meshCache.Write( *aCacheItem->renderData, aCacheItem->pluginInfo );
 }
 
 
@@ -372,6 +515,25 @@ bool S3D_CACHE::getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum )
         return false;
     }
 
+    // Hashing a large model is expensive, so the digest of a file is reused as long as its
+    // size and modification time are unchanged.
+    wxFileName fname( aFileName );
+    wxDateTime fmdate = fname.GetModificationTime();
+    wxULongLong fsize = fname.GetSize();
+
+    {
+        std::lock_guard<std::mutex> lock( mutex3D_hashes );
+
+        auto it = fileHashes.find( aFileName );
+
+        if( it != fileHashes.end() && fmdate.IsValid() && it->second.modTime == fmdate
+                && it->second.fileSize == fsize )
+        {
+            memcpy( aSHA1Sum, it->second.sha1sum, 20 );
+            return true;
+        }
+    }
+
 #ifdef _WIN32
     FILE* fp = _wfopen( aFileName.wc_str(), L"rb" );
 #else
@@ -381,29 +543,24 @@ bool S3D_CACHE::getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum )
     if( nullptr == fp )
         return false;
 
-    boost::uuids::detail::sha1 dblock;
+    SHA1_HASH     dblock;
     unsigned char block[4096];
     size_t bsize = 0;
 
     while( ( bsize = fread( &block, 1, 4096, fp ) ) > 0 )
-        dblock.process_bytes( block, bsize );
+        dblock.Update( block, bsize );
 
     fclose( fp );
-    unsigned int digest[5];
-    dblock.get_digest( digest );
+    dblock.GetDigest( aSHA1Sum );
 
-    // ensure MSB order
-    for( int i = 0; i < 5; ++i )
+    if( fmdate.IsValid() )
     {
-        int idx = i << 2;
-        unsigned int tmp = digest[i];
-        aSHA1Sum[idx+3] = tmp & 0xff;
-        tmp >>= 8;
-        aSHA1Sum[idx+2] = tmp & 0xff;
-        tmp >>= 8;
-        aSHA1Sum[idx+1] = tmp & 0xff;
-        tmp >>= 8;
-        aSHA1Sum[idx] = tmp & 0xff;
+        std::lock_guard<std::mutex> lock( mutex3D_hashes );
+
+        S3D_FILE_HASH& hash = fileHashes[aFileName];
+        hash.modTime = fmdate;
+        hash.fileSize = fsize;
+        memcpy( hash.sha1sum, aSHA1Sum, 20 );
     }
 
     return true;
@@ -441,7 +598,10 @@ bool S3D_CACHE::loadCacheData( S3D_CACHE_ENTRY* aCacheItem )
     if( nullptr != aCacheItem->sceneData )
         S3D::DestroyNode( (SGNODE*) aCacheItem->sceneData );
 
-    aCacheItem->sceneData = (SCENEGRAPH*)S3D::ReadCache( fname.ToUTF8(), m_Plugins, checkTag );
+    // keep the plugin tag so the mesh cache can be written for the model
+    S3D_TAG_CHECK tagCheck = { m_Plugins, &aCacheItem->pluginInfo };
+
+    aCacheItem->sceneData = (SCENEGRAPH*)S3D::ReadCache( fname.ToUTF8(), &tagCheck, recordTag );
 
     if( nullptr == aCacheItem->sceneData )
         return false;
@@ -643,29 +803,52 @@ void S3D_CACHE::ClosePlugins()
 S3DMODEL* S3D_CACHE::GetModel( const wxString& aModelFileName )
 {
     S3D_CACHE_ENTRY* cp = nullptr;
-    SCENEGRAPH* sp = load( aModelFileName, &cp );
+    load( aModelFileName, &cp, true );
 
-    if( !sp )
+    if( !cp )
         return nullptr;
 
-    if( !cp )
-    {
-        wxLogTrace( MASK_3D_CACHE,
-                    wxT( "%s:%s:%d\n  * [BUG] model loaded with no associated S3D_CACHE_ENTRY" ),
-                    __FILE__, __FUNCTION__, __LINE__ );
+    return cp->renderData;
+}
 
-        return nullptr;
+
+void S3D_CACHE::PreloadModels( const std::vector<wxString>& aModelFileNames )
+{
+    std::vector<wxString> files( aModelFileNames );
+
+    std::sort( files.begin(), files.end() );
+    files.erase( std::unique( files.begin(), files.end() ), files.end() );
+
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   files.size() );
+    std::atomic<size_t> nextFile( 0 );
+
+    auto preload =
+            [&]() -> size_t
+            {
+                for( size_t ii = nextFile++; ii < files.size(); ii = nextFile++ )
+                    GetModel( files[ii] );
+
+                return 1;
+            };
+
+    if( parallelThreadCount <= 1 )
+    {
+        preload();
+        return;
     }
 
-    if( cp->renderData )
-        return cp->renderData;
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
 
-    S3DMODEL* mp = S3D::GetModel( sp );
-    cp->renderData = mp;
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        returns[ii] = std::async( std::launch::async, preload );
 
-    return mp;
+    // Finalize the threads
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+        returns[ii].wait();
 }
 
+
 void S3D_CACHE::CleanCacheDir( int aNumDaysOld )
 {
     wxDir         dir;
@@ -686,8 +869,10 @@ void S3D_CACHE::CleanCacheDir( int aNumDaysOld )
     {
         thisFile.SetPath( m_CacheDir ); // Set the base path to the cache folder
 
-        // Get a list of all the ".3dc" files in the cache directory
-        numFilesFound = dir.GetAllFiles( m_CacheDir, &fileList, fileSpec );
+        // Get a list of all the ".3dc" and ".3dmc" files in the cache directory
+        dir.GetAllFiles( m_CacheDir, &fileList, fileSpec );
+        dir.GetAllFiles( m_CacheDir, &fileList, wxT( "*.3dmc" ) );
+        numFilesFound = fileList.size();
 
         for( unsigned int i = 0; i < numFilesFound; i++ )
         {
@@ -34,6 +34,7 @@
 #include "string_utils.h"
 #include <list>
 #include <map>
+#include <vector>
 #include "plugins/3dapi/c3dmodel.h"
 #include <project.h>
 #include <wx/string.h>
@@ -126,45 +127,78 @@ public:
      */
     S3DMODEL* GetModel( const wxString& aModelFileName );
 
+    /**
+     * Load the render data of a list of models concurrently.
+     *
+     * Duplicate names are only loaded once.  The models are kept in the cache, so the following
+     * calls to GetModel() for these names do not have to wait for the model files to be read.
+     * GetModel() may be called from several threads; a model requested while it is already
+     * being loaded by another thread is not loaded a second time.
+     *
+     * @param aModelFileNames are the partial or full paths of the models to load.
+     */
+    void PreloadModels( const std::vector<wxString>& aModelFileNames );
+
     /**
      * Delete up old cache files in cache directory.
      *
-     * Deletes ".3dc" files in the cache directory that are older than \a aNumDaysOld.
+     * Deletes ".3dc" and ".3dmc" files in the cache directory that are older than
+     * \a aNumDaysOld.
      *
-     * @param aNumDaysOld is age threshold to delete ".3dc" cache files.
+     * @param aNumDaysOld is age threshold to delete cache files.
      */
     void CleanCacheDir( int aNumDaysOld );
 
 private:
     /**
-     * Find or create cache entry for file name
+     * Fill a new cache entry for file name
      *
-     * Searches the cache list for the given filename and retrieves the cache data; a cache
-     * entry is created if one does not already exist.
+     * Retrieves the modification time and SHA1 hash of the model file; the scene and render
+     * data of the model are loaded on demand.
      *
-     * @param aFileName  is the file name (full or partial path).
-     * @param aCachePtr is an optional return address for cache entry pointer.
-     * @return SCENEGRAPH object associated with file name or NULL on error.
+     * @param aFileName  is the full path of the model file.
+     * @param aCacheItem is the new cache entry.
      */
-    SCENEGRAPH* checkCache( const wxString& aFileName, S3D_CACHE_ENTRY** aCachePtr = nullptr );
+    void checkCache( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
+
+    /**
+     * Reload the scene data of a cache entry if its model file has changed since it was loaded.
+     *
+     * The file is only hashed again when its size or modification time has changed.
+     */
+    void checkModified( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
 
     /**
      * Calculate the SHA1 hash of the given file.
      *
+     * The hash is reused without reading the file again while the size and modification time
+     * of the file are unchanged.
+     *
      * @param aFileName file name (full path).
      * @param aSHA1Sum a 20 byte character array to hold the SHA1 hash.
      * @return true on  success, otherwise false.
      */
     bool getSHA1( const wxString& aFileName, unsigned char* aSHA1Sum );
 
+    // load scene data from the cache file, or from the model file with the plugins
+    void loadSceneData( const wxString& aFileName, S3D_CACHE_ENTRY* aCacheItem );
+
     // load scene data from a cache file
     bool loadCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
     // save scene data to a cache file
     bool saveCacheData( S3D_CACHE_ENTRY* aCacheItem );
 
-    // the real load function (can supply a cache entry pointer to member functions)
-    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = nullptr );
+    // load render data from a mesh cache file (see S3D_MESH_CACHE)
+    bool loadMeshCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // save render data to a mesh cache file
+    bool saveMeshCacheData( S3D_CACHE_ENTRY* aCacheItem );
+
+    // the real load function (can supply a cache entry pointer to member functions and
+    // optionally build the render data of the model)
+    SCENEGRAPH* load( const wxString& aModelFile, S3D_CACHE_ENTRY** aCachePtr = nullptr,
+                      bool aBuildRenderData = false );
 
     /// cache entries
     std::list< S3D_CACHE_ENTRY* > m_CacheList;
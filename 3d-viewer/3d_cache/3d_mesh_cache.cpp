@@ -0,0 +1,318 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include <wx/ffile.h>
+#include <wx/filename.h>
+#include <wx/log.h>
+
+#include <lib_binary_cache.h>
+#include <macros.h>
+
+#include "3d_mesh_cache.h"
+#include "plugins/3dapi/c3dmodel.h"
+#include "plugins/3dapi/ifsg_api.h"
+
+
+#define MASK_3D_CACHE "3D_CACHE"
+
+static const char MESH_CACHE_MAGIC[8] = { 'K', 'I', '3', 'D', 'M', 'E', 'S', 'H' };
+
+/// Changes whenever the layout of the cache files changes.
+static const uint32_t MESH_CACHE_VERSION = 2;
+
+static_assert( sizeof( SFVEC2F ) == 2 * sizeof( float ), "SFVEC2F must be packed" );
+static_assert( sizeof( SFVEC3F ) == 3 * sizeof( float ), "SFVEC3F must be packed" );
+
+/// Flags of the optional arrays of a mesh
+enum MESH_ARRAYS : uint32_t
+{
+    MESH_HAS_NORMALS   = 1 << 0,
+    MESH_HAS_TEXCOORDS = 1 << 1,
+    MESH_HAS_COLORS    = 1 << 2
+};
+
+
+S3D_MESH_CACHE::S3D_MESH_CACHE( const wxString& aCacheFile, const unsigned char* aSHA1Sum ) :
+        m_cacheFile( aCacheFile )
+{
+    memcpy( m_sha1sum, aSHA1Sum, sizeof( m_sha1sum ) );
+}
+
+
+/**
+ * Allocate and read an array of \a aCount elements of type T.
+ */
+template <typename T>
+static bool readArray( BINARY_CACHE_READER& aReader, T*& aArray, size_t aCount )
+{
+    // check the size before allocating so a damaged file cannot exhaust the memory
+    if( aCount == 0 || aCount > aReader.Remaining() / sizeof( T ) )
+        return false;
+
+    aArray = new T[aCount];
+    return aReader.Raw( aArray, aCount * sizeof( T ) );
+}
+
+
+static bool readMaterial( BINARY_CACHE_READER& aReader, SMATERIAL& aMaterial )
+{
+    float values[14];
+
+    if( !aReader.Raw( values, sizeof( values ) ) )
+        return false;
+
+    aMaterial.m_Ambient = SFVEC3F( values[0], values[1], values[2] );
+    aMaterial.m_Diffuse = SFVEC3F( values[3], values[4], values[5] );
+    aMaterial.m_Emissive = SFVEC3F( values[6], values[7], values[8] );
+    aMaterial.m_Specular = SFVEC3F( values[9], values[10], values[11] );
+    aMaterial.m_Shininess = values[12];
+    aMaterial.m_Transparency = values[13];
+
+    return true;
+}
+
+
+static bool readMesh( BINARY_CACHE_READER& aReader, SMESH& aMesh, size_t aMaterialCount )
+{
+    size_t   vertexCount = aReader.Count();
+    size_t   indexCount = aReader.Count();
+    int32_t  materialIdx = aReader.Int();
+    uint32_t arrays = (uint32_t) aReader.Int();
+
+    if( !aReader.Ok() || materialIdx < 0 || (size_t) materialIdx >= aMaterialCount
+            || indexCount % 3 != 0 )
+    {
+        return false;
+    }
+
+    aMesh.m_VertexSize = (unsigned int) vertexCount;
+    aMesh.m_FaceIdxSize = (unsigned int) indexCount;
+    aMesh.m_MaterialIdx = (unsigned int) materialIdx;
+
+    if( !readArray( aReader, aMesh.m_Positions, vertexCount ) )
+        return false;
+
+    if( ( arrays & MESH_HAS_NORMALS ) && !readArray( aReader, aMesh.m_Normals, vertexCount ) )
+        return false;
+
+    if( ( arrays & MESH_HAS_TEXCOORDS ) && !readArray( aReader, aMesh.m_Texcoords, vertexCount ) )
+        return false;
+
+    if( ( arrays & MESH_HAS_COLORS ) && !readArray( aReader, aMesh.m_Color, vertexCount ) )
+        return false;
+
+    if( !readArray( aReader, aMesh.m_FaceIdx, indexCount ) )
+        return false;
+
+    for( size_t ii = 0; ii < indexCount; ++ii )
+    {
+        if( aMesh.m_FaceIdx[ii] >= vertexCount )
+            return false;
+    }
+
+    return true;
+}
+
+
+S3DMODEL* S3D_MESH_CACHE::Read( std::string& aPluginInfo ) const
+{
+    if( !wxFileName::FileExists( m_cacheFile ) )
+        return nullptr;
+
+    wxFFile     file( m_cacheFile, wxT( "rb" ) );
+    std::string buffer;
+
+    if( !file.IsOpened() )
+        return nullptr;
+
+    buffer.resize( file.Length() );
+
+    if( buffer.empty() || file.Read( &buffer[0], buffer.size() ) != buffer.size() )
+        return nullptr;
+
+    BINARY_CACHE_READER in( buffer );
+    unsigned char       sha1sum[20];
+
+    if( !in.Header( MESH_CACHE_MAGIC, MESH_CACHE_VERSION )
+            || !in.Raw( sha1sum, sizeof( sha1sum ) )
+            || memcmp( sha1sum, m_sha1sum, sizeof( sha1sum ) ) )
+    {
+        wxLogTrace( MASK_3D_CACHE, wxT( " * [3D model] stale mesh cache file '%s'" ),
+                    m_cacheFile );
+        return nullptr;
+    }
+
+    wxString pluginInfo = in.String();
+    size_t   materialCount = in.Count();
+    size_t   meshCount = in.Count();
+
+    if( !in.Ok() || materialCount == 0 || meshCount == 0 )
+        return nullptr;
+
+    // each material takes 14 floats in the file
+    if( materialCount > in.Remaining() / ( 14 * sizeof( float ) ) )
+        return nullptr;
+
+    S3DMODEL* model = S3D::New3DModel();
+    bool      ok = true;
+
+    model->m_Materials = new SMATERIAL[materialCount];
+    model->m_MaterialsSize = (unsigned int) materialCount;
+
+    for( size_t ii = 0; ok && ii < materialCount; ++ii )
+        ok = readMaterial( in, model->m_Materials[ii] );
+
+    // each mesh takes at least 16 bytes in the file
+    if( ok && meshCount > in.Remaining() / 16 )
+        ok = false;
+
+    if( ok )
+    {
+        model->m_Meshes = new SMESH[meshCount];
+        model->m_MeshesSize = (unsigned int) meshCount;
+
+        for( size_t ii = 0; ii < meshCount; ++ii )
+            S3D::Init3DMesh( model->m_Meshes[ii] );
+
+        for( size_t ii = 0; ok && ii < meshCount; ++ii )
+            ok = readMesh( in, model->m_Meshes[ii], materialCount );
+    }
+
+    if( !ok || in.Remaining() != 0 )
+    {
+        wxLogTrace( MASK_3D_CACHE, wxT( " * [3D model] invalid mesh cache file '%s'" ),
+                    m_cacheFile );
+
+        S3D::Destroy3DModel( &model );
+        return nullptr;
+    }
+
+    aPluginInfo = TO_UTF8( pluginInfo );
+    return model;
+}
+
+
+static void writeMaterial( BINARY_CACHE_WRITER& aWriter, const SMATERIAL& aMaterial )
+{
+    const float values[14] = {
+        aMaterial.m_Ambient.r,  aMaterial.m_Ambient.g,  aMaterial.m_Ambient.b,
+        aMaterial.m_Diffuse.r,  aMaterial.m_Diffuse.g,  aMaterial.m_Diffuse.b,
+        aMaterial.m_Emissive.r, aMaterial.m_Emissive.g, aMaterial.m_Emissive.b,
+        aMaterial.m_Specular.r, aMaterial.m_Specular.g, aMaterial.m_Specular.b,
+        aMaterial.m_Shininess,  aMaterial.m_Transparency
+    };
+
+    aWriter.Raw( values, sizeof( values ) );
+}
+
+
+static void writeMesh( BINARY_CACHE_WRITER& aWriter, const SMESH& aMesh )
+{
+    uint32_t arrays = 0;
+
+    if( aMesh.m_Normals )
+        arrays |= MESH_HAS_NORMALS;
+
+    if( aMesh.m_Texcoords )
+        arrays |= MESH_HAS_TEXCOORDS;
+
+    if( aMesh.m_Color )
+        arrays |= MESH_HAS_COLORS;
+
+    aWriter.Int( (int32_t) aMesh.m_VertexSize );
+    aWriter.Int( (int32_t) aMesh.m_FaceIdxSize );
+    aWriter.Int( (int32_t) aMesh.m_MaterialIdx );
+    aWriter.Int( (int32_t) arrays );
+
+    aWriter.Raw( aMesh.m_Positions, aMesh.m_VertexSize * sizeof( SFVEC3F ) );
+
+    if( aMesh.m_Normals )
+        aWriter.Raw( aMesh.m_Normals, aMesh.m_VertexSize * sizeof( SFVEC3F ) );
+
+    if( aMesh.m_Texcoords )
+        aWriter.Raw( aMesh.m_Texcoords, aMesh.m_VertexSize * sizeof( SFVEC2F ) );
+
+    if( aMesh.m_Color )
+        aWriter.Raw( aMesh.m_Color, aMesh.m_VertexSize * sizeof( SFVEC3F ) );
+
+    aWriter.Raw( aMesh.m_FaceIdx, aMesh.m_FaceIdxSize * sizeof( unsigned int ) );
+}
+
+
+bool S3D_MESH_CACHE::Write( const S3DMODEL& aModel, const std::string& aPluginInfo ) const
+{
+    if( aModel.m_MaterialsSize == 0 || aModel.m_MeshesSize == 0 || aPluginInfo.size() > 1024 )
+        return false;
+
+    // The reader rejects meshes without vertices or faces, so don't write a cache the reader
+    // would discard anyway.
+    for( unsigned int ii = 0; ii < aModel.m_MeshesSize; ++ii )
+    {
+        const SMESH& mesh = aModel.m_Meshes[ii];
+
+        if( !mesh.m_Positions || !mesh.m_FaceIdx || mesh.m_VertexSize == 0
+                || mesh.m_FaceIdxSize == 0 )
+        {
+            return false;
+        }
+    }
+
+    BINARY_CACHE_WRITER out;
+
+    out.Header( MESH_CACHE_MAGIC, MESH_CACHE_VERSION );
+    out.Raw( m_sha1sum, sizeof( m_sha1sum ) );
+    out.String( wxString::FromUTF8( aPluginInfo.c_str() ) );
+    out.Int( (int32_t) aModel.m_MaterialsSize );
+    out.Int( (int32_t) aModel.m_MeshesSize );
+
+    for( unsigned int ii = 0; ii < aModel.m_MaterialsSize; ++ii )
+        writeMaterial( out, aModel.m_Materials[ii] );
+
+    for( unsigned int ii = 0; ii < aModel.m_MeshesSize; ++ii )
+        writeMesh( out, aModel.m_Meshes[ii] );
+
+    const std::string& buffer = out.GetBuffer();
+    wxFileName         cacheFile( m_cacheFile );
+
+    // Write to a temporary file first so other instances never see a partial cache file.
+    wxString tmpPath = wxFileName::CreateTempFileName( cacheFile.GetPathWithSep()
+                                                       + cacheFile.GetName() );
+
+    if( tmpPath.IsEmpty() )
+        return false;
+
+    bool ok = false;
+
+    {
+        wxFFile file( tmpPath, wxT( "wb" ) );
+
+        if( file.IsOpened() )
+            ok = file.Write( buffer.data(), buffer.size() ) == buffer.size() && file.Close();
+    }
+
+    if( !ok || !wxRenameFile( tmpPath, m_cacheFile, true ) )
+    {
+        wxRemoveFile( tmpPath );
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file 3d_mesh_cache.h
+ */
+
+#ifndef MESH_CACHE_3D_H
+#define MESH_CACHE_3D_H
+
+#include <string>
+#include <wx/string.h>
+
+struct S3DMODEL;
+
+
+/**
+ * A binary copy of the render data (S3DMODEL) of a 3D model.
+ *
+ * The meshes are stored as the indexed vertex, normal, texture coordinate and color arrays
+ * used by the renderers, each mesh referring to its material, so reading the cache file only
+ * amounts to reading these arrays back into the buffers of a new S3DMODEL.  This is much faster
+ * than rebuilding the render data from the scene graph cache (.3dc) file.
+ *
+ * A cache file is only valid for the model file content it was written for; it holds the SHA1
+ * of the model file, which is checked when reading it, along with the format version and the
+ * KiCad build which wrote it.
+ */
+class S3D_MESH_CACHE
+{
+public:
+    /**
+     * @param aCacheFile is the full path of the cache file.
+     * @param aSHA1Sum is the 20 byte SHA1 of the model file.
+     */
+    S3D_MESH_CACHE( const wxString& aCacheFile, const unsigned char* aSHA1Sum );
+
+    /**
+     * Read the render data of the model.
+     *
+     * @param aPluginInfo is set to the PluginName:Version string of the plugin that loaded the
+     *                    model.
+     * @return the render data, to be freed with S3D::Destroy3DModel(), or NULL if there is no
+     *         valid cache file for the model.
+     */
+    S3DMODEL* Read( std::string& aPluginInfo ) const;
+
+    /**
+     * Write the render data of the model.
+     *
+     * @param aModel is the render data of the model.
+     * @param aPluginInfo is the PluginName:Version string of the plugin that loaded the model.
+     * @return true on success.
+     */
+    bool Write( const S3DMODEL& aModel, const std::string& aPluginInfo ) const;
+
+private:
+    wxString      m_cacheFile;
+    unsigned char m_sha1sum[20];
+};
+
+#endif  // MESH_CACHE_3D_H
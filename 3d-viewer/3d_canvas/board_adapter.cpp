@@ -508,7 +508,7 @@ void BOARD_ADAPTER::InitSettings( REPORTER* aStatusReporter, REPORTER* aWarningR
 
     createLayers( aStatusReporter );
 
-    COLOR_SETTINGS* colors = Pgm().GetSettingsManager().GetColorSettings();
+    COLOR_SETTINGS* colors = m_colors;
 
     auto to_SFVEC4F =
             []( const COLOR4D& src )
@@ -919,6 +919,26 @@ void RENDER_3D_OPENGL::load3dModels( REPORTER* aStatusReporter )
         return;
     }
 
+    // Load the models not in our cache map concurrently before creating their OpenGL data
+    std::vector<wxString> modelFiles;
+
+    for( const FOOTPRINT* footprint : m_boardAdapter.GetBoard()->Footprints() )
+    {
+        for( const FP_3DMODEL& fp_model : footprint->Models() )
+        {
+            if( fp_model.m_Show && !fp_model.m_Filename.empty()
+                    && m_3dModelMap.find( fp_model.m_Filename ) == m_3dModelMap.end() )
+            {
+                modelFiles.push_back( fp_model.m_Filename );
+            }
+        }
+    }
+
+    if( aStatusReporter && !modelFiles.empty() )
+        aStatusReporter->Report( _( "Loading 3D models..." ) );
+
+    m_boardAdapter.Get3dCacheManager()->PreloadModels( modelFiles );
+
     // Go for all footprints
     for( const FOOTPRINT* footprint : m_boardAdapter.GetBoard()->Footprints() )
     {
@@ -28,6 +28,7 @@
  */
 
 #include "bvh_pbrt.h"
+#include "bvh_simd.h"
 
 
 #define BVH_RANGED_TRAVERSAL
@@ -44,23 +45,129 @@ struct StackNode
 };
 
 
-static inline unsigned int getFirstHit( const RAYPACKET& aRayPacket, const BBOX_3D& aBBox,
-                                        unsigned int ia, HITINFO_PACKET* aHitInfoPacket )
+static_assert( RAYPACKET_RAYS_PER_PACKET % 4 == 0, "Packet rays are tested four at a time" );
+
+
+/**
+ * The rays of a packet grouped by four for the SIMD tests, along with the distance of their
+ * nearest hit.
+ */
+struct PACKET_RAYS
+{
+    PACKET_RAYS( const RAYPACKET& aRayPacket, const HITINFO_PACKET* aHitInfoPacket )
+    {
+        for( unsigned int group = 0; group < RAYPACKET_RAYS_PER_PACKET / 4; ++group )
+        {
+            float coords[9][4];
+
+            for( unsigned int lane = 0; lane < 4; ++lane )
+            {
+                const RAY& ray = aRayPacket.m_ray[group * 4 + lane];
+
+                for( unsigned int axis = 0; axis < 3; ++axis )
+                {
+                    coords[axis][lane] = ray.m_Origin[axis];
+                    coords[axis + 3][lane] = ray.m_Dir[axis];
+                    coords[axis + 6][lane] = ray.m_InvDir[axis];
+                }
+            }
+
+            RAY4& rays = m_Rays[group];
+
+            rays.m_OriginX = VLoad( coords[0] );
+            rays.m_OriginY = VLoad( coords[1] );
+            rays.m_OriginZ = VLoad( coords[2] );
+            rays.m_DirX    = VLoad( coords[3] );
+            rays.m_DirY    = VLoad( coords[4] );
+            rays.m_DirZ    = VLoad( coords[5] );
+            rays.m_InvDirX = VLoad( coords[6] );
+            rays.m_InvDirY = VLoad( coords[7] );
+            rays.m_InvDirZ = VLoad( coords[8] );
+            rays.InitSigns();
+        }
+
+        for( unsigned int i = 0; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+            m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
+    }
+
+    RAY4  m_Rays[RAYPACKET_RAYS_PER_PACKET / 4];
+    float m_tHit[RAYPACKET_RAYS_PER_PACKET];
+};
+
+
+/**
+ * A box in the four SIMD lanes, to test four rays of a packet at once.
+ */
+struct PACKET_BBOX
+{
+    explicit PACKET_BBOX( const BBOX_3D& aBBox ) :
+            m_MinX( VSet( aBBox.Min().x ) ),
+            m_MinY( VSet( aBBox.Min().y ) ),
+            m_MinZ( VSet( aBBox.Min().z ) ),
+            m_MaxX( VSet( aBBox.Max().x ) ),
+            m_MaxY( VSet( aBBox.Max().y ) ),
+            m_MaxZ( VSet( aBBox.Max().z ) )
+    {
+    }
+
+    /**
+     * @return the mask of the rays of \a aGroup that hit the box before their nearest hit.
+     */
+    int Intersect( const PACKET_RAYS& aRays, unsigned int aGroup ) const
+    {
+        VFLOAT4 nearT;
+
+        return IntersectBBox4( aRays.m_Rays[aGroup], m_MinX, m_MinY, m_MinZ, m_MaxX, m_MaxY,
+                               m_MaxZ, VLoad( &aRays.m_tHit[aGroup * 4] ), nearT );
+    }
+
+    VFLOAT4 m_MinX, m_MinY, m_MinZ;
+    VFLOAT4 m_MaxX, m_MaxY, m_MaxZ;
+};
+
+
+static inline unsigned int firstLane( int aMask )
 {
-    float hitT;
+    unsigned int lane = 0;
 
-    if( aBBox.Intersect( aRayPacket.m_ray[ia], &hitT )
-      && ( hitT < aHitInfoPacket[ia].m_HitInfo.m_tHit ) )
-        return ia;
+    while( !( aMask & ( 1 << lane ) ) )
+        ++lane;
+
+    return lane;
+}
+
+
+static inline unsigned int lastLane( int aMask )
+{
+    unsigned int lane = 3;
+
+    while( !( aMask & ( 1 << lane ) ) )
+        --lane;
+
+    return lane;
+}
+
+
+static inline unsigned int getFirstHit( const RAYPACKET& aRayPacket, const PACKET_RAYS& aRays,
+                                        const BBOX_3D& aBBox, unsigned int ia )
+{
+    const PACKET_BBOX bbox( aBBox );
+
+    unsigned int group = ia / 4;
+    int hits = bbox.Intersect( aRays, group ) & ( 0xF << ( ia % 4 ) );
+
+    if( hits )
+        return group * 4 + firstLane( hits );
 
     if( !aRayPacket.m_Frustum.Intersect( aBBox ) )
         return RAYPACKET_RAYS_PER_PACKET;
 
-    for( unsigned int i = ia + 1; i < RAYPACKET_RAYS_PER_PACKET; ++i )
+    for( ++group; group < RAYPACKET_RAYS_PER_PACKET / 4; ++group )
     {
-        if( aBBox.Intersect( aRayPacket.m_ray[i], &hitT )
-          && ( hitT < aHitInfoPacket[i].m_HitInfo.m_tHit ) )
-            return i;
+        hits = bbox.Intersect( aRays, group );
+
+        if( hits )
+            return group * 4 + firstLane( hits );
     }
 
     return RAYPACKET_RAYS_PER_PACKET;
@@ -69,18 +176,26 @@ static inline unsigned int getFirstHit( const RAYPACKET& aRayPacket, const BBOX_
 
 #ifdef BVH_RANGED_TRAVERSAL
 
-static inline unsigned int getLastHit( const RAYPACKET& aRayPacket, const BBOX_3D& aBBox,
-                                       unsigned int ia, HITINFO_PACKET* aHitInfoPacket )
+static inline unsigned int getLastHit( const PACKET_RAYS& aRays, const BBOX_3D& aBBox,
+                                       unsigned int ia )
 {
-    for( unsigned int ie = (RAYPACKET_RAYS_PER_PACKET - 1); ie > ia; --ie )
+    const PACKET_BBOX bbox( aBBox );
+
+    for( unsigned int group = RAYPACKET_RAYS_PER_PACKET / 4 - 1; group > ia / 4; --group )
     {
-        float hitT;
+        const int hits = bbox.Intersect( aRays, group );
 
-        if( aBBox.Intersect( aRayPacket.m_ray[ie], &hitT )
-          && ( hitT < aHitInfoPacket[ie].m_HitInfo.m_tHit ) )
-            return ie + 1;
+        if( hits )
+            return group * 4 + lastLane( hits ) + 1;
     }
 
+    // Only the rays after ia in its own group are left
+    const unsigned int group = ia / 4;
+    const int hits = bbox.Intersect( aRays, group ) & ( 0xE << ( ia % 4 ) ) & 0xF;
+
+    if( hits )
+        return group * 4 + lastLane( hits ) + 1;
+
     return ia + 1;
 }
 
@@ -101,13 +216,27 @@ bool BVH_PBRT::Intersect( const RAYPACKET& aRayPacket, HITINFO_PACKET* aHitInfoP
     int todoOffset = 0, nodeNum = 0;
     StackNode todo[MAX_TODOS];
 
+    PACKET_RAYS rays( aRayPacket, aHitInfoPacket );
+
+    auto intersectRay =
+            [&]( const OBJECT_3D* aObject, unsigned int i )
+            {
+                if( aObject->Intersect( aRayPacket.m_ray[i], aHitInfoPacket[i].m_HitInfo ) )
+                {
+                    anyHit = true;
+                    aHitInfoPacket[i].m_hitresult = true;
+                    aHitInfoPacket[i].m_HitInfo.m_acc_node_info = nodeNum;
+                    rays.m_tHit[i] = aHitInfoPacket[i].m_HitInfo.m_tHit;
+                }
+            };
+
     unsigned int ia = 0;
 
     while( true )
     {
         const LinearBVHNode *curCell = &m_nodes[nodeNum];
 
-        ia = getFirstHit( aRayPacket, curCell->bounds, ia, aHitInfoPacket );
+        ia = getFirstHit( aRayPacket, rays, curCell->bounds, ia );
 
         if( ia < RAYPACKET_RAYS_PER_PACKET )
         {
@@ -121,26 +250,51 @@ bool BVH_PBRT::Intersect( const RAYPACKET& aRayPacket, HITINFO_PACKET* aHitInfoP
             }
             else
             {
-                const unsigned int ie = getLastHit( aRayPacket, curCell->bounds, ia,
-                                                    aHitInfoPacket );
+                const unsigned int ie = getLastHit( rays, curCell->bounds, ia );
+                const int trianglesOffset = m_leafTrianglesOffset[nodeNum];
 
                 for( int j = 0; j < curCell->nPrimitives; ++j )
                 {
                     const OBJECT_3D* obj = m_primitives[curCell->primitivesOffset + j];
 
-                    if( aRayPacket.m_Frustum.Intersect( obj->GetBBox() ) )
+                    if( !aRayPacket.m_Frustum.Intersect( obj->GetBBox() ) )
+                        continue;
+
+                    if( trianglesOffset < 0 )
                     {
                         for( unsigned int i = ia; i < ie; ++i )
+                            intersectRay( obj, i );
+
+                        continue;
+                    }
+
+                    // Pre-test the rays four at a time against the triangle
+                    const LinearTriangle4& triangles = m_leafTriangles[trianglesOffset + j / 4];
+                    const int lane = j % 4;
+
+                    const VFLOAT4 v0x = VSet( triangles.vertex0[0][lane] );
+                    const VFLOAT4 v0y = VSet( triangles.vertex0[1][lane] );
+                    const VFLOAT4 v0z = VSet( triangles.vertex0[2][lane] );
+                    const VFLOAT4 e1x = VSet( triangles.edge1[0][lane] );
+                    const VFLOAT4 e1y = VSet( triangles.edge1[1][lane] );
+                    const VFLOAT4 e1z = VSet( triangles.edge1[2][lane] );
+                    const VFLOAT4 e2x = VSet( triangles.edge2[0][lane] );
+                    const VFLOAT4 e2y = VSet( triangles.edge2[1][lane] );
+                    const VFLOAT4 e2z = VSet( triangles.edge2[2][lane] );
+
+                    for( unsigned int group = ia / 4; group * 4 < ie; ++group )
+                    {
+                        const VFLOAT4 maxT = VLoad( &rays.m_tHit[group * 4] );
+                        const int candidates = IntersectTriangle4( rays.m_Rays[group],
+                                                                   v0x, v0y, v0z, e1x, e1y, e1z,
+                                                                   e2x, e2y, e2z, maxT );
+
+                        for( unsigned int k = 0; k < 4; ++k )
                         {
-                            const bool hit = obj->Intersect( aRayPacket.m_ray[i],
-                                                             aHitInfoPacket[i].m_HitInfo );
+                            const unsigned int i = group * 4 + k;
 
-                            if( hit )
-                            {
-                                anyHit |= hit;
-                                aHitInfoPacket[i].m_hitresult |= hit;
-                                aHitInfoPacket[i].m_HitInfo.m_acc_node_info = nodeNum;
-                            }
+                            if( ( candidates & ( 1 << k ) ) && i >= ia && i < ie )
+                                intersectRay( obj, i );
                         }
                     }
                 }
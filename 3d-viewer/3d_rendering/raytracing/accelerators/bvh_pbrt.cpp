@@ -67,12 +67,15 @@
  */
 
 #include "bvh_pbrt.h"
+#include "bvh_simd.h"
+#include "../shapes3D/triangle_3d.h"
 #include "../../../3d_fastmath.h"
 #include <macros.h>
 
 #include <boost/range/algorithm/nth_element.hpp>
 #include <boost/range/algorithm/partition.hpp>
 #include <cstdlib>
+#include <cstring>
 #include <vector>
 
 #include <stack>
@@ -300,6 +303,10 @@ BVH_PBRT::BVH_PBRT( const CONTAINER_3D_BASE& aObjectContainer, int aMaxPrimsInNo
     flattenBVHTree( root, &offset );
 
     wxASSERT( offset == (unsigned int)totalNodes );
+
+    flattenWideBVHTree( 0 );
+
+    buildLeafTriangles( totalNodes );
 }
 
 
@@ -1060,67 +1067,298 @@ int BVH_PBRT::flattenBVHTree( BVHBuildNode* node, uint32_t* offset )
 }
 
 
-#define MAX_TODOS 64
+int BVH_PBRT::flattenWideBVHTree( int aNodeNum )
+{
+    int children[4];
+    int nChildren = 0;
 
+    if( m_nodes[aNodeNum].nPrimitives > 0 )
+    {
+        // Only the root can be a leaf here
+        children[nChildren++] = aNodeNum;
+    }
+    else
+    {
+        children[nChildren++] = aNodeNum + 1;
+        children[nChildren++] = m_nodes[aNodeNum].secondChildOffset;
 
-bool BVH_PBRT::Intersect( const RAY& aRay, HITINFO& aHitInfo ) const
-{
-    if( !m_nodes )
-        return false;
+        while( nChildren < 4 )
+        {
+            int   largest = -1;
+            float largestArea = 0.0f;
 
-    bool hit = false;
+            for( int i = 0; i < nChildren; ++i )
+            {
+                const LinearBVHNode& child = m_nodes[children[i]];
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
+                if( child.nPrimitives == 0
+                  && ( largest < 0 || child.bounds.SurfaceArea() > largestArea ) )
+                {
+                    largest = i;
+                    largestArea = child.bounds.SurfaceArea();
+                }
+            }
+
+            if( largest < 0 )
+                break;
+
+            const int pulledUp = children[largest];
+
+            children[largest] = pulledUp + 1;
+            children[nChildren++] = m_nodes[pulledUp].secondChildOffset;
+        }
+    }
+
+    const int wideNodeNum = m_wideNodes.size();
+
+    m_wideNodes.emplace_back();
 
-    while( true )
     {
-        const LinearBVHNode *node = &m_nodes[nodeNum];
+        LinearBVH4Node& wideNode = m_wideNodes[wideNodeNum];
 
-        wxASSERT( todoOffset < MAX_TODOS );
+        memset( &wideNode, 0, sizeof( wideNode ) );
+        wideNode.nChildren = nChildren;
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+        for( int i = 0; i < nChildren; ++i )
+        {
+            const BBOX_3D& bounds = m_nodes[children[i]].bounds;
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+            for( int axis = 0; axis < 3; ++axis )
+            {
+                wideNode.bounds[axis][i] = bounds.Min()[axis];
+                wideNode.bounds[axis + 3][i] = bounds.Max()[axis];
+            }
+        }
+    }
 
-        if( hitted && ( hitBox < aHitInfo.m_tHit ) )
+    // The wide nodes vector grows while creating the children, so no reference is kept to it
+    for( int i = 0; i < nChildren; ++i )
+    {
+        int child = ~children[i];
+
+        if( m_nodes[children[i]].nPrimitives == 0 )
+            child = flattenWideBVHTree( children[i] );
+
+        m_wideNodes[wideNodeNum].children[i] = child;
+    }
+
+    return wideNodeNum;
+}
+
+
+void BVH_PBRT::buildLeafTriangles( int aTotalNodes )
+{
+    m_leafTrianglesOffset.assign( aTotalNodes, -1 );
+
+    for( int nodeNum = 0; nodeNum < aTotalNodes; ++nodeNum )
+    {
+        const LinearBVHNode& node = m_nodes[nodeNum];
+
+        if( node.nPrimitives == 0 )
+            continue;
+
+        bool allTriangles = true;
+
+        for( int i = 0; i < node.nPrimitives && allTriangles; ++i )
         {
-            if( node->nPrimitives > 0 )
+            allTriangles = m_primitives[node.primitivesOffset + i]->GetObjectType()
+                           == OBJECT_3D_TYPE::TRIANGLE;
+        }
+
+        if( !allTriangles )
+            continue;
+
+        m_leafTrianglesOffset[nodeNum] = m_leafTriangles.size();
+
+        for( int i = 0; i < node.nPrimitives; i += 4 )
+        {
+            // The unused lanes are left as degenerated triangles, they are never hit
+            LinearTriangle4 group;
+
+            memset( &group, 0, sizeof( group ) );
+
+            for( int lane = 0; lane < 4 && i + lane < node.nPrimitives; ++lane )
             {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
+                const TRIANGLE* triangle = static_cast<const TRIANGLE*>(
+                        m_primitives[node.primitivesOffset + i + lane] );
+
+                const SFVEC3F& v0 = triangle->GetVertex( 0 );
+                const SFVEC3F  e1 = triangle->GetVertex( 1 ) - v0;
+                const SFVEC3F  e2 = triangle->GetVertex( 2 ) - v0;
+
+                for( int axis = 0; axis < 3; ++axis )
                 {
-                    if( m_primitives[node->primitivesOffset + i]->Intersect( aRay, aHitInfo ) )
-                    {
-                        aHitInfo.m_acc_node_info = nodeNum;
-                        hit = true;
-                    }
+                    group.vertex0[axis][lane] = v0[axis];
+                    group.edge1[axis][lane] = e1[axis];
+                    group.edge2[axis][lane] = e2[axis];
                 }
             }
-            else
+
+            m_leafTriangles.push_back( group );
+        }
+    }
+}
+
+
+static inline int intersectChildren( const RAY4& aRay, const LinearBVH4Node& aNode, float aMaxT,
+                                     float* aNearT )
+{
+    VFLOAT4 nearT;
+
+    const int hits = IntersectBBox4( aRay, VLoad( aNode.bounds[0] ), VLoad( aNode.bounds[1] ),
+                                     VLoad( aNode.bounds[2] ), VLoad( aNode.bounds[3] ),
+                                     VLoad( aNode.bounds[4] ), VLoad( aNode.bounds[5] ),
+                                     VSet( aMaxT ), nearT );
+
+    VStore( aNearT, nearT );
+
+    return hits & ( ( 1 << aNode.nChildren ) - 1 );
+}
+
+
+static inline int intersectTriangles( const RAY4& aRay, const LinearTriangle4& aTriangles,
+                                      float aMaxT )
+{
+    return IntersectTriangle4( aRay, VLoad( aTriangles.vertex0[0] ),
+                               VLoad( aTriangles.vertex0[1] ), VLoad( aTriangles.vertex0[2] ),
+                               VLoad( aTriangles.edge1[0] ), VLoad( aTriangles.edge1[1] ),
+                               VLoad( aTriangles.edge1[2] ), VLoad( aTriangles.edge2[0] ),
+                               VLoad( aTriangles.edge2[1] ), VLoad( aTriangles.edge2[2] ),
+                               VSet( aMaxT ) );
+}
+
+
+bool BVH_PBRT::intersectLeaf( const RAY& aRay, const RAY4& aRay4, int aNodeNum,
+                              HITINFO& aHitInfo ) const
+{
+    const LinearBVHNode& node = m_nodes[aNodeNum];
+    const int trianglesOffset = m_leafTrianglesOffset[aNodeNum];
+
+    bool hit = false;
+
+    for( int i = 0; i < node.nPrimitives; i += 4 )
+    {
+        int candidates = 0xF;
+
+        if( trianglesOffset >= 0 )
+        {
+            candidates = intersectTriangles( aRay4, m_leafTriangles[trianglesOffset + i / 4],
+                                             aHitInfo.m_tHit );
+        }
+
+        for( int lane = 0; lane < 4 && i + lane < node.nPrimitives; ++lane )
+        {
+            if( ( candidates & ( 1 << lane ) )
+              && m_primitives[node.primitivesOffset + i + lane]->Intersect( aRay, aHitInfo ) )
             {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
+                aHitInfo.m_acc_node_info = aNodeNum;
+                hit = true;
+            }
+        }
+    }
+
+    return hit;
+}
+
+
+bool BVH_PBRT::intersectLeafP( const RAY& aRay, const RAY4& aRay4, int aNodeNum,
+                               float aMaxDistance ) const
+{
+    const LinearBVHNode& node = m_nodes[aNodeNum];
+    const int trianglesOffset = m_leafTrianglesOffset[aNodeNum];
+
+    for( int i = 0; i < node.nPrimitives; i += 4 )
+    {
+        int candidates = 0xF;
+
+        if( trianglesOffset >= 0 )
+        {
+            candidates = intersectTriangles( aRay4, m_leafTriangles[trianglesOffset + i / 4],
+                                             aMaxDistance );
+        }
+
+        for( int lane = 0; lane < 4 && i + lane < node.nPrimitives; ++lane )
+        {
+            const OBJECT_3D* obj = m_primitives[node.primitivesOffset + i + lane];
+
+            if( ( candidates & ( 1 << lane ) ) && obj->GetMaterial()->GetCastShadows()
+              && obj->IntersectP( aRay, aMaxDistance ) )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+
+#define MAX_TODOS 64
+
+// Each level of the wide tree can leave up to three nodes on the stack
+#define MAX_WIDE_TODOS ( 3 * MAX_TODOS )
+
+
+struct WideStackNode
+{
+    int   node;     // Wide node index, or ~binary node index of a leaf
+    float nearT;    // Entry distance of the ray in the node
+};
+
+
+bool BVH_PBRT::Intersect( const RAY& aRay, HITINFO& aHitInfo ) const
+{
+    if( m_wideNodes.empty() )
+        return false;
+
+    const RAY4 ray4( aRay );
+
+    bool hit = false;
+
+    // Follow ray through the wide BVH nodes, visiting the nearest children first
+    int todoOffset = 0;
+    WideStackNode todo[MAX_WIDE_TODOS];
+
+    todo[todoOffset++] = { 0, 0.0f };
+
+    while( todoOffset > 0 )
+    {
+        const WideStackNode current = todo[--todoOffset];
+
+        // Skip the nodes that are behind a hit found since they were pushed
+        if( !( current.nearT < aHitInfo.m_tHit ) )
+            continue;
+
+        if( current.node < 0 )
+        {
+            hit |= intersectLeaf( aRay, ray4, ~current.node, aHitInfo );
+            continue;
+        }
+
+        const LinearBVH4Node& node = m_wideNodes[current.node];
 
+        float nearT[4];
+        const int hits = intersectChildren( ray4, node, aHitInfo.m_tHit, nearT );
+
+        // Sort the children that were hit from the farthest to the nearest
+        int order[4];
+        int nHits = 0;
+
+        for( int i = 0; i < 4; ++i )
+        {
+            if( !( hits & ( 1 << i ) ) )
                 continue;
-            }
+
+            int j = nHits++;
+
+            for( ; j > 0 && nearT[order[j - 1]] < nearT[i]; --j )
+                order[j] = order[j - 1];
+
+            order[j] = i;
         }
 
-        if( todoOffset == 0 )
-            break;
+        wxASSERT( todoOffset + nHits <= MAX_WIDE_TODOS );
 
-        nodeNum = todo[--todoOffset];
+        for( int j = 0; j < nHits; ++j )
+            todo[todoOffset++] = { node.children[order[j]], nearT[order[j]] };
     }
 
     return hit;
@@ -1194,60 +1432,41 @@ bool BVH_PBRT::Intersect( const RAY& aRay, HITINFO& aHitInfo, unsigned int aAccN
 
 bool BVH_PBRT::IntersectP( const RAY& aRay, float aMaxDistance ) const
 {
-    if( !m_nodes )
+    if( m_wideNodes.empty() )
         return false;
 
-    // Follow ray through BVH nodes to find primitive intersections
-    int todoOffset = 0, nodeNum = 0;
-    int todo[MAX_TODOS];
-
-    while( true )
-    {
-        const LinearBVHNode* node = &m_nodes[nodeNum];
+    const RAY4 ray4( aRay );
 
-        wxASSERT( todoOffset < MAX_TODOS );
+    // Follow ray through the wide BVH nodes, any hit ends the search
+    int todoOffset = 0;
+    int todo[MAX_WIDE_TODOS];
 
-        // Check ray against BVH node
-        float hitBox = 0.0f;
+    todo[todoOffset++] = 0;
 
-        const bool hitted = node->bounds.Intersect( aRay, &hitBox );
+    while( todoOffset > 0 )
+    {
+        const int nodeNum = todo[--todoOffset];
 
-        if( hitted && ( hitBox < aMaxDistance ) )
+        if( nodeNum < 0 )
         {
-            if( node->nPrimitives > 0 )
-            {
-                // Intersect ray with primitives in leaf BVH node
-                for( int i = 0; i < node->nPrimitives; ++i )
-                {
-                    const OBJECT_3D* obj = m_primitives[node->primitivesOffset + i];
+            if( intersectLeafP( aRay, ray4, ~nodeNum, aMaxDistance ) )
+                return true;
 
-                    if( obj->GetMaterial()->GetCastShadows()
-                      && obj->IntersectP( aRay, aMaxDistance ) )
-                        return true;
-                }
-            }
-            else
-            {
-                // Put far BVH node on _todo_ stack, advance to near node
-                if( aRay.m_dirIsNeg[node->axis] )
-                {
-                    todo[todoOffset++] = nodeNum + 1;
-                    nodeNum = node->secondChildOffset;
-                }
-                else
-                {
-                    todo[todoOffset++] = node->secondChildOffset;
-                    nodeNum = nodeNum + 1;
-                }
-
-                continue;
-            }
+            continue;
         }
 
-        if( todoOffset == 0 )
-            break;
+        const LinearBVH4Node& node = m_wideNodes[nodeNum];
 
-        nodeNum = todo[--todoOffset];
+        float nearT[4];
+        const int hits = intersectChildren( ray4, node, aMaxDistance, nearT );
+
+        wxASSERT( todoOffset + 4 <= MAX_WIDE_TODOS );
+
+        for( int i = 0; i < 4; ++i )
+        {
+            if( hits & ( 1 << i ) )
+                todo[todoOffset++] = node.children[i];
+        }
     }
 
     return false;
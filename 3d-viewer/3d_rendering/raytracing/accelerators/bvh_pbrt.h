@@ -33,6 +33,7 @@
  *  - Code style to match KiCad
  *  - Asserts converted
  *  - Use compare functions/structures for std::partition and std::nth_element
+ *  - Collapse the binary tree to a four wide one for single ray traversal
  *
  * The original source code have the following licence:
  *
@@ -71,8 +72,10 @@
 #define _BVH_PBRT_H_
 
 #include "accelerator_3d.h"
+#include "bvh_simd.h"
 #include <cstdint>
 #include <list>
+#include <vector>
 
 // Forward Declarations
 struct BVHBuildNode;
@@ -98,6 +101,32 @@ struct LinearBVHNode
 };
 
 
+/**
+ * A node of the four wide BVH collapsed from the binary one.
+ *
+ * The bounds of the children are stored per coordinate so a ray can be tested against the four
+ * of them at once.
+ */
+struct LinearBVH4Node
+{
+    float bounds[6][4];     ///< Min x, y, z then max x, y, z, one child per column.
+    int   children[4];      ///< Node index of an interior child, ~node index in the binary
+                            ///< tree of a leaf child.
+    int   nChildren;
+};
+
+
+/**
+ * Four triangles of a leaf stored per coordinate, used to pre-test a ray against them at once.
+ */
+struct LinearTriangle4
+{
+    float vertex0[3][4];
+    float edge1[3][4];      ///< vertex1 - vertex0
+    float edge2[3][4];      ///< vertex2 - vertex0
+};
+
+
 enum class SPLITMETHOD
 {
     MIDDLE,
@@ -138,12 +167,37 @@ private:
 
     int flattenBVHTree( BVHBuildNode* node, uint32_t* offset );
 
+    /**
+     * Create the wide node of a binary node, pulling up the children of its largest interior
+     * children until it has four children.
+     *
+     * @return the index of the created node.
+     */
+    int flattenWideBVHTree( int aNodeNum );
+
+    /**
+     * Store the vertices of the leaves made only of triangles for the SIMD pre-test.
+     */
+    void buildLeafTriangles( int aTotalNodes );
+
+    bool intersectLeaf( const RAY& aRay, const RAY4& aRay4, int aNodeNum,
+                        HITINFO& aHitInfo ) const;
+    bool intersectLeafP( const RAY& aRay, const RAY4& aRay4, int aNodeNum,
+                         float aMaxDistance ) const;
+
     // BVH Private Data
     const int           m_maxPrimsInNode;
     SPLITMETHOD         m_splitMethod;
     CONST_VECTOR_OBJECT m_primitives;
     LinearBVHNode*      m_nodes;
 
+    std::vector<LinearBVH4Node>  m_wideNodes;
+    std::vector<LinearTriangle4> m_leafTriangles;
+
+    ///< Index in m_leafTriangles of the first group of each binary node, -1 if the node is not a
+    ///< leaf made only of triangles.
+    std::vector<int>             m_leafTrianglesOffset;
+
     std::list<void*>    m_nodesToFree;
 
     // Partition traversal
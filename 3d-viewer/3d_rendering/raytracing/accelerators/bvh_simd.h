@@ -0,0 +1,341 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file bvh_simd.h
+ * @brief Four wide ray / box and ray / triangle tests used by the BVH traversal.
+ *
+ * The four lanes either hold one ray tested against four boxes or triangles (the wide nodes
+ * and the triangle groups of the leaves) or four rays of a packet tested against one box or
+ * triangle.  SSE2 is used when the compiler targets it, which is always the case on x86-64;
+ * other targets use the plain C++ version of the same operations.  Define BVH_NO_SIMD to build
+ * the plain C++ version on any target.
+ */
+
+#ifndef _BVH_SIMD_H_
+#define _BVH_SIMD_H_
+
+#include "../ray.h"
+
+#include <cmath>
+#include <limits>
+
+#include <math/simd_target.h>
+
+#if defined( KIMATH_TARGET_SSE2 ) && !defined( BVH_NO_SIMD )
+#define BVH_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// The two versions live in different namespaces so code built with BVH_NO_SIMD can be linked
+// with code built without it.
+#ifdef BVH_USE_SSE2
+inline namespace BVH_SSE2
+#else
+inline namespace BVH_SCALAR
+#endif
+{
+
+#ifdef BVH_USE_SSE2
+
+typedef __m128 VFLOAT4;
+
+inline VFLOAT4 VLoad( const float* aPtr ) { return _mm_loadu_ps( aPtr ); }
+inline VFLOAT4 VSet( float aValue )       { return _mm_set1_ps( aValue ); }
+inline void    VStore( float* aPtr, VFLOAT4 a ) { _mm_storeu_ps( aPtr, a ); }
+
+inline VFLOAT4 VAdd( VFLOAT4 a, VFLOAT4 b ) { return _mm_add_ps( a, b ); }
+inline VFLOAT4 VSub( VFLOAT4 a, VFLOAT4 b ) { return _mm_sub_ps( a, b ); }
+inline VFLOAT4 VMul( VFLOAT4 a, VFLOAT4 b ) { return _mm_mul_ps( a, b ); }
+inline VFLOAT4 VDiv( VFLOAT4 a, VFLOAT4 b ) { return _mm_div_ps( a, b ); }
+inline VFLOAT4 VAbs( VFLOAT4 a )            { return _mm_andnot_ps( _mm_set1_ps( -0.0f ), a ); }
+
+// As the SSE instructions, return b if any of the values is a NaN
+inline VFLOAT4 VMin( VFLOAT4 a, VFLOAT4 b ) { return _mm_min_ps( a, b ); }
+inline VFLOAT4 VMax( VFLOAT4 a, VFLOAT4 b ) { return _mm_max_ps( a, b ); }
+
+/// @return a bit mask of the lanes where a <= b (bit 0 is lane 0).
+inline int VLessEqual( VFLOAT4 a, VFLOAT4 b )    { return _mm_movemask_ps( _mm_cmple_ps( a, b ) ); }
+inline int VLess( VFLOAT4 a, VFLOAT4 b )         { return _mm_movemask_ps( _mm_cmplt_ps( a, b ) ); }
+
+/// @return a lane mask for VSelect of the lanes where a < b.
+inline VFLOAT4 VLessMask( VFLOAT4 a, VFLOAT4 b ) { return _mm_cmplt_ps( a, b ); }
+
+inline VFLOAT4 VSelect( VFLOAT4 aMask, VFLOAT4 aTrue, VFLOAT4 aFalse )
+{
+    return _mm_or_ps( _mm_and_ps( aMask, aTrue ), _mm_andnot_ps( aMask, aFalse ) );
+}
+
+#else
+
+struct VFLOAT4
+{
+    float v[4];
+};
+
+inline VFLOAT4 VLoad( const float* aPtr )
+{
+    return { { aPtr[0], aPtr[1], aPtr[2], aPtr[3] } };
+}
+
+inline VFLOAT4 VSet( float aValue )
+{
+    return { { aValue, aValue, aValue, aValue } };
+}
+
+inline void VStore( float* aPtr, VFLOAT4 a )
+{
+    for( int i = 0; i < 4; ++i )
+        aPtr[i] = a.v[i];
+}
+
+#define VFLOAT4_OP( name, expr )                                \
+    inline VFLOAT4 name( VFLOAT4 a, VFLOAT4 b )                 \
+    {                                                           \
+        VFLOAT4 r;                                              \
+                                                                \
+        for( int i = 0; i < 4; ++i )                            \
+            r.v[i] = expr;                                      \
+                                                                \
+        return r;                                               \
+    }
+
+VFLOAT4_OP( VAdd, a.v[i] + b.v[i] )
+VFLOAT4_OP( VSub, a.v[i] - b.v[i] )
+VFLOAT4_OP( VMul, a.v[i] * b.v[i] )
+VFLOAT4_OP( VDiv, a.v[i] / b.v[i] )
+VFLOAT4_OP( VMin, a.v[i] < b.v[i] ? a.v[i] : b.v[i] )
+VFLOAT4_OP( VMax, a.v[i] > b.v[i] ? a.v[i] : b.v[i] )
+
+inline int VLessEqual( VFLOAT4 a, VFLOAT4 b )
+{
+    int mask = 0;
+
+    for( int i = 0; i < 4; ++i )
+        mask |= ( a.v[i] <= b.v[i] ) << i;
+
+    return mask;
+}
+
+inline int VLess( VFLOAT4 a, VFLOAT4 b )
+{
+    int mask = 0;
+
+    for( int i = 0; i < 4; ++i )
+        mask |= ( a.v[i] < b.v[i] ) << i;
+
+    return mask;
+}
+
+VFLOAT4_OP( VLessMask, a.v[i] < b.v[i] ? 1.0f : 0.0f )
+
+#undef VFLOAT4_OP
+
+inline VFLOAT4 VAbs( VFLOAT4 a )
+{
+    VFLOAT4 r;
+
+    for( int i = 0; i < 4; ++i )
+        r.v[i] = std::fabs( a.v[i] );
+
+    return r;
+}
+
+inline VFLOAT4 VSelect( VFLOAT4 aMask, VFLOAT4 aTrue, VFLOAT4 aFalse )
+{
+    VFLOAT4 r;
+
+    for( int i = 0; i < 4; ++i )
+        r.v[i] = aMask.v[i] != 0.0f ? aTrue.v[i] : aFalse.v[i];
+
+    return r;
+}
+
+#endif
+
+
+/**
+ * Four rays, or one ray in the four lanes.
+ */
+struct RAY4
+{
+    RAY4( const RAY& aRay )
+    {
+        m_OriginX = VSet( aRay.m_Origin.x );
+        m_OriginY = VSet( aRay.m_Origin.y );
+        m_OriginZ = VSet( aRay.m_Origin.z );
+        m_DirX    = VSet( aRay.m_Dir.x );
+        m_DirY    = VSet( aRay.m_Dir.y );
+        m_DirZ    = VSet( aRay.m_Dir.z );
+        m_InvDirX = VSet( aRay.m_InvDir.x );
+        m_InvDirY = VSet( aRay.m_InvDir.y );
+        m_InvDirZ = VSet( aRay.m_InvDir.z );
+
+        InitSigns();
+    }
+
+    RAY4() {}
+
+    /**
+     * Set the direction sign masks from the inverse directions.
+     *
+     * The sign of the inverse direction is used because a -0 direction gives a negative
+     * infinite inverse direction.
+     */
+    void InitSigns()
+    {
+        m_NegX = VLessMask( m_InvDirX, VSet( 0.0f ) );
+        m_NegY = VLessMask( m_InvDirY, VSet( 0.0f ) );
+        m_NegZ = VLessMask( m_InvDirZ, VSet( 0.0f ) );
+    }
+
+    VFLOAT4 m_OriginX, m_OriginY, m_OriginZ;
+    VFLOAT4 m_DirX, m_DirY, m_DirZ;
+    VFLOAT4 m_InvDirX, m_InvDirY, m_InvDirZ;
+    VFLOAT4 m_NegX, m_NegY, m_NegZ;
+};
+
+
+/**
+ * Intersect rays with axis aligned boxes using the slab test.
+ *
+ * The near and far planes of each slab are chosen from the ray direction.  A ray parallel to
+ * and lying on a box face gives a NaN distance for that slab, which is ignored: VMin and VMax
+ * return their second operand when one of them is a NaN.
+ *
+ * @param aMinX ... aMaxZ are the bounds of the boxes.
+ * @param aMaxT is the distance beyond which a hit is not wanted.
+ * @param aNearT is set to the entry distance of each ray in the box.
+ * @return the mask of the lanes where the ray hits the box before \a aMaxT.
+ */
+inline int IntersectBBox4( const RAY4& aRay, VFLOAT4 aMinX, VFLOAT4 aMinY, VFLOAT4 aMinZ,
+                           VFLOAT4 aMaxX, VFLOAT4 aMaxY, VFLOAT4 aMaxZ, VFLOAT4 aMaxT,
+                           VFLOAT4& aNearT )
+{
+    const VFLOAT4 nearX = VMul( VSub( VSelect( aRay.m_NegX, aMaxX, aMinX ), aRay.m_OriginX ),
+                                aRay.m_InvDirX );
+    const VFLOAT4 nearY = VMul( VSub( VSelect( aRay.m_NegY, aMaxY, aMinY ), aRay.m_OriginY ),
+                                aRay.m_InvDirY );
+    const VFLOAT4 nearZ = VMul( VSub( VSelect( aRay.m_NegZ, aMaxZ, aMinZ ), aRay.m_OriginZ ),
+                                aRay.m_InvDirZ );
+    const VFLOAT4 farX = VMul( VSub( VSelect( aRay.m_NegX, aMinX, aMaxX ), aRay.m_OriginX ),
+                               aRay.m_InvDirX );
+    const VFLOAT4 farY = VMul( VSub( VSelect( aRay.m_NegY, aMinY, aMaxY ), aRay.m_OriginY ),
+                               aRay.m_InvDirY );
+    const VFLOAT4 farZ = VMul( VSub( VSelect( aRay.m_NegZ, aMinZ, aMaxZ ), aRay.m_OriginZ ),
+                               aRay.m_InvDirZ );
+
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    const VFLOAT4 nearT = VMax( nearX, VMax( nearY, VMax( nearZ, VSet( -infinity ) ) ) );
+    const VFLOAT4 farT  = VMin( farX, VMin( farY, VMin( farZ, VSet( infinity ) ) ) );
+
+    aNearT = nearT;
+
+    return VLessEqual( nearT, farT ) & VLessEqual( VSet( 0.0f ), farT ) & VLess( nearT, aMaxT );
+}
+
+
+/**
+ * Intersect rays with triangles using the Möller–Trumbore test.
+ *
+ * This is a conservative pre-test: the barycentric coordinates and the distance are checked
+ * with a tolerance covering the rounding errors of both tests, including at grazing angles,
+ * and the back faces are not culled, so a lane that is set may still miss the exact test of
+ * the TRIANGLE object, but a ray that hits the triangle is never rejected.
+ *
+ * @param aV0X ... aV0Z are the first vertex of the triangles.
+ * @param aE1X ... aE2Z are the edges from the first vertex to the second and third vertices.
+ * @param aMaxT is the distance beyond which a hit is not wanted.
+ * @return the mask of the lanes where the ray may hit the triangle before \a aMaxT.
+ */
+inline int IntersectTriangle4( const RAY4& aRay, VFLOAT4 aV0X, VFLOAT4 aV0Y, VFLOAT4 aV0Z,
+                               VFLOAT4 aE1X, VFLOAT4 aE1Y, VFLOAT4 aE1Z,
+                               VFLOAT4 aE2X, VFLOAT4 aE2Y, VFLOAT4 aE2Z, VFLOAT4 aMaxT )
+{
+    const float tolerance = 1e-4f;
+    const float roundingError = 32 * std::numeric_limits<float>::epsilon();
+
+    // p = dir x e2
+    const VFLOAT4 px = VSub( VMul( aRay.m_DirY, aE2Z ), VMul( aRay.m_DirZ, aE2Y ) );
+    const VFLOAT4 py = VSub( VMul( aRay.m_DirZ, aE2X ), VMul( aRay.m_DirX, aE2Z ) );
+    const VFLOAT4 pz = VSub( VMul( aRay.m_DirX, aE2Y ), VMul( aRay.m_DirY, aE2X ) );
+
+    const VFLOAT4 det = VAdd( VAdd( VMul( aE1X, px ), VMul( aE1Y, py ) ), VMul( aE1Z, pz ) );
+
+    // A ray parallel to the triangle gives NaN and infinite values, see the parallel mask below
+    const VFLOAT4 invDet = VDiv( VSet( 1.0f ), det );
+
+    // s = origin - v0
+    const VFLOAT4 sx = VSub( aRay.m_OriginX, aV0X );
+    const VFLOAT4 sy = VSub( aRay.m_OriginY, aV0Y );
+    const VFLOAT4 sz = VSub( aRay.m_OriginZ, aV0Z );
+
+    const VFLOAT4 u = VMul( VAdd( VAdd( VMul( sx, px ), VMul( sy, py ) ), VMul( sz, pz ) ),
+                            invDet );
+
+    // q = s x e1
+    const VFLOAT4 qx = VSub( VMul( sy, aE1Z ), VMul( sz, aE1Y ) );
+    const VFLOAT4 qy = VSub( VMul( sz, aE1X ), VMul( sx, aE1Z ) );
+    const VFLOAT4 qz = VSub( VMul( sx, aE1Y ), VMul( sy, aE1X ) );
+
+    const VFLOAT4 v = VMul( VAdd( VAdd( VMul( aRay.m_DirX, qx ), VMul( aRay.m_DirY, qy ) ),
+                                  VMul( aRay.m_DirZ, qz ) ),
+                            invDet );
+
+    const VFLOAT4 t = VMul( VAdd( VAdd( VMul( aE2X, qx ), VMul( aE2Y, qy ) ), VMul( aE2Z, qz ) ),
+                            invDet );
+
+    // The rounding errors of this test and of the exact one grow with the distance of the ray
+    // origin and of the triangle from the coordinate origin, and as the ray gets parallel to the
+    // triangle (the determinant goes to zero), so the tolerances grow with them.
+    const VFLOAT4 magnitude = VAdd( VAdd( VAdd( VAbs( aRay.m_OriginX ), VAbs( aRay.m_OriginY ) ),
+                                          VAdd( VAbs( aRay.m_OriginZ ), VAbs( aV0X ) ) ),
+                                    VAdd( VAbs( aV0Y ), VAbs( aV0Z ) ) );
+    const VFLOAT4 dirNorm = VAdd( VAdd( VAbs( aRay.m_DirX ), VAbs( aRay.m_DirY ) ),
+                                  VAbs( aRay.m_DirZ ) );
+    const VFLOAT4 pNorm = VAdd( VAdd( VAbs( px ), VAbs( py ) ), VAbs( pz ) );
+    const VFLOAT4 e1Norm = VAdd( VAdd( VAbs( aE1X ), VAbs( aE1Y ) ), VAbs( aE1Z ) );
+    const VFLOAT4 e2Norm = VAdd( VAdd( VAbs( aE2X ), VAbs( aE2Y ) ), VAbs( aE2Z ) );
+    const VFLOAT4 error = VMul( VSet( roundingError ), VMul( magnitude, VAbs( invDet ) ) );
+
+    const VFLOAT4 tolU = VAdd( VSet( tolerance ), VMul( error, pNorm ) );
+    const VFLOAT4 tolV = VAdd( VSet( tolerance ), VMul( error, VMul( e1Norm, dirNorm ) ) );
+    const VFLOAT4 tolT = VAdd( VSet( tolerance ), VMul( error, VMul( e1Norm, e2Norm ) ) );
+
+    const VFLOAT4 zero = VSet( 0.0f );
+    const VFLOAT4 maxT = VAdd( VAdd( aMaxT, VMul( aMaxT, VSet( tolerance ) ) ), tolT );
+
+    // A ray parallel to the triangle is left to the exact test
+    const int parallel = VLessEqual( VAbs( det ), zero );
+
+    return ( VLessEqual( VSub( zero, tolU ), u ) & VLessEqual( VSub( zero, tolV ), v )
+             & VLessEqual( VAdd( u, v ), VAdd( VSet( 1.0f ), VAdd( tolU, tolV ) ) )
+             & VLess( VSub( zero, tolT ), t ) & VLess( t, maxT ) )
+           | parallel;
+}
+
+} // inline namespace
+
+#endif // _BVH_SIMD_H_
@@ -28,6 +28,7 @@
 #include "shapes3D/layer_item_3d.h"
 #include "shapes3D/cylinder_3d.h"
 #include "shapes3D/triangle_3d.h"
+#include "shapes3D/model_instance_3d.h"
 #include "shapes2D/layer_item_2d.h"
 #include "shapes2D/ring_2d.h"
 #include "shapes2D/polygon_2d.h"
@@ -379,6 +380,9 @@ void RENDER_3D_RAYTRACE::Reload( REPORTER* aStatusReporter, REPORTER* aWarningRe
     m_objectContainer.Clear();
     m_containerWithObjectsToDelete.Clear();
 
+    // The model instances were deleted with the object container
+    deleteModelMeshes();
+
     setupMaterials();
 
     if( aStatusReporter )
@@ -1192,7 +1196,8 @@ void RENDER_3D_RAYTRACE::addPadsAndVias()
 
 void RENDER_3D_RAYTRACE::load3DModels( CONTAINER_3D& aDstContainer, bool aSkipMaterialInformation )
 {
-    if( !m_boardAdapter.GetBoard() )
+    // Offscreen renders may be made without a 3D model cache, and so without the models
+    if( !m_boardAdapter.GetBoard() || !m_boardAdapter.Get3dCacheManager() )
         return;
 
     if( !m_boardAdapter.m_Cfg->m_Render.show_footprints_normal
@@ -1202,6 +1207,26 @@ void RENDER_3D_RAYTRACE::load3DModels( CONTAINER_3D& aDstContainer, bool aSkipMa
         return;
     }
 
+    // Load the models of all footprints concurrently before building the scene
+    std::vector<wxString> modelFiles;
+
+    for( FOOTPRINT* fp : m_boardAdapter.GetBoard()->Footprints() )
+    {
+        if( !m_boardAdapter.IsFootprintShown( (FOOTPRINT_ATTR_T) fp->GetAttributes() ) )
+            continue;
+
+        for( const FP_3DMODEL& fp_model : fp->Models() )
+        {
+            if( static_cast<float>( fp_model.m_Opacity ) > FLT_EPSILON
+                    && fp_model.m_Show && !fp_model.m_Filename.empty() )
+            {
+                modelFiles.push_back( fp_model.m_Filename );
+            }
+        }
+    }
+
+    m_boardAdapter.Get3dCacheManager()->PreloadModels( modelFiles );
+
     // Go for all footprints
     for( FOOTPRINT* fp : m_boardAdapter.GetBoard()->Footprints() )
     {
@@ -1289,6 +1314,15 @@ void RENDER_3D_RAYTRACE::load3DModels( CONTAINER_3D& aDstContainer, bool aSkipMa
 }
 
 
+void RENDER_3D_RAYTRACE::deleteModelMeshes()
+{
+    for( MAP_MODEL_MESHES::value_type& entry : m_modelMeshMap )
+        delete entry.second;
+
+    m_modelMeshMap.clear();
+}
+
+
 MODEL_MATERIALS* RENDER_3D_RAYTRACE::getModelMaterial( const S3DMODEL* a3DModel )
 {
     MODEL_MATERIALS* materialVector;
@@ -1402,10 +1436,6 @@ void RENDER_3D_RAYTRACE::addModels( CONTAINER_3D& aDstContainer, const S3DMODEL*
     if( a3DModel == nullptr )
         return;
 
-    wxASSERT( a3DModel->m_Materials != nullptr );
-    wxASSERT( a3DModel->m_Meshes != nullptr );
-    wxASSERT( a3DModel->m_MaterialsSize > 0 );
-    wxASSERT( a3DModel->m_MeshesSize > 0 );
     wxASSERT( aFPOpacity > 0.0f );
     wxASSERT( aFPOpacity <= 1.0f );
 
@@ -1414,6 +1444,50 @@ void RENDER_3D_RAYTRACE::addModels( CONTAINER_3D& aDstContainer, const S3DMODEL*
         aFPOpacity = 1.0f;
     }
 
+    // A mirroring model matrix reverses the winding of the triangles, which must be kept for
+    // the back face culling of the triangles to work in model space.
+    const bool mirrored = glm::determinant( glm::mat3( aModelMatrix ) ) < 0.0f;
+
+    const MODEL_MESH_KEY key( a3DModel, aFPOpacity, mirrored );
+    MODEL_MESH_3D*       mesh = nullptr;
+
+    MAP_MODEL_MESHES::const_iterator it = m_modelMeshMap.find( key );
+
+    if( it != m_modelMeshMap.end() )
+    {
+        mesh = it->second;
+    }
+    else
+    {
+        mesh = new MODEL_MESH_3D;
+        addModelTriangles( *mesh, a3DModel, aFPOpacity, mirrored, aSkipMaterialInformation );
+
+        if( !mesh->IsEmpty() )
+            mesh->Build();
+
+        m_modelMeshMap[key] = mesh;
+    }
+
+    if( mesh->IsEmpty() )
+        return;
+
+    MODEL_INSTANCE_3D* instance = new MODEL_INSTANCE_3D( mesh, aModelMatrix );
+
+    instance->SetBoardItem( aBoardItem );
+
+    aDstContainer.Add( instance );
+}
+
+
+void RENDER_3D_RAYTRACE::addModelTriangles( MODEL_MESH_3D& aMesh, const S3DMODEL* a3DModel,
+                                            float aFPOpacity, bool aMirrored,
+                                            bool aSkipMaterialInformation )
+{
+    wxASSERT( a3DModel->m_Materials != nullptr );
+    wxASSERT( a3DModel->m_Meshes != nullptr );
+    wxASSERT( a3DModel->m_MaterialsSize > 0 );
+    wxASSERT( a3DModel->m_MeshesSize > 0 );
+
     if( ( a3DModel->m_Materials != nullptr ) && ( a3DModel->m_Meshes != nullptr )
       && ( a3DModel->m_MaterialsSize > 0 ) && ( a3DModel->m_MeshesSize > 0 ) )
     {
@@ -1424,8 +1498,6 @@ void RENDER_3D_RAYTRACE::addModels( CONTAINER_3D& aDstContainer, const S3DMODEL*
             materialVector = getModelMaterial( a3DModel );
         }
 
-        const glm::mat3 normalMatrix = glm::transpose( glm::inverse( glm::mat3( aModelMatrix ) ) );
-
         for( unsigned int mesh_i = 0; mesh_i < a3DModel->m_MeshesSize; ++mesh_i )
         {
             const SMESH& mesh = a3DModel->m_Meshes[mesh_i];
@@ -1472,24 +1544,20 @@ void RENDER_3D_RAYTRACE::addModels( CONTAINER_3D& aDstContainer, const S3DMODEL*
                         const SFVEC3F& v1 = mesh.m_Positions[idx1];
                         const SFVEC3F& v2 = mesh.m_Positions[idx2];
 
-                        const SFVEC3F& n0 = mesh.m_Normals[idx0];
-                        const SFVEC3F& n1 = mesh.m_Normals[idx1];
-                        const SFVEC3F& n2 = mesh.m_Normals[idx2];
+                        const SFVEC3F n0 = glm::normalize( mesh.m_Normals[idx0] );
+                        const SFVEC3F n1 = glm::normalize( mesh.m_Normals[idx1] );
+                        const SFVEC3F n2 = glm::normalize( mesh.m_Normals[idx2] );
 
-                        // Transform vertex with the model matrix
-                        const SFVEC3F vt0 = SFVEC3F( aModelMatrix * glm::vec4( v0, 1.0f ) );
-                        const SFVEC3F vt1 = SFVEC3F( aModelMatrix * glm::vec4( v1, 1.0f ) );
-                        const SFVEC3F vt2 = SFVEC3F( aModelMatrix * glm::vec4( v2, 1.0f ) );
+                        // The triangles stay in model space; the instances of the model
+                        // transform the rays instead.
+                        MODEL_TRIANGLE* newTriangle = nullptr;
 
-                        const SFVEC3F nt0 = glm::normalize( SFVEC3F( normalMatrix * n0 ) );
-                        const SFVEC3F nt1 = glm::normalize( SFVEC3F( normalMatrix * n1 ) );
-                        const SFVEC3F nt2 = glm::normalize( SFVEC3F( normalMatrix * n2 ) );
-
-                        TRIANGLE* newTriangle = new TRIANGLE( vt0, vt2, vt1, nt0, nt2, nt1 );
-
-                        newTriangle->SetBoardItem( aBoardItem );
+                        if( aMirrored )
+                            newTriangle = new MODEL_TRIANGLE( v0, v1, v2, n0, n1, n2 );
+                        else
+                            newTriangle = new MODEL_TRIANGLE( v0, v2, v1, n0, n2, n1 );
 
-                        aDstContainer.Add( newTriangle );
+                        aMesh.Add( newTriangle );
 
                         if( !aSkipMaterialInformation )
                         {
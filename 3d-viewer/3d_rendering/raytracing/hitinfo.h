@@ -38,6 +38,7 @@ struct HITINFO
     float   m_tHit;                     ///< ( 4) distance
 
     const OBJECT_3D* pHitObject;        ///< ( 4) Object that was hitted
+    const OBJECT_3D* pHitSurface;       ///< ( 4) Triangle hitted inside a model instance
     SFVEC2F m_UV;                       ///< ( 8) 2-D texture coordinates
     unsigned int m_acc_node_info;       ///< ( 4) The acc stores here the node that it hits
 
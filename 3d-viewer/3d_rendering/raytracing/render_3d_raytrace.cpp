@@ -37,6 +37,7 @@
 #include "3d_math.h"
 #include "../common_ogl/ogl_utils.h"
 #include <profile.h>        // To use GetRunningMicroSecs or another profiling utility
+#include <wx/image.h>
 #include <wx/log.h>
 
 
@@ -63,6 +64,8 @@ RENDER_3D_RAYTRACE::RENDER_3D_RAYTRACE( EDA_3D_CANVAS* aCanvas, BOARD_ADAPTER& a
     m_xoffset = 0;
     m_yoffset = 0;
 
+    m_threadCount = 0;
+
     m_isPreview = false;
     m_renderState = RT_RENDER_STATE_MAX; // Set to an initial invalid state
     m_renderStartTime = 0;
@@ -77,6 +80,8 @@ RENDER_3D_RAYTRACE::~RENDER_3D_RAYTRACE()
     delete m_accelerator;
     m_accelerator = nullptr;
 
+    deleteModelMeshes();
+
     delete m_outlineBoard2dObjects;
     m_outlineBoard2dObjects = nullptr;
 
@@ -96,6 +101,15 @@ int RENDER_3D_RAYTRACE::GetWaitForEditingTimeOut()
 }
 
 
+size_t RENDER_3D_RAYTRACE::getThreadCount() const
+{
+    if( m_threadCount > 0 )
+        return m_threadCount;
+
+    return std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+}
+
+
 void RENDER_3D_RAYTRACE::deletePbo()
 {
     // Delete PBO if it was created
@@ -342,6 +356,184 @@ void RENDER_3D_RAYTRACE::render( GLubyte* ptrPBO, REPORTER* aStatusReporter )
 }
 
 
+static wxString formatRenderStats( const RT_RENDER_STATS& aStats )
+{
+    return wxString::Format( _( "Loading %.3f s, tracing %.3f s, shading %.3f s, blur %.3f s, "
+                                "image %.3f s, saving %.3f s, total %.3f s" ),
+                             aStats.m_LoadTime / 1e6, aStats.m_TracingTime / 1e6,
+                             aStats.m_ShadingTime / 1e6, aStats.m_BlurTime / 1e6,
+                             aStats.m_ImageTime / 1e6, aStats.m_SaveTime / 1e6,
+                             aStats.m_TotalTime / 1e6 );
+}
+
+
+bool RENDER_3D_RAYTRACE::RenderToImage( const RT_OFFSCREEN_SETTINGS& aSettings, wxImage& aImage,
+                                        REPORTER* aStatusReporter, REPORTER* aWarningReporter,
+                                        RT_RENDER_STATS* aStats )
+{
+    RT_RENDER_STATS stats;
+
+    if( !renderOffscreen( aSettings, aImage, aStatusReporter, aWarningReporter, stats ) )
+        return false;
+
+    const wxString msg = formatRenderStats( stats );
+
+    wxLogTrace( m_logTrace, wxT( "RENDER_3D_RAYTRACE offscreen render: %s" ), msg );
+
+    if( aStatusReporter )
+        aStatusReporter->Report( msg );
+
+    if( aStats )
+        *aStats = stats;
+
+    return true;
+}
+
+
+bool RENDER_3D_RAYTRACE::RenderToFile( const wxString& aFileName,
+                                       const RT_OFFSCREEN_SETTINGS& aSettings,
+                                       REPORTER* aStatusReporter, REPORTER* aWarningReporter,
+                                       RT_RENDER_STATS* aStats )
+{
+    RT_RENDER_STATS stats;
+    wxImage         image;
+
+    if( !renderOffscreen( aSettings, image, aStatusReporter, aWarningReporter, stats ) )
+        return false;
+
+    const unsigned saveStartTime = GetRunningMicroSecs();
+
+    if( wxImage::FindHandler( wxBITMAP_TYPE_PNG ) == nullptr )
+        wxImage::AddHandler( new wxPNGHandler );
+
+    if( !image.SaveFile( aFileName, wxBITMAP_TYPE_PNG ) )
+    {
+        if( aWarningReporter )
+        {
+            aWarningReporter->Report( wxString::Format( _( "Cannot write image file '%s'." ),
+                                                        aFileName ),
+                                      RPT_SEVERITY_ERROR );
+        }
+
+        return false;
+    }
+
+    stats.m_SaveTime = GetRunningMicroSecs() - saveStartTime;
+    stats.m_TotalTime += stats.m_SaveTime;
+
+    const wxString msg = formatRenderStats( stats );
+
+    wxLogTrace( m_logTrace, wxT( "RENDER_3D_RAYTRACE offscreen render: %s" ), msg );
+
+    if( aStatusReporter )
+        aStatusReporter->Report( msg );
+
+    if( aStats )
+        *aStats = stats;
+
+    return true;
+}
+
+
+bool RENDER_3D_RAYTRACE::renderOffscreen( const RT_OFFSCREEN_SETTINGS& aSettings,
+                                          wxImage& aImage, REPORTER* aStatusReporter,
+                                          REPORTER* aWarningReporter, RT_RENDER_STATS& aStats )
+{
+    if( aSettings.m_Size.x <= 0 || aSettings.m_Size.y <= 0 )
+        return false;
+
+    const unsigned startTime = GetRunningMicroSecs();
+    unsigned       phaseStartTime = startTime;
+
+    auto endPhase =
+            [&]( unsigned& aPhaseTime )
+            {
+                const unsigned now = GetRunningMicroSecs();
+
+                aPhaseTime = now - phaseStartTime;
+                phaseStartTime = now;
+            };
+
+    if( m_reloadRequested || !m_accelerator )
+    {
+        if( aStatusReporter )
+            aStatusReporter->Report( _( "Loading..." ) );
+
+        Reload( aStatusReporter, aWarningReporter, false );
+    }
+
+    endPhase( aStats.m_LoadTime );
+
+    if( !m_accelerator )
+        return false;
+
+    // Render at the image size.  The buffers of the interactive render are set again on the
+    // next redraw.
+    const wxSize windowSize = m_windowSize;
+
+    m_windowSize = aSettings.m_Size;
+    m_threadCount = aSettings.m_ThreadCount;
+    m_camera.SetCurWindowSize( m_windowSize );
+
+    std::vector<size_t> tileStart;
+    initializeTiledBlockPositions( aSettings.m_TileSize, tileStart );
+
+    std::vector<GLubyte> buffer( (size_t) m_realBufferSize.x * m_realBufferSize.y * 4 );
+
+    restartRenderState();
+
+    if( m_cameraLight )
+        m_cameraLight->SetDirection( -m_camera.GetDir() );
+
+    m_backgroundColorTop = ConvertSRGBToLinear( (SFVEC3F)m_boardAdapter.m_BgColorTop );
+    m_backgroundColorBottom = ConvertSRGBToLinear( (SFVEC3F)m_boardAdapter.m_BgColorBot );
+
+    if( aStatusReporter )
+        aStatusReporter->Report( _( "Rendering..." ) );
+
+    renderTiles( buffer.data(), tileStart );
+    endPhase( aStats.m_TracingTime );
+
+    if( m_renderState == RT_RENDER_STATE_POST_PROCESS_SHADE )
+    {
+        postProcessShading( buffer.data(), aStatusReporter );
+        endPhase( aStats.m_ShadingTime );
+
+        postProcessBlurFinish( buffer.data(), aStatusReporter );
+        endPhase( aStats.m_BlurTime );
+    }
+
+    // The buffer is RGBA with the rows going bottom up, as it is drawn by OpenGL
+    aImage.Create( m_windowSize.x, m_windowSize.y, false );
+
+    unsigned char* dst = aImage.GetData();
+
+    for( int y = 0; y < m_windowSize.y; ++y )
+    {
+        const GLubyte* src = &buffer[(size_t) ( m_windowSize.y - 1 - y ) * m_realBufferSize.x * 4];
+
+        for( int x = 0; x < m_windowSize.x; ++x )
+        {
+            *dst++ = src[0];
+            *dst++ = src[1];
+            *dst++ = src[2];
+            src += 4;
+        }
+    }
+
+    endPhase( aStats.m_ImageTime );
+
+    m_threadCount = 0;
+    m_windowSize = windowSize;
+    m_oldWindowsSize = wxSize( 0, 0 );
+    m_renderState = RT_RENDER_STATE_MAX;
+
+    aStats.m_TotalTime = GetRunningMicroSecs() - startTime;
+
+    return true;
+}
+
+
 void RENDER_3D_RAYTRACE::renderTracing( GLubyte* ptrPBO, REPORTER* aStatusReporter )
 {
     m_isPreview = false;
@@ -353,9 +545,8 @@ void RENDER_3D_RAYTRACE::renderTracing( GLubyte* ptrPBO, REPORTER* aStatusReport
     std::atomic<size_t> currentBlock( 0 );
     std::atomic<size_t> threadsFinished( 0 );
 
-    size_t parallelThreadCount = std::min<size_t>(
-            std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-            m_blockPositions.size() );
+    size_t parallelThreadCount = std::min<size_t>( getThreadCount(),
+                                                   m_blockPositions.size() );
 
     for( size_t ii = 0; ii < parallelThreadCount; ++ii )
     {
@@ -407,6 +598,49 @@ void RENDER_3D_RAYTRACE::renderTracing( GLubyte* ptrPBO, REPORTER* aStatusReport
 }
 
 
+void RENDER_3D_RAYTRACE::renderTiles( GLubyte* aBuffer, const std::vector<size_t>& aTileStart )
+{
+    m_isPreview = false;
+
+    const size_t tileCount = aTileStart.empty() ? 0 : aTileStart.size() - 1;
+
+    std::atomic<size_t> nextTile( 0 );
+    std::atomic<size_t> threadsFinished( 0 );
+
+    size_t parallelThreadCount = std::min<size_t>( getThreadCount(), tileCount );
+
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    {
+        std::thread t = std::thread( [&]()
+        {
+            for( size_t iTile = nextTile.fetch_add( 1 ); iTile < tileCount;
+                 iTile = nextTile.fetch_add( 1 ) )
+            {
+                for( size_t iBlock = aTileStart[iTile]; iBlock < aTileStart[iTile + 1]; ++iBlock )
+                {
+                    renderBlockTracing( aBuffer, iBlock );
+                    m_blockPositionsWasProcessed[iBlock] = 1;
+                }
+            }
+
+            threadsFinished++;
+        } );
+
+        t.detach();
+    }
+
+    while( threadsFinished < parallelThreadCount )
+        std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+
+    m_blockRenderProgressCount = m_blockPositions.size();
+
+    if( m_boardAdapter.m_Cfg->m_Render.raytrace_post_processing )
+        m_renderState = RT_RENDER_STATE_POST_PROCESS_SHADE;
+    else
+        m_renderState = RT_RENDER_STATE_FINISH;
+}
+
+
 #ifdef USE_SRGB_SPACE
 
 /// @todo This should be removed in future when KiCad supports a greater version of glm lib.
@@ -846,7 +1080,7 @@ void RENDER_3D_RAYTRACE::postProcessShading( GLubyte* /* ptrPBO */, REPORTER* aS
         std::atomic<size_t> nextBlock( 0 );
         std::atomic<size_t> threadsFinished( 0 );
 
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+        size_t parallelThreadCount = getThreadCount();
 
         for( size_t ii = 0; ii < parallelThreadCount; ++ii )
         {
@@ -894,7 +1128,7 @@ void RENDER_3D_RAYTRACE::postProcessBlurFinish( GLubyte* ptrPBO, REPORTER* /* aS
         std::atomic<size_t> nextBlock( 0 );
         std::atomic<size_t> threadsFinished( 0 );
 
-        size_t parallelThreadCount = std::max<size_t>( std::thread::hardware_concurrency(), 2 );
+        size_t parallelThreadCount = getThreadCount();
 
         for( size_t ii = 0; ii < parallelThreadCount; ++ii )
         {
@@ -950,9 +1184,8 @@ void RENDER_3D_RAYTRACE::renderPreview( GLubyte* ptrPBO )
     std::atomic<size_t> nextBlock( 0 );
     std::atomic<size_t> threadsFinished( 0 );
 
-    size_t parallelThreadCount = std::min<size_t>(
-            std::max<size_t>( std::thread::hardware_concurrency(), 2 ),
-            m_blockPositions.size() );
+    size_t parallelThreadCount = std::min<size_t>( getThreadCount(),
+                                                   m_blockPositions.size() );
 
     for( size_t ii = 0; ii < parallelThreadCount; ++ii )
     {
@@ -1131,10 +1364,11 @@ void RENDER_3D_RAYTRACE::renderPreview( GLubyte* ptrPBO )
                             hitInfoLRT.m_tHit = std::numeric_limits<float>::infinity();
 
                             if( hitPacket[iLT].m_hitresult && hitPacket[iRT].m_hitresult
-                                && ( hitPacket[iLT].m_HitInfo.pHitObject
-                                     == hitPacket[iRT].m_HitInfo.pHitObject ) )
+                                && OBJECT_3D::IsSameSurface( hitPacket[ iLT ].m_HitInfo,
+                                                             hitPacket[ iRT ].m_HitInfo ) )
                             {
                                 hitInfoLRT.pHitObject = hitPacket[ iLT ].m_HitInfo.pHitObject;
+                                hitInfoLRT.pHitSurface = hitPacket[ iLT ].m_HitInfo.pHitSurface;
                                 hitInfoLRT.m_tHit = ( hitPacket[ iLT ].m_HitInfo.m_tHit +
                                                       hitPacket[ iRT ].m_HitInfo.m_tHit ) * 0.5f;
                                 hitInfoLRT.m_HitNormal =
@@ -1202,10 +1436,11 @@ void RENDER_3D_RAYTRACE::renderPreview( GLubyte* ptrPBO )
                             hitInfoLTB.m_tHit = std::numeric_limits<float>::infinity();
 
                             if( hitPacket[ iLT ].m_hitresult && hitPacket[ iLB ].m_hitresult
-                              && ( hitPacket[ iLT ].m_HitInfo.pHitObject ==
-                                   hitPacket[ iLB ].m_HitInfo.pHitObject ) )
+                              && OBJECT_3D::IsSameSurface( hitPacket[ iLT ].m_HitInfo,
+                                                           hitPacket[ iLB ].m_HitInfo ) )
                             {
                                 hitInfoLTB.pHitObject = hitPacket[ iLT ].m_HitInfo.pHitObject;
+                                hitInfoLTB.pHitSurface = hitPacket[ iLT ].m_HitInfo.pHitSurface;
                                 hitInfoLTB.m_tHit = ( hitPacket[ iLT ].m_HitInfo.m_tHit +
                                                       hitPacket[ iLB ].m_HitInfo.m_tHit ) * 0.5f;
                                 hitInfoLTB.m_HitNormal =
@@ -1267,10 +1502,11 @@ void RENDER_3D_RAYTRACE::renderPreview( GLubyte* ptrPBO )
                         hitInfoRTB.m_tHit = std::numeric_limits<float>::infinity();
 
                         if( hitPacket[ iRT ].m_hitresult && hitPacket[ iRB ].m_hitresult
-                          && ( hitPacket[ iRT ].m_HitInfo.pHitObject ==
-                               hitPacket[ iRB ].m_HitInfo.pHitObject ) )
+                          && OBJECT_3D::IsSameSurface( hitPacket[ iRT ].m_HitInfo,
+                                                       hitPacket[ iRB ].m_HitInfo ) )
                         {
                             hitInfoRTB.pHitObject = hitPacket[ iRT ].m_HitInfo.pHitObject;
+                            hitInfoRTB.pHitSurface = hitPacket[ iRT ].m_HitInfo.pHitSurface;
 
                             hitInfoRTB.m_tHit = ( hitPacket[ iRT ].m_HitInfo.m_tHit +
                                                   hitPacket[ iRB ].m_HitInfo.m_tHit ) * 0.5f;
@@ -1336,10 +1572,11 @@ void RENDER_3D_RAYTRACE::renderPreview( GLubyte* ptrPBO )
                         hitInfoLRB.m_tHit = std::numeric_limits<float>::infinity();
 
                         if( hitPacket[iLB].m_hitresult && hitPacket[iRB].m_hitresult
-                            && ( hitPacket[iLB].m_HitInfo.pHitObject ==
-                                 hitPacket[iRB].m_HitInfo.pHitObject ) )
+                            && OBJECT_3D::IsSameSurface( hitPacket[ iLB ].m_HitInfo,
+                                                         hitPacket[ iRB ].m_HitInfo ) )
                         {
                             hitInfoLRB.pHitObject = hitPacket[ iLB ].m_HitInfo.pHitObject;
+                            hitInfoLRB.pHitSurface = hitPacket[ iLB ].m_HitInfo.pHitSurface;
 
                             hitInfoLRB.m_tHit = ( hitPacket[ iLB ].m_HitInfo.m_tHit +
                                                   hitPacket[ iRB ].m_HitInfo.m_tHit ) * 0.5f;
@@ -1543,7 +1780,9 @@ SFVEC3F RENDER_3D_RAYTRACE::shadeHit( const SFVEC3F& aBgColor, const RAY& aRay,
                                       bool aIsInsideObject, unsigned int aRecursiveLevel,
                                       bool is_testShadow ) const
 {
-    const MATERIAL* objMaterial = aHitInfo.pHitObject->GetMaterial();
+    // The material and transparency of a model instance are the ones of the model triangle hit
+    const OBJECT_3D* hitSurface = aHitInfo.pHitObject->GetHitSurface( aHitInfo );
+    const MATERIAL*  objMaterial = hitSurface->GetMaterial();
     wxASSERT( objMaterial != nullptr );
 
     SFVEC3F outColor = objMaterial->GetEmissiveColor() + objMaterial->GetAmbientColor();
@@ -1715,7 +1954,7 @@ SFVEC3F RENDER_3D_RAYTRACE::shadeHit( const SFVEC3F& aBgColor, const RAY& aRay,
         }
 
         // Refraction
-        const float objTransparency = aHitInfo.pHitObject->GetModelTransparency();
+        const float objTransparency = hitSurface->GetModelTransparency();
 
         if( ( objTransparency > 0.0f ) && m_boardAdapter.m_Cfg->m_Render.raytrace_refractions
           && ( aRecursiveLevel < objMaterial->GetRefractionRecursionCount() ) )
@@ -1924,6 +2163,52 @@ void RENDER_3D_RAYTRACE::initializeBlockPositions()
 }
 
 
+void RENDER_3D_RAYTRACE::initializeTiledBlockPositions( unsigned int aTileSize,
+                                                        std::vector<size_t>& aTileStart )
+{
+    // There is no preview border to leave out, the buffer covers the whole window
+    m_realBufferSize.x = ( m_windowSize.x + RAYPACKET_DIM - 1 ) & RAYPACKET_INVMASK;
+    m_realBufferSize.y = ( m_windowSize.y + RAYPACKET_DIM - 1 ) & RAYPACKET_INVMASK;
+
+    m_xoffset = 0;
+    m_yoffset = 0;
+
+    m_postShaderSsao.UpdateSize( m_realBufferSize );
+
+    const unsigned int tileSize = std::max<unsigned int>(
+            ( aTileSize + RAYPACKET_DIM - 1 ) & RAYPACKET_INVMASK, RAYPACKET_DIM );
+
+    m_blockPositions.clear();
+    m_blockPositions.reserve( ( m_realBufferSize.x / RAYPACKET_DIM )
+                              * ( m_realBufferSize.y / RAYPACKET_DIM ) );
+    aTileStart.clear();
+
+    for( unsigned int tileY = 0; tileY < m_realBufferSize.y; tileY += tileSize )
+    {
+        const unsigned int tileEndY = std::min( tileY + tileSize, m_realBufferSize.y );
+
+        for( unsigned int tileX = 0; tileX < m_realBufferSize.x; tileX += tileSize )
+        {
+            const unsigned int tileEndX = std::min( tileX + tileSize, m_realBufferSize.x );
+
+            aTileStart.push_back( m_blockPositions.size() );
+
+            for( unsigned int y = tileY; y < tileEndY; y += RAYPACKET_DIM )
+            {
+                for( unsigned int x = tileX; x < tileEndX; x += RAYPACKET_DIM )
+                    m_blockPositions.emplace_back( x, y );
+            }
+        }
+    }
+
+    aTileStart.push_back( m_blockPositions.size() );
+
+    // Create m_shader buffer
+    delete[] m_shaderBuffer;
+    m_shaderBuffer = new SFVEC3F[m_realBufferSize.x * m_realBufferSize.y];
+}
+
+
 BOARD_ITEM* RENDER_3D_RAYTRACE::IntersectBoardItem( const RAY& aRay )
 {
     HITINFO hitInfo;
@@ -35,6 +35,11 @@
 #include <plugins/3dapi/c3dmodel.h>
 
 #include <map>
+#include <tuple>
+
+class wxImage;
+
+class MODEL_MESH_3D;
 
 /// Vector of materials
 typedef std::vector< BLINN_PHONG_MATERIAL > MODEL_MATERIALS;
@@ -42,6 +47,12 @@ typedef std::vector< BLINN_PHONG_MATERIAL > MODEL_MATERIALS;
 /// Maps a S3DMODEL pointer with a created BLINN_PHONG_MATERIAL vector
 typedef std::map< const S3DMODEL* , MODEL_MATERIALS > MAP_MODEL_MATERIALS;
 
+/// A model along with the footprint opacity and mirroring its triangles are created for
+typedef std::tuple< const S3DMODEL*, float, bool > MODEL_MESH_KEY;
+
+/// Maps a model to the triangles and BVH shared by its instances
+typedef std::map< MODEL_MESH_KEY, MODEL_MESH_3D* > MAP_MODEL_MESHES;
+
 typedef enum
 {
     RT_RENDER_STATE_TRACING = 0,
@@ -52,6 +63,39 @@ typedef enum
 } RT_RENDER_STATE;
 
 
+/**
+ * Parameters of a render made without an OpenGL context, see RENDER_3D_RAYTRACE::RenderToImage.
+ */
+struct RT_OFFSCREEN_SETTINGS
+{
+    RT_OFFSCREEN_SETTINGS() :
+            m_Size( 1024, 768 ),
+            m_TileSize( 64 ),
+            m_ThreadCount( 0 )
+    {
+    }
+
+    wxSize       m_Size;           ///< Size of the rendered image in pixels.
+    unsigned int m_TileSize;       ///< Side in pixels of the square tiles handed to the threads.
+    unsigned int m_ThreadCount;    ///< Number of render threads, 0 to use all the cores.
+};
+
+
+/**
+ * Time spent in each phase of a render made without an OpenGL context, in microseconds.
+ */
+struct RT_RENDER_STATS
+{
+    unsigned m_LoadTime        = 0;
+    unsigned m_TracingTime     = 0;
+    unsigned m_ShadingTime     = 0;
+    unsigned m_BlurTime        = 0;
+    unsigned m_ImageTime       = 0;
+    unsigned m_SaveTime        = 0;
+    unsigned m_TotalTime       = 0;
+};
+
+
 class RENDER_3D_RAYTRACE : public RENDER_3D_BASE
 {
 public:
@@ -73,6 +117,33 @@ public:
 
     BOARD_ITEM *IntersectBoardItem( const RAY& aRay );
 
+    /**
+     * Render the board into a CPU frame buffer, without any OpenGL context.
+     *
+     * This runs the same tracing and post processing as the interactive render, but at the
+     * requested size and to completion.  The board is loaded first if a reload is pending.  The
+     * camera must be set up by the caller; its window size is changed to the image size.
+     *
+     * @param aSettings are the image size, tile size and thread count of the render.
+     * @param aImage is the rendered image.
+     * @param aStatusReporter receives the progress and the time spent in each phase.
+     * @param aWarningReporter receives the warnings of the board load.
+     * @param aStats receives the time spent in each phase, if not null.
+     * @return false if the image could not be rendered.
+     */
+    bool RenderToImage( const RT_OFFSCREEN_SETTINGS& aSettings, wxImage& aImage,
+                        REPORTER* aStatusReporter = nullptr,
+                        REPORTER* aWarningReporter = nullptr,
+                        RT_RENDER_STATS* aStats = nullptr );
+
+    /**
+     * Render the board as #RenderToImage does and save the result to a PNG file.
+     */
+    bool RenderToFile( const wxString& aFileName, const RT_OFFSCREEN_SETTINGS& aSettings,
+                       REPORTER* aStatusReporter = nullptr,
+                       REPORTER* aWarningReporter = nullptr,
+                       RT_RENDER_STATS* aStats = nullptr );
+
 private:
     bool initializeOpenGL();
     void initializeNewWindowSize();
@@ -87,6 +158,29 @@ private:
     void postProcessShading( GLubyte* ptrPBO, REPORTER* aStatusReporter );
     void postProcessBlurFinish( GLubyte* ptrPBO, REPORTER* aStatusReporter );
     void renderBlockTracing( GLubyte* ptrPBO , signed int iBlock );
+
+    /**
+     * Trace all the blocks, handing a tile of blocks at a time to each thread.
+     *
+     * @param aTileStart is the index of the first block of each tile, followed by the number
+     *                   of blocks.
+     */
+    void renderTiles( GLubyte* aBuffer, const std::vector<size_t>& aTileStart );
+
+    /**
+     * Set the blocks of an offscreen render of the current window size, grouped by tile.
+     */
+    void initializeTiledBlockPositions( unsigned int aTileSize, std::vector<size_t>& aTileStart );
+
+    bool renderOffscreen( const RT_OFFSCREEN_SETTINGS& aSettings, wxImage& aImage,
+                          REPORTER* aStatusReporter, REPORTER* aWarningReporter,
+                          RT_RENDER_STATS& aStats );
+
+    /**
+     * @return the number of threads used by each render phase.
+     */
+    size_t getThreadCount() const;
+
     void renderFinalColor( GLubyte* ptrPBO, const SFVEC3F& rgbColor,
                            bool applyColorSpaceConversion );
 
@@ -117,10 +211,22 @@ private:
     void insertHole( const PCB_VIA* aVia );
     void insertHole( const PAD* aPad );
     void load3DModels( CONTAINER_3D& aDstContainer, bool aSkipMaterialInformation );
+
+    /**
+     * Add an instance of a 3D model to the scene.
+     *
+     * The triangles of the model are created in model space and sorted in a BVH only once for
+     * all the instances of the model sharing the same opacity and mirroring.
+     */
     void addModels( CONTAINER_3D& aDstContainer, const S3DMODEL* a3DModel,
                     const glm::mat4& aModelMatrix, float aFPOpacity,
                     bool aSkipMaterialInformation, BOARD_ITEM* aBoardItem );
 
+    void addModelTriangles( MODEL_MESH_3D& aMesh, const S3DMODEL* a3DModel, float aFPOpacity,
+                            bool aMirrored, bool aSkipMaterialInformation );
+
+    void deleteModelMeshes();
+
     MODEL_MATERIALS* getModelMaterial( const S3DMODEL* a3DModel );
 
     void initializeBlockPositions();
@@ -198,6 +304,9 @@ private:
     SFVEC2UI m_realBufferSize;
     SFVEC2UI m_fastPreviewModeSize;
 
+    ///< Number of threads used to render, 0 to use all the cores.
+    unsigned int m_threadCount;
+
     HITINFO_PACKET* m_firstHitinfo;
 
     SFVEC3F* m_shaderBuffer;
@@ -209,6 +318,9 @@ private:
     /// Stores materials of the 3D models
     MAP_MODEL_MATERIALS m_modelMaterialMap;
 
+    /// Stores the triangles of the 3D models, shared by their instances
+    MAP_MODEL_MESHES m_modelMeshMap;
+
     // Statistics
     unsigned int m_convertedDummyBlockCount;
     unsigned int m_converted2dRoundSegmentCount;
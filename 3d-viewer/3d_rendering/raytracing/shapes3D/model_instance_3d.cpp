@@ -0,0 +1,128 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file model_instance_3d.cpp
+ */
+
+#include "model_instance_3d.h"
+#include "../accelerators/bvh_pbrt.h"
+
+
+MODEL_MESH_3D::MODEL_MESH_3D()
+{
+    m_accelerator = nullptr;
+}
+
+
+MODEL_MESH_3D::~MODEL_MESH_3D()
+{
+    delete m_accelerator;
+}
+
+
+void MODEL_MESH_3D::Build()
+{
+    delete m_accelerator;
+    m_accelerator = new BVH_PBRT( m_triangles, 8, SPLITMETHOD::MIDDLE );
+}
+
+
+MODEL_INSTANCE_3D::MODEL_INSTANCE_3D( const MODEL_MESH_3D* aMesh, const glm::mat4& aModelMatrix )
+        : OBJECT_3D( OBJECT_3D_TYPE::MODELINSTANCE )
+{
+    m_mesh = aMesh;
+    m_invMatrix = glm::inverse( aModelMatrix );
+    m_normalMatrix = glm::transpose( glm::inverse( glm::mat3( aModelMatrix ) ) );
+
+    // World bounding box of the transformed model bounding box
+    const BBOX_3D& bbox = aMesh->GetBBox();
+
+    m_bbox.Reset();
+
+    for( unsigned int i = 0; i < 8; ++i )
+    {
+        const SFVEC3F corner( ( i & 1 ) ? bbox.Max().x : bbox.Min().x,
+                              ( i & 2 ) ? bbox.Max().y : bbox.Min().y,
+                              ( i & 4 ) ? bbox.Max().z : bbox.Min().z );
+
+        m_bbox.Union( SFVEC3F( aModelMatrix * glm::vec4( corner, 1.0f ) ) );
+    }
+
+    m_bbox.ScaleNextUp();
+    m_centroid = m_bbox.GetCenter();
+}
+
+
+void MODEL_INSTANCE_3D::toModelSpace( const RAY& aRay, RAY& aModelRay ) const
+{
+    aModelRay.Init( SFVEC3F( m_invMatrix * glm::vec4( aRay.m_Origin, 1.0f ) ),
+                    SFVEC3F( m_invMatrix * glm::vec4( aRay.m_Dir, 0.0f ) ) );
+}
+
+
+bool MODEL_INSTANCE_3D::Intersect( const RAY& aRay, HITINFO& aHitInfo ) const
+{
+    RAY modelRay;
+    toModelSpace( aRay, modelRay );
+
+    HITINFO modelHitInfo;
+    modelHitInfo.m_tHit = aHitInfo.m_tHit;
+
+    if( !m_mesh->GetAccelerator()->Intersect( modelRay, modelHitInfo ) )
+        return false;
+
+    aHitInfo.m_tHit = modelHitInfo.m_tHit;
+    aHitInfo.m_HitPoint = aRay.at( modelHitInfo.m_tHit );
+    aHitInfo.m_HitNormal = glm::normalize( m_normalMatrix * modelHitInfo.m_HitNormal );
+    aHitInfo.m_UV = modelHitInfo.m_UV;
+    aHitInfo.pHitObject = this;
+    aHitInfo.pHitSurface = modelHitInfo.pHitObject;
+
+    // The material generators work in world space, so they are applied once the hit has been
+    // transformed rather than by the triangles of the model.
+    aHitInfo.pHitSurface->GetMaterial()->Generate( aHitInfo.m_HitNormal, aRay, aHitInfo );
+
+    return true;
+}
+
+
+bool MODEL_INSTANCE_3D::IntersectP( const RAY& aRay, float aMaxDistance ) const
+{
+    RAY modelRay;
+    toModelSpace( aRay, modelRay );
+
+    return m_mesh->GetAccelerator()->IntersectP( modelRay, aMaxDistance );
+}
+
+
+bool MODEL_INSTANCE_3D::Intersects( const BBOX_3D& aBBox ) const
+{
+    return m_bbox.Intersects( aBBox );
+}
+
+
+SFVEC3F MODEL_INSTANCE_3D::GetDiffuseColor( const HITINFO& aHitInfo ) const
+{
+    return aHitInfo.pHitSurface->GetDiffuseColor( aHitInfo );
+}
@@ -0,0 +1,109 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file model_instance_3d.h
+ */
+
+#ifndef _MODEL_INSTANCE_3D_H_
+#define _MODEL_INSTANCE_3D_H_
+
+#include "object_3d.h"
+#include "../accelerators/container_3d.h"
+
+class ACCELERATOR_3D;
+
+
+/**
+ * The triangles of a 3D model in model space, along with the BVH built over them.
+ *
+ * It is shared by all the MODEL_INSTANCE_3D objects placing the model in the scene, so the
+ * triangles of a model are only created and sorted once however many footprints use it.
+ */
+class MODEL_MESH_3D
+{
+public:
+    MODEL_MESH_3D();
+    ~MODEL_MESH_3D();
+
+    /**
+     * Add a triangle in model space; the mesh takes ownership of it.
+     */
+    void Add( OBJECT_3D* aTriangle ) { m_triangles.Add( aTriangle ); }
+
+    /**
+     * Build the BVH of the mesh, once all its triangles have been added.
+     */
+    void Build();
+
+    bool IsEmpty() const { return m_triangles.GetList().empty(); }
+
+    const BBOX_3D& GetBBox() const { return m_triangles.GetBBox(); }
+
+    const ACCELERATOR_3D* GetAccelerator() const { return m_accelerator; }
+
+private:
+    CONTAINER_3D    m_triangles;
+    ACCELERATOR_3D* m_accelerator;
+};
+
+
+/**
+ * A 3D model placed in the scene by a transformation matrix.
+ *
+ * Rays are transformed to model space and traced through the BVH of the shared MODEL_MESH_3D.
+ * The direction of the transformed ray is not normalized, so the distance to a hit is the same
+ * in model and world space.
+ *
+ * The hit object reported for a ray is the instance, so the board item of the footprint can be
+ * retrieved from it; the triangle of the model that was hit is reported in
+ * HITINFO::pHitSurface and gives the material and color at the hit point.
+ */
+class MODEL_INSTANCE_3D : public OBJECT_3D
+{
+public:
+    /**
+     * @param aMesh is the mesh of the model, which must outlive the instance.
+     * @param aModelMatrix transforms the model to world space.
+     */
+    MODEL_INSTANCE_3D( const MODEL_MESH_3D* aMesh, const glm::mat4& aModelMatrix );
+
+    bool Intersect( const RAY& aRay, HITINFO& aHitInfo ) const override;
+    bool IntersectP( const RAY& aRay, float aMaxDistance ) const override;
+    bool Intersects( const BBOX_3D& aBBox ) const override;
+    SFVEC3F GetDiffuseColor( const HITINFO& aHitInfo ) const override;
+
+    const OBJECT_3D* GetHitSurface( const HITINFO& aHitInfo ) const override
+    {
+        return aHitInfo.pHitSurface;
+    }
+
+private:
+    void toModelSpace( const RAY& aRay, RAY& aModelRay ) const;
+
+    const MODEL_MESH_3D* m_mesh;
+    glm::mat4            m_invMatrix;
+    glm::mat3            m_normalMatrix;
+};
+
+#endif // _MODEL_INSTANCE_3D_H_
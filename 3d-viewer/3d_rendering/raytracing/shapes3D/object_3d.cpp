@@ -59,7 +59,8 @@ const std::map<OBJECT_3D_TYPE, const char*> objectTypeNames
     { OBJECT_3D_TYPE::LAYERITEM,  "OBJECT_3D_TYPE::LAYER_ITEM" },
     { OBJECT_3D_TYPE::XYPLANE,    "OBJECT_3D_TYPE::XY_PLANE" },
     { OBJECT_3D_TYPE::ROUNDSEG,   "OBJECT_3D_TYPE::ROUND_SEG" },
-    { OBJECT_3D_TYPE::TRIANGLE,   "OBJECT_3D_TYPE::TRIANGLE" }
+    { OBJECT_3D_TYPE::TRIANGLE,   "OBJECT_3D_TYPE::TRIANGLE" },
+    { OBJECT_3D_TYPE::MODELINSTANCE, "OBJECT_3D_TYPE::MODEL_INSTANCE" }
 };
 // clang-format on
 
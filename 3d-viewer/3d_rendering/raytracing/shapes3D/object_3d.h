@@ -43,6 +43,7 @@ enum class OBJECT_3D_TYPE
     XYPLANE,
     ROUNDSEG,
     TRIANGLE,
+    MODELINSTANCE,
     MAX
 };
 
@@ -61,6 +62,8 @@ public:
         m_modelTransparency = aMaterial->GetTransparency(); // Default transparency is from material
     }
 
+    OBJECT_3D_TYPE GetObjectType() const { return m_obj_type; }
+
     const MATERIAL* GetMaterial() const { return m_material; }
     float GetModelTransparency() const { return m_modelTransparency; }
     void SetModelTransparency( float aModelTransparency )
@@ -70,6 +73,24 @@ public:
 
     virtual SFVEC3F GetDiffuseColor( const HITINFO& aHitInfo ) const = 0;
 
+    /**
+     * @return the object whose material and model transparency apply to the hit described by
+     *         \a aHitInfo; this is the object itself except for objects made of other objects.
+     */
+    virtual const OBJECT_3D* GetHitSurface( const HITINFO& aHitInfo ) const { return this; }
+
+    /**
+     * @return true if \a aHitA and \a aHitB are on the same surface, so the shading between them
+     *         can be interpolated; the triangles of a model instance are different surfaces of
+     *         the same hit object.
+     */
+    static bool IsSameSurface( const HITINFO& aHitA, const HITINFO& aHitB )
+    {
+        return aHitA.pHitObject == aHitB.pHitObject
+               && aHitA.pHitObject->GetHitSurface( aHitA )
+                          == aHitB.pHitObject->GetHitSurface( aHitB );
+    }
+
     virtual ~OBJECT_3D() {}
 
     /**
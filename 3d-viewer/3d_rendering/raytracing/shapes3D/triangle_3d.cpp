@@ -200,6 +200,17 @@ static const unsigned int s_modulo[] = { 0, 1, 2, 0, 1 };
 
 
 bool TRIANGLE::Intersect( const RAY& aRay, HITINFO& aHitInfo ) const
+{
+    if( !intersectSurface( aRay, aHitInfo ) )
+        return false;
+
+    m_material->Generate( aHitInfo.m_HitNormal, aRay, aHitInfo );
+
+    return true;
+}
+
+
+bool TRIANGLE::intersectSurface( const RAY& aRay, HITINFO& aHitInfo ) const
 {
     //!TODO: precalc this, improve it
 #define ku s_modulo[m_k + 1]
@@ -243,8 +254,6 @@ bool TRIANGLE::Intersect( const RAY& aRay, HITINFO& aHitInfo ) const
     aHitInfo.m_HitNormal =
             glm::normalize( ( 1.0f - u - v ) * m_normal[0] + u * m_normal[1] + v * m_normal[2] );
 
-    m_material->Generate( aHitInfo.m_HitNormal, aRay, aHitInfo );
-
     aHitInfo.pHitObject = this;
 
     return true;
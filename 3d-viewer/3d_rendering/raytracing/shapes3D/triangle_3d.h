@@ -61,11 +61,19 @@ public:
 
     void SetUV( const SFVEC2F& aUV1, const SFVEC2F& aUV2, const SFVEC2F& aUV3 );
 
+    const SFVEC3F& GetVertex( unsigned int aIndex ) const { return m_vertex[aIndex]; }
+
     bool Intersect( const RAY& aRay, HITINFO& aHitInfo ) const override;
     bool IntersectP(const RAY& aRay, float aMaxDistance ) const override;
     bool Intersects( const BBOX_3D& aBBox ) const override;
     SFVEC3F GetDiffuseColor( const HITINFO& aHitInfo ) const override;
 
+protected:
+    /**
+     * Intersect the ray with the triangle without applying the material normal generator.
+     */
+    bool intersectSurface( const RAY& aRay, HITINFO& aHitInfo ) const;
+
 private:
     void pre_calc_const();
 
@@ -81,4 +89,22 @@ private:
                                         // 152 bytes (max 160 == 5 * 32)
 };
 
+
+/**
+ * A triangle of a 3D model in model space, shared by the instances of the model.
+ *
+ * The material normal generators work in world space, so they are not applied here but by the
+ * MODEL_INSTANCE_3D that transformed the ray.
+ */
+class MODEL_TRIANGLE : public TRIANGLE
+{
+public:
+    using TRIANGLE::TRIANGLE;
+
+    bool Intersect( const RAY& aRay, HITINFO& aHitInfo ) const override
+    {
+        return intersectSurface( aRay, aHitInfo );
+    }
+};
+
 #endif // _TRIANGLE_H_
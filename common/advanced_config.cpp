@@ -95,6 +95,12 @@ static const wxChar HoleWallThickness[] = wxT( "HoleWallPlatingThickness" );
  */
 static const wxChar RealtimeConnectivity[] = wxT( "RealtimeConnectivity" );
 
+/**
+ * When off, every connectivity update in the schematic editor recomputes the item connections
+ * of all sheets instead of only the sheets which changed.
+ */
+static const wxChar ReuseSheetConnectivity[] = wxT( "ReuseSheetConnectivity" );
+
 /**
  * Configure the coroutine stack size in bytes.  This should be allocated in multiples of
  * the system page size (n*4096 is generally safe)
@@ -179,6 +185,8 @@ static const wxChar Skip3DModelFileCache[] = wxT( "Skip3DModelFileCache" );
 
 static const wxChar Skip3DModelMemoryCache[] = wxT( "Skip3DModelMemoryCache" );
 
+static const wxChar SymbolLibraryCache[] = wxT( "SymbolLibraryCache" );
+
 static const wxChar HideVersionFromTitle[] = wxT( "HideVersionFromTitle" );
 
 static const wxChar TraceMasks[] = wxT( "TraceMasks" );
@@ -270,6 +278,7 @@ ADVANCED_CFG::ADVANCED_CFG()
     // Init defaults - this is done in case the config doesn't exist,
     // then the values will remain as set here.
     m_RealTimeConnectivity      = true;
+    m_ReuseSheetConnectivity    = true;
     m_CoroutineStackSize        = AC_STACK::default_stack;
     m_ShowRouterDebugGraphics   = false;
     m_DrawArcAccuracy           = 10.0;
@@ -299,6 +308,7 @@ ADVANCED_CFG::ADVANCED_CFG()
     m_ShowPcbnewExportNetlist   = false;
     m_Skip3DModelFileCache      = false;
     m_Skip3DModelMemoryCache    = false;
+    m_SymbolLibraryCache        = false;
     m_HideVersionFromTitle      = false;
     m_ShowEventCounters         = false;
     m_AllowManualCanvasScale    = false;
@@ -352,6 +362,10 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::RealtimeConnectivity,
                                                 &m_RealTimeConnectivity, m_RealTimeConnectivity ) );
 
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::ReuseSheetConnectivity,
+                                                &m_ReuseSheetConnectivity,
+                                                m_ReuseSheetConnectivity ) );
+
     configParams.push_back( new PARAM_CFG_DOUBLE( true, AC_KEYS::ExtraFillMargin,
                                                   &m_ExtraClearance, m_ExtraClearance, 0.0, 1.0 ) );
 
@@ -425,6 +439,9 @@ void ADVANCED_CFG::loadSettings( wxConfigBase& aCfg )
     configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::Skip3DModelMemoryCache,
                                                 &m_Skip3DModelMemoryCache, m_Skip3DModelMemoryCache ) );
 
+    configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::SymbolLibraryCache,
+                                                &m_SymbolLibraryCache, m_SymbolLibraryCache ) );
+
     configParams.push_back( new PARAM_CFG_BOOL( true, AC_KEYS::HideVersionFromTitle,
                                                 &m_HideVersionFromTitle, m_HideVersionFromTitle ) );
 
@@ -310,6 +310,10 @@ void EDA_DRAW_PANEL_GAL::DoRePaint()
 
     m_lastRefresh = wxGetLocalTimeMillis();
     m_drawing = false;
+
+    // Come back for the simplified items that were missing from this frame
+    if( m_view->HasPendingLodUpdates() && !m_refreshTimer.IsRunning() )
+        m_refreshTimer.StartOnce( MinRefreshPeriod );
 }
 
 
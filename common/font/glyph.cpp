@@ -116,10 +116,82 @@ BOX2D OUTLINE_GLYPH::BoundingBox()
 }
 
 
+void OUTLINE_GLYPH::SetDrawSource( std::shared_ptr<const OUTLINE_GLYPH> aSource,
+                                   const VECTOR2D& aOffset, bool aMirror,
+                                   const EDA_ANGLE& aAngle, const VECTOR2I& aOrigin )
+{
+    auto transform =
+            [&]( VECTOR2D aPt ) -> VECTOR2D
+            {
+                aPt += aOffset;
+
+                if( aMirror )
+                    aPt.x = aOrigin.x - ( aPt.x - aOrigin.x );
+
+                if( !aAngle.IsZero() )
+                    RotatePoint( aPt, aOrigin, aAngle );
+
+                return aPt;
+            };
+
+    m_drawSource = std::move( aSource );
+    m_drawOffset = transform( VECTOR2D( 0, 0 ) );
+    m_drawAxisX = transform( VECTOR2D( 1, 0 ) ) - m_drawOffset;
+    m_drawAxisY = transform( VECTOR2D( 0, 1 ) ) - m_drawOffset;
+}
+
+
+void OUTLINE_GLYPH::Move( const VECTOR2I& aVector )
+{
+    SHAPE_POLY_SET::Move( aVector );
+    m_drawOffset += aVector;
+}
+
+
+void OUTLINE_GLYPH::Rotate( const EDA_ANGLE& aAngle, const VECTOR2I& aCenter )
+{
+    SHAPE_POLY_SET::Rotate( aAngle, aCenter );
+    m_drawSource.reset();
+}
+
+
+void OUTLINE_GLYPH::Mirror( bool aX, bool aY, const VECTOR2I& aRef )
+{
+    SHAPE_POLY_SET::Mirror( aX, aY, aRef );
+    m_drawSource.reset();
+}
+
+
 void OUTLINE_GLYPH::Triangulate( std::function<void( const VECTOR2I& aPt1,
                                                      const VECTOR2I& aPt2,
                                                      const VECTOR2I& aPt3 )> aCallback ) const
 {
+    if( m_drawSource )
+    {
+        auto transform =
+                [&]( const VECTOR2I& aPt ) -> VECTOR2I
+                {
+                    return VECTOR2I( m_drawOffset + m_drawAxisX * double( aPt.x )
+                                     + m_drawAxisY * double( aPt.y ) );
+                };
+
+        // The shared glyph was triangulated before being shared, and is never changed again
+        for( unsigned int i = 0; i < m_drawSource->TriangulatedPolyCount(); i++ )
+        {
+            const SHAPE_POLY_SET::TRIANGULATED_POLYGON* polygon =
+                    m_drawSource->TriangulatedPolygon( i );
+
+            for( size_t j = 0; j < polygon->GetTriangleCount(); j++ )
+            {
+                VECTOR2I a, b, c;
+                polygon->GetTriangle( j, a, b, c );
+                aCallback( transform( a ), transform( b ), transform( c ) );
+            }
+        }
+
+        return;
+    }
+
     const_cast<OUTLINE_GLYPH*>( this )->CacheTriangulation( false );
 
     for( unsigned int i = 0; i < TriangulatedPolyCount(); i++ )
@@ -25,6 +25,9 @@
  */
 
 #include <limits>
+#include <map>
+#include <mutex>
+#include <tuple>
 #include <pgm_base.h>
 #include <settings/settings_manager.h>
 #include <harfbuzz/hb.h>
@@ -285,6 +288,127 @@ VECTOR2I OUTLINE_FONT::GetTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_pt
 }
 
 
+/**
+ * Glyphs already converted from their FreeType outlines, shared by all the texts using the
+ * same font, glyph, size and style.
+ */
+typedef std::tuple<const OUTLINE_FONT*, unsigned int, int, int, TEXT_STYLE_FLAGS> GLYPH_CACHE_KEY;
+
+static std::mutex                                                           s_glyphCacheLock;
+static std::map<GLYPH_CACHE_KEY, std::shared_ptr<const OUTLINE_FONT::CACHED_GLYPH>> s_glyphCache;
+
+
+std::shared_ptr<const OUTLINE_FONT::CACHED_GLYPH>
+OUTLINE_FONT::getGlyph( unsigned int aGlyphIndex, const VECTOR2I& aSize,
+                        const VECTOR2D& aScaleFactor, TEXT_STYLE_FLAGS aTextStyle ) const
+{
+    // Bounds the cache for (unlikely) uses of many different sizes
+    const size_t GLYPH_CACHE_MAX_SIZE = 100000;
+
+    // Only the styles that change the glyph shapes
+    TEXT_STYLE_FLAGS style = aTextStyle & ( TEXT_STYLE::SUBSCRIPT | TEXT_STYLE::SUPERSCRIPT );
+    GLYPH_CACHE_KEY  key( this, aGlyphIndex, aSize.x, aSize.y, style );
+
+    {
+        std::lock_guard<std::mutex> lock( s_glyphCacheLock );
+        auto                        it = s_glyphCache.find( key );
+
+        if( it != s_glyphCache.end() )
+            return it->second;
+    }
+
+    FT_Face face = m_face;
+    double  scaler = faceSize();
+
+    if( IsSubscript( aTextStyle ) || IsSuperscript( aTextStyle ) )
+        scaler = subscriptSize();
+
+    FT_Load_Glyph( face, aGlyphIndex, FT_LOAD_NO_BITMAP );
+
+    std::shared_ptr<CACHED_GLYPH> cached = std::make_shared<CACHED_GLYPH>();
+
+    // m_Contours is a collection of all outlines in the glyph; for example the 'o' glyph
+    // generally contains 2 contours, one for the glyph outline and one for the hole
+    OUTLINE_DECOMPOSER decomposer( face->glyph->outline );
+    decomposer.OutlineToSegments( &cached->m_Contours );
+
+    const CONTOURS&                contours = cached->m_Contours;
+    std::shared_ptr<OUTLINE_GLYPH> glyph = std::make_shared<OUTLINE_GLYPH>();
+    std::vector<SHAPE_LINE_CHAIN>  holes;
+    std::vector<size_t>            holeContours;
+
+    for( size_t ci = 0; ci < contours.size(); ++ci )
+    {
+        SHAPE_LINE_CHAIN shape;
+
+        for( const VECTOR2D& v : contours[ci].points )
+        {
+            VECTOR2D pt( v );
+
+            if( IsSubscript( aTextStyle ) )
+                pt.y += m_subscriptVerticalOffset * scaler;
+            else if( IsSuperscript( aTextStyle ) )
+                pt.y += m_superscriptVerticalOffset * scaler;
+
+            pt *= aScaleFactor;
+
+            shape.Append( KiROUND( pt.x ), KiROUND( pt.y ) );
+        }
+
+        shape.SetClosed( true );
+
+        if( contourIsHole( contours[ci] ) )
+        {
+            holes.push_back( std::move( shape ) );
+            holeContours.push_back( ci );
+        }
+        else
+        {
+            glyph->AddOutline( std::move( shape ) );
+        }
+    }
+
+    // The outline each hole is in is found here once, rather than for each text
+    cached->m_HoleOwners.assign( contours.size(), -1 );
+
+    for( size_t hi = 0; hi < holes.size(); ++hi )
+    {
+        SHAPE_LINE_CHAIN& hole = holes[hi];
+
+        if( hole.PointCount() )
+        {
+            for( int ii = 0; ii < glyph->OutlineCount(); ++ii )
+            {
+                if( glyph->Outline( ii ).PointInside( hole.GetPoint( 0 ) ) )
+                {
+                    cached->m_HoleOwners[holeContours[hi]] = ii;
+                    glyph->AddHole( std::move( hole ), ii );
+                    break;
+                }
+            }
+        }
+    }
+
+    // FONT TODO we might not want to do Fracture() here;
+    // knockout text (eg. silkscreen labels with a background) will
+    // need to do that after the contours have been turned into holes
+    // and vice versa
+    if( glyph->HasHoles() )
+        glyph->Fracture( SHAPE_POLY_SET::PM_FAST ); // FONT TODO verify aFastMode
+
+    // Triangulated once here; the texts draw it transformed into place
+    glyph->CacheTriangulation( false );
+    cached->m_Shape = glyph;
+
+    std::lock_guard<std::mutex> lock( s_glyphCacheLock );
+
+    if( s_glyphCache.size() >= GLYPH_CACHE_MAX_SIZE )
+        s_glyphCache.clear();
+
+    return s_glyphCache.emplace( key, cached ).first->second;
+}
+
+
 VECTOR2I OUTLINE_FONT::getTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_ptr<GLYPH>>* aGlyphs,
                                         const wxString& aText, const VECTOR2I& aSize,
                                         const VECTOR2I& aPosition, const EDA_ANGLE& aAngle,
@@ -300,6 +424,9 @@ VECTOR2I OUTLINE_FONT::getTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_pt
         scaler = subscriptSize();
     }
 
+    // The face is shared by all the threads building texts in this font
+    std::unique_lock<std::mutex> faceLock( m_faceLock );
+
     // set glyph resolution so that FT_Load_Glyph() results are good enough for decomposing
     FT_Set_Char_Size( face, 0, scaler, GLYPH_RESOLUTION, 0 );
 
@@ -329,24 +456,21 @@ VECTOR2I OUTLINE_FONT::getTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_pt
 
         if( aGlyphs )
         {
-            FT_Load_Glyph( face, glyphInfo[i].codepoint, FT_LOAD_NO_BITMAP );
-
-            // contours is a collection of all outlines in the glyph; for example the 'o' glyph
-            // generally contains 2 contours, one for the glyph outline and one for the hole
-            CONTOURS contours;
-
-            OUTLINE_DECOMPOSER decomposer( face->glyph->outline );
-            decomposer.OutlineToSegments( &contours );
+            std::shared_ptr<const CACHED_GLYPH> cached = getGlyph( glyphInfo[i].codepoint, aSize,
+                                                                   scaleFactor, aTextStyle );
+            const CONTOURS&                     contours = cached->m_Contours;
 
             std::unique_ptr<OUTLINE_GLYPH> glyph = std::make_unique<OUTLINE_GLYPH>();
-            std::vector<SHAPE_LINE_CHAIN>  holes;
+            std::vector<SHAPE_LINE_CHAIN>  holes( contours.size() );
 
-            for( CONTOUR& c : contours )
+            // The text keeps its own outlines, for hit testing, plotting and so on, transformed
+            // from the decomposed contours as they always were.  Only drawing uses the shared
+            // triangulated glyph.
+            for( size_t ci = 0; ci < contours.size(); ++ci )
             {
-                GLYPH_POINTS     points = c.points;
                 SHAPE_LINE_CHAIN shape;
 
-                for( const VECTOR2D& v : points )
+                for( const VECTOR2D& v : contours[ci].points )
                 {
                     VECTOR2D pt( v + cursor );
 
@@ -369,34 +493,26 @@ VECTOR2I OUTLINE_FONT::getTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_pt
 
                 shape.SetClosed( true );
 
-                if( contourIsHole( c ) )
-                    holes.push_back( std::move( shape ) );
+                if( contourIsHole( contours[ci] ) )
+                    holes[ci] = std::move( shape );
                 else
                     glyph->AddOutline( std::move( shape ) );
             }
 
-            for( SHAPE_LINE_CHAIN& hole : holes )
+            for( size_t ci = 0; ci < contours.size(); ++ci )
             {
-                if( hole.PointCount() )
-                {
-                    for( int ii = 0; ii < glyph->OutlineCount(); ++ii )
-                    {
-                        if( glyph->Outline( ii ).PointInside( hole.GetPoint( 0 ) ) )
-                        {
-                            glyph->AddHole( std::move( hole ), ii );
-                            break;
-                        }
-                    }
-                }
+                if( cached->m_HoleOwners[ci] >= 0 )
+                    glyph->AddHole( std::move( holes[ci] ), cached->m_HoleOwners[ci] );
             }
 
-            // FONT TODO we might not want to do Fracture() here;
-            // knockout text (eg. silkscreen labels with a background) will
-            // need to do that after the contours have been turned into holes
-            // and vice versa
             if( glyph->HasHoles() )
                 glyph->Fracture( SHAPE_POLY_SET::PM_FAST ); // FONT TODO verify aFastMode
 
+            VECTOR2D offset( cursor.x * scaleFactor.x + aPosition.x,
+                             cursor.y * scaleFactor.y + aPosition.y );
+
+            glyph->SetDrawSource( cached->m_Shape, offset, aMirror, aAngle, aOrigin );
+
             aGlyphs->push_back( std::move( glyph ) );
         }
 
@@ -407,6 +523,9 @@ VECTOR2I OUTLINE_FONT::getTextAsGlyphs( BOX2I* aBBox, std::vector<std::unique_pt
 
     int      ascender = abs( face->size->metrics.ascender * GLYPH_SIZE_SCALER );
     int      descender = abs( face->size->metrics.descender * GLYPH_SIZE_SCALER );
+
+    faceLock.unlock();
+
     VECTOR2I extents( cursor.x * scaleFactor.x, ( ascender + descender ) * abs( scaleFactor.y ) );
 
     // Font metrics don't include all descenders and diacriticals, so beef them up just a little.
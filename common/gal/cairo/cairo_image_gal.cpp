@@ -0,0 +1,73 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gal/cairo/cairo_image_gal.h>
+
+#include <algorithm>
+
+using namespace KIGFX;
+
+
+CAIRO_IMAGE_GAL::CAIRO_IMAGE_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, const VECTOR2I& aSize ) :
+        CAIRO_GAL_BASE( aDisplayOptions )
+{
+    m_screenSize = aSize;
+    createSurface();
+}
+
+
+void CAIRO_IMAGE_GAL::ResizeScreen( int aWidth, int aHeight )
+{
+    CAIRO_GAL_BASE::ResizeScreen( aWidth, aHeight );
+    createSurface();
+}
+
+
+const unsigned char* CAIRO_IMAGE_GAL::GetImageData()
+{
+    cairo_surface_flush( m_surface );
+    return cairo_image_surface_get_data( m_surface );
+}
+
+
+int CAIRO_IMAGE_GAL::GetStride() const
+{
+    return cairo_image_surface_get_stride( m_surface );
+}
+
+
+bool CAIRO_IMAGE_GAL::SaveAsPng( const std::string& aFileName )
+{
+    cairo_surface_flush( m_surface );
+    return cairo_surface_write_to_png( m_surface, aFileName.c_str() ) == CAIRO_STATUS_SUCCESS;
+}
+
+
+void CAIRO_IMAGE_GAL::createSurface()
+{
+    if( m_context )
+        cairo_destroy( m_context );
+
+    if( m_surface )
+        cairo_surface_destroy( m_surface );
+
+    m_surface = cairo_image_surface_create( CAIRO_FORMAT_ARGB32, std::max( m_screenSize.x, 1 ),
+                                            std::max( m_screenSize.y, 1 ) );
+    m_context = m_currentContext = cairo_create( m_surface );
+}
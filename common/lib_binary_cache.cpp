@@ -0,0 +1,190 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cstring>
+
+#include <wx/ffile.h>
+
+#include <build_version.h>
+#include <lib_binary_cache.h>
+#include <paths.h>
+#include <sha1_hash.h>
+
+
+void BINARY_CACHE_WRITER::Color( const KIGFX::COLOR4D& aColor )
+{
+    Double( aColor.r );
+    Double( aColor.g );
+    Double( aColor.b );
+    Double( aColor.a );
+}
+
+
+void BINARY_CACHE_WRITER::String( const wxString& aString )
+{
+    const wxScopedCharBuffer utf8 = aString.utf8_str();
+
+    Int( (int32_t) utf8.length() );
+    Raw( utf8.data(), utf8.length() );
+}
+
+
+void BINARY_CACHE_WRITER::Header( const char* aMagic, uint32_t aFormatVersion )
+{
+    Raw( aMagic, 8 );
+    Int( (int32_t) aFormatVersion );
+    String( GetBuildVersion() );
+}
+
+
+bool BINARY_CACHE_READER::Raw( void* aData, size_t aLength )
+{
+    if( !m_ok || aLength > m_buffer.size() - m_pos )
+    {
+        memset( aData, 0, aLength );
+        m_ok = false;
+        return false;
+    }
+
+    memcpy( aData, m_buffer.data() + m_pos, aLength );
+    m_pos += aLength;
+    return true;
+}
+
+
+KIGFX::COLOR4D BINARY_CACHE_READER::Color()
+{
+    KIGFX::COLOR4D color;
+
+    color.r = Double();
+    color.g = Double();
+    color.b = Double();
+    color.a = Double();
+
+    return color;
+}
+
+
+wxString BINARY_CACHE_READER::String()
+{
+    size_t length = Count();
+
+    if( !m_ok )
+        return wxEmptyString;
+
+    wxString str = wxString::FromUTF8( m_buffer.data() + m_pos, length );
+    m_pos += length;
+    return str;
+}
+
+
+size_t BINARY_CACHE_READER::Count()
+{
+    int32_t count = Int();
+
+    if( count < 0 || (size_t) count > m_buffer.size() - m_pos )
+    {
+        m_ok = false;
+        return 0;
+    }
+
+    return (size_t) count;
+}
+
+
+bool BINARY_CACHE_READER::Header( const char* aMagic, uint32_t aFormatVersion )
+{
+    char magic[8];
+
+    Raw( magic, sizeof( magic ) );
+    uint32_t version = (uint32_t) Int();
+    wxString buildVersion = String();
+
+    return m_ok && memcmp( magic, aMagic, sizeof( magic ) ) == 0 && version == aFormatVersion
+           && buildVersion == GetBuildVersion();
+}
+
+
+LIB_BINARY_CACHE_FILE::LIB_BINARY_CACHE_FILE( const wxString& aKind,
+                                              const wxString& aLibraryPath,
+                                              const wxString& aCacheDir )
+{
+    const wxScopedCharBuffer path = aLibraryPath.utf8_str();
+    SHA1_HASH                pathHash;
+    unsigned char            digest[SHA1_HASH::DIGEST_SIZE];
+    wxString                 name;
+
+    pathHash.Update( path.data(), path.length() );
+    pathHash.GetDigest( digest );
+
+    for( unsigned char c : digest )
+        name << wxString::Format( wxT( "%02x" ), c );
+
+    m_file.AssignDir( aCacheDir.IsEmpty() ? PATHS::GetUserCachePath() : aCacheDir );
+    m_file.AppendDir( aKind );
+    m_file.SetName( name );
+    m_file.SetExt( wxT( "bin" ) );
+}
+
+
+bool LIB_BINARY_CACHE_FILE::Read( std::string& aBuffer ) const
+{
+    if( !m_file.FileExists() )
+        return false;
+
+    wxFFile file( m_file.GetFullPath(), wxT( "rb" ) );
+
+    if( !file.IsOpened() )
+        return false;
+
+    aBuffer.resize( file.Length() );
+
+    return aBuffer.empty() || file.Read( &aBuffer[0], aBuffer.size() ) == aBuffer.size();
+}
+
+
+void LIB_BINARY_CACHE_FILE::Write( const std::string& aBuffer ) const
+{
+    if( !m_file.DirExists() && !m_file.Mkdir( wxS_DIR_DEFAULT, wxPATH_MKDIR_FULL ) )
+        return;
+
+    wxString tmpPath = wxFileName::CreateTempFileName( m_file.GetPathWithSep()
+                                                       + m_file.GetName() );
+
+    if( tmpPath.IsEmpty() )
+        return;
+
+    {
+        wxFFile file( tmpPath, wxT( "wb" ) );
+
+        if( !file.IsOpened() || file.Write( aBuffer.data(), aBuffer.size() ) != aBuffer.size() )
+        {
+            file.Close();
+            wxRemoveFile( tmpPath );
+            return;
+        }
+    }
+
+    if( !wxRenameFile( tmpPath, m_file.GetFullPath(), true ) )
+        wxRemoveFile( tmpPath );
+}
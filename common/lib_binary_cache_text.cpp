@@ -0,0 +1,86 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * The EDA_TEXT part of the library cache format.  It is built with each kiface rather than with
+ * the common library, as EDA_TEXT depends on the internal units of the kiface.
+ */
+
+#include <eda_text.h>
+#include <font/font.h>
+#include <lib_binary_cache.h>
+
+
+void BINARY_CACHE_WRITER::Text( const EDA_TEXT* aText )
+{
+    const TEXT_ATTRIBUTES& attrs = aText->GetAttributes();
+
+    String( aText->GetText() );
+    Point( aText->GetTextPos() );
+    String( attrs.m_Font ? attrs.m_Font->GetName() : wxString( wxEmptyString ) );
+    Int( attrs.m_Halign );
+    Int( attrs.m_Valign );
+    Double( attrs.m_Angle.AsDegrees() );
+    Double( attrs.m_LineSpacing );
+    Int( attrs.m_StrokeWidth );
+    Bool( attrs.m_Italic );
+    Bool( attrs.m_Bold );
+    Bool( attrs.m_Visible );
+    Bool( attrs.m_Mirrored );
+    Bool( attrs.m_Multiline );
+    Bool( attrs.m_KeepUpright );
+    Color( attrs.m_Color );
+    Int( aText->GetTextSize().x );
+    Int( aText->GetTextSize().y );
+}
+
+
+void BINARY_CACHE_READER::Text( EDA_TEXT* aText )
+{
+    aText->SetText( String() );
+    aText->SetTextPos( Point() );
+
+    wxString faceName = String();
+
+    aText->SetHorizJustify( static_cast<GR_TEXT_H_ALIGN_T>( Int() ) );
+    aText->SetVertJustify( static_cast<GR_TEXT_V_ALIGN_T>( Int() ) );
+    aText->SetTextAngle( EDA_ANGLE( Double(), DEGREES_T ) );
+    aText->SetLineSpacing( Double() );
+    aText->SetTextThickness( Int() );
+    aText->SetItalic( Bool() );
+    aText->SetBold( Bool() );
+    aText->SetVisible( Bool() );
+    aText->SetMirrored( Bool() );
+    aText->SetMultilineAllowed( Bool() );
+    aText->SetKeepUpright( Bool() );
+    aText->SetTextColor( Color() );
+
+    int width = Int();
+    int height = Int();
+
+    aText->SetTextSize( wxSize( width, height ) );
+
+    if( !faceName.IsEmpty() && m_ok )
+        aText->SetFont( KIFONT::FONT::GetFont( faceName, aText->IsBold(), aText->IsItalic() ) );
+}
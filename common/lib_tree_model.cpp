@@ -22,6 +22,8 @@
 #include <lib_tree_model.h>
 
 #include <algorithm>
+#include <iterator>
+#include <unordered_set>
 #include <eda_pattern_match.h>
 #include <lib_tree_item.h>
 #include <utility>
@@ -36,6 +38,49 @@
 static const unsigned kLowestDefaultScore = 1;
 
 
+// Returns true if a match of any of the EDA_COMBINED_MATCHER matchers on aTerm implies that
+// aTerm appears literally in the matched text.  Terms containing regular expression, wildcard
+// or relational characters don't qualify, and neither do terms too short to have a trigram.
+static bool isLiteralTerm( const wxString& aTerm )
+{
+    static const wxString specialChars = wxT( ".*+?^${}()|[]\\<>=" );
+
+    if( aTerm.length() < 3 )
+        return false;
+
+    for( wxUniChar c : aTerm )
+    {
+        if( specialChars.Find( c ) != wxNOT_FOUND )
+            return false;
+    }
+
+    return true;
+}
+
+
+// Calls aFunc with a key for each consecutive three character sequence in aText.
+template <typename Func>
+static void forEachTrigram( const wxString& aText, Func aFunc )
+{
+    if( aText.length() < 3 )
+        return;
+
+    wxString::const_iterator it = aText.begin();
+    uint64_t                 a = static_cast<wxUniChar>( *it++ ).GetValue();
+    uint64_t                 b = static_cast<wxUniChar>( *it++ ).GetValue();
+
+    for( ; it != aText.end(); ++it )
+    {
+        uint64_t c = static_cast<wxUniChar>( *it ).GetValue();
+
+        aFunc( ( a << 42 ) | ( b << 21 ) | c );
+
+        a = b;
+        b = c;
+    }
+}
+
+
 // Creates a score depending on the position of a string match. If the position
 // is 0 (= prefix match), this returns the maximum score. This degrades until
 // pos == max, which returns a score of 0; Evertyhing else beyond that is just
@@ -124,7 +169,27 @@ LIB_TREE_NODE::LIB_TREE_NODE()
       m_Normalized( false ),
       m_Unit( 0 ),
       m_IsRoot( false )
-{}
+{
+}
+
+
+LIB_TREE_NODE::~LIB_TREE_NODE()
+{
+    // Nodes are removed from the tree by deleting them
+    invalidateSearchIndex();
+}
+
+
+void LIB_TREE_NODE::invalidateSearchIndex()
+{
+    LIB_TREE_NODE* node = this;
+
+    while( node->m_Parent )
+        node = node->m_Parent;
+
+    if( node->m_Type == ROOT )
+        static_cast<LIB_TREE_NODE_ROOT*>( node )->m_treeRevision++;
+}
 
 
 LIB_TREE_NODE_UNIT::LIB_TREE_NODE_UNIT( LIB_TREE_NODE* aParent, LIB_TREE_ITEM* aItem, int aUnit )
@@ -202,22 +267,30 @@ void LIB_TREE_NODE_LIB_ID::Update( LIB_TREE_ITEM* aItem )
     m_IsRoot = aItem->IsRoot();
     m_Children.clear();
 
+    invalidateSearchIndex();
+
     for( int u = 1; u <= aItem->GetUnitCount(); ++u )
         AddUnit( aItem, u );
 }
 
 
-void LIB_TREE_NODE_LIB_ID::UpdateScore( EDA_COMBINED_MATCHER& aMatcher, const wxString& aLib )
+void LIB_TREE_NODE_LIB_ID::Normalize()
 {
-    if( m_Score <= 0 )
-        return; // Leaf nodes without scores are out of the game.
-
     if( !m_Normalized )
     {
         m_MatchName = UnescapeString( m_MatchName ).Lower();
         m_SearchText = m_SearchText.Lower();
         m_Normalized = true;
     }
+}
+
+
+void LIB_TREE_NODE_LIB_ID::UpdateScore( EDA_COMBINED_MATCHER& aMatcher, const wxString& aLib )
+{
+    if( m_Score <= 0 )
+        return; // Leaf nodes without scores are out of the game.
+
+    Normalize();
 
     if( !aLib.IsEmpty() && m_Parent->m_MatchName != aLib )
     {
@@ -284,6 +357,7 @@ LIB_TREE_NODE_LIB_ID& LIB_TREE_NODE_LIB::AddItem( LIB_TREE_ITEM* aItem )
 {
     LIB_TREE_NODE_LIB_ID* item = new LIB_TREE_NODE_LIB_ID( this, aItem );
     m_Children.push_back( std::unique_ptr<LIB_TREE_NODE>( item ) );
+    invalidateSearchIndex();
     return *item;
 }
 
@@ -331,23 +405,192 @@ void LIB_TREE_NODE_LIB::UpdateScore( EDA_COMBINED_MATCHER& aMatcher, const wxStr
 }
 
 
-LIB_TREE_NODE_ROOT::LIB_TREE_NODE_ROOT()
+LIB_TREE_NODE_ROOT::LIB_TREE_NODE_ROOT() :
+        m_treeRevision( 1 ),
+        m_searchIndexRevision( 0 )
 {
     m_Type = ROOT;
 }
 
 
+LIB_TREE_NODE_ROOT::~LIB_TREE_NODE_ROOT()
+{
+    // Delete the children while m_treeRevision, which they update, still exists
+    m_Children.clear();
+}
+
+
 LIB_TREE_NODE_LIB& LIB_TREE_NODE_ROOT::AddLib( wxString const& aName, wxString const& aDesc )
 {
     LIB_TREE_NODE_LIB* lib = new LIB_TREE_NODE_LIB( this, aName, aDesc );
     m_Children.push_back( std::unique_ptr<LIB_TREE_NODE>( lib ) );
+    invalidateSearchIndex();
     return *lib;
 }
 
 
 void LIB_TREE_NODE_ROOT::UpdateScore( EDA_COMBINED_MATCHER& aMatcher, const wxString& aLib )
 {
-    for( std::unique_ptr<LIB_TREE_NODE>& child: m_Children )
-        child->UpdateScore( aMatcher, aLib );
+    const wxString& term = aMatcher.GetPattern();
+
+    if( !isLiteralTerm( term ) )
+    {
+        for( std::unique_ptr<LIB_TREE_NODE>& child: m_Children )
+            child->UpdateScore( aMatcher, aLib );
+
+        return;
+    }
+
+    updateSearchIndex();
+
+    std::vector<bool> isCandidate( m_searchItems.size(), false );
+
+    for( int idx : findCandidates( term ) )
+        isCandidate[idx] = true;
+
+    // Items also match on their library name, which isn't part of the index.
+    std::unordered_set<LIB_TREE_NODE*> matchingLibs;
+
+    for( std::unique_ptr<LIB_TREE_NODE>& lib: m_Children )
+    {
+        if( lib->m_MatchName.Contains( term ) )
+            matchingLibs.insert( lib.get() );
+    }
+
+    for( size_t ii = 0; ii < m_searchItems.size(); ++ii )
+    {
+        LIB_TREE_NODE_LIB_ID* item = m_searchItems[ii];
+
+        if( isCandidate[ii] || ( !matchingLibs.empty() && matchingLibs.count( item->m_Parent ) ) )
+            item->UpdateScore( aMatcher, aLib );
+        else
+            item->m_Score = 0;   // None of the matchers can fire on this item
+    }
+
+    for( std::unique_ptr<LIB_TREE_NODE>& lib: m_Children )
+    {
+        if( lib->m_Children.empty() )
+        {
+            lib->UpdateScore( aMatcher, aLib );
+            continue;
+        }
+
+        lib->m_Score = 0;
+
+        for( std::unique_ptr<LIB_TREE_NODE>& child: lib->m_Children )
+        {
+            if( child->m_Type != LIBID )
+                child->UpdateScore( aMatcher, aLib );
+
+            lib->m_Score = std::max( lib->m_Score, child->m_Score );
+        }
+    }
+}
+
+
+void LIB_TREE_NODE_ROOT::updateSearchIndex()
+{
+    if( m_treeRevision == m_searchIndexRevision )
+        return;
+
+    m_searchItems.clear();
+    m_trigrams.clear();
+    m_candidateCache.clear();
+
+    for( std::unique_ptr<LIB_TREE_NODE>& lib: m_Children )
+    {
+        for( std::unique_ptr<LIB_TREE_NODE>& child: lib->m_Children )
+        {
+            if( child->m_Type != LIBID )
+                continue;
+
+            LIB_TREE_NODE_LIB_ID* item = static_cast<LIB_TREE_NODE_LIB_ID*>( child.get() );
+            int                   idx = (int) m_searchItems.size();
+
+            item->Normalize();
+            m_searchItems.push_back( item );
+
+            auto addTrigram =
+                    [&]( uint64_t aTrigram )
+                    {
+                        std::vector<int>& postings = m_trigrams[aTrigram];
+
+                        if( postings.empty() || postings.back() != idx )
+                            postings.push_back( idx );
+                    };
+
+            forEachTrigram( item->m_MatchName, addTrigram );
+            forEachTrigram( item->m_SearchText, addTrigram );
+        }
+    }
+
+    m_searchIndexRevision = m_treeRevision;
+}
+
+
+const std::vector<int>& LIB_TREE_NODE_ROOT::findCandidates( const wxString& aTerm )
+{
+    auto cached = m_candidateCache.find( aTerm );
+
+    if( cached != m_candidateCache.end() )
+        return cached->second;
+
+    std::vector<const std::vector<int>*> postings;
+    bool                                 missingTrigram = false;
+
+    forEachTrigram( aTerm,
+            [&]( uint64_t aTrigram )
+            {
+                auto it = m_trigrams.find( aTrigram );
+
+                if( it == m_trigrams.end() )
+                    missingTrigram = true;
+                else
+                    postings.push_back( &it->second );
+            } );
+
+    std::vector<int> candidates;
+
+    if( !missingTrigram )
+    {
+        std::sort( postings.begin(), postings.end(),
+                   []( const std::vector<int>* a, const std::vector<int>* b )
+                   {
+                       return a->size() < b->size();
+                   } );
+
+        // Anything matching this term also matches any shorter term it contains, so when the
+        // user is typing we can start from the candidates of what they typed before.
+        const std::vector<int>* narrowest = postings.front();
+
+        for( const std::pair<const wxString, std::vector<int>>& entry : m_candidateCache )
+        {
+            if( entry.second.size() < narrowest->size() && aTerm.Contains( entry.first ) )
+                narrowest = &entry.second;
+        }
+
+        candidates = *narrowest;
+
+        for( const std::vector<int>* list : postings )
+        {
+            if( candidates.empty() )
+                break;
+
+            if( list == narrowest )
+                continue;
+
+            std::vector<int> intersection;
+
+            std::set_intersection( candidates.begin(), candidates.end(), list->begin(),
+                                   list->end(), std::back_inserter( intersection ) );
+
+            candidates.swap( intersection );
+        }
+    }
+
+    if( m_candidateCache.size() >= 64 )
+        m_candidateCache.clear();
+
+    return m_candidateCache.emplace( aTerm, std::move( candidates ) ).first->second;
 }
 
@@ -0,0 +1,61 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <thread_budget.h>
+
+
+///< Number of worker threads reserved by all the budgets of the process
+static std::atomic<size_t> s_reserved( 0 );
+
+
+THREAD_BUDGET::THREAD_BUDGET( size_t aWanted ) :
+        m_count( 0 )
+{
+    size_t total = GetTotal();
+    size_t reserved = s_reserved.load();
+    size_t granted;
+
+    do
+    {
+        granted = std::min( aWanted, total > reserved ? total - reserved : 0 );
+    } while( !s_reserved.compare_exchange_weak( reserved, reserved + granted ) );
+
+    m_count = granted;
+}
+
+
+void THREAD_BUDGET::Release()
+{
+    s_reserved -= m_count;
+    m_count = 0;
+}
+
+
+size_t THREAD_BUDGET::GetTotal()
+{
+    return std::max<size_t>( 1, std::thread::hardware_concurrency() );
+}
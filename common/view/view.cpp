@@ -26,6 +26,9 @@
  */
 
 
+#include <cmath>
+
+#include <core/kicad_algo.h>
 #include <eda_item.h>
 #include <layer_ids.h>
 #include <trace_helpers.h>
@@ -59,7 +62,9 @@ public:
         m_requiredUpdate( KIGFX::NONE ),
         m_drawPriority( 0 ),
         m_groups( nullptr ),
-        m_groupsSize( 0 ) {}
+        m_groupsSize( 0 ),
+        m_lodCaches( nullptr ),
+        m_lodCachesSize( 0 ) {}
 
     ~VIEW_ITEM_DATA()
     {
@@ -139,6 +144,42 @@ private:
     }
 
 
+    /**
+     * Return the group id of the simplified version of the item for the given layer, or -1
+     * if it has none.
+     */
+    int getLodGroup( int aLayer ) const
+    {
+        const LOD_CACHE* cache = findLodCache( aLayer );
+
+        return cache ? cache->m_group : -1;
+    }
+
+    void setLodGroup( int aLayer, int aGroup )
+    {
+        lodCache( aLayer ).m_group = aGroup;
+    }
+
+    /**
+     * Return the tolerance the simplified version of the item was built with for the given
+     * layer, 0 if the painter has one but it was not built yet, or -1 if there is none.
+     */
+    int getLodTolerance( int aLayer ) const
+    {
+        const LOD_CACHE* cache = findLodCache( aLayer );
+
+        return cache ? cache->m_tolerance : -1;
+    }
+
+    void setLodTolerance( int aLayer, int aTolerance )
+    {
+        // Most items have no simplified version, which is the default
+        if( aTolerance < 0 && !findLodCache( aLayer ) )
+            return;
+
+        lodCache( aLayer ).m_tolerance = aTolerance;
+    }
+
     /**
      * Remove all of the stored group ids. Forces recaching of the item.
      */
@@ -147,6 +188,10 @@ private:
         delete[] m_groups;
         m_groups = nullptr;
         m_groupsSize = 0;
+
+        delete[] m_lodCaches;
+        m_lodCaches = nullptr;
+        m_lodCachesSize = 0;
     }
 
 
@@ -184,6 +229,14 @@ private:
 
             m_groups[i].first = new_layer;
         }
+
+        for( int i = 0; i < m_lodCachesSize; ++i )
+        {
+            auto it = aReorderMap.find( m_lodCaches[i].m_layer );
+
+            if( it != aReorderMap.end() )
+                m_lodCaches[i].m_layer = it->second;
+        }
     }
 
     /**
@@ -229,6 +282,51 @@ private:
         return m_flags == VISIBLE;
     }
 
+    /**
+     * The simplified version of the item for a layer (see PAINTER::HasLodProxy()).
+     */
+    struct LOD_CACHE
+    {
+        int m_layer;
+        int m_group;        ///< Group id, or -1 if it is not built
+        int m_tolerance;    ///< What it was built for, 0 if it is not built yet, -1 if none
+    };
+
+    const LOD_CACHE* findLodCache( int aLayer ) const
+    {
+        for( int i = 0; i < m_lodCachesSize; ++i )
+        {
+            if( m_lodCaches[i].m_layer == aLayer )
+                return &m_lodCaches[i];
+        }
+
+        return nullptr;
+    }
+
+    ///< Return the simplified version entry of a layer, adding an empty one if needed
+    LOD_CACHE& lodCache( int aLayer )
+    {
+        for( int i = 0; i < m_lodCachesSize; ++i )
+        {
+            if( m_lodCaches[i].m_layer == aLayer )
+                return m_lodCaches[i];
+        }
+
+        // Same growth as setGroup(): items have very few layers
+        LOD_CACHE* newCaches = new LOD_CACHE[m_lodCachesSize + 1];
+
+        if( m_lodCachesSize > 0 )
+        {
+            std::copy( m_lodCaches, m_lodCaches + m_lodCachesSize, newCaches );
+            delete[] m_lodCaches;
+        }
+
+        m_lodCaches = newCaches;
+        newCaches[m_lodCachesSize] = { aLayer, -1, -1 };
+
+        return newCaches[m_lodCachesSize++];
+    }
+
     VIEW*                m_view;             ///< Current dynamic view the item is assigned to.
     int                  m_flags;            ///< Visibility flags
     int                  m_requiredUpdate;   ///< Flag required for updating
@@ -238,6 +336,10 @@ private:
                                              ///< item occupies.
     int                  m_groupsSize;
 
+    LOD_CACHE*           m_lodCaches;        ///< Simplified versions, for the layers where the
+                                             ///< painter has one.
+    int                  m_lodCachesSize;
+
     std::vector<int>     m_layers;           /// Stores layer numbers used by the item.
 };
 
@@ -378,12 +480,23 @@ void VIEW::Remove( VIEW_ITEM* aItem )
         // Clear the GAL cache
         int prevGroup = viewData->getGroup( layers[i] );
 
+        if( prevGroup >= 0 )
+            m_gal->DeleteGroup( prevGroup );
+
+        prevGroup = viewData->getLodGroup( layers[i] );
+
         if( prevGroup >= 0 )
             m_gal->DeleteGroup( prevGroup );
     }
 
     viewData->deleteGroups();
     viewData->m_view = nullptr;
+
+    alg::delete_if( m_lodQueue,
+                    [aItem]( const std::pair<VIEW_ITEM*, int>& aEntry )
+                    {
+                        return aEntry.first == aItem;
+                    } );
 }
 
 
@@ -726,6 +839,11 @@ struct VIEW::UPDATE_COLOR_VISITOR
         const COLOR4D color = painter->GetSettings()->GetColor( aItem, layer );
         int           group = aItem->viewPrivData()->getGroup( layer );
 
+        if( group >= 0 )
+            gal->ChangeGroupColor( group, color );
+
+        group = aItem->viewPrivData()->getLodGroup( layer );
+
         if( group >= 0 )
             gal->ChangeGroupColor( group, color );
 
@@ -780,6 +898,11 @@ void VIEW::UpdateAllLayersColor()
                 const COLOR4D color = m_painter->GetSettings()->GetColor( item, layers[i] );
                 int           group = viewData->getGroup( layers[i] );
 
+                if( group >= 0 )
+                    m_gal->ChangeGroupColor( group, color );
+
+                group = viewData->getLodGroup( layers[i] );
+
                 if( group >= 0 )
                     m_gal->ChangeGroupColor( group, color );
             }
@@ -803,6 +926,11 @@ struct VIEW::UPDATE_DEPTH_VISITOR
     {
         int group = aItem->viewPrivData()->getGroup( layer );
 
+        if( group >= 0 )
+            gal->ChangeGroupDepth( group, depth );
+
+        group = aItem->viewPrivData()->getLodGroup( layer );
+
         if( group >= 0 )
             gal->ChangeGroupDepth( group, depth );
 
@@ -912,6 +1040,11 @@ void VIEW::UpdateAllLayersOrder()
             {
                 int group = viewData->getGroup( layers[i] );
 
+                if( group >= 0 )
+                    m_gal->ChangeGroupDepth( group, m_layers[layers[i]].renderingOrder );
+
+                group = viewData->getLodGroup( layers[i] );
+
                 if( group >= 0 )
                     m_gal->ChangeGroupDepth( group, m_layers[layers[i]].renderingOrder );
             }
@@ -1026,9 +1159,28 @@ void VIEW::draw( VIEW_ITEM* aItem, int aLayer, bool aImmediate )
         int group = viewData->getGroup( aLayer );
 
         if( group >= 0 )
+        {
+            // Use the simplified version when zoomed out far enough.  If it is missing or was
+            // built for another zoom level, draw the full one and build it on the next update.
+            int builtTolerance = viewData->getLodTolerance( aLayer );
+            int tolerance = builtTolerance >= 0 ? lodTolerance( aItem ) : 0;
+
+            if( tolerance > 0 )
+            {
+                int lodGroup = viewData->getLodGroup( aLayer );
+
+                if( lodGroup >= 0 && tolerance == builtTolerance )
+                    group = lodGroup;
+                else
+                    m_lodQueue.emplace_back( aItem, aLayer );
+            }
+
             m_gal->DrawGroup( group );
+        }
         else
+        {
             Update( aItem );
+        }
     }
     else
     {
@@ -1086,6 +1238,15 @@ struct VIEW::RECACHE_ITEM_VISITOR
             gal->DeleteGroup( group );
 
         viewData->setGroup( layer, -1 );
+
+        group = viewData->getLodGroup( layer );
+
+        if( group >= 0 )
+        {
+            gal->DeleteGroup( group );
+            viewData->setLodGroup( layer, -1 );
+        }
+
         view->Update( aItem );
 
         return true;
@@ -1107,6 +1268,7 @@ void VIEW::Clear()
         layer.items->RemoveAll();
 
     m_nextDrawPriority = 0;
+    m_lodQueue.clear();
 
     m_gal->ClearCache();
 }
@@ -1273,6 +1435,11 @@ void VIEW::updateItemColor( VIEW_ITEM* aItem, int aLayer )
     // Change the color, only if it has group assigned
     if( group >= 0 )
         m_gal->ChangeGroupColor( group, color );
+
+    group = viewData->getLodGroup( aLayer );
+
+    if( group >= 0 )
+        m_gal->ChangeGroupColor( group, color );
 }
 
 
@@ -1303,6 +1470,70 @@ void VIEW::updateItemGeometry( VIEW_ITEM* aItem, int aLayer )
         aItem->ViewDraw( aLayer, this ); // Alternative drawing method
 
     m_gal->EndGroup();
+
+    // Its simplified version is built when it is first needed (see draw())
+    int lodGroup = viewData->getLodGroup( aLayer );
+
+    if( lodGroup >= 0 )
+    {
+        m_gal->DeleteGroup( lodGroup );
+        viewData->setLodGroup( aLayer, -1 );
+    }
+
+    viewData->setLodTolerance( aLayer, m_painter->HasLodProxy( aItem, aLayer ) ? 0 : -1 );
+}
+
+
+void VIEW::updateItemLod( VIEW_ITEM* aItem, int aLayer )
+{
+    VIEW_ITEM_DATA* viewData = aItem->viewPrivData();
+
+    if( !viewData || viewData->m_view != this || !IsCached( aLayer ) )
+        return;
+
+    int tolerance = lodTolerance( aItem );
+    int lodGroup = viewData->getLodGroup( aLayer );
+
+    // No longer wanted, or queued more than once
+    if( tolerance <= 0 || viewData->getLodTolerance( aLayer ) < 0
+            || ( lodGroup >= 0 && viewData->getLodTolerance( aLayer ) == tolerance ) )
+    {
+        return;
+    }
+
+    VIEW_LAYER& l = m_layers.at( aLayer );
+
+    m_gal->SetTarget( l.target );
+    m_gal->SetLayerDepth( l.renderingOrder );
+
+    if( lodGroup >= 0 )
+        m_gal->DeleteGroup( lodGroup );
+
+    lodGroup = m_gal->BeginGroup();
+    m_painter->DrawLodProxy( aItem, aLayer, tolerance );
+    m_gal->EndGroup();
+
+    viewData->setLodGroup( aLayer, lodGroup );
+    viewData->setLodTolerance( aLayer, tolerance );
+
+    MarkTargetDirty( l.target );
+}
+
+
+int VIEW::lodTolerance( const VIEW_ITEM* aItem ) const
+{
+    const BOX2I bbox = aItem->ViewBBox();
+    double      worldScale = m_gal->GetWorldScale();
+    double      maxError = LOD_MAX_ERROR / worldScale;
+    double      screenSize = std::max( bbox.GetWidth(), bbox.GetHeight() ) * worldScale;
+
+    // Zoomed in too far for the simplification to remove anything worth it
+    if( maxError < 1.0 || screenSize > LOD_MAX_SIZE )
+        return 0;
+
+    // Round down to a power of two, so that zooming rebuilds the simplified version only
+    // every time the scale doubles or halves
+    return 1 << std::min( 30, (int) std::floor( std::log2( maxError ) ) );
 }
 
 
@@ -1349,6 +1580,14 @@ void VIEW::updateLayers( VIEW_ITEM* aItem )
                 m_gal->DeleteGroup( prevGroup );
                 viewData->setGroup( l.id, -1 );
             }
+
+            prevGroup = viewData->getLodGroup( layers[i] );
+
+            if( prevGroup >= 0 )
+            {
+                m_gal->DeleteGroup( prevGroup );
+                viewData->setLodGroup( l.id, -1 );
+            }
         }
     }
 
@@ -1474,6 +1713,17 @@ void VIEW::UpdateItems()
         }
     }
 
+    // Simplified versions requested by the last redraw
+    if( !m_lodQueue.empty() )
+    {
+        GAL_UPDATE_CONTEXT ctx( m_gal );
+
+        for( const std::pair<VIEW_ITEM*, int>& entry : m_lodQueue )
+            updateItemLod( entry.first, entry.second );
+
+        m_lodQueue.clear();
+    }
+
     KI_TRACE( traceGalProfile, "View update: total items %u, geom %u updates %u\n", cntTotal,
               cntGeomUpdate, cntAnyUpdate );
 }
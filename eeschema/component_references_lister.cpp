@@ -33,6 +33,7 @@
 #include <wx/regex.h>
 #include <algorithm>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <string_utils.h>
@@ -337,7 +338,7 @@ void SCH_REFERENCE_LIST::ReannotateDuplicates( const SCH_REFERENCE_LIST& aAdditi
 
 
 void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int aStartNumber,
-                                   SCH_MULTI_UNIT_REFERENCE_MAP aLockedUnitMap,
+                                   const SCH_MULTI_UNIT_REFERENCE_MAP& aLockedUnitMap,
                                    const SCH_REFERENCE_LIST& aAdditionalRefs, bool aStartAtCurrent )
 {
     if ( flatList.size() == 0 )
@@ -371,6 +372,93 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
         AddItem( additionalRef ); //add to this container
     }
 
+    // The references already annotated, indexed by reference prefix, reference number and unit
+    // (the value is the count of references using that unit).  This replaces the linear scans
+    // of GetRefsInUse() and FindUnit() for every symbol, which made annotation quadratic.
+    std::unordered_map<std::string, std::map<int, std::map<int, int>>> annotatedRefs;
+
+    auto indexRef =
+            [&]( const SCH_REFERENCE& aRef )
+            {
+                if( !aRef.m_isNew )
+                    annotatedRefs[aRef.GetRefStr()][aRef.m_numRef][aRef.m_unit]++;
+            };
+
+    auto unindexRef =
+            [&]( const SCH_REFERENCE& aRef )
+            {
+                if( aRef.m_isNew )
+                    return;
+
+                auto prefixIt = annotatedRefs.find( aRef.GetRefStr() );
+
+                if( prefixIt == annotatedRefs.end() )
+                    return;
+
+                auto numIt = prefixIt->second.find( aRef.m_numRef );
+
+                if( numIt == prefixIt->second.end() )
+                    return;
+
+                auto unitIt = numIt->second.find( aRef.m_unit );
+
+                if( unitIt != numIt->second.end() && --unitIt->second <= 0 )
+                    numIt->second.erase( unitIt );
+
+                if( numIt->second.empty() )
+                    prefixIt->second.erase( numIt );
+            };
+
+    // Same result as GetRefsInUse(), from the index
+    auto getRefsInUse =
+            [&]( const SCH_REFERENCE& aRef, std::vector<int>& aIdList, int aMinRefId )
+            {
+                aIdList.clear();
+
+                auto prefixIt = annotatedRefs.find( aRef.GetRefStr() );
+
+                if( prefixIt == annotatedRefs.end() )
+                    return;
+
+                for( auto numIt = prefixIt->second.lower_bound( aMinRefId );
+                     numIt != prefixIt->second.end(); ++numIt )
+                {
+                    aIdList.push_back( numIt->first );
+                }
+            };
+
+    // Same test as FindUnit() >= 0, from the index.  The caller never asks for the unit of
+    // aRef itself so it doesn't need to be excluded.
+    auto unitExists =
+            [&]( const SCH_REFERENCE& aRef, int aUnit ) -> bool
+            {
+                auto prefixIt = annotatedRefs.find( aRef.GetRefStr() );
+
+                if( prefixIt == annotatedRefs.end() )
+                    return false;
+
+                auto numIt = prefixIt->second.find( aRef.m_numRef );
+
+                return numIt != prefixIt->second.end() && numIt->second.count( aUnit );
+            };
+
+    for( const SCH_REFERENCE& ref : flatList )
+        indexRef( ref );
+
+    // Locked references are looked up by symbol rather than by scanning the whole map for
+    // every symbol.  Only the first locked list holding a given instance is used.
+    std::unordered_map<SCH_SYMBOL*, std::vector<std::pair<const SCH_REFERENCE*,
+                                                          const SCH_REFERENCE_LIST*>>> lockedRefs;
+
+    for( const SCH_MULTI_UNIT_REFERENCE_MAP::value_type& pair : aLockedUnitMap )
+    {
+        for( unsigned thisRefI = 0; thisRefI < pair.second.GetCount(); ++thisRefI )
+        {
+            const SCH_REFERENCE& thisRef = pair.second[thisRefI];
+            lockedRefs[thisRef.GetSymbol()].emplace_back( &thisRef, &pair.second );
+        }
+    }
+
     int LastReferenceNumber = 0;
     int NumberOfUnits, Unit;
 
@@ -393,7 +481,7 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
     // This is the list of all Id already in use for a given reference prefix.
     // Will be refilled for each new reference prefix.
     std::vector<int>idList;
-    GetRefsInUse( first, idList, minRefId );
+    getRefsInUse( flatList[first], idList, minRefId );
 
     for( unsigned ii = 0; ii < flatList.size(); ii++ )
     {
@@ -403,25 +491,20 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
             continue;
 
         // Check whether this symbol is in aLockedUnitMap.
-        SCH_REFERENCE_LIST* lockedList = nullptr;
+        const SCH_REFERENCE_LIST* lockedList = nullptr;
+        auto                      lockedIt = lockedRefs.find( ref_unit.GetSymbol() );
 
-        for( SCH_MULTI_UNIT_REFERENCE_MAP::value_type& pair : aLockedUnitMap )
+        if( lockedIt != lockedRefs.end() )
         {
-            unsigned n_refs = pair.second.GetCount();
-
-            for( unsigned thisRefI = 0; thisRefI < n_refs; ++thisRefI )
+            for( const std::pair<const SCH_REFERENCE*, const SCH_REFERENCE_LIST*>& locked :
+                    lockedIt->second )
             {
-                SCH_REFERENCE &thisRef = pair.second[thisRefI];
-
-                if( thisRef.IsSameInstance( ref_unit ) )
+                if( locked.first->IsSameInstance( ref_unit ) )
                 {
-                    lockedList = &pair.second;
+                    lockedList = locked.second;
                     break;
                 }
             }
-
-            if( lockedList != nullptr )
-                break;
         }
 
         if(  ( flatList[first].CompareRef( ref_unit ) != 0 )
@@ -436,19 +519,21 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
             else
                 minRefId = aStartNumber + 1;
 
-            GetRefsInUse( first, idList, minRefId );
+            getRefsInUse( flatList[first], idList, minRefId );
         }
 
         // Find references greater than current reference (unless not annotated)
         if( aStartAtCurrent && ref_unit.m_numRef > 0 )
         {
             minRefId = ref_unit.m_numRef;
-            GetRefsInUse( first, idList, minRefId );
+            getRefsInUse( flatList[first], idList, minRefId );
         }
 
         // Annotation of one part per package symbols (trivial case).
         if( ref_unit.GetLibPart()->GetUnitCount() <= 1 )
         {
+            unindexRef( ref_unit );
+
             if( ref_unit.m_isNew )
             {
                 LastReferenceNumber = CreateFirstFreeRefId( idList, minRefId );
@@ -457,6 +542,7 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
 
             ref_unit.m_flag  = 1;
             ref_unit.m_isNew = false;
+            indexRef( ref_unit );
             continue;
         }
 
@@ -479,12 +565,14 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
 
             for( unsigned thisRefI = 0; thisRefI < n_refs; ++thisRefI )
             {
-                SCH_REFERENCE &thisRef = (*lockedList)[thisRefI];
+                const SCH_REFERENCE& thisRef = (*lockedList)[thisRefI];
 
                 if( thisRef.IsSameInstance( ref_unit ) )
                 {
                     // This is the symbol we're currently annotating. Hold the unit!
+                    unindexRef( ref_unit );
                     ref_unit.m_unit = thisRef.m_unit;
+                    indexRef( ref_unit );
                     // lock this new full reference
                     inUseRefs.insert( buildFullReference( ref_unit ) );
                 }
@@ -508,9 +596,11 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
                     // multiunits symbols have duplicate references)
                     if( inUseRefs.find( ref_candidate ) == inUseRefs.end() )
                     {
+                        unindexRef( flatList[jj] );
                         flatList[jj].m_numRef = ref_unit.m_numRef;
                         flatList[jj].m_isNew = false;
                         flatList[jj].m_flag = 1;
+                        indexRef( flatList[jj] );
                         // lock this new full reference
                         inUseRefs.insert( ref_candidate );
                         break;
@@ -529,9 +619,7 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
                 if( ref_unit.m_unit == Unit )
                     continue;
 
-                int found = FindUnit( ii, Unit );
-
-                if( found >= 0 )
+                if( unitExists( ref_unit, Unit ) )
                     continue; // this unit exists for this reference (unit already annotated)
 
                 // Search a symbol to annotate ( same prefix, same value, not annotated)
@@ -564,6 +652,7 @@ void SCH_REFERENCE_LIST::Annotate( bool aUseSheetNum, int aSheetIntervalId, int
                         cmp_unit.m_numRef = ref_unit.m_numRef;
                         cmp_unit.m_flag   = 1;
                         cmp_unit.m_isNew  = false;
+                        indexRef( cmp_unit );
                         break;
                     }
                 }
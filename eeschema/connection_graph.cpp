@@ -20,6 +20,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <functional>
 #include <list>
 #include <thread>
 #include <future>
@@ -443,6 +444,7 @@ void CONNECTION_GRAPH::Reset()
     m_item_to_subgraph_map.clear();
     m_local_label_cache.clear();
     m_global_label_cache.clear();
+    m_sheet_revisions.clear();
     m_last_net_code = 1;
     m_last_bus_code = 1;
     m_last_subgraph_code = 1;
@@ -454,31 +456,91 @@ void CONNECTION_GRAPH::Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnco
 {
     PROF_TIMER recalc_time( "CONNECTION_GRAPH::Recalculate" );
 
-    if( aUnconditional )
-        Reset();
+    // Subgraphs and nets are always rebuilt, but the item connections of a sheet only depend
+    // on the items of that sheet and are kept when its screen did not change.
+    std::unordered_map<SCH_SHEET_PATH, uint64_t> sheetRevisions;
+
+    if( !aUnconditional )
+        sheetRevisions = m_sheet_revisions;
+
+    Reset();
 
     PROF_TIMER update_items( "updateItemConnectivity" );
 
     m_sheetList = aSheetList;
 
+    size_t updatedSheets = 0;
+
+    // The dangling end test of a screen only re-tests what changed since the previous one, so
+    // a screen shared by several sheets has to be fully tested on each of them.
+    std::unordered_map<SCH_SCREEN*, int> screenUses;
+
+    for( const SCH_SHEET_PATH& sheet : aSheetList )
+        screenUses[ sheet.LastScreen() ]++;
+
     for( const SCH_SHEET_PATH& sheet : aSheetList )
     {
+        SCH_SCREEN*            screen = sheet.LastScreen();
         std::vector<SCH_ITEM*> items;
+        auto                   revision = sheetRevisions.find( sheet );
+        bool                   update = revision == sheetRevisions.end()
+                                        || revision->second != screen->GetConnectivityRevision();
+
+        // Items never connected on this sheet (such as new sheet pins, which don't go through
+        // the screen) also need their connections computed.
+        auto needsUpdate =
+                [&]( SCH_ITEM* aItem )
+                {
+                    return aItem->IsConnectivityDirty() || !aItem->Connection( &sheet );
+                };
 
-        for( SCH_ITEM* item : sheet.LastScreen()->Items() )
+        for( SCH_ITEM* item : screen->Items() )
         {
-            if( item->IsConnectable() && ( aUnconditional || item->IsConnectivityDirty() ) )
-                items.push_back( item );
+            if( !item->IsConnectable() )
+                continue;
+
+            items.push_back( item );
+
+            if( update )
+                continue;
+
+            update |= item->IsConnectivityDirty();
+
+            if( item->Type() == SCH_SHEET_T )
+            {
+                for( SCH_SHEET_PIN* pin : static_cast<SCH_SHEET*>( item )->GetPins() )
+                    update |= needsUpdate( pin );
+            }
+            else if( item->Type() == SCH_SYMBOL_T )
+            {
+                for( SCH_PIN* pin : static_cast<SCH_SYMBOL*>( item )->GetPins( &sheet ) )
+                    update |= needsUpdate( pin );
+            }
+            else
+            {
+                update |= needsUpdate( item );
+            }
         }
 
         m_items.reserve( m_items.size() + items.size() );
 
-        updateItemConnectivity( sheet, items );
+        updateItemConnectivity( sheet, items, !update );
 
         // UpdateDanglingState() also adds connected items for SCH_TEXT
-        sheet.LastScreen()->TestDanglingEnds( &sheet, aChangedItemHandler );
+        if( update )
+        {
+            bool incremental = !aUnconditional && screenUses[ screen ] == 1;
+
+            screen->TestDanglingEnds( &sheet, aChangedItemHandler, incremental );
+            updatedSheets++;
+        }
+
+        m_sheet_revisions[ sheet ] = screen->GetConnectivityRevision();
     }
 
+    wxLogTrace( ConnTrace, "Updated item connections of %zu of %zu sheets", updatedSheets,
+                aSheetList.size() );
+
     if( wxLog::IsAllowedTraceMask( ConnProfileMask ) )
         update_items.Show();
 
@@ -508,14 +570,20 @@ void CONNECTION_GRAPH::Recalculate( const SCH_SHEET_LIST& aSheetList, bool aUnco
 
 
 void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
-                                               const std::vector<SCH_ITEM*>& aItemList )
+                                               const std::vector<SCH_ITEM*>& aItemList,
+                                               bool aKeepConnectedItems )
 {
     std::map<VECTOR2I, std::vector<SCH_ITEM*>> connection_map;
 
     for( SCH_ITEM* item : aItemList )
     {
-        std::vector<VECTOR2I> points = item->GetConnectionPoints();
-        item->ConnectedItems( aSheet ).clear();
+        std::vector<VECTOR2I> points;
+
+        if( !aKeepConnectedItems )
+        {
+            points = item->GetConnectionPoints();
+            item->ConnectedItems( aSheet ).clear();
+        }
 
         if( item->Type() == SCH_SHEET_T )
         {
@@ -523,9 +591,12 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
             {
                 pin->InitializeConnection( aSheet, this );
 
-                pin->ConnectedItems( aSheet ).clear();
+                if( !aKeepConnectedItems )
+                {
+                    pin->ConnectedItems( aSheet ).clear();
+                    connection_map[ pin->GetTextPos() ].push_back( pin );
+                }
 
-                connection_map[ pin->GetTextPos() ].push_back( pin );
                 m_items.emplace_back( pin );
             }
         }
@@ -541,14 +612,18 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
 
                 // because calling the first time is not thread-safe
                 pin->GetDefaultNetName( aSheet );
-                pin->ConnectedItems( aSheet ).clear();
 
                 // Invisible power pins need to be post-processed later
 
                 if( pin->IsPowerConnection() && !pin->IsVisible() )
                     m_invisible_power_pins.emplace_back( std::make_pair( aSheet, pin ) );
 
-                connection_map[ pos ].push_back( pin );
+                if( !aKeepConnectedItems )
+                {
+                    pin->ConnectedItems( aSheet ).clear();
+                    connection_map[ pos ].push_back( pin );
+                }
+
                 m_items.emplace_back( pin );
             }
         }
@@ -567,9 +642,14 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
 
             case SCH_BUS_BUS_ENTRY_T:
                 conn->SetType( CONNECTION_TYPE::BUS );
+
                 // clean previous (old) links:
-                static_cast<SCH_BUS_BUS_ENTRY*>( item )->m_connected_bus_items[0] = nullptr;
-                static_cast<SCH_BUS_BUS_ENTRY*>( item )->m_connected_bus_items[1] = nullptr;
+                if( !aKeepConnectedItems )
+                {
+                    static_cast<SCH_BUS_BUS_ENTRY*>( item )->m_connected_bus_items[0] = nullptr;
+                    static_cast<SCH_BUS_BUS_ENTRY*>( item )->m_connected_bus_items[1] = nullptr;
+                }
+
                 break;
 
             case SCH_PIN_T:
@@ -578,8 +658,11 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
 
             case SCH_BUS_WIRE_ENTRY_T:
                 conn->SetType( CONNECTION_TYPE::NET );
+
                 // clean previous (old) link:
-                static_cast<SCH_BUS_WIRE_ENTRY*>( item )->m_connected_bus_item = nullptr;
+                if( !aKeepConnectedItems )
+                    static_cast<SCH_BUS_WIRE_ENTRY*>( item )->m_connected_bus_item = nullptr;
+
                 break;
 
             default:
@@ -593,6 +676,10 @@ void CONNECTION_GRAPH::updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
         item->SetConnectivityDirty( false );
     }
 
+    // The links between the items, and with the buses, are still valid
+    if( aKeepConnectedItems )
+        return;
+
     for( const auto& it : connection_map )
     {
         const std::vector<SCH_ITEM*>& connection_vec = it.second;
@@ -2264,6 +2351,7 @@ int CONNECTION_GRAPH::RunERC()
     // We don't want to run many ERC checks more than once on a given screen even though it may
     // represent multiple sheets with multiple subgraphs.  We can tell these apart by drivers.
     std::set<SCH_ITEM*> seenDriverInstances;
+    std::vector<CONNECTION_SUBGRAPH*> subgraphs;
 
     for( CONNECTION_SUBGRAPH* subgraph : m_subgraphs )
     {
@@ -2282,62 +2370,131 @@ int CONNECTION_GRAPH::RunERC()
         if( subgraph->m_driver )
             seenDriverInstances.insert( subgraph->m_driver );
 
-        /**
-         * NOTE:
-         *
-         * We could check that labels attached to bus subgraphs follow the
-         * proper format (i.e. actually define a bus).
-         *
-         * This check doesn't need to be here right now because labels
-         * won't actually be connected to bus wires if they aren't in the right
-         * format due to their TestDanglingEnds() implementation.
-         */
-        if( settings.IsTestEnabled( ERCE_DRIVER_CONFLICT ) )
-        {
-            if( !ercCheckMultipleDrivers( subgraph ) )
-                error_count++;
-        }
+        subgraphs.push_back( subgraph );
+    }
 
-        subgraph->ResolveDrivers( false );
+    // The subgraph checks only add markers to their own subgraph, so they are run in parallel
+    // with each subgraph collecting its markers separately.  The markers are added to the
+    // screens afterwards in subgraph order so the results don't depend on thread scheduling.
+    std::vector<std::vector<SCH_MARKER*>> markers( subgraphs.size() );
+    std::vector<int>                      errors( subgraphs.size(), 0 );
 
-        if( settings.IsTestEnabled( ERCE_BUS_TO_NET_CONFLICT ) )
-        {
-            if( !ercCheckBusToNetConflicts( subgraph ) )
-                error_count++;
-        }
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   ( subgraphs.size() + 3 ) / 4 );
 
-        if( settings.IsTestEnabled( ERCE_BUS_ENTRY_CONFLICT ) )
-        {
-            if( !ercCheckBusToBusEntryConflicts( subgraph ) )
-                error_count++;
-        }
+    auto runParallel =
+            [&]( const std::function<void( size_t )>& aCheck )
+            {
+                std::atomic<size_t> nextSubgraph( 0 );
+                std::vector<std::future<size_t>> returns( parallelThreadCount );
 
-        if( settings.IsTestEnabled( ERCE_BUS_TO_BUS_CONFLICT ) )
-        {
-            if( !ercCheckBusToBusConflicts( subgraph ) )
-                error_count++;
-        }
+                auto check_lambda =
+                        [&]() -> size_t
+                        {
+                            for( size_t ii = nextSubgraph++; ii < subgraphs.size();
+                                 ii = nextSubgraph++ )
+                            {
+                                aCheck( ii );
+                            }
 
-        if( settings.IsTestEnabled( ERCE_WIRE_DANGLING ) )
-        {
-            if( !ercCheckFloatingWires( subgraph ) )
-                error_count++;
-        }
+                            return 1;
+                        };
 
-        if( settings.IsTestEnabled( ERCE_NOCONNECT_CONNECTED )
-                || settings.IsTestEnabled( ERCE_NOCONNECT_NOT_CONNECTED )
-                || settings.IsTestEnabled( ERCE_PIN_NOT_CONNECTED ) )
-        {
-            if( !ercCheckNoConnects( subgraph ) )
-                error_count++;
-        }
+                if( parallelThreadCount <= 1 )
+                {
+                    check_lambda();
+                }
+                else
+                {
+                    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+                        returns[ii] = std::async( std::launch::async, check_lambda );
 
-        if( settings.IsTestEnabled( ERCE_LABEL_NOT_CONNECTED )
-                || settings.IsTestEnabled( ERCE_GLOBLABEL ) )
-        {
-            if( !ercCheckLabels( subgraph ) )
-                error_count++;
-        }
+                    // Finalize the threads
+                    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+                        returns[ii].wait();
+                }
+            };
+
+    // ResolveDrivers() must be finished on every subgraph before the remaining checks run,
+    // because the label checks look at the drivers of neighboring subgraphs.
+    runParallel(
+            [&]( size_t ii )
+            {
+                CONNECTION_SUBGRAPH* subgraph = subgraphs[ii];
+
+                /**
+                 * NOTE:
+                 *
+                 * We could check that labels attached to bus subgraphs follow the
+                 * proper format (i.e. actually define a bus).
+                 *
+                 * This check doesn't need to be here right now because labels
+                 * won't actually be connected to bus wires if they aren't in the right
+                 * format due to their TestDanglingEnds() implementation.
+                 */
+                if( settings.IsTestEnabled( ERCE_DRIVER_CONFLICT ) )
+                {
+                    if( !ercCheckMultipleDrivers( subgraph, markers[ii] ) )
+                        errors[ii]++;
+                }
+
+                subgraph->ResolveDrivers( false );
+            } );
+
+    runParallel(
+            [&]( size_t ii )
+            {
+                CONNECTION_SUBGRAPH*      subgraph = subgraphs[ii];
+                std::vector<SCH_MARKER*>& sgMarkers = markers[ii];
+
+                if( settings.IsTestEnabled( ERCE_BUS_TO_NET_CONFLICT ) )
+                {
+                    if( !ercCheckBusToNetConflicts( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+
+                if( settings.IsTestEnabled( ERCE_BUS_ENTRY_CONFLICT ) )
+                {
+                    if( !ercCheckBusToBusEntryConflicts( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+
+                if( settings.IsTestEnabled( ERCE_BUS_TO_BUS_CONFLICT ) )
+                {
+                    if( !ercCheckBusToBusConflicts( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+
+                if( settings.IsTestEnabled( ERCE_WIRE_DANGLING ) )
+                {
+                    if( !ercCheckFloatingWires( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+
+                if( settings.IsTestEnabled( ERCE_NOCONNECT_CONNECTED )
+                        || settings.IsTestEnabled( ERCE_NOCONNECT_NOT_CONNECTED )
+                        || settings.IsTestEnabled( ERCE_PIN_NOT_CONNECTED ) )
+                {
+                    if( !ercCheckNoConnects( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+
+                if( settings.IsTestEnabled( ERCE_LABEL_NOT_CONNECTED )
+                        || settings.IsTestEnabled( ERCE_GLOBLABEL ) )
+                {
+                    if( !ercCheckLabels( subgraph, sgMarkers ) )
+                        errors[ii]++;
+                }
+            } );
+
+    for( size_t ii = 0; ii < subgraphs.size(); ++ii )
+    {
+        SCH_SCREEN* screen = subgraphs[ii]->m_sheet.LastScreen();
+
+        for( SCH_MARKER* marker : markers[ii] )
+            screen->Append( marker );
+
+        error_count += errors[ii];
     }
 
     // Hierarchical sheet checking is done at the schematic level
@@ -2351,7 +2508,8 @@ int CONNECTION_GRAPH::RunERC()
 }
 
 
-bool CONNECTION_GRAPH::ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubgraph,
+                                                std::vector<SCH_MARKER*>& aMarkers )
 {
     wxCHECK( aSubgraph, false );
     /*
@@ -2381,7 +2539,7 @@ bool CONNECTION_GRAPH::ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubg
         ercItem->SetErrorMessage( msg );
 
         SCH_MARKER* marker = new SCH_MARKER( ercItem, pos );
-        aSubgraph->m_sheet.LastScreen()->Append( marker );
+        aMarkers.push_back( marker );
 
         return false;
     }
@@ -2412,7 +2570,7 @@ bool CONNECTION_GRAPH::ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubg
                 ercItem->SetErrorMessage( msg );
 
                 SCH_MARKER* marker = new SCH_MARKER( ercItem, driver->GetPosition() );
-                aSubgraph->m_sheet.LastScreen()->Append( marker );
+                aMarkers.push_back( marker );
 
                 return false;
             }
@@ -2424,10 +2582,10 @@ bool CONNECTION_GRAPH::ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubg
 }
 
 
-bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                                  std::vector<SCH_MARKER*>& aMarkers )
 {
     const SCH_SHEET_PATH& sheet = aSubgraph->m_sheet;
-    SCH_SCREEN* screen = sheet.LastScreen();
 
     SCH_ITEM* net_item = nullptr;
     SCH_ITEM* bus_item = nullptr;
@@ -2472,7 +2630,7 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSu
         ercItem->SetItems( net_item, bus_item );
 
         SCH_MARKER* marker = new SCH_MARKER( ercItem, net_item->GetPosition() );
-        screen->Append( marker );
+        aMarkers.push_back( marker );
 
         return false;
     }
@@ -2481,11 +2639,11 @@ bool CONNECTION_GRAPH::ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSu
 }
 
 
-bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                                  std::vector<SCH_MARKER*>& aMarkers )
 {
     wxString msg;
     const SCH_SHEET_PATH& sheet = aSubgraph->m_sheet;
-    SCH_SCREEN* screen = sheet.LastScreen();
 
     SCH_ITEM* label = nullptr;
     SCH_ITEM* port = nullptr;
@@ -2540,7 +2698,7 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSu
             ercItem->SetItems( label, port );
 
             SCH_MARKER* marker = new SCH_MARKER( ercItem, label->GetPosition() );
-            screen->Append( marker );
+            aMarkers.push_back( marker );
 
             return false;
         }
@@ -2550,11 +2708,11 @@ bool CONNECTION_GRAPH::ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSu
 }
 
 
-bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                                       std::vector<SCH_MARKER*>& aMarkers )
 {
     bool conflict = false;
     const SCH_SHEET_PATH& sheet = aSubgraph->m_sheet;
-    SCH_SCREEN* screen = sheet.LastScreen();
 
     SCH_BUS_WIRE_ENTRY* bus_entry = nullptr;
     SCH_ITEM* bus_wire = nullptr;
@@ -2638,7 +2796,7 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH
         ercItem->SetErrorMessage( msg );
 
         SCH_MARKER* marker = new SCH_MARKER( ercItem, bus_entry->GetPosition() );
-        screen->Append( marker );
+        aMarkers.push_back( marker );
 
         return false;
     }
@@ -2648,12 +2806,12 @@ bool CONNECTION_GRAPH::ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH
 
 
 // TODO(JE) Check sheet pins here too?
-bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
+                                           std::vector<SCH_MARKER*>& aMarkers )
 {
     ERC_SETTINGS&         settings = m_schematic->ErcSettings();
     wxString              msg;
     const SCH_SHEET_PATH& sheet  = aSubgraph->m_sheet;
-    SCH_SCREEN*           screen = sheet.LastScreen();
     bool                  ok     = true;
 
     if( aSubgraph->m_no_connect != nullptr )
@@ -2707,7 +2865,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph
             ercItem->SetItems( pin );
 
             SCH_MARKER* marker = new SCH_MARKER( ercItem, pin->GetTransformedPosition() );
-            screen->Append( marker );
+            aMarkers.push_back( marker );
 
             ok = false;
         }
@@ -2718,7 +2876,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph
             ercItem->SetItems( aSubgraph->m_no_connect );
 
             SCH_MARKER* marker = new SCH_MARKER( ercItem, aSubgraph->m_no_connect->GetPosition() );
-            screen->Append( marker );
+            aMarkers.push_back( marker );
 
             ok = false;
         }
@@ -2785,7 +2943,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph
             ercItem->SetItems( pin );
 
             SCH_MARKER* marker = new SCH_MARKER( ercItem, pin->GetTransformedPosition() );
-            screen->Append( marker );
+            aMarkers.push_back( marker );
 
             ok = false;
         }
@@ -2809,7 +2967,7 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph
 
                     SCH_MARKER* marker = new SCH_MARKER( ercItem,
                                                          testPin->GetTransformedPosition() );
-                    screen->Append( marker );
+                    aMarkers.push_back( marker );
 
                     ok = false;
                 }
@@ -2821,7 +2979,8 @@ bool CONNECTION_GRAPH::ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph
 }
 
 
-bool CONNECTION_GRAPH::ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgraph,
+                                              std::vector<SCH_MARKER*>& aMarkers )
 {
     if( aSubgraph->m_driver )
         return true;
@@ -2841,8 +3000,6 @@ bool CONNECTION_GRAPH::ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgra
 
     if( !wires.empty() )
     {
-        SCH_SCREEN* screen = aSubgraph->m_sheet.LastScreen();
-
         std::shared_ptr<ERC_ITEM> ercItem = ERC_ITEM::Create( ERCE_WIRE_DANGLING );
         ercItem->SetItems( wires[0],
                            wires.size() > 1 ? wires[1] : nullptr,
@@ -2850,7 +3007,7 @@ bool CONNECTION_GRAPH::ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgra
                            wires.size() > 3 ? wires[3] : nullptr );
 
         SCH_MARKER* marker = new SCH_MARKER( ercItem, wires[0]->GetPosition() );
-        screen->Append( marker );
+        aMarkers.push_back( marker );
 
         return false;
     }
@@ -2859,7 +3016,8 @@ bool CONNECTION_GRAPH::ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgra
 }
 
 
-bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph )
+bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
+                                       std::vector<SCH_MARKER*>& aMarkers )
 {
     // Label connection rules:
     // Local labels are flagged if they don't connect to any pins and don't have a no-connect
@@ -2922,7 +3080,7 @@ bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph )
                 ercItem->SetItems( text );
 
                 SCH_MARKER* marker = new SCH_MARKER( ercItem, text->GetPosition() );
-                aSubgraph->m_sheet.LastScreen()->Append( marker );
+                aMarkers.push_back( marker );
                 ok = false;
             }
 
@@ -3004,7 +3162,7 @@ bool CONNECTION_GRAPH::ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph )
         ercItem->SetItems( text );
 
         SCH_MARKER* marker = new SCH_MARKER( ercItem, text->GetPosition() );
-        aSubgraph->m_sheet.LastScreen()->Append( marker );
+        aMarkers.push_back( marker );
 
         return false;
     }
@@ -40,6 +40,7 @@ class CONNECTION_GRAPH;
 class SCHEMATIC;
 class SCH_EDIT_FRAME;
 class SCH_HIERLABEL;
+class SCH_MARKER;
 class SCH_PIN;
 class SCH_SHEET_PIN;
 
@@ -270,6 +271,11 @@ public:
     /**
      * Updates the connection graph for the given list of sheets.
      *
+     * Unless \a aUnconditional is set, the item connections of the sheets whose screen did not
+     * change since the last call (see SCH_SCREEN::GetConnectivityRevision()) are kept.  This is
+     * not an incremental graph update: the subgraphs, their drivers and the nets are always
+     * rebuilt for the whole hierarchy, as net names and codes depend on every sheet.
+     *
      * @param aSheetList is the list of possibly modified sheets
      * @param aUnconditional is true if an unconditional full recalculation should be done
      * @param aChangedItemHandler an optional handler to receive any changed items
@@ -351,9 +357,12 @@ private:
      *
      * @param aSheet is the path to the sheet of all items in the list
      * @param aItemList is a list of items to consider
+     * @param aKeepConnectedItems set when the items have not changed since their connections
+     *                            were last computed; only their connection objects are reset
      */
     void updateItemConnectivity( const SCH_SHEET_PATH& aSheet,
-                                 const std::vector<SCH_ITEM*>& aItemList );
+                                 const std::vector<SCH_ITEM*>& aItemList,
+                                 bool aKeepConnectedItems = false );
 
     /**
      * Generates the connection graph (after all item connectivity has been updated)
@@ -449,9 +458,11 @@ private:
      * ResolveDrivers() will have stored the second driver for use by this function, which actually
      * creates the markers
      * @param aSubgraph is the subgraph to examine
+     * @param aMarkers receives the markers created; the caller adds them to the screen
      * @return  true for no errors, false for errors
      */
-    bool ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckMultipleDrivers( const CONNECTION_SUBGRAPH* aSubgraph,
+                                  std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for conflicting connections between net and bus labels
@@ -459,9 +470,11 @@ private:
      * For example, a net wire connected to a bus port/pin, or vice versa
      *
      * @param  aSubgraph      is the subgraph to examine
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckBusToNetConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                    std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for conflicting connections between two bus items
@@ -471,9 +484,11 @@ private:
      * sheet pin
      *
      * @param  aSubgraph      is the subgraph to examine
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckBusToBusConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                    std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for conflicting bus entry to bus connections
@@ -485,9 +500,11 @@ private:
      * "USB.DP" but someone might accidentally just enter "DP"
      *
      * @param  aSubgraph      is the subgraph to examine
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckBusToBusEntryConflicts( const CONNECTION_SUBGRAPH* aSubgraph,
+                                         std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for proper presence or absence of no-connect symbols
@@ -496,9 +513,11 @@ private:
      * A pin without a no-connect symbol should have at least one connection
      *
      * @param  aSubgraph      is the subgraph to examine
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckNoConnects( const CONNECTION_SUBGRAPH* aSubgraph,
+                             std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for floating wires
@@ -506,9 +525,11 @@ private:
      * Will throw an error for any subgraph that consists of just wires with no driver
      *
      * @param  aSubgraph      is the subgraph to examine
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckFloatingWires( const CONNECTION_SUBGRAPH* aSubgraph,
+                                std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks one subgraph for proper connection of labels
@@ -516,10 +537,11 @@ private:
      * Labels should be connected to something
      *
      * @param  aSubgraph      is the subgraph to examine
-     * @param  aCheckGlobalLabels is true if global labels should be checked for loneliness
+     * @param  aMarkers       receives the markers created; the caller adds them to the screen
      * @return                true for no errors, false for errors
      */
-    bool ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph );
+    bool ercCheckLabels( const CONNECTION_SUBGRAPH* aSubgraph,
+                         std::vector<SCH_MARKER*>& aMarkers );
 
     /**
      * Checks that a hierarchical sheet has at least one matching label inside the sheet for each
@@ -569,6 +591,9 @@ private:
 
     NET_MAP m_net_code_to_subgraphs_map;
 
+    // Screen connectivity revision at which the item connections of each sheet were computed
+    std::unordered_map<SCH_SHEET_PATH, uint64_t> m_sheet_revisions;
+
     int m_last_net_code;
 
     int m_last_bus_code;
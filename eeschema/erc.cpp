@@ -23,6 +23,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <atomic>
+#include <future>
+#include <thread>
+
 #include "connection_graph.h"
 #include <common.h>     // for ExpandEnvVarSubstitutions
 #include <erc.h>
@@ -442,20 +446,38 @@ int ERC_TESTER::TestNoConnectPins()
 }
 
 
-int ERC_TESTER::TestPinToPin()
+int ERC_TESTER::TestPinToPin( bool aParallel )
 {
     ERC_SETTINGS&  settings = m_schematic->ErcSettings();
     const NET_MAP& nets     = m_schematic->ConnectionGraph()->GetNetMap();
 
-    int errors = 0;
+    // ElectricalPinTypeGetText() builds its names lazily and translations aren't thread safe
+    // either, so look the texts up before starting the threads
+    const wxString        pinToPinMsg = _( "Pins of type %s and %s are connected" );
+    std::vector<wxString> pinTypeNames;
 
-    for( const std::pair<NET_NAME_CODE, std::vector<CONNECTION_SUBGRAPH*>> net : nets )
+    for( int ii = 0; ii < ELECTRICAL_PINTYPES_TOTAL; ++ii )
+        pinTypeNames.push_back( ElectricalPinTypeGetText( static_cast<ELECTRICAL_PINTYPE>( ii ) ) );
+
+    // Each net is tested independently; markers are collected per net and added to the screens
+    // afterwards in net order so the results don't depend on thread scheduling.
+    std::vector<const std::vector<CONNECTION_SUBGRAPH*>*> netList;
+
+    for( const std::pair<const NET_NAME_CODE, std::vector<CONNECTION_SUBGRAPH*>>& net : nets )
+        netList.push_back( &net.second );
+
+    std::vector<std::vector<std::pair<SCH_SCREEN*, SCH_MARKER*>>> netMarkers( netList.size() );
+
+    auto testNet = [&]( size_t aNetIdx )
     {
+        const std::vector<CONNECTION_SUBGRAPH*>&          subgraphs = *netList[aNetIdx];
+        std::vector<std::pair<SCH_SCREEN*, SCH_MARKER*>>& markers   = netMarkers[aNetIdx];
+
         std::vector<SCH_PIN*> pins;
         std::unordered_map<EDA_ITEM*, SCH_SCREEN*> pinToScreenMap;
         bool has_noconnect = false;
 
-        for( CONNECTION_SUBGRAPH* subgraph: net.second )
+        for( CONNECTION_SUBGRAPH* subgraph : subgraphs )
         {
             if( subgraph->m_no_connect )
                 has_noconnect = true;
@@ -544,14 +566,13 @@ int ERC_TESTER::TestPinToPin()
                     ercItem->SetIsSheetSpecific();
 
                     ercItem->SetErrorMessage(
-                            wxString::Format( _( "Pins of type %s and %s are connected" ),
-                                              ElectricalPinTypeGetText( refType ),
-                                              ElectricalPinTypeGetText( testType ) ) );
+                            wxString::Format( pinToPinMsg,
+                                              pinTypeNames[static_cast<int>( refType )],
+                                              pinTypeNames[static_cast<int>( testType )] ) );
 
                     SCH_MARKER* marker = new SCH_MARKER( ercItem,
                                                          refPin->GetTransformedPosition() );
-                    pinToScreenMap[refPin]->Append( marker );
-                    errors++;
+                    markers.emplace_back( pinToScreenMap[refPin], marker );
                 }
             }
         }
@@ -568,10 +589,50 @@ int ERC_TESTER::TestPinToPin()
 
                 SCH_MARKER* marker = new SCH_MARKER( ercItem,
                                                      needsDriver->GetTransformedPosition() );
-                pinToScreenMap[needsDriver]->Append( marker );
-                errors++;
+                markers.emplace_back( pinToScreenMap[needsDriver], marker );
             }
         }
+    };
+
+    // We don't want to spin up a new thread for only a few nets (overhead costs)
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   ( netList.size() + 3 ) / 4 );
+
+    std::atomic<size_t>              nextNet( 0 );
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+    auto test_lambda =
+            [&]() -> size_t
+            {
+                for( size_t ii = nextNet++; ii < netList.size(); ii = nextNet++ )
+                    testNet( ii );
+
+                return 1;
+            };
+
+    if( !aParallel || parallelThreadCount <= 1 )
+    {
+        test_lambda();
+    }
+    else
+    {
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, test_lambda );
+
+        // Finalize the threads
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii].wait();
+    }
+
+    int errors = 0;
+
+    for( const std::vector<std::pair<SCH_SCREEN*, SCH_MARKER*>>& markers : netMarkers )
+    {
+        for( const std::pair<SCH_SCREEN*, SCH_MARKER*>& marker : markers )
+        {
+            marker.first->Append( marker.second );
+            errors++;
+        }
     }
 
     return errors;
@@ -643,15 +704,16 @@ int ERC_TESTER::TestSimilarLabels()
 
     int errors = 0;
 
-    std::unordered_map<wxString, SCH_LABEL_BASE*> labelMap;
+    // Labels are bucketed by their case-folded text, so only labels that fold to the same text
+    // are ever compared.  The shown text of the first label in each bucket is kept alongside it
+    // as resolving text variables is much more expensive than the comparison itself.
+    std::unordered_map<wxString, std::pair<wxString, SCH_LABEL_BASE*>> labelMap;
 
-    for( const std::pair<NET_NAME_CODE, std::vector<CONNECTION_SUBGRAPH*>> net : nets )
+    for( const std::pair<const NET_NAME_CODE, std::vector<CONNECTION_SUBGRAPH*>>& net : nets )
     {
-        std::vector<SCH_PIN*> pins;
-
         for( CONNECTION_SUBGRAPH* subgraph : net.second )
         {
-            for( EDA_ITEM* item : subgraph->m_items )
+            for( SCH_ITEM* item : subgraph->m_items )
             {
                 switch( item->Type() )
                 {
@@ -660,17 +722,19 @@ int ERC_TESTER::TestSimilarLabels()
                 case SCH_GLOBAL_LABEL_T:
                 {
                     SCH_LABEL_BASE* label = static_cast<SCH_LABEL_BASE*>( item );
+                    wxString        shownText = label->GetShownText();
+                    wxString        normalized = shownText.Lower();
 
-                    wxString normalized = label->GetShownText().Lower();
+                    auto it = labelMap.find( normalized );
 
-                    if( !labelMap.count( normalized ) )
+                    if( it == labelMap.end() )
                     {
-                        labelMap[normalized] = label;
+                        labelMap.emplace( normalized, std::make_pair( shownText, label ) );
                     }
-                    else if( labelMap.at( normalized )->GetShownText() != label->GetShownText() )
+                    else if( it->second.first != shownText )
                     {
                         std::shared_ptr<ERC_ITEM> ercItem = ERC_ITEM::Create( ERCE_SIMILAR_LABELS );
-                        ercItem->SetItems( label, labelMap.at( normalized ) );
+                        ercItem->SetItems( label, it->second.second );
 
                         SCH_MARKER* marker = new SCH_MARKER( ercItem, label->GetPosition() );
                         subgraph->m_sheet.LastScreen()->Append( marker );
@@ -106,9 +106,10 @@ public:
 
     /**
      * Checks the full netlist against the pin-to-pin connectivity requirements
+     * @param aParallel set to test the nets on several threads; the markers are the same
      * @return the error count
      */
-    int TestPinToPin();
+    int TestPinToPin( bool aParallel = true );
 
     /**
      * Checks if shared pins on multi-unit symbols have been connected to different nets
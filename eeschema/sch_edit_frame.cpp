@@ -1447,7 +1447,11 @@ void SCH_EDIT_FRAME::RecalculateConnections( SCH_CLEANUP_FLAGS aCleanupFlags )
                 GetCanvas()->GetView()->Update( aChangedItem, KIGFX::REPAINT );
             };
 
-    Schematic().ConnectionGraph()->Recalculate( list, true, &changeHandler );
+    // Interactive edits only touch a few sheets; keep the item connections of the others.
+    bool unconditional = aCleanupFlags != LOCAL_CLEANUP
+                         || !ADVANCED_CFG::GetCfg().m_ReuseSheetConnectivity;
+
+    Schematic().ConnectionGraph()->Recalculate( list, unconditional, &changeHandler );
 
     GetCanvas()->GetView()->UpdateAllItemsConditionally( KIGFX::REPAINT,
             []( KIGFX::VIEW_ITEM* aItem )
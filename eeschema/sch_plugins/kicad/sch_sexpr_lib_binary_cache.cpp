@@ -0,0 +1,540 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <memory>
+
+#include <wx/log.h>
+
+#include <lib_binary_cache.h>
+#include <lib_field.h>
+#include <lib_pin.h>
+#include <lib_shape.h>
+#include <lib_symbol.h>
+#include <lib_text.h>
+#include <lib_textbox.h>
+#include <richio.h>
+#include <sha1_hash.h>
+#include <trace_helpers.h>
+#include "sch_sexpr_lib_binary_cache.h"
+#include "sch_sexpr_lib_plugin_cache.h"
+
+
+/// Identifies symbol library cache files.
+static const char     CACHE_MAGIC[8] = { 'K', 'I', 'S', 'Y', 'M', 'B', 'I', 'N' };
+
+/// Changes whenever the layout of the cache files changes.  Cache files written by another
+/// build of KiCad are never read, so this only needs bumping for changes made between builds.
+static const uint32_t CACHE_FORMAT_VERSION = 1;
+
+
+static void writeShapeStyle( BINARY_CACHE_WRITER& aOut, const LIB_SHAPE* aShape )
+{
+    STROKE_PARAMS stroke = aShape->GetStroke();
+
+    aOut.Int( stroke.GetWidth() );
+    aOut.Int( static_cast<int>( stroke.GetPlotStyle() ) );
+    aOut.Color( stroke.GetColor() );
+    aOut.Int( static_cast<int>( aShape->GetFillMode() ) );
+    aOut.Color( aShape->GetFillColor() );
+}
+
+
+static void readShapeStyle( BINARY_CACHE_READER& aIn, LIB_SHAPE* aShape )
+{
+    int            width = aIn.Int();
+    PLOT_DASH_TYPE plotStyle = static_cast<PLOT_DASH_TYPE>( aIn.Int() );
+    KIGFX::COLOR4D color = aIn.Color();
+
+    aShape->SetStroke( STROKE_PARAMS( width, plotStyle, color ) );
+    aShape->SetFillMode( static_cast<FILL_T>( aIn.Int() ) );
+    aShape->SetFillColor( aIn.Color() );
+}
+
+
+static void writeItem( BINARY_CACHE_WRITER& aOut, LIB_ITEM* aItem )
+{
+    aOut.Int( aItem->Type() );
+    aOut.Int( aItem->GetUnit() );
+    aOut.Int( aItem->GetConvert() );
+    aOut.Bool( aItem->IsPrivate() );
+
+    switch( aItem->Type() )
+    {
+    case LIB_SHAPE_T:
+    {
+        LIB_SHAPE* shape = static_cast<LIB_SHAPE*>( aItem );
+
+        aOut.Int( static_cast<int>( shape->GetShape() ) );
+        writeShapeStyle( aOut, shape );
+
+        switch( shape->GetShape() )
+        {
+        case SHAPE_T::ARC:
+            aOut.Point( shape->GetStart() );
+            aOut.Point( shape->GetEnd() );
+            aOut.Point( shape->GetCenter() );
+            aOut.Point( shape->GetArcMid() );
+            break;
+
+        case SHAPE_T::BEZIER:
+            aOut.Point( shape->GetStart() );
+            aOut.Point( shape->GetBezierC1() );
+            aOut.Point( shape->GetBezierC2() );
+            aOut.Point( shape->GetEnd() );
+            break;
+
+        case SHAPE_T::POLY:
+        {
+            const SHAPE_POLY_SET& poly = shape->GetPolyShape();
+            int pointCount = poly.OutlineCount() ? poly.Outline( 0 ).PointCount() : 0;
+
+            aOut.Int( pointCount );
+
+            for( int ii = 0; ii < pointCount; ++ii )
+                aOut.Point( poly.Outline( 0 ).CPoint( ii ) );
+
+            break;
+        }
+
+        default:
+            aOut.Point( shape->GetStart() );
+            aOut.Point( shape->GetEnd() );
+            break;
+        }
+
+        break;
+    }
+
+    case LIB_PIN_T:
+    {
+        LIB_PIN* pin = static_cast<LIB_PIN*>( aItem );
+
+        aOut.Int( static_cast<int>( pin->GetType() ) );
+        aOut.Int( static_cast<int>( pin->GetShape() ) );
+        aOut.Point( pin->GetPosition() );
+        aOut.Int( pin->GetOrientation() );
+        aOut.Int( pin->GetLength() );
+        aOut.Bool( pin->IsVisible() );
+        aOut.String( pin->GetName() );
+        aOut.String( pin->GetNumber() );
+        aOut.Int( pin->GetNameTextSize() );
+        aOut.Int( pin->GetNumberTextSize() );
+        aOut.Int( (int32_t) pin->GetAlternates().size() );
+
+        for( const std::pair<const wxString, LIB_PIN::ALT>& alt : pin->GetAlternates() )
+        {
+            aOut.String( alt.second.m_Name );
+            aOut.Int( static_cast<int>( alt.second.m_Type ) );
+            aOut.Int( static_cast<int>( alt.second.m_Shape ) );
+        }
+
+        break;
+    }
+
+    case LIB_TEXT_T:
+        aOut.Text( static_cast<LIB_TEXT*>( aItem ) );
+        break;
+
+    case LIB_TEXTBOX_T:
+    {
+        LIB_TEXTBOX* textBox = static_cast<LIB_TEXTBOX*>( aItem );
+
+        writeShapeStyle( aOut, textBox );
+        aOut.Point( textBox->GetStart() );
+        aOut.Point( textBox->GetEnd() );
+        aOut.Text( textBox );
+        break;
+    }
+
+    default:
+        wxFAIL_MSG( wxT( "Unexpected symbol item type " ) + aItem->GetClass() );
+    }
+}
+
+
+static LIB_ITEM* readItem( BINARY_CACHE_READER& aIn )
+{
+    KICAD_T type = static_cast<KICAD_T>( aIn.Int() );
+    int     unit = aIn.Int();
+    int     convert = aIn.Int();
+    bool    isPrivate = aIn.Bool();
+
+    std::unique_ptr<LIB_ITEM> item;
+
+    switch( type )
+    {
+    case LIB_SHAPE_T:
+    {
+        SHAPE_T                    shapeType = static_cast<SHAPE_T>( aIn.Int() );
+        std::unique_ptr<LIB_SHAPE> shape = std::make_unique<LIB_SHAPE>( nullptr, shapeType );
+
+        readShapeStyle( aIn, shape.get() );
+
+        switch( shapeType )
+        {
+        case SHAPE_T::ARC:
+        {
+            VECTOR2I start = aIn.Point();
+            VECTOR2I end = aIn.Point();
+            VECTOR2I center = aIn.Point();
+            VECTOR2I mid = aIn.Point();
+
+            shape->SetStart( start );
+            shape->SetEnd( end );
+            shape->SetCenter( center );
+            shape->SetCachedArcData( start, mid, end, center );
+            break;
+        }
+
+        case SHAPE_T::BEZIER:
+            shape->SetStart( aIn.Point() );
+            shape->SetBezierC1( aIn.Point() );
+            shape->SetBezierC2( aIn.Point() );
+            shape->SetEnd( aIn.Point() );
+            shape->RebuildBezierToSegmentsPointsList( shape->GetWidth() );
+            break;
+
+        case SHAPE_T::POLY:
+        {
+            size_t pointCount = aIn.Count();
+
+            for( size_t ii = 0; ii < pointCount && aIn.Ok(); ++ii )
+                shape->AddPoint( aIn.Point() );
+
+            break;
+        }
+
+        case SHAPE_T::CIRCLE:
+        case SHAPE_T::RECT:
+            shape->SetStart( aIn.Point() );
+            shape->SetEnd( aIn.Point() );
+            break;
+
+        default:
+            return nullptr;
+        }
+
+        item = std::move( shape );
+        break;
+    }
+
+    case LIB_PIN_T:
+    {
+        std::unique_ptr<LIB_PIN> pin = std::make_unique<LIB_PIN>( nullptr );
+
+        pin->SetType( static_cast<ELECTRICAL_PINTYPE>( aIn.Int() ) );
+        pin->SetShape( static_cast<GRAPHIC_PINSHAPE>( aIn.Int() ) );
+        pin->SetPosition( aIn.Point() );
+        pin->SetOrientation( aIn.Int() );
+        pin->SetLength( aIn.Int() );
+        pin->SetVisible( aIn.Bool() );
+        pin->SetName( aIn.String() );
+        pin->SetNumber( aIn.String() );
+        pin->SetNameTextSize( aIn.Int() );
+        pin->SetNumberTextSize( aIn.Int() );
+
+        size_t altCount = aIn.Count();
+
+        for( size_t ii = 0; ii < altCount && aIn.Ok(); ++ii )
+        {
+            LIB_PIN::ALT alt;
+
+            alt.m_Name = aIn.String();
+            alt.m_Type = static_cast<ELECTRICAL_PINTYPE>( aIn.Int() );
+            alt.m_Shape = static_cast<GRAPHIC_PINSHAPE>( aIn.Int() );
+            pin->GetAlternates()[ alt.m_Name ] = alt;
+        }
+
+        item = std::move( pin );
+        break;
+    }
+
+    case LIB_TEXT_T:
+    {
+        std::unique_ptr<LIB_TEXT> text = std::make_unique<LIB_TEXT>( nullptr );
+
+        aIn.Text( text.get() );
+        item = std::move( text );
+        break;
+    }
+
+    case LIB_TEXTBOX_T:
+    {
+        std::unique_ptr<LIB_TEXTBOX> textBox = std::make_unique<LIB_TEXTBOX>( nullptr );
+
+        readShapeStyle( aIn, textBox.get() );
+        textBox->SetStart( aIn.Point() );
+        textBox->SetEnd( aIn.Point() );
+        aIn.Text( textBox.get() );
+        item = std::move( textBox );
+        break;
+    }
+
+    default:
+        return nullptr;
+    }
+
+    item->SetUnit( unit );
+    item->SetConvert( convert );
+    item->SetPrivate( isPrivate );
+
+    return item.release();
+}
+
+
+static void writeSymbol( BINARY_CACHE_WRITER& aOut, LIB_SYMBOL* aSymbol,
+                         const wxString& aParentName )
+{
+    wxCHECK2( aSymbol->IsRoot(), /* the parent is stored by name */ );
+
+    aOut.String( aSymbol->GetLibId().Format().wx_str() );
+    aOut.String( aParentName );
+    aOut.Bool( aSymbol->IsPower() );
+    aOut.Int( aSymbol->GetPinNameOffset() );
+    aOut.Bool( aSymbol->ShowPinNames() );
+    aOut.Bool( aSymbol->ShowPinNumbers() );
+    aOut.Bool( aSymbol->GetIncludeInBom() );
+    aOut.Bool( aSymbol->GetIncludeOnBoard() );
+    aOut.Bool( aSymbol->UnitsLocked() );
+    aOut.Int( aSymbol->GetUnitCount() );
+    aOut.String( aSymbol->GetKeyWords() );
+    aOut.String( aSymbol->GetDescription() );
+
+    wxArrayString fpFilters = aSymbol->GetFPFilters();
+
+    aOut.Int( (int32_t) fpFilters.size() );
+
+    for( const wxString& filter : fpFilters )
+        aOut.String( filter );
+
+    std::vector<LIB_FIELD*> fields;
+    aSymbol->GetFields( fields );
+
+    aOut.Int( (int32_t) fields.size() );
+
+    for( LIB_FIELD* field : fields )
+    {
+        aOut.Int( field->GetId() );
+        aOut.String( field->GetName( false ) );
+        aOut.Text( field );
+    }
+
+    std::vector<LIB_ITEM*> items;
+
+    for( LIB_ITEM& item : aSymbol->GetDrawItems() )
+    {
+        if( item.Type() != LIB_FIELD_T )
+            items.push_back( &item );
+    }
+
+    aOut.Int( (int32_t) items.size() );
+
+    for( LIB_ITEM* item : items )
+        writeItem( aOut, item );
+}
+
+
+static LIB_SYMBOL* readSymbol( BINARY_CACHE_READER& aIn, wxString& aParentName )
+{
+    std::unique_ptr<LIB_SYMBOL> symbol = std::make_unique<LIB_SYMBOL>( wxEmptyString );
+    LIB_ID                      id;
+
+    if( id.Parse( aIn.String() ) >= 0 )
+        return nullptr;
+
+    symbol->SetName( id.GetLibItemName().wx_str() );
+    symbol->SetLibId( id );
+
+    aParentName = aIn.String();
+
+    if( aIn.Bool() )
+        symbol->SetPower();
+
+    symbol->SetPinNameOffset( aIn.Int() );
+    symbol->SetShowPinNames( aIn.Bool() );
+    symbol->SetShowPinNumbers( aIn.Bool() );
+    symbol->SetIncludeInBom( aIn.Bool() );
+    symbol->SetIncludeOnBoard( aIn.Bool() );
+    symbol->LockUnits( aIn.Bool() );
+    symbol->SetUnitCount( aIn.Int(), false );
+    symbol->SetKeyWords( aIn.String() );
+    symbol->SetDescription( aIn.String() );
+
+    wxArrayString fpFilters;
+    size_t        filterCount = aIn.Count();
+
+    for( size_t ii = 0; ii < filterCount && aIn.Ok(); ++ii )
+        fpFilters.Add( aIn.String() );
+
+    symbol->SetFPFilters( fpFilters );
+
+    size_t fieldCount = aIn.Count();
+
+    for( size_t ii = 0; ii < fieldCount && aIn.Ok(); ++ii )
+    {
+        int                        id = aIn.Int();
+        std::unique_ptr<LIB_FIELD> field = std::make_unique<LIB_FIELD>( symbol.get(), id );
+
+        field->SetName( aIn.String() );
+        aIn.Text( field.get() );
+
+        if( id >= 0 && id < MANDATORY_FIELDS )
+            *symbol->GetFieldById( id ) = *field;
+        else
+            symbol->AddDrawItem( field.release(), false );
+    }
+
+    size_t itemCount = aIn.Count();
+
+    for( size_t ii = 0; ii < itemCount && aIn.Ok(); ++ii )
+    {
+        LIB_ITEM* item = readItem( aIn );
+
+        if( !item )
+            return nullptr;
+
+        item->SetParent( symbol.get() );
+        symbol->AddDrawItem( item, false );
+    }
+
+    if( !aIn.Ok() )
+        return nullptr;
+
+    symbol->GetDrawItems().sort();
+
+    return symbol.release();
+}
+
+
+/**
+ * Format \a aSymbol the way it is saved in symbol library files.
+ */
+static std::string formatSymbol( LIB_SYMBOL* aSymbol )
+{
+    STRING_FORMATTER formatter;
+
+    SCH_SEXPR_PLUGIN_CACHE::SaveSymbol( aSymbol, formatter );
+    return formatter.GetString();
+}
+
+
+SCH_SEXPR_LIB_BINARY_CACHE::SCH_SEXPR_LIB_BINARY_CACHE( const wxString& aLibraryPath,
+                                                        const std::string& aContent,
+                                                        const wxString& aCacheDir ) :
+        m_cacheFile( wxT( "symbols" ), aLibraryPath, aCacheDir )
+{
+    SHA1_HASH contentHash;
+
+    contentHash.Update( aContent.data(), aContent.size() );
+    contentHash.GetDigest( m_contentHash );
+}
+
+
+bool SCH_SEXPR_LIB_BINARY_CACHE::Read( std::vector<LIB_SYMBOL*>& aSymbols,
+                                       std::vector<wxString>& aParentNames ) const
+{
+    std::string buffer;
+
+    if( !m_cacheFile.Read( buffer ) )
+        return false;
+
+    BINARY_CACHE_READER in( buffer );
+    unsigned char       contentHash[sizeof( m_contentHash )];
+
+    bool valid = in.Header( CACHE_MAGIC, CACHE_FORMAT_VERSION );
+    in.Raw( contentHash, sizeof( contentHash ) );
+
+    if( !valid || !in.Ok() || memcmp( contentHash, m_contentHash, sizeof( contentHash ) ) != 0 )
+    {
+        wxLogTrace( traceSchLegacyPlugin, "Symbol cache '%s' is out of date",
+                    m_cacheFile.GetFileName().GetFullPath() );
+        return false;
+    }
+
+    std::vector<LIB_SYMBOL*> symbols;
+    std::vector<wxString>    parentNames;
+    size_t                   count = in.Count();
+
+    for( size_t ii = 0; ii < count && in.Ok(); ++ii )
+    {
+        wxString    parentName;
+        LIB_SYMBOL* symbol = readSymbol( in, parentName );
+
+        if( !symbol )
+            break;
+
+        symbols.push_back( symbol );
+        parentNames.push_back( parentName );
+    }
+
+    if( symbols.size() != count )
+    {
+        wxLogTrace( traceSchLegacyPlugin, "Symbol cache '%s' is corrupt",
+                    m_cacheFile.GetFileName().GetFullPath() );
+
+        for( LIB_SYMBOL* symbol : symbols )
+            delete symbol;
+
+        return false;
+    }
+
+    aSymbols = std::move( symbols );
+    aParentNames = std::move( parentNames );
+
+    return true;
+}
+
+
+void SCH_SEXPR_LIB_BINARY_CACHE::Write( const std::vector<LIB_SYMBOL*>& aSymbols,
+                                        const std::vector<wxString>& aParentNames ) const
+{
+    wxCHECK_RET( aSymbols.size() == aParentNames.size(), "Missing symbol parent names." );
+
+    BINARY_CACHE_WRITER out;
+
+    out.Header( CACHE_MAGIC, CACHE_FORMAT_VERSION );
+    out.Raw( m_contentHash, sizeof( m_contentHash ) );
+    out.Int( (int32_t) aSymbols.size() );
+
+    for( size_t ii = 0; ii < aSymbols.size(); ++ii )
+    {
+        BINARY_CACHE_WRITER symbolOut;
+        wxString            parentName;
+
+        writeSymbol( symbolOut, aSymbols[ii], aParentNames[ii] );
+
+        // Make sure nothing saved in the library file is lost on the way through the cache,
+        // ie: that the serializer knows about every property of the symbol.  This is only
+        // done when the library changed, so it doesn't slow down loading from the cache.
+        BINARY_CACHE_READER         in( symbolOut.GetBuffer() );
+        std::unique_ptr<LIB_SYMBOL> readBack( readSymbol( in, parentName ) );
+
+        if( !readBack || formatSymbol( readBack.get() ) != formatSymbol( aSymbols[ii] ) )
+        {
+            wxLogTrace( traceSchLegacyPlugin, "Symbol %s can't be cached; not caching '%s'",
+                        aSymbols[ii]->GetName(), m_cacheFile.GetFileName().GetFullPath() );
+            return;
+        }
+
+        out.Raw( symbolOut.GetBuffer().data(), symbolOut.GetBuffer().size() );
+    }
+
+    m_cacheFile.Write( out.GetBuffer() );
+}
@@ -0,0 +1,91 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _SCH_SEXPR_LIB_BINARY_CACHE_
+#define _SCH_SEXPR_LIB_BINARY_CACHE_
+
+#include <string>
+#include <vector>
+
+#include <wx/string.h>
+
+#include <lib_binary_cache.h>
+#include <sha1_hash.h>
+
+class LIB_SYMBOL;
+
+
+/**
+ * A precompiled, binary copy of the symbols of an s-expression symbol library, stored in the
+ * user cache directory.
+ *
+ * The cache file of a library is named after the library path and is only valid for the exact
+ * library file content it was written for, so any change of the library file (including one
+ * made outside of KiCad) invalidates it.
+ *
+ * Symbols are stored as they come out of the parser, that is before the inheritance of derived
+ * symbols is resolved.  The name of the parent of each symbol is stored alongside it so the
+ * caller can resolve the inheritance the same way for parsed and cached symbols.
+ *
+ * Libraries are only cached when all their symbols read back from the cache the same as they
+ * were parsed.
+ *
+ * This is enabled with the SymbolLibraryCache advanced config setting.
+ */
+class SCH_SEXPR_LIB_BINARY_CACHE
+{
+public:
+    /**
+     * @param aLibraryPath is the full path of the library file.
+     * @param aContent is the content of the library file.
+     * @param aCacheDir is the directory to keep the cache in instead of the user cache directory.
+     */
+    SCH_SEXPR_LIB_BINARY_CACHE( const wxString& aLibraryPath, const std::string& aContent,
+                                const wxString& aCacheDir = wxEmptyString );
+
+    /**
+     * Read the symbols of the library from the cache.
+     *
+     * @param aSymbols is filled with the cached symbols, owned by the caller.
+     * @param aParentNames is filled with the parent name of each symbol, or an empty string.
+     * @return false if there is no valid cache for the library content, in which case nothing
+     *         is returned.
+     */
+    bool Read( std::vector<LIB_SYMBOL*>& aSymbols, std::vector<wxString>& aParentNames ) const;
+
+    /**
+     * Write the symbols of the library to the cache.
+     *
+     * Failing to write the cache is not an error; the library will just be parsed again the
+     * next time it is loaded.
+     *
+     * @param aSymbols are the symbols parsed from the library, in file order.
+     * @param aParentNames is the parent name of each symbol, or an empty string.
+     */
+    void Write( const std::vector<LIB_SYMBOL*>& aSymbols,
+                const std::vector<wxString>& aParentNames ) const;
+
+private:
+    LIB_BINARY_CACHE_FILE m_cacheFile;
+
+    /// SHA1 of the library file content.
+    unsigned char         m_contentHash[SHA1_HASH::DIGEST_SIZE];
+};
+
+#endif    // _SCH_SEXPR_LIB_BINARY_CACHE_
@@ -19,6 +19,13 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <atomic>
+#include <cctype>
+#include <exception>
+#include <future>
+#include <memory>
+
+#include <advanced_config.h>
 #include <lib_field.h>
 #include <lib_shape.h>
 #include <lib_symbol.h>
@@ -27,13 +34,143 @@
 #include <locale_io.h>
 #include <macros.h>
 #include <richio.h>
+#include "sch_sexpr_lib_binary_cache.h"
 #include "sch_sexpr_lib_plugin_cache.h"
 #include "sch_sexpr_plugin_common.h"
 #include "sch_sexpr_parser.h"
 #include <string_utils.h>
+#include <thread_budget.h>
 #include <trace_helpers.h>
 
 
+/**
+ * A #STRING_LINE_READER over a part of a file which reports line numbers relative to the
+ * whole file.
+ */
+class SPAN_LINE_READER : public STRING_LINE_READER
+{
+public:
+    SPAN_LINE_READER( const std::string& aText, const wxString& aSource, unsigned aFirstLine ) :
+            STRING_LINE_READER( aText, aSource )
+    {
+        m_lineNum = aFirstLine;
+    }
+};
+
+
+bool SCH_SEXPR_PLUGIN_CACHE::SplitLibSymbols( const std::string& aText, size_t& aHeaderEnd,
+                                              std::vector<LIB_SYMBOL_SPAN>& aSpans )
+{
+    static const std::string symbolToken = "symbol";
+
+    int      depth = 0;
+    bool     inString = false;
+    bool     done = false;
+    unsigned line = 0;
+    size_t   lineStart = 0;
+
+    auto isLineStart =
+            [&]( size_t aOffset )
+            {
+                for( size_t ii = lineStart; ii < aOffset; ++ii )
+                {
+                    if( !isspace( (unsigned char) aText[ii] ) )
+                        return false;
+                }
+
+                return true;
+            };
+
+    for( size_t ii = 0; ii < aText.size(); ++ii )
+    {
+        char c = aText[ii];
+
+        if( c == '\n' )
+        {
+            // The lexer doesn't allow strings to span lines.
+            if( inString )
+                return false;
+
+            ++line;
+            lineStart = ii + 1;
+            continue;
+        }
+
+        if( inString )
+        {
+            if( c == '\\' && ii + 1 < aText.size() && aText[ii + 1] != '\n' )
+                ++ii;
+            else if( c == '"' )
+                inString = false;
+
+            continue;
+        }
+
+        if( c == '#' && isLineStart( ii ) )
+        {
+            // A comment line, which the lexer skips whatever its depth.
+            while( ii + 1 < aText.size() && aText[ii + 1] != '\n' )
+                ++ii;
+
+            continue;
+        }
+
+        if( done )
+        {
+            // Nothing but white space may follow the library.
+            if( !isspace( (unsigned char) c ) )
+                return false;
+
+            continue;
+        }
+
+        if( c == '"' )
+        {
+            inString = true;
+        }
+        else if( c == '(' )
+        {
+            if( ++depth != 2 )
+                continue;
+
+            size_t token = ii + 1;
+
+            while( token < aText.size() && isspace( (unsigned char) aText[token] ) )
+                ++token;
+
+            bool isSymbol = aText.compare( token, symbolToken.size(), symbolToken ) == 0
+                            && token + symbolToken.size() < aText.size()
+                            && isspace( (unsigned char) aText[token + symbolToken.size()] );
+
+            if( isSymbol )
+            {
+                if( aSpans.empty() )
+                    aHeaderEnd = ii;
+
+                aSpans.push_back( { ii, 0, line, ii - lineStart } );
+            }
+            else if( !aSpans.empty() )
+            {
+                // Only symbols may follow the header.
+                return false;
+            }
+        }
+        else if( c == ')' )
+        {
+            if( depth == 2 && !aSpans.empty() && aSpans.back().m_End == 0 )
+                aSpans.back().m_End = ii + 1;
+
+            if( --depth == 0 )
+                done = true;
+            else if( depth < 0 )
+                return false;
+        }
+    }
+
+    return done && !inString && !aSpans.empty();
+}
+
+
 SCH_SEXPR_PLUGIN_CACHE::SCH_SEXPR_PLUGIN_CACHE( const wxString& aFullPathAndFileName ) :
     SCH_LIB_PLUGIN_CACHE( aFullPathAndFileName )
 {
@@ -66,10 +203,47 @@ void SCH_SEXPR_PLUGIN_CACHE::Load()
                 m_libFileName.GetFullPath() );
 
     FILE_LINE_READER reader( m_libFileName.GetFullPath() );
+    std::string      text;
+
+    while( reader.ReadLine() )
+        text.append( reader.Line(), reader.Length() );
+
+    std::unique_ptr<SCH_SEXPR_LIB_BINARY_CACHE> binaryCache;
+    std::vector<LIB_SYMBOL*>                    symbols;
+    std::vector<wxString>                       parentNames;
+    std::vector<LIB_SYMBOL_SPAN>                spans;
+    size_t                                      headerEnd = 0;
+
+    if( ADVANCED_CFG::GetCfg().m_SymbolLibraryCache )
+    {
+        binaryCache = std::make_unique<SCH_SEXPR_LIB_BINARY_CACHE>( m_libFileName.GetFullPath(),
+                                                                    text );
+    }
+
+    if( binaryCache && binaryCache->Read( symbols, parentNames ) )
+    {
+        wxLogTrace( traceSchLegacyPlugin, "Loaded %zu symbols from the cache of '%s'",
+                    symbols.size(), m_libFileName.GetFullPath() );
+
+        addSymbols( symbols, parentNames );
+    }
+    else if( SplitLibSymbols( text, headerEnd, spans ) )
+    {
+        parseSymbols( text, headerEnd, spans, symbols, parentNames );
 
-    SCH_SEXPR_PARSER parser( &reader );
+        if( binaryCache )
+            binaryCache->Write( symbols, parentNames );
+
+        addSymbols( symbols, parentNames );
+    }
+    else
+    {
+        STRING_LINE_READER fileReader( text, reader.GetSource() );
+        SCH_SEXPR_PARSER   parser( &fileReader );
+
+        parser.ParseLib( m_symbols );
+    }
 
-    parser.ParseLib( m_symbols );
     ++m_modHash;
 
     // Remember the file modification time of library file when the
@@ -79,6 +253,112 @@ void SCH_SEXPR_PLUGIN_CACHE::Load()
 }
 
 
+void SCH_SEXPR_PLUGIN_CACHE::parseSymbols( const std::string& aText, size_t aHeaderEnd,
+                                           const std::vector<LIB_SYMBOL_SPAN>& aSpans,
+                                           std::vector<LIB_SYMBOL*>& aSymbols,
+                                           std::vector<wxString>& aParentNames )
+{
+    const wxString source = m_libFileName.GetFullPath();
+
+    STRING_LINE_READER headerReader( aText.substr( 0, aHeaderEnd ), source );
+    SCH_SEXPR_PARSER   headerParser( &headerReader );
+    int                version = headerParser.ParseLibHeader();
+
+    std::vector<LIB_SYMBOL*>        symbols( aSpans.size(), nullptr );
+    std::vector<wxString>           parentNames( aSpans.size() );
+    std::vector<std::exception_ptr> errors( aSpans.size() );
+    std::atomic<size_t>             nextSpan( 0 );
+
+    auto parse_lambda =
+            [&]() -> size_t
+            {
+                for( size_t ii = nextSpan++; ii < aSpans.size(); ii = nextSpan++ )
+                {
+                    const LIB_SYMBOL_SPAN& span = aSpans[ii];
+
+                    // Pad the first line so that error messages report the right column.
+                    std::string spanText( span.m_Column, ' ' );
+                    spanText.append( aText, span.m_Start, span.m_End - span.m_Start );
+
+                    SPAN_LINE_READER reader( spanText, source, span.m_Line );
+                    SCH_SEXPR_PARSER parser( &reader );
+
+                    try
+                    {
+                        symbols[ii] = parser.ParseLibSymbol( version, parentNames[ii] );
+                    }
+                    catch( ... )
+                    {
+                        errors[ii] = std::current_exception();
+                    }
+                }
+
+                return 1;
+            };
+
+    // Share the cores with the other parallel loads (eg: SYMBOL_ASYNC_LOADER's, which load
+    // several libraries at once); the symbols are parsed on this thread when there are none left.
+    THREAD_BUDGET budget( ( aSpans.size() + 3 ) / 4 );
+    size_t        parallelThreadCount = budget.GetCount();
+
+    if( parallelThreadCount <= 1 )
+    {
+        parse_lambda();
+    }
+    else
+    {
+        std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, parse_lambda );
+
+        // Finalize the threads
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii].wait();
+    }
+
+    // Report the first error in the file, as the sequential parser would have.
+    for( size_t ii = 0; ii < aSpans.size(); ++ii )
+    {
+        if( errors[ii] )
+        {
+            for( LIB_SYMBOL* symbol : symbols )
+                delete symbol;
+
+            std::rethrow_exception( errors[ii] );
+        }
+    }
+
+    aSymbols = std::move( symbols );
+    aParentNames = std::move( parentNames );
+}
+
+
+void SCH_SEXPR_PLUGIN_CACHE::addSymbols( const std::vector<LIB_SYMBOL*>& aSymbols,
+                                         const std::vector<wxString>& aParentNames )
+{
+    for( LIB_SYMBOL* symbol : aSymbols )
+        m_symbols[symbol->GetName()] = symbol;
+
+    // Now that all symbols are known, resolve the inheritance of the derived ones.
+    for( size_t ii = 0; ii < aSymbols.size(); ++ii )
+    {
+        if( aParentNames[ii].IsEmpty() )
+            continue;
+
+        auto it = m_symbols.find( aParentNames[ii] );
+
+        if( it == m_symbols.end() )
+        {
+            THROW_IO_ERROR( wxString::Format( _( "No parent for extended symbol %s" ),
+                                              aParentNames[ii] ) );
+        }
+
+        aSymbols[ii]->SetParent( it->second );
+    }
+}
+
+
 void SCH_SEXPR_PLUGIN_CACHE::Save( const std::optional<bool>& aOpt )
 {
     if( !m_isModified )
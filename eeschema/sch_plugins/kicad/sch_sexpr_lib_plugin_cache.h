@@ -22,6 +22,8 @@
 #ifndef _SCH_SEXPR_LIB_PLUGIN_CACHE_
 #define _SCH_SEXPR_LIB_PLUGIN_CACHE_
 
+#include <vector>
+
 #include "../sch_lib_plugin_cache.h"
 
 class FILE_LINE_READER;
@@ -33,6 +35,19 @@ class LIB_TEXTBOX;
 class LINE_READER;
 class SCH_SEXPR_PLUGIN;
 
+
+/**
+ * The location of a top level (symbol ...) list in a symbol library file.
+ */
+struct LIB_SYMBOL_SPAN
+{
+    size_t   m_Start;       ///< Offset of the opening parenthesis.
+    size_t   m_End;         ///< Offset just past the closing parenthesis.
+    unsigned m_Line;        ///< Line number of the opening parenthesis, zero based.
+    size_t   m_Column;      ///< Offset of the opening parenthesis within its line.
+};
+
+
 /**
  * A cache assistant for the KiCad s-expression symbol libraries.
  */
@@ -56,9 +71,43 @@ public:
     static void SaveSymbol( LIB_SYMBOL* aSymbol, OUTPUTFORMATTER& aFormatter,
                             int aNestLevel = 0, const wxString& aLibName = wxEmptyString );
 
+    /**
+     * Split the text of a symbol library file into its header and its top level symbols.
+     *
+     * @param aText is the content of the library file.
+     * @param aHeaderEnd is set to the offset of the first symbol.
+     * @param aSpans is filled with the locations of the symbols, in file order.
+     * @return false if the file is not laid out as expected, in which case it is left to the
+     *         sequential parser to load it or to report what is wrong with it.
+     */
+    static bool SplitLibSymbols( const std::string& aText, size_t& aHeaderEnd,
+                                 std::vector<LIB_SYMBOL_SPAN>& aSpans );
+
 private:
     friend SCH_SEXPR_PLUGIN;
 
+    /**
+     * Parse the symbols of the library file \a aText, which has been split into the header
+     * and top level symbols by the caller.
+     *
+     * The symbols are parsed concurrently on the worker threads left in the THREAD_BUDGET.  The
+     * parents of derived symbols are not resolved; their names are returned in \a aParentNames
+     * for addSymbols().
+     *
+     * @throw IO_ERROR if any of the symbols cannot be parsed.
+     */
+    void parseSymbols( const std::string& aText, size_t aHeaderEnd,
+                       const std::vector<LIB_SYMBOL_SPAN>& aSpans,
+                       std::vector<LIB_SYMBOL*>& aSymbols, std::vector<wxString>& aParentNames );
+
+    /**
+     * Take ownership of \a aSymbols and resolve the parents of the derived ones.
+     *
+     * @throw IO_ERROR if the parent of a derived symbol is not in the library.
+     */
+    void addSymbols( const std::vector<LIB_SYMBOL*>& aSymbols,
+                     const std::vector<wxString>& aParentNames );
+
     static void saveSymbolDrawItem( LIB_ITEM* aItem, OUTPUTFORMATTER& aFormatter,
                                     int aNestLevel );
     static void saveField( LIB_FIELD* aField, OUTPUTFORMATTER& aFormatter, int aNestLevel );
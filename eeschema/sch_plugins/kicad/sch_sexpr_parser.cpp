@@ -68,6 +68,7 @@ SCH_SEXPR_PARSER::SCH_SEXPR_PARSER( LINE_READER* aLineReader, PROGRESS_REPORTER*
     m_fieldId( 0 ),
     m_unit( 1 ),
     m_convert( 1 ),
+    m_deferredParentName( nullptr ),
     m_progressReporter( aProgressReporter ),
     m_lineReader( aLineReader ),
     m_lastProgressLine( 0 ),
@@ -156,6 +157,46 @@ void SCH_SEXPR_PARSER::ParseLib( LIB_SYMBOL_MAP& aSymbolLibMap )
 }
 
 
+int SCH_SEXPR_PARSER::ParseLibHeader()
+{
+    NeedLEFT();
+    NextTok();
+    parseHeader( T_kicad_symbol_lib, SEXPR_SYMBOL_LIB_FILE_VERSION );
+
+    return m_requiredVersion;
+}
+
+
+LIB_SYMBOL* SCH_SEXPR_PARSER::ParseLibSymbol( int aFileVersion, wxString& aParentName )
+{
+    LIB_SYMBOL_MAP noSymbols;
+    LIB_SYMBOL*    symbol = nullptr;
+
+    NeedLEFT();
+
+    if( NextTok() != T_symbol )
+        Expecting( "symbol" );
+
+    m_unit = 1;
+    m_convert = 1;
+    m_deferredParentName = &aParentName;
+
+    try
+    {
+        symbol = ParseSymbol( noSymbols, aFileVersion );
+    }
+    catch( ... )
+    {
+        m_deferredParentName = nullptr;
+        throw;
+    }
+
+    m_deferredParentName = nullptr;
+
+    return symbol;
+}
+
+
 LIB_SYMBOL* SCH_SEXPR_PARSER::ParseSymbol( LIB_SYMBOL_MAP& aSymbolLibMap, int aFileVersion )
 {
     wxCHECK_MSG( CurTok() == T_symbol, nullptr,
@@ -249,6 +290,14 @@ LIB_SYMBOL* SCH_SEXPR_PARSER::ParseSymbol( LIB_SYMBOL_MAP& aSymbolLibMap, int aF
             }
 
             name = FromUTF8();
+
+            if( m_deferredParentName )
+            {
+                *m_deferredParentName = name;
+                NeedRIGHT();
+                break;
+            }
+
             auto it = aSymbolLibMap.find( name );
 
             if( it == aSymbolLibMap.end() )
@@ -84,6 +84,9 @@ class SCH_SEXPR_PARSER : public SCHEMATIC_LEXER
     int m_convert;          ///< The current body style being parsed.
     wxString m_symbolName;  ///< The current symbol name.
 
+    /// When set, the parent name of a derived symbol is stored here rather than looked up.
+    wxString* m_deferredParentName;
+
     /// Field IDs that have been read so far for the current symbol.
     std::set<int>      m_fieldIDsRead;
 
@@ -210,6 +213,25 @@ public:
 
     void ParseLib( LIB_SYMBOL_MAP& aSymbolLibMap );
 
+    /**
+     * Parse the header of a symbol library file, up to its first symbol.
+     *
+     * @return the file version of the library.
+     */
+    int ParseLibHeader();
+
+    /**
+     * Parse a single top level symbol of a symbol library file.
+     *
+     * Unlike ParseSymbol(), the parent of a derived symbol is not looked up.  Its name is
+     * returned in \a aParentName instead so the symbols of a library can be parsed
+     * independently of each other and the inheritance resolved once all of them are loaded.
+     *
+     * @param aFileVersion is the file version returned by ParseLibHeader().
+     * @param aParentName is set to the name of the parent symbol, or left empty.
+     */
+    LIB_SYMBOL* ParseLibSymbol( int aFileVersion, wxString& aParentName );
+
     LIB_SYMBOL* ParseSymbol( LIB_SYMBOL_MAP& aSymbolLibMap,
                              int aFileVersion = SEXPR_SYMBOL_LIB_FILE_VERSION );
 
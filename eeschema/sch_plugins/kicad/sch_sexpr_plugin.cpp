@@ -21,6 +21,10 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <future>
+#include <set>
+#include <thread>
 
 // For some reason wxWidgets is built with wxUSE_BASE64 unset so expose the wxWidgets
 // base64 code.
@@ -93,6 +97,7 @@ void SCH_SEXPR_PLUGIN::init( SCHEMATIC* aSchematic, const PROPERTIES* aPropertie
     m_cache           = nullptr;
     m_out             = nullptr;
     m_nextFreeFieldId = 100; // number arbitrarily > MANDATORY_FIELDS or SHEET_MANDATORY_FIELDS
+    m_preloadedSheets.clear();
 }
 
 
@@ -177,7 +182,9 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
 {
     SCH_SCREEN* screen = nullptr;
 
-    if( !aSheet->GetScreen() )
+    auto preloaded = m_preloadedSheets.find( aSheet );
+
+    if( !aSheet->GetScreen() || preloaded != m_preloadedSheets.end() )
     {
         // SCH_SCREEN objects store the full path and file name where the SCH_SHEET object only
         // stores the file name and extension.  Add the project path to the file name and
@@ -195,7 +202,8 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
         wxLogTrace( traceSchLegacyPlugin, "Current path   '%s'", m_currentPath.top() );
         wxLogTrace( traceSchLegacyPlugin, "Loading        '%s'", fileName.GetFullPath() );
 
-        m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen );
+        if( preloaded == m_preloadedSheets.end() )
+            m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen );
 
         if( screen )
         {
@@ -205,24 +213,41 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
         }
         else
         {
-            aSheet->SetScreen( new SCH_SCREEN( m_schematic ) );
-            aSheet->GetScreen()->SetFileName( fileName.GetFullPath() );
-
-            try
+            if( preloaded != m_preloadedSheets.end() )
             {
-                loadFile( fileName.GetFullPath(), aSheet );
+                // The file was already parsed by preloadSubsheets().  Queue up its error
+                // message here so errors are still reported in hierarchy order.
+                if( !preloaded->second.IsEmpty() )
+                {
+                    if( !m_error.IsEmpty() )
+                        m_error += "\n";
+
+                    m_error += preloaded->second;
+                }
+
+                m_preloadedSheets.erase( preloaded );
             }
-            catch( const IO_ERROR& ioe )
+            else
             {
-                // If there is a problem loading the root sheet, there is no recovery.
-                if( aSheet == m_rootSheet )
-                    throw;
+                aSheet->SetScreen( new SCH_SCREEN( m_schematic ) );
+                aSheet->GetScreen()->SetFileName( fileName.GetFullPath() );
+
+                try
+                {
+                    loadFile( fileName.GetFullPath(), aSheet );
+                }
+                catch( const IO_ERROR& ioe )
+                {
+                    // If there is a problem loading the root sheet, there is no recovery.
+                    if( aSheet == m_rootSheet )
+                        throw;
 
-                // For all subsheets, queue up the error message for the caller.
-                if( !m_error.IsEmpty() )
-                    m_error += "\n";
+                    // For all subsheets, queue up the error message for the caller.
+                    if( !m_error.IsEmpty() )
+                        m_error += "\n";
 
-                m_error += ioe.What();
+                    m_error += ioe.What();
+                }
             }
 
             if( fileName.FileExists() )
@@ -236,6 +261,8 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
                 aSheet->GetScreen()->SetFileExists( false );
             }
 
+            preloadSubsheets( aSheet );
+
             // This was moved out of the try{} block so that any sheets definitionsthat
             // the plugin fully parsed before the exception was raised will be loaded.
             for( SCH_ITEM* aItem : aSheet->GetScreen()->Items().OfType( SCH_SHEET_T ) )
@@ -254,6 +281,95 @@ void SCH_SEXPR_PLUGIN::loadHierarchy( SCH_SHEET* aSheet )
 }
 
 
+void SCH_SEXPR_PLUGIN::preloadSubsheets( SCH_SHEET* aSheet )
+{
+    std::vector<std::pair<SCH_SHEET*, wxString>> toLoad;
+    std::set<wxString>                           fileNames;
+
+    for( SCH_ITEM* aItem : aSheet->GetScreen()->Items().OfType( SCH_SHEET_T ) )
+    {
+        SCH_SHEET* sheet = static_cast<SCH_SHEET*>( aItem );
+
+        if( sheet->GetScreen() )
+            continue;
+
+        wxFileName fileName = sheet->GetFileName();
+
+        if( !fileName.IsAbsolute() )
+            fileName.MakeAbsolute( m_currentPath.top() );
+
+        // Files already in the hierarchy (including the ones being descended, which is what
+        // stops recursive sheets) are shared by loadHierarchy() rather than parsed again.
+        SCH_SCREEN* screen = nullptr;
+        m_rootSheet->SearchHierarchy( fileName.GetFullPath(), &screen );
+
+        if( screen || !fileNames.insert( fileName.GetFullPath() ).second )
+            continue;
+
+        toLoad.emplace_back( sheet, fileName.GetFullPath() );
+    }
+
+    // A single file gains nothing from a worker thread and keeps the detailed progress report.
+    if( toLoad.size() < 2 )
+        return;
+
+    if( m_progressReporter )
+    {
+        m_progressReporter->Report( wxString::Format( _( "Loading %d sheets..." ),
+                                                      (int) toLoad.size() ) );
+
+        if( !m_progressReporter->KeepRefreshing() )
+            THROW_IO_ERROR( ( "Open cancelled by user." ) );
+    }
+
+    // Screens are created here so the workers only touch the sheet and screen they parse.
+    for( const std::pair<SCH_SHEET*, wxString>& entry : toLoad )
+    {
+        entry.first->SetScreen( new SCH_SCREEN( m_schematic ) );
+        entry.first->GetScreen()->SetFileName( entry.second );
+    }
+
+    std::vector<wxString>          errors( toLoad.size() );
+    std::atomic<size_t>            nextSheet( 0 );
+    std::vector<std::future<void>> returns;
+    size_t                         parallelThreadCount = std::max<size_t>( 1,
+                                            std::min<size_t>( std::thread::hardware_concurrency(),
+                                                              toLoad.size() ) );
+
+    wxLogTrace( traceSchLegacyPlugin, "Parsing %zu sheets of '%s' on %zu threads.",
+                toLoad.size(), aSheet->GetScreen()->GetFileName(), parallelThreadCount );
+
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    {
+        returns.emplace_back( std::async( std::launch::async,
+                [&]()
+                {
+                    for( size_t i = nextSheet.fetch_add( 1 ); i < toLoad.size();
+                         i = nextSheet.fetch_add( 1 ) )
+                    {
+                        try
+                        {
+                            FILE_LINE_READER reader( toLoad[i].second );
+                            SCH_SEXPR_PARSER parser( &reader );
+
+                            parser.ParseSchematic( toLoad[i].first );
+                        }
+                        catch( const IO_ERROR& ioe )
+                        {
+                            errors[i] = ioe.What();
+                        }
+                    }
+                } ) );
+    }
+
+    for( std::future<void>& ret : returns )
+        ret.get();
+
+    for( size_t i = 0; i < toLoad.size(); ++i )
+        m_preloadedSheets[ toLoad[i].first ] = errors[i];
+}
+
+
 void SCH_SEXPR_PLUGIN::loadFile( const wxString& aFileName, SCH_SHEET* aSheet )
 {
     FILE_LINE_READER reader( aFileName );
@@ -23,6 +23,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <map>
 #include <memory>
 #include <sch_io_mgr.h>
 #include <sch_file_versions.h>
@@ -143,6 +144,15 @@ private:
     void loadHierarchy( SCH_SHEET* aSheet );
     void loadFile( const wxString& aFileName, SCH_SHEET* aSheet );
 
+    /**
+     * Parse the files of the child sheets of \a aSheet concurrently.
+     *
+     * Each distinct file not already loaded in the hierarchy is parsed once into the screen
+     * of the first sheet referencing it.  loadHierarchy() then links the remaining sheets to
+     * the shared screens and descends as usual.
+     */
+    void preloadSubsheets( SCH_SHEET* aSheet );
+
     void saveSymbol( SCH_SYMBOL* aSymbol, SCH_SHEET_PATH* aSheetPath, int aNestLevel,
                      bool aForClipboard );
     void saveField( SCH_FIELD* aField, int aNestLevel );
@@ -176,6 +186,8 @@ protected:
     SCHEMATIC*              m_schematic;
     OUTPUTFORMATTER*        m_out;              ///< The formatter for saving SCH_SCREEN objects.
     SCH_SEXPR_PLUGIN_CACHE* m_cache;
+    std::map<SCH_SHEET*, wxString> m_preloadedSheets; ///< Sheets parsed by preloadSubsheets(),
+                                                      ///< with their load error if any.
 
     /// initialize PLUGIN like a constructor would.
     void init( SCHEMATIC* aSchematic, const PROPERTIES* aProperties = nullptr );
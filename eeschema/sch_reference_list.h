@@ -314,7 +314,7 @@ public:
             aStartNumber)
      */
     void Annotate( bool aUseSheetNum, int aSheetIntervalId, int aStartNumber,
-                   SCH_MULTI_UNIT_REFERENCE_MAP aLockedUnitMap,
+                   const SCH_MULTI_UNIT_REFERENCE_MAP& aLockedUnitMap,
                    const SCH_REFERENCE_LIST& aAdditionalRefs, bool aStartAtCurrent = false );
 
     /**
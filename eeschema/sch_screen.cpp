@@ -29,6 +29,7 @@
  * @brief Implementation of SCH_SCREEN and SCH_SCREENS classes.
  */
 
+#include <atomic>
 #include <wx/filefn.h>
 
 #include <eda_item.h>
@@ -63,6 +64,12 @@
 #include <profile.h>
 #include "sch_bus_entry.h"
 
+
+// Shared by all screens so a screen allocated where another one was freed cannot report the
+// revision of the old one.
+static std::atomic<uint64_t> s_lastConnectivityRevision( 0 );
+
+
 SCH_SCREEN::SCH_SCREEN( EDA_ITEM* aParent ) :
     BASE_SCREEN( aParent, SCH_SCREEN_T ),
     m_fileFormatVersionAtLoad( 0 ),
@@ -73,6 +80,8 @@ SCH_SCREEN::SCH_SCREEN( EDA_ITEM* aParent ) :
     m_modification_sync = 0;
     m_refCount = 0;
     m_zoomInitialized = false;
+    m_danglingAllDirty = true;
+    m_connectivityRevision = ++s_lastConnectivityRevision;
     m_LastZoomLevel = 1.0;
 
     // Suitable for schematic only. For symbol_editor and viewlib, must be set to true
@@ -207,8 +216,13 @@ void SCH_SCREEN::Append( SCH_ITEM* aItem )
         }
 
         m_rtree.insert( aItem );
+        addDanglingArea( aItem );
         --m_modification_sync;
     }
+    else if( aItem->Type() == SCH_SHEET_PIN_T )
+    {
+        m_connectivityRevision = ++s_lastConnectivityRevision;
+    }
 }
 
 
@@ -237,6 +251,11 @@ void SCH_SCREEN::Clear( bool aFree )
         m_rtree.clear();
     }
 
+    m_connectableAreas.clear();
+    m_danglingDirtyAreas.clear();
+    m_danglingAllDirty = true;
+    m_connectivityRevision = ++s_lastConnectivityRevision;
+
     // Clear the project settings
     m_virtualPageNumber = m_pageCount = 1;
 
@@ -257,6 +276,10 @@ void SCH_SCREEN::FreeDrawList()
             } );
 
     m_rtree.clear();
+    m_connectableAreas.clear();
+    m_danglingDirtyAreas.clear();
+    m_danglingAllDirty = true;
+    m_connectivityRevision = ++s_lastConnectivityRevision;
 
     for( SCH_ITEM* item : delete_list )
         delete item;
@@ -270,10 +293,75 @@ void SCH_SCREEN::Update( SCH_ITEM* aItem )
 }
 
 
+void SCH_SCREEN::addDanglingArea( SCH_ITEM* aItem )
+{
+    if( !aItem->IsConnectable() )
+        return;
+
+    // Match the inflation used by the RTree so the overlap tests done by TestDanglingEnds()
+    // see the same neighbours.
+    EDA_RECT area = aItem->GetBoundingBox();
+    area.Inflate( aItem->GetPenWidth() );
+
+    m_connectableAreas[ aItem ] = area;
+    markDanglingDirty( area );
+    m_connectivityRevision = ++s_lastConnectivityRevision;
+}
+
+
+void SCH_SCREEN::removeDanglingArea( SCH_ITEM* aItem )
+{
+    auto it = m_connectableAreas.find( aItem );
+
+    m_connectivityRevision = ++s_lastConnectivityRevision;
+
+    // The item may have been moved since it was added, so both its old and its current area
+    // are affected.
+    if( it != m_connectableAreas.end() )
+    {
+        markDanglingDirty( it->second );
+        m_connectableAreas.erase( it );
+    }
+
+    if( aItem->IsConnectable() )
+    {
+        EDA_RECT area = aItem->GetBoundingBox();
+        area.Inflate( aItem->GetPenWidth() );
+        markDanglingDirty( area );
+    }
+
+    // Sheet pins are not in the RTree; their sheet holds their dangling state.
+    if( aItem->Type() == SCH_SHEET_PIN_T && aItem->GetParent() )
+        markDanglingDirty( aItem->GetParent()->GetBoundingBox() );
+}
+
+
+void SCH_SCREEN::markDanglingDirty( const EDA_RECT& aArea )
+{
+    // Past a certain number of changes (eg: while loading or pasting), testing everything
+    // is cheaper than looking up the neighbours of each change.
+    const size_t MAX_DIRTY_AREAS = 256;
+
+    if( m_danglingAllDirty )
+        return;
+
+    if( m_danglingDirtyAreas.size() >= MAX_DIRTY_AREAS )
+    {
+        m_danglingDirtyAreas.clear();
+        m_danglingAllDirty = true;
+        return;
+    }
+
+    m_danglingDirtyAreas.push_back( aArea );
+}
+
+
 bool SCH_SCREEN::Remove( SCH_ITEM* aItem )
 {
     bool retv = m_rtree.remove( aItem );
 
+    removeDanglingArea( aItem );
+
     // Check if the library symbol for the removed schematic symbol is still required.
     if( retv && aItem->Type() == SCH_SYMBOL_T )
     {
@@ -772,6 +860,7 @@ void SCH_SCREEN::UpdateLocalLibSymbolLinks()
     {
         // Changing the symbol may adjust the bbox of the symbol; remove and reinsert it afterwards.
         m_rtree.remove( symbol );
+        removeDanglingArea( symbol );
 
         auto it = m_libSymbols.find( symbol->GetSchSymbolLibraryName() );
 
@@ -783,12 +872,15 @@ void SCH_SCREEN::UpdateLocalLibSymbolLinks()
         symbol->SetLibSymbol( libSymbol );
 
         m_rtree.insert( symbol );
+        addDanglingArea( symbol );
     }
 }
 
 
 void SCH_SCREEN::SetConnectivityDirty()
 {
+    m_connectivityRevision = ++s_lastConnectivityRevision;
+
     for( SCH_ITEM* item : Items() )
         item->SetConnectivityDirty( true );
 }
@@ -1057,26 +1149,65 @@ void SCH_SCREEN::GetSheets( std::vector<SCH_ITEM*>* aItems ) const
 
 
 void SCH_SCREEN::TestDanglingEnds( const SCH_SHEET_PATH* aPath,
-                                   std::function<void( SCH_ITEM* )>* aChangedHandler ) const
+                                   std::function<void( SCH_ITEM* )>* aChangedHandler,
+                                   bool aIncremental ) const
 {
     std::vector<DANGLING_END_ITEM> endPoints;
 
-    for( SCH_ITEM* item : Items() )
+    auto testItem =
+            [&]( SCH_ITEM* aItem )
+            {
+                endPoints.clear();
+
+                for( SCH_ITEM* overlapping : Items().Overlapping( aItem->GetBoundingBox() ) )
+                    overlapping->GetEndPoints( endPoints );
+
+                if( aItem->UpdateDanglingState( endPoints, aPath ) )
+                {
+                    if( aChangedHandler )
+                        (*aChangedHandler)( aItem );
+                }
+            };
+
+    if( aIncremental && !m_danglingAllDirty )
     {
-        if( item->IsConnectable() )
-        {
-            endPoints.clear();
+        // Only the items overlapping a changed item can see a different set of end points.
+        std::unordered_set<SCH_ITEM*> tested;
 
-            for( SCH_ITEM* overlapping : Items().Overlapping( item->GetBoundingBox() ) )
-                overlapping->GetEndPoints( endPoints );
+        for( const EDA_RECT& area : m_danglingDirtyAreas )
+        {
+            for( SCH_ITEM* item : Items().Overlapping( area ) )
+            {
+                if( item->IsConnectable() && tested.insert( item ).second )
+                    testItem( item );
+            }
+        }
 
-            if( item->UpdateDanglingState( endPoints, aPath ) )
+        // Labels also (re)connect themselves to the wires they sit on for the given sheet
+        if( aPath )
+        {
+            for( KICAD_T type : { SCH_LABEL_T, SCH_GLOBAL_LABEL_T, SCH_HIER_LABEL_T,
+                                  SCH_DIRECTIVE_LABEL_T } )
             {
-                if( aChangedHandler )
-                    (*aChangedHandler)( item );
+                for( SCH_ITEM* item : Items().OfType( type ) )
+                {
+                    if( tested.insert( item ).second )
+                        testItem( item );
+                }
             }
         }
     }
+    else
+    {
+        for( SCH_ITEM* item : Items() )
+        {
+            if( item->IsConnectable() )
+                testItem( item );
+        }
+    }
+
+    m_danglingDirtyAreas.clear();
+    m_danglingAllDirty = false;
 }
 
 
@@ -27,6 +27,7 @@
 
 #include <memory>
 #include <stddef.h>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <wx/arrstr.h>
@@ -162,6 +163,12 @@ public:
 
     void SetConnectivityDirty();
 
+    /**
+     * Return a value which changes whenever a connectable item is added to, removed from or
+     * updated on this screen.  Values are never reused, even by other screens.
+     */
+    uint64_t GetConnectivityRevision() const                { return m_connectivityRevision; }
+
     /**
      * Return the number of times this screen is used.
      *
@@ -291,9 +298,15 @@ public:
      *
      * @param aPath is a sheet path to pass to UpdateDanglingState if desired.
      * @param aChangedHandler is an optional callback to make on each changed item.
+     * @param aIncremental set to only test the items overlapping connectable items which were
+     *                     appended, removed or updated since the last test (and all labels
+     *                     when \a aPath is given, as they rebuild their connections on it).
+     *                     Items modified without going through Append(), Remove() or Update()
+     *                     are missed.
      */
     void TestDanglingEnds( const SCH_SHEET_PATH* aPath = nullptr,
-                           std::function<void( SCH_ITEM* )>* aChangedHandler = nullptr ) const;
+                           std::function<void( SCH_ITEM* )>* aChangedHandler = nullptr,
+                           bool aIncremental = false ) const;
 
     /**
      * Return all wires and junctions connected to \a aSegment which are not connected any
@@ -508,6 +521,16 @@ public:
     double m_LastZoomLevel;
 
 private:
+    /**
+     * Record the area of a connectable item so TestDanglingEnds() can find the items whose
+     * dangling state may have been changed by it.
+     */
+    void addDanglingArea( SCH_ITEM* aItem );
+    void removeDanglingArea( SCH_ITEM* aItem );
+
+    ///< Record an area to re-test, unless there are already so many that everything will be.
+    void markDanglingDirty( const EDA_RECT& aArea );
+
     bool doIsJunction( const VECTOR2I& aPosition, bool aBreakCrossings,
                        bool* aHasExplicitJunctionDot, bool* aHasBusEntry ) const;
 
@@ -537,6 +560,21 @@ private:
     VECTOR2I    m_aux_origin;               // Origin used for drill & place files by Pcbnew.
     EE_RTREE    m_rtree;
 
+    /// Area of each connectable item at the time it was added to the screen.
+    std::unordered_map<const SCH_ITEM*, EDA_RECT> m_connectableAreas;
+
+    /**
+     * Areas changed since the last dangling end test, or all of them.
+     *
+     * Areas rather than an index of end points: an item also stops dangling when another
+     * item's end lands in the middle of it (a label on a wire, a wire ending on another),
+     * which only a query of the RTree finds.
+     */
+    mutable std::vector<EDA_RECT> m_danglingDirtyAreas;
+    mutable bool                  m_danglingAllDirty;
+
+    uint64_t    m_connectivityRevision;
+
     int         m_modification_sync;        // Inequality with SYMBOL_LIBS::GetModificationHash()
                                             // will trigger ResolveAll().
 
@@ -18,7 +18,7 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
-#include <thread>
+#include <algorithm>
 
 #include <core/wx_stl_compat.h>
 #include <symbol_async_loader.h>
@@ -35,10 +35,13 @@ SYMBOL_ASYNC_LOADER::SYMBOL_ASYNC_LOADER( const std::vector<wxString>& aNickname
         m_onlyPowerSymbols( aOnlyPowerSymbols ),
         m_output( aOutput ),
         m_reporter( aReporter ),
+        m_budget( THREAD_BUDGET::GetTotal() ),
         m_nextLibrary( 0 )
 {
     wxASSERT( m_table );
-    m_threadCount = std::max<size_t>( 1, std::thread::hardware_concurrency() );
+
+    // Load on one thread at least, even when other loaders hold all the cores.
+    m_threadCount = std::max<size_t>( 1, m_budget.GetCount() );
 
     m_returns.resize( m_threadCount );
 }
@@ -83,6 +86,8 @@ bool SYMBOL_ASYNC_LOADER::Join()
         }
     }
 
+    m_budget.Release();
+
     return true;
 }
 
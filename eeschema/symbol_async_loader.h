@@ -29,6 +29,8 @@
 
 #include <wx/string.h>
 
+#include <thread_budget.h>
+
 class LIB_SYMBOL;
 class PROGRESS_REPORTER;
 class SYMBOL_LIB_TABLE;
@@ -90,6 +92,9 @@ private:
     ///< Progress reporter (may be null)
     PROGRESS_REPORTER* m_reporter;
 
+    ///< Worker threads reserved for the load, which leaves none to the library parsers
+    THREAD_BUDGET m_budget;
+
     size_t              m_threadCount;
     std::atomic<size_t> m_nextLibrary;
     wxString            m_errors;
@@ -38,6 +38,7 @@
 #include <wildcards_and_files_ext.h>
 #include <connection_graph.h>
 #include <wx/log.h>
+#include <unordered_map>
 
 
 BACK_ANNOTATE::BACK_ANNOTATE( SCH_EDIT_FRAME* aFrame, REPORTER& aReporter, bool aRelinkFootprints,
@@ -51,6 +52,25 @@ BACK_ANNOTATE::BACK_ANNOTATE( SCH_EDIT_FRAME* aFrame, REPORTER& aReporter, bool
         m_processNetNames( aProcessNetNames ),
         m_dryRun( aDryRun ),
         m_frame( aFrame ),
+        m_schematic( &aFrame->Schematic() ),
+        m_changesCount( 0 ),
+        m_appendUndo( false )
+{
+}
+
+
+BACK_ANNOTATE::BACK_ANNOTATE( SCHEMATIC* aSchematic, REPORTER& aReporter, bool aRelinkFootprints,
+                              bool aProcessFootprints, bool aProcessValues,
+                              bool aProcessReferences ) :
+        m_reporter( aReporter ),
+        m_matchByReference( aRelinkFootprints ),
+        m_processFootprints( aProcessFootprints ),
+        m_processValues( aProcessValues ),
+        m_processReferences( aProcessReferences ),
+        m_processNetNames( false ),
+        m_dryRun( true ),
+        m_frame( nullptr ),
+        m_schematic( aSchematic ),
         m_changesCount( 0 ),
         m_appendUndo( false )
 {
@@ -78,7 +98,7 @@ bool BACK_ANNOTATE::BackAnnotateSymbols( const std::string& aNetlist )
 
     getPcbModulesFromString( aNetlist );
 
-    SCH_SHEET_LIST sheets = m_frame->Schematic().GetSheets();
+    SCH_SHEET_LIST sheets = m_schematic->GetSheets();
     sheets.GetSymbols( m_refs, false );
     sheets.GetMultiUnitSymbols( m_multiUnitsRefs );
 
@@ -211,48 +231,53 @@ void BACK_ANNOTATE::getPcbModulesFromString( const std::string& aPayload )
 
 void BACK_ANNOTATE::getChangeList()
 {
+    // Index the references by reference or path once rather than searching every list for
+    // every footprint.  The first match wins, as it did with FindRef() and FindRefByPath().
+    auto refKey =
+            [&]( const SCH_REFERENCE& aRef ) -> wxString
+            {
+                return m_matchByReference ? aRef.GetRef() : aRef.GetPath();
+            };
+
+    std::unordered_map<wxString, SCH_REFERENCE_LIST*> multiUnitIndex;
+    std::unordered_map<wxString, int>                 refIndexMap;
+
+    for( std::pair<const wxString, SCH_REFERENCE_LIST>& item : m_multiUnitsRefs )
+    {
+        for( size_t i = 0; i < item.second.GetCount(); ++i )
+            multiUnitIndex.emplace( refKey( item.second[i] ), &item.second );
+    }
+
+    for( size_t i = 0; i < m_refs.GetCount(); ++i )
+        refIndexMap.emplace( refKey( m_refs[i] ), (int) i );
+
     for( std::pair<const wxString, std::shared_ptr<PCB_FP_DATA>>& fpData : m_pcbFootprints )
     {
         const wxString& pcbPath = fpData.first;
         auto&           pcbData = fpData.second;
-        int             refIndex;
-        bool            foundInMultiunit = false;
+        auto            multiUnitIt = multiUnitIndex.find( pcbPath );
 
-        for( std::pair<const wxString, SCH_REFERENCE_LIST>& item : m_multiUnitsRefs )
+        if( multiUnitIt != multiUnitIndex.end() )
         {
-            SCH_REFERENCE_LIST& refList = item.second;
+            // If footprint linked to multi unit symbol, we add all symbol's units to
+            // the change list
+            SCH_REFERENCE_LIST& refList = *multiUnitIt->second;
 
-            if( m_matchByReference )
-                refIndex = refList.FindRef( pcbPath );
-            else
-                refIndex = refList.FindRefByPath( pcbPath );
-
-            if( refIndex >= 0 )
+            for( size_t i = 0; i < refList.GetCount(); ++i )
             {
-                // If footprint linked to multi unit symbol, we add all symbol's units to
-                // the change list
-                foundInMultiunit = true;
-
-                for( size_t i = 0; i < refList.GetCount(); ++i )
-                {
-                    refList[ i ].GetSymbol()->ClearFlags(SKIP_STRUCT );
-                    m_changelist.emplace_back( CHANGELIST_ITEM( refList[i], pcbData ) );
-                }
-
-                break;
+                refList[ i ].GetSymbol()->ClearFlags(SKIP_STRUCT );
+                m_changelist.emplace_back( CHANGELIST_ITEM( refList[i], pcbData ) );
             }
-        }
 
-        if( foundInMultiunit )
             continue;
+        }
 
-        if( m_matchByReference )
-            refIndex = m_refs.FindRef( pcbPath );
-        else
-            refIndex = m_refs.FindRefByPath( pcbPath );
+        auto refIt = refIndexMap.find( pcbPath );
 
-        if( refIndex >= 0 )
+        if( refIt != refIndexMap.end() )
         {
+            int refIndex = refIt->second;
+
             m_refs[ refIndex ].GetSymbol()->ClearFlags( SKIP_STRUCT );
             m_changelist.emplace_back( CHANGELIST_ITEM( m_refs[refIndex], pcbData ) );
         }
@@ -301,8 +326,9 @@ void BACK_ANNOTATE::checkForUnusedSymbols()
         ++i;
     }
 
-    if( m_matchByReference && !m_frame->ReadyToNetlist( _( "Re-linking footprints requires a fully "
-                                                           "annotated schematic." ) ) )
+    if( m_matchByReference && m_frame
+            && !m_frame->ReadyToNetlist( _( "Re-linking footprints requires a fully "
+                                            "annotated schematic." ) ) )
     {
         m_reporter.ReportTail( _( "Footprint re-linking cancelled by user." ), RPT_SEVERITY_ERROR );
     }
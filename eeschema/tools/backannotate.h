@@ -37,6 +37,7 @@
 class REPORTER;
 class SCH_SHEET_LIST;
 class SCH_EDIT_FRAME;
+class SCHEMATIC;
 
 
 /**
@@ -82,6 +83,13 @@ public:
     BACK_ANNOTATE( SCH_EDIT_FRAME* aFrame, REPORTER& aReporter, bool aRelinkFootprints,
                    bool aProcessFootprints, bool aProcessValues, bool aProcessReferences,
                    bool aProcessNetNames, bool aDryRun );
+
+    /**
+     * Report the changes back annotation would make to \a aSchematic, without an editor
+     * frame to apply them.  Net names are not processed.
+     */
+    BACK_ANNOTATE( SCHEMATIC* aSchematic, REPORTER& aReporter, bool aRelinkFootprints,
+                   bool aProcessFootprints, bool aProcessValues, bool aProcessReferences );
     ~BACK_ANNOTATE();
 
     /**
@@ -143,7 +151,8 @@ private:
     SCH_REFERENCE_LIST           m_refs;
     SCH_MULTI_UNIT_REFERENCE_MAP m_multiUnitsRefs;
     std::deque<CHANGELIST_ITEM>  m_changelist;
-    SCH_EDIT_FRAME*              m_frame;
+    SCH_EDIT_FRAME*              m_frame;           // nullptr for dry runs without editor
+    SCHEMATIC*                   m_schematic;
 
     int                          m_changesCount;    // Number of user-level changes
     bool                         m_appendUndo;
@@ -880,7 +880,6 @@ int SCH_MOVE_TOOL::Main( const TOOL_EVENT& aEvent )
         m_toolMgr->RunAction( EE_ACTIONS::addNeededJunctions, true, &selectionCopy );
 
         m_frame->RecalculateConnections( LOCAL_CLEANUP );
-        m_frame->TestDanglingEnds();
 
         m_frame->OnModify();
     }
@@ -1531,7 +1530,6 @@ int SCH_MOVE_TOOL::AlignElements( const TOOL_EVENT& aEvent )
     m_toolMgr->RunAction( EE_ACTIONS::addNeededJunctions, true, &selection );
 
     m_frame->RecalculateConnections( LOCAL_CLEANUP );
-    m_frame->TestDanglingEnds();
 
     m_frame->OnModify();
     return 0;
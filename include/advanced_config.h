@@ -118,6 +118,12 @@ public:
      */
     bool m_RealTimeConnectivity;
 
+    /**
+     * Only recompute the item connections of the schematic sheets which changed.  The
+     * connection graph itself is always rebuilt in full.
+     */
+    bool m_ReuseSheetConnectivity;
+
     /**
      * Set the stack size for coroutines
      */
@@ -205,6 +211,13 @@ public:
      */
     bool m_Skip3DModelMemoryCache;
 
+    /**
+     * Keep a binary copy of the symbols of each symbol library in the user cache directory
+     * and load from it rather than parsing the library file again when the file content has
+     * not changed.
+     */
+    bool m_SymbolLibraryCache;
+
     /**
      * Hides the build version from the KiCad manager frame title.
      * Useful for making screenshots/videos of KiCad without pinning to a specific version.
@@ -63,7 +63,11 @@ public:
     {}
 
     OUTLINE_GLYPH( const OUTLINE_GLYPH& aGlyph ) :
-            SHAPE_POLY_SET( aGlyph )
+            SHAPE_POLY_SET( aGlyph ),
+            m_drawSource( aGlyph.m_drawSource ),
+            m_drawAxisX( aGlyph.m_drawAxisX ),
+            m_drawAxisY( aGlyph.m_drawAxisY ),
+            m_drawOffset( aGlyph.m_drawOffset )
     {}
 
     OUTLINE_GLYPH( const SHAPE_POLY_SET& aPoly ) :
@@ -74,9 +78,31 @@ public:
 
     BOX2D BoundingBox() override;
 
+    /**
+     * Draw this glyph from the triangulation of \a aSource, a glyph shared by other texts,
+     * instead of triangulating its own outlines.
+     *
+     * \a aSource is at the text origin.  Its points are moved by \a aOffset, mirrored around
+     * \a aOrigin if \a aMirror is set, then rotated by \a aAngle around \a aOrigin.
+     */
+    void SetDrawSource( std::shared_ptr<const OUTLINE_GLYPH> aSource, const VECTOR2D& aOffset,
+                        bool aMirror, const EDA_ANGLE& aAngle, const VECTOR2I& aOrigin );
+
+    void Move( const VECTOR2I& aVector ) override;
+
+    void Rotate( const EDA_ANGLE& aAngle, const VECTOR2I& aCenter = { 0, 0 } ) override;
+
+    void Mirror( bool aX = true, bool aY = false, const VECTOR2I& aRef = { 0, 0 } );
+
     void Triangulate( std::function<void( const VECTOR2I& aPt1,
                                           const VECTOR2I& aPt2,
                                           const VECTOR2I& aPt3 )> aCallback ) const;
+
+private:
+    std::shared_ptr<const OUTLINE_GLYPH> m_drawSource;  ///< Shared glyph drawn instead, if any
+    VECTOR2D                             m_drawAxisX;   ///< Transform from m_drawSource
+    VECTOR2D                             m_drawAxisY;   ///< coordinates: the images of the
+    VECTOR2D                             m_drawOffset;  ///< axes and of the origin
 };
 
 
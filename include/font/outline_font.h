@@ -27,6 +27,7 @@
 #ifndef OUTLINE_FONT_H_
 #define OUTLINE_FONT_H_
 
+#include <mutex>
 #include <gal/graphics_abstraction_layer.h>
 #include <geometry/shape_poly_set.h>
 #ifdef _MSC_VER
@@ -115,15 +116,33 @@ protected:
                               const VECTOR2I& aPosition, const EDA_ANGLE& aAngle, bool aMirror,
                               const VECTOR2I& aOrigin, TEXT_STYLE_FLAGS aTextStyle ) const;
 
+    /**
+     * A glyph converted from its FreeType outline, shared by all the texts using the same
+     * font, glyph, size and style.
+     */
+    struct CACHED_GLYPH
+    {
+        CONTOURS                             m_Contours;   ///< In font units
+        std::vector<int>                     m_HoleOwners; ///< Outline each hole contour is in,
+                                                           ///<   or -1
+        std::shared_ptr<const OUTLINE_GLYPH> m_Shape;      ///< Triangulated, at the text origin
+    };
+
+    /**
+     * Return a glyph from the process-wide glyph cache, building it if needed.
+     *
+     * Must be called with m_faceLock held, after setting the character size of the face.
+     */
+    std::shared_ptr<const CACHED_GLYPH> getGlyph( unsigned int aGlyphIndex, const VECTOR2I& aSize,
+                                                  const VECTOR2D& aScaleFactor,
+                                                  TEXT_STYLE_FLAGS aTextStyle ) const;
+
 private:
     // FreeType variables
-    static FT_Library m_freeType;
-    FT_Face           m_face;
-    const int         m_faceSize;
-
-    // cache for glyphs converted to straight segments
-    // key is glyph index (FT_GlyphSlot field glyph_index)
-    std::map<unsigned int, GLYPH_POINTS_LIST> m_contourCache;
+    static FT_Library  m_freeType;
+    FT_Face            m_face;
+    const int          m_faceSize;
+    mutable std::mutex m_faceLock;   ///< FreeType faces are not thread safe
 
     // The height of the KiCad stroke font is the distance between stroke endpoints for a vertical
     // line of cap-height.  So the cap-height of the font is actually stroke-width taller than its
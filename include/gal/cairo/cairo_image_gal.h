@@ -0,0 +1,67 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CAIRO_IMAGE_GAL_H_
+#define _CAIRO_IMAGE_GAL_H_
+
+#include <gal/cairo/cairo_gal.h>
+
+#include <string>
+
+namespace KIGFX
+{
+/**
+ * Cairo GAL rendering into an offscreen image, without any window.
+ *
+ * All the render targets are drawn into the same ARGB32 image, in the same way as for
+ * printouts.  Meant for rendering views where there is no display (tests, benchmarks,
+ * command line exports).
+ */
+class CAIRO_IMAGE_GAL : public CAIRO_GAL_BASE
+{
+public:
+    /**
+     * @param aSize is the image size, in pixels.
+     */
+    CAIRO_IMAGE_GAL( GAL_DISPLAY_OPTIONS& aDisplayOptions, const VECTOR2I& aSize );
+
+    /// @copydoc GAL::ResizeScreen()
+    void ResizeScreen( int aWidth, int aHeight ) override;
+
+    /**
+     * @return the pixels of the image, in Cairo's native-endian ARGB32 format, with rows
+     *         GetStride() bytes apart.
+     */
+    const unsigned char* GetImageData();
+
+    int GetStride() const;
+
+    /**
+     * Write the image to a PNG file.
+     *
+     * @return false if the file couldn't be written.
+     */
+    bool SaveAsPng( const std::string& aFileName );
+
+private:
+    void createSurface();
+};
+} // namespace KIGFX
+
+#endif /* _CAIRO_IMAGE_GAL_H_ */
@@ -0,0 +1,205 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef LIB_BINARY_CACHE_H
+#define LIB_BINARY_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+#include <wx/filename.h>
+#include <wx/string.h>
+
+#include <gal/color4d.h>
+#include <math/vector2d.h>
+
+class EDA_TEXT;
+
+
+/**
+ * Append plain values to the buffer of a library cache file.
+ *
+ * Values are stored in the byte order of the machine, as cache files are not shared between
+ * machines.
+ */
+class BINARY_CACHE_WRITER
+{
+public:
+    void Raw( const void* aData, size_t aLength )
+    {
+        m_buffer.append( static_cast<const char*>( aData ), aLength );
+    }
+
+    void Int( int32_t aValue )        { Raw( &aValue, sizeof( aValue ) ); }
+    void Double( double aValue )      { Raw( &aValue, sizeof( aValue ) ); }
+    void Bool( bool aValue )          { Int( aValue ? 1 : 0 ); }
+
+    void Point( const VECTOR2I& aPoint )
+    {
+        Int( aPoint.x );
+        Int( aPoint.y );
+    }
+
+    void Color( const KIGFX::COLOR4D& aColor );
+    void String( const wxString& aString );
+
+    /**
+     * Write the text, position and attributes of \a aText.
+     *
+     * Only available to the kifaces which build lib_binary_cache_text.cpp.
+     */
+    void Text( const EDA_TEXT* aText );
+
+    /**
+     * Write the header of a cache file.
+     *
+     * Besides \a aMagic and \a aFormatVersion, the header holds the version of KiCad writing
+     * the file, so that cache files are never read by another build: the objects they hold
+     * may have gained properties which their serializer does not know about yet.
+     *
+     * @param aMagic identifies the kind of cache file, on 8 characters.
+     * @param aFormatVersion is the version of the layout of this kind of cache file.
+     */
+    void Header( const char* aMagic, uint32_t aFormatVersion );
+
+    const std::string& GetBuffer() const { return m_buffer; }
+
+private:
+    std::string m_buffer;
+};
+
+
+/**
+ * Read back the values written by a #BINARY_CACHE_WRITER.
+ *
+ * Reading past the end of the buffer doesn't throw; it returns zeroes and flags the reader as
+ * failed, which the caller checks once it is done.
+ */
+class BINARY_CACHE_READER
+{
+public:
+    BINARY_CACHE_READER( const std::string& aBuffer ) :
+            m_buffer( aBuffer ),
+            m_pos( 0 ),
+            m_ok( true )
+    {}
+
+    bool Raw( void* aData, size_t aLength );
+
+    int32_t Int()
+    {
+        int32_t value;
+        Raw( &value, sizeof( value ) );
+        return value;
+    }
+
+    double Double()
+    {
+        double value;
+        Raw( &value, sizeof( value ) );
+        return value;
+    }
+
+    bool Bool()                       { return Int() != 0; }
+
+    VECTOR2I Point()
+    {
+        int x = Int();
+        int y = Int();
+
+        return VECTOR2I( x, y );
+    }
+
+    KIGFX::COLOR4D Color();
+    wxString String();
+
+    /**
+     * Read an element count, which can't be more than the number of bytes left.
+     */
+    size_t Count();
+
+    /**
+     * Read the text, position and attributes written by BINARY_CACHE_WRITER::Text().
+     */
+    void Text( EDA_TEXT* aText );
+
+    /**
+     * Read the header written by BINARY_CACHE_WRITER::Header().
+     *
+     * @return false if the header is not that of a cache file of the given kind and format
+     *         version, written by this build of KiCad.
+     */
+    bool Header( const char* aMagic, uint32_t aFormatVersion );
+
+    bool Ok() const { return m_ok; }
+
+    ///< Return the number of bytes left to read
+    size_t Remaining() const { return m_buffer.size() - m_pos; }
+
+private:
+    const std::string& m_buffer;
+    size_t             m_pos;
+    bool               m_ok;
+};
+
+
+/**
+ * The file holding the binary cache of a library, in the user cache directory.
+ *
+ * The file of a library is named after the SHA1 of the library path.
+ */
+class LIB_BINARY_CACHE_FILE
+{
+public:
+    /**
+     * @param aKind is the name of the cache subdirectory holding this kind of library.
+     * @param aLibraryPath is the full path of the library.
+     * @param aCacheDir is the directory holding the cache subdirectories, or an empty string
+     *                  for the user cache directory.
+     */
+    LIB_BINARY_CACHE_FILE( const wxString& aKind, const wxString& aLibraryPath,
+                           const wxString& aCacheDir = wxEmptyString );
+
+    /**
+     * Read the whole cache file.
+     *
+     * @return false if there is no cache file or it can't be read.
+     */
+    bool Read( std::string& aBuffer ) const;
+
+    /**
+     * Replace the cache file with \a aBuffer.
+     *
+     * The file is written under a temporary name first so other instances never see a
+     * partial cache file.  Failing to write the cache is not an error; the library will just
+     * be parsed again the next time it is loaded.
+     */
+    void Write( const std::string& aBuffer ) const;
+
+    const wxFileName& GetFileName() const { return m_file; }
+
+private:
+    wxFileName m_file;
+};
+
+#endif  // LIB_BINARY_CACHE_H
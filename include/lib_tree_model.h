@@ -22,8 +22,11 @@
 #ifndef LIB_TREE_MODEL_H
 #define LIB_TREE_MODEL_H
 
+#include <cstdint>
 #include <vector>
+#include <map>
 #include <memory>
+#include <unordered_map>
 #include <wx/string.h>
 #include <lib_tree_item.h>
 
@@ -106,8 +109,16 @@ public:
     static int Compare( LIB_TREE_NODE const& aNode1, LIB_TREE_NODE const& aNode2 );
 
     LIB_TREE_NODE();
-    virtual ~LIB_TREE_NODE() {}
+    virtual ~LIB_TREE_NODE();
 
+protected:
+    /**
+     * Tell the root node of the tree this node belongs to, if any, that the tree changed and
+     * its search index must be rebuilt.
+     */
+    void invalidateSearchIndex();
+
+public:
     enum TYPE {
         ROOT, LIB, LIBID, UNIT, INVALID
     };
@@ -206,6 +217,11 @@ public:
      */
     void Update( LIB_TREE_ITEM* aItem );
 
+    /**
+     * Normalize m_MatchName and m_SearchText for matching, if not already done.
+     */
+    void Normalize();
+
     /**
      * Perform the actual search.
      */
@@ -272,12 +288,46 @@ public:
      */
     LIB_TREE_NODE_ROOT();
 
+    ~LIB_TREE_NODE_ROOT();
+
     /**
      * Construct an empty library node, add it to the root, and return it.
      */
     LIB_TREE_NODE_LIB& AddLib( wxString const& aName, wxString const& aDesc );
 
+    /**
+     * Score all nodes against a search term.
+     *
+     * Plain text terms of three or more characters are first narrowed down through a trigram
+     * index of the item names and search text, so only items which can possibly match are
+     * handed to the matchers.  Other terms (regular expressions, wildcards, relational terms
+     * and short terms) are scored against every item.
+     */
     virtual void UpdateScore( EDA_COMBINED_MATCHER& aMatcher, const wxString& aLib ) override;
+
+private:
+    friend class LIB_TREE_NODE;     // Only to bump m_treeRevision.
+
+    /**
+     * (Re)build the trigram index if any node has been added, removed or updated since it
+     * was last built.
+     */
+    void updateSearchIndex();
+
+    /**
+     * Return the sorted indices (into m_searchItems) of the items whose name or search text
+     * contains all trigrams of \a aTerm.
+     */
+    const std::vector<int>& findCandidates( const wxString& aTerm );
+
+private:
+    unsigned                                        m_treeRevision;  ///< Bumped on each change
+    unsigned                                        m_searchIndexRevision;
+    std::vector<LIB_TREE_NODE_LIB_ID*>              m_searchItems;
+    std::unordered_map<uint64_t, std::vector<int>>  m_trigrams;
+
+    ///< Candidates of recent terms, used to narrow down longer terms as the user types.
+    std::map<wxString, std::vector<int>>            m_candidateCache;
 };
 
 
@@ -95,6 +95,23 @@ public:
      */
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) = 0;
 
+    /**
+     * Tell if there is a simplified version of an item, that VIEW should cache alongside the
+     * full one and draw instead of it when zoomed out.  It is built on first use, and again
+     * each time the zoom level doubles or halves.
+     *
+     * Worth it only for items with a lot of geometry, like zone fills.
+     */
+    virtual bool HasLodProxy( const VIEW_ITEM* aItem, int aLayer ) { return false; }
+
+    /**
+     * Draw the simplified version of an item (see HasLodProxy()).
+     *
+     * @param aTolerance is the maximum deviation allowed from the full item, in world units.
+     *                   It is at most half a pixel at the zoom level it is built for.
+     */
+    virtual void DrawLodProxy( const VIEW_ITEM* aItem, int aLayer, int aTolerance ) {}
+
 protected:
     /// Instance of graphic abstraction layer that gives an interface to call
     /// commands used to draw (eg. DrawLine, DrawCircle, etc.)
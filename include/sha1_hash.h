@@ -0,0 +1,81 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef SHA1_HASH_H
+#define SHA1_HASH_H
+
+#include <cstddef>
+
+#include <boost/version.hpp>
+
+#if BOOST_VERSION >= 106800
+#include <boost/uuid/detail/sha1.hpp>
+#else
+#include <boost/uuid/sha1.hpp>
+#endif
+
+
+/**
+ * An incremental SHA1 digest, used to recognize the content of the files cached by KiCad.
+ */
+class SHA1_HASH
+{
+public:
+    static constexpr size_t DIGEST_SIZE = 20;
+
+    void Update( const void* aData, size_t aLength )
+    {
+        m_sha1.process_bytes( aData, aLength );
+    }
+
+    /**
+     * Write the digest of the data given to Update() to \a aDigest, most significant byte first.
+     *
+     * @param aDigest must have room for #DIGEST_SIZE bytes.
+     */
+    void GetDigest( unsigned char* aDigest )
+    {
+        unsigned int digest[5];
+
+        m_sha1.get_digest( digest );
+
+        // ensure MSB order
+        for( int i = 0; i < 5; ++i )
+        {
+            int idx = i << 2;
+            unsigned int tmp = digest[i];
+            aDigest[idx+3] = tmp & 0xff;
+            tmp >>= 8;
+            aDigest[idx+2] = tmp & 0xff;
+            tmp >>= 8;
+            aDigest[idx+1] = tmp & 0xff;
+            tmp >>= 8;
+            aDigest[idx] = tmp & 0xff;
+        }
+    }
+
+private:
+    boost::uuids::detail::sha1 m_sha1;
+};
+
+#endif  // SHA1_HASH_H
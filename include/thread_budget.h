@@ -0,0 +1,66 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef THREAD_BUDGET_H
+#define THREAD_BUDGET_H
+
+#include <cstddef>
+
+
+/**
+ * A share of the worker threads the whole process may run at once, one per core.
+ *
+ * Parallel code reserves its workers here rather than asking the hardware, so that nested
+ * callers (eg: a library parser run by each thread of a parallel library loader) don't start
+ * more threads than there are cores between them.  The reservation is returned when the
+ * budget is released or destroyed.
+ */
+class THREAD_BUDGET
+{
+public:
+    /**
+     * Reserve up to \a aWanted worker threads.
+     *
+     * Fewer threads, possibly none, are granted when other callers hold the rest.
+     */
+    explicit THREAD_BUDGET( size_t aWanted );
+
+    ~THREAD_BUDGET() { Release(); }
+
+    THREAD_BUDGET( const THREAD_BUDGET& ) = delete;
+    THREAD_BUDGET& operator=( const THREAD_BUDGET& ) = delete;
+
+    ///< Return the number of worker threads granted
+    size_t GetCount() const { return m_count; }
+
+    ///< Return the granted threads to the budget
+    void Release();
+
+    ///< Return the number of worker threads the whole process may run at once
+    static size_t GetTotal();
+
+private:
+    size_t m_count;
+};
+
+#endif  // THREAD_BUDGET_H
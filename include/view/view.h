@@ -597,6 +597,15 @@ public:
         return false;
     }
 
+    /**
+     * Return true if the last redraw used full versions of items in place of simplified ones
+     * that are yet to be built.  Another update and redraw will replace them.
+     */
+    bool HasPendingLodUpdates() const
+    {
+        return !m_lodQueue.empty();
+    }
+
     /**
      * Return true if any of layers belonging to the target or the target itself should be
      * redrawn.
@@ -798,6 +807,14 @@ protected:
     ///< Update all information needed to draw an item
     void updateItemGeometry( VIEW_ITEM* aItem, int aLayer );
 
+    ///< (Re)build the simplified version of an item for the current zoom level (see
+    ///< PAINTER::DrawLodProxy())
+    void updateItemLod( VIEW_ITEM* aItem, int aLayer );
+
+    ///< Maximum deviation allowed for the simplified version of an item at the current zoom
+    ///< level, in world units, or 0 if the full version should be drawn
+    int lodTolerance( const VIEW_ITEM* aItem ) const;
+
     ///< Update bounding box of an item
     void updateBbox( VIEW_ITEM* aItem );
 
@@ -865,6 +882,15 @@ protected:
     ///< Rendering order modifier for layers that are marked as top layers.
     static const int TOP_LAYER_MODIFIER;
 
+    ///< Simplified versions of items deviate from the full ones by at most this (in pixels)...
+    static constexpr double LOD_MAX_ERROR = 0.5;
+
+    ///< ... and are drawn instead of them only for items smaller than this (in pixels).
+    static constexpr double LOD_MAX_SIZE = 4096.0;
+
+    ///< Items and layers whose simplified version was missing or out of date in the last redraw
+    std::vector<std::pair<VIEW_ITEM*, int>> m_lodQueue;
+
     ///< Flag to respect draw priority when drawing items.
     bool m_useDrawPriority;
 
@@ -0,0 +1,135 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef POLY_EDGE_INDEX_H
+#define POLY_EDGE_INDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include <geometry/seg.h>
+#include <math/vector2d.h>
+#include <md5_hash.h>
+
+class SHAPE_LINE_CHAIN;
+class SHAPE_POLY_SET;
+
+/**
+ * Acceleration structure for point and segment queries against the contours of a
+ * SHAPE_POLY_SET.
+ *
+ * The edges of each contour are sorted into horizontal bands ("buckets") covering the
+ * contour's vertical extent, so that a ray-crossing test only looks at the edges in the
+ * point's band and distance searches only visit the bands that can still hold a closer edge.
+ * Small contours are not indexed and the queries fall back on a linear scan for them.
+ *
+ * The index is immutable once built and records the hash of the polygon set it was built
+ * from; it may be shared between copies of that polygon set.  Queries against a contour that
+ * no longer matches the index (a different polygon or contour count, or a different number of
+ * points) fall back on the linear scan, so a stale index gives at worst a stale answer.
+ */
+class POLY_EDGE_INDEX
+{
+public:
+    POLY_EDGE_INDEX( const SHAPE_POLY_SET& aPolySet, const MD5_HASH& aHash );
+
+    const MD5_HASH& GetHash() const { return m_hash; }
+
+    ///< Return false if all contours were too small to be worth indexing.
+    bool HasIndexedContours() const;
+
+    bool IsIndexed( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain ) const
+    {
+        return indexedContour( aPolygon, aContour, aChain ) != nullptr;
+    }
+
+    /**
+     * Ray-crossing test of \a aP against contour \a aContour of polygon \a aPolygon.  Gives
+     * the same result as SHAPE_LINE_CHAIN::PointInside() with an accuracy of 1 or less.
+     *
+     * @param aChain is the indexed contour.
+     */
+    bool PointInside( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                      const VECTOR2I& aP ) const;
+
+    /**
+     * @return true if an edge of the contour ends on \a aP or has a SEG::Distance() to \a aP of
+     *         no more than \a aDist (see SHAPE_LINE_CHAIN::EdgeContainingPoint()).
+     */
+    bool EdgeWithin( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                     const VECTOR2I& aP, int aDist ) const;
+
+    /**
+     * @return the squared distance from \a aP to the nearest edge of the contour, or
+     *         VECTOR2I::ECOORD_MAX if it has no edges.
+     * @param aNearest if not null, receives the nearest point of that edge.
+     */
+    SEG::ecoord SquaredDistance( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                                 const VECTOR2I& aP, VECTOR2I* aNearest = nullptr ) const;
+
+    /**
+     * @return the squared distance from \a aSeg to the nearest edge of the contour, or
+     *         VECTOR2I::ECOORD_MAX if it has no edges.
+     * @param aNearest if not null, receives SEG::NearestPoint() of that edge and \a aSeg.
+     */
+    SEG::ecoord SquaredDistance( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                                 const SEG& aSeg, VECTOR2I* aNearest = nullptr ) const;
+
+private:
+    struct CONTOUR_BUCKETS
+    {
+        size_t                m_pointCount = 0;
+        int                   m_yMin = 0;
+        int                   m_yMax = 0;
+        int64_t               m_bucketHeight = 1;
+        std::vector<uint32_t> m_bucketStart;    ///< Offsets into m_edges, one past the end last
+        std::vector<uint32_t> m_edges;          ///< Edge i runs from point i to point i + 1
+
+        bool IsIndexed() const { return !m_bucketStart.empty(); }
+        int  BucketCount() const { return (int) m_bucketStart.size() - 1; }
+        int  BucketOf( int64_t aY ) const;
+    };
+
+    void buildContour( const SHAPE_LINE_CHAIN& aChain, CONTOUR_BUCKETS& aBuckets );
+
+    ///< Return the buckets of the contour if it is indexed and still has the indexed size.
+    const CONTOUR_BUCKETS* indexedContour( int aPolygon, int aContour,
+                                           const SHAPE_LINE_CHAIN& aChain ) const;
+
+    /**
+     * Visit the edges of the buckets covering [aYMin, aYMax] first, then the other buckets
+     * in order of increasing distance from that range, as long as the squared vertical
+     * distance to the bucket is below the value returned by \a aVisitor.
+     *
+     * @param aVisitor is called with each edge index (edges may be visited more than once)
+     *                 and returns the current squared distance bound.
+     */
+    template <typename Visitor>
+    void visitOutwards( const CONTOUR_BUCKETS& aBuckets, int64_t aYMin, int64_t aYMax,
+                        Visitor aVisitor ) const;
+
+    MD5_HASH                                  m_hash;
+    std::vector<std::vector<CONTOUR_BUCKETS>> m_contours;
+};
+
+#endif // POLY_EDGE_INDEX_H
@@ -0,0 +1,73 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file polyline_kernels.h
+ * @brief Point queries running directly over a contiguous array of polyline vertices.
+ *
+ * These are the inner loops behind SHAPE_LINE_CHAIN_BASE::PointInside(), SquaredDistance()
+ * and EdgeContainingPoint().  They avoid the per-vertex virtual calls and SEG construction of
+ * the generic implementations, and reject segments on their bounding box before doing any
+ * 64-bit arithmetic.  When the compiler targets SSE2 (always the case on x86-64) the straddle
+ * and bounding box tests run on several vertices at once; define POLYLINE_KERNELS_NO_SIMD to
+ * build the plain C++ loops instead.  Results are identical to the generic SEG based code.
+ */
+
+#ifndef POLYLINE_KERNELS_H
+#define POLYLINE_KERNELS_H
+
+#include <cstddef>
+
+#include <geometry/seg.h>
+#include <math/vector2d.h>
+
+/**
+ * Check if \a aP lies inside the closed polygon made of the \a aCount vertices at \a aPts.
+ *
+ * Uses the even-odd rule; a point exactly on an edge may be reported either way.
+ */
+bool PolylineContainsPoint( const VECTOR2I* aPts, size_t aCount, const VECTOR2I& aP );
+
+/**
+ * Find the segment of a polyline nearest to \a aP.
+ *
+ * @param aClosed true to include the segment from the last vertex back to the first.
+ * @param aStopBelow if greater than 0, stop searching as soon as a segment closer than
+ *                   sqrt( aStopBelow ) is found.
+ * @param aNearest if not null, receives the nearest point on the returned segment.
+ * @param aSegment if not null, receives the index of the nearest segment (-1 if none).
+ * @return the squared distance to the nearest segment, or VECTOR2I::ECOORD_MAX if the
+ *         polyline has no segments.
+ */
+SEG::ecoord PolylineSquaredDistance( const VECTOR2I* aPts, size_t aCount, bool aClosed,
+                                     const VECTOR2I& aP, SEG::ecoord aStopBelow = 0,
+                                     VECTOR2I* aNearest = nullptr, int* aSegment = nullptr );
+
+/**
+ * Return the index of the first segment of a polyline that ends on \a aP or whose
+ * SEG::Distance() to \a aP is no more than \a aDist, or -1 if there is none.
+ */
+int PolylineEdgeWithin( const VECTOR2I* aPts, size_t aCount, bool aClosed, const VECTOR2I& aP,
+                        int aDist );
+
+#endif // POLYLINE_KERNELS_H
@@ -311,6 +311,13 @@ public:
     virtual bool IsClosed() const = 0;
 
     virtual BOX2I* GetCachedBBox() const { return nullptr; }
+
+protected:
+    /**
+     * Return the vertices as a contiguous array when the implementation stores them that way,
+     * letting the point queries above run over it directly.  Otherwise return nullptr.
+     */
+    virtual const VECTOR2I* GetPointArray() const { return nullptr; }
 };
 
 #endif // __SHAPE_H
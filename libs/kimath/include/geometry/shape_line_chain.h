@@ -860,6 +860,8 @@ public:
 protected:
     friend class SHAPE_POLY_SET;
 
+    const VECTOR2I* GetPointArray() const override { return m_points.data(); }
+
     /**
      * Convert an arc to only a point chain by removing the arc and references
      *
@@ -916,6 +918,15 @@ protected:
      */
     void fixIndicesRotation();
 
+    /**
+     * Make every arc start and end on the points that reference it.
+     *
+     * Clipping or offsetting can cut an arc short or split its points into several separate
+     * runs.  Each run is given its own arc trimmed to the run's end points, and arcs referenced
+     * by a single point are converted to plain points.
+     */
+    void trimArcsToPoints();
+
     /**
      * Merge the first and last point if they are the same and this chain is closed.
      */
@@ -46,6 +46,8 @@
 #include <math/vector2d.h>              // for VECTOR2I
 #include <md5_hash.h>
 
+class POLY_EDGE_INDEX;
+
 
 /**
  * Represent a set of closed polygons. Polygons may be nonconvex, self-intersecting
@@ -171,6 +173,10 @@ public:
                 vertex += aVec;
         }
 
+        void Rotate( const EDA_ANGLE& aAngle, const VECTOR2I& aCenter );
+
+        void Mirror( bool aX, bool aY, const VECTOR2I& aRef );
+
     private:
         int                  m_sourceOutline;
         std::deque<TRI>      m_triangles;
@@ -498,7 +504,17 @@ public:
 
     SHAPE_POLY_SET& operator=( const SHAPE_POLY_SET& aOther );
 
-    void CacheTriangulation( bool aPartition = true );
+    /**
+     * Build the triangulation cache, if it isn't up to date.
+     *
+     * @param aPartition triangulates each outline in regularly-sized cells (in parallel for
+     *                   large sets), and keeps the triangles of outlines which are unchanged
+     *                   since the last (partitioned) triangulation.  Holes are ignored: the set
+     *                   must be fractured.
+     * @param aHintData is an optional previous version of this set (such as an earlier fill of
+     *                  the same zone) whose triangles may be reused for unchanged outlines.
+     */
+    void CacheTriangulation( bool aPartition = true, const SHAPE_POLY_SET* aHintData = nullptr );
     bool IsTriangulationUpToDate() const;
 
     MD5_HASH GetHash() const;
@@ -993,14 +1009,20 @@ public:
      *                        #CHAMFER_ACUTE_CORNERS to chop angles less than 90°,
      *                        #ROUND_ACUTE_CORNERS to round off angles less than 90°,
      *                        #ROUND_ALL_CORNERS to round regardless of angles
+     * @param aPreserveArcs if true, the rounded corners created by the offset are kept as
+     *                      SHAPE_ARCs in the resulting outlines (the vertices approximating
+     *                      them are still present).  Arcs already in the input are linearized
+     *                      as usual.
      */
     void Inflate( int aAmount, int aCircleSegCount,
-                  CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS );
+                  CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS,
+                  bool aPreserveArcs = false );
 
     void Deflate( int aAmount, int aCircleSegmentsCount,
-                  CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS )
+                  CORNER_STRATEGY aCornerStrategy = ROUND_ALL_CORNERS,
+                  bool aPreserveArcs = false )
     {
-        Inflate( -aAmount, aCircleSegmentsCount, aCornerStrategy );
+        Inflate( -aAmount, aCircleSegmentsCount, aCornerStrategy, aPreserveArcs );
     }
 
     /**
@@ -1168,7 +1190,8 @@ public:
                       int aClearance = 0 ) const;
 
     /**
-     * Construct BBoxCaches for Contains(), below.
+     * Construct BBoxCaches for Contains(), below.  For large polygons this also builds (or
+     * revalidates against the current hash) an edge index used by the same calls.
      *
      * @note These caches **must** be built before a group of calls to Contains().  They are
      *       **not** kept up-to-date by editing actions.
@@ -1296,6 +1319,18 @@ public:
      */
     SHAPE_POLY_SET Fillet( int aRadius, int aErrorMax );
 
+    /**
+     * Return a copy of the polygon set with as few vertices as possible while staying within
+     * \a aTolerance of the original contours (Douglas-Peucker).
+     *
+     * Arcs are replaced by their approximating segments.  Contours that collapse to fewer than
+     * three vertices are dropped (along with their holes, for outlines).  The result is meant
+     * for coarse display only: it is not guaranteed to be free of self-intersections.
+     *
+     * @param aTolerance is the maximum distance between a removed vertex and the new contour.
+     */
+    SHAPE_POLY_SET Decimate( int aTolerance ) const;
+
     /**
      * Compute the minimum distance between the \a aIndex-th polygon and \a aPoint.
      *
@@ -1303,11 +1338,12 @@ public:
      * @param  aIndex is the index of the polygon whose distance to aPoint has to be measured.
      * @param  aNearest [out] an optional pointer to be filled in with the point on the
      *                  polyset which is closest to aPoint.
+     * @param  aUseBBoxCaches see Contains().
      * @return The minimum distance between \a aPoint and all the segments of the \a aIndex-th
      *         polygon. If the point is contained in the polygon, the distance is zero.
      */
-    SEG::ecoord SquaredDistanceToPolygon( VECTOR2I aPoint, int aIndex,
-                                          VECTOR2I* aNearest ) const;
+    SEG::ecoord SquaredDistanceToPolygon( VECTOR2I aPoint, int aIndex, VECTOR2I* aNearest,
+                                          bool aUseBBoxCaches = false ) const;
 
     /**
      * Compute the minimum distance between the aIndex-th polygon and aSegment with a
@@ -1318,11 +1354,12 @@ public:
      * @param  aIndex   is the index of the polygon whose distance to aPoint has to be measured.
      * @param  aNearest [out] an optional pointer to be filled in with the point on the
      *                  polyset which is closest to aSegment.
+     * @param  aUseBBoxCaches see Contains().
      * @return The minimum distance between \a aSegment and all the segments of the \a aIndex-th
      *         polygon. If the point is contained in the polygon, the distance is zero.
      */
-    SEG::ecoord SquaredDistanceToPolygon( const SEG& aSegment, int aIndex,
-                                          VECTOR2I* aNearest) const;
+    SEG::ecoord SquaredDistanceToPolygon( const SEG& aSegment, int aIndex, VECTOR2I* aNearest,
+                                          bool aUseBBoxCaches = false ) const;
 
     /**
      * Compute the minimum distance squared between aPoint and all the polygons in the set.
@@ -1331,10 +1368,12 @@ public:
      * @param  aPoint is the point whose distance to the set has to be measured.
      * @param  aNearest [out] an optional pointer to be filled in with the point on the
      *                  polyset which is closest to aPoint.
+     * @param  aUseBBoxCaches see Contains().
      * @return The minimum distance squared between aPoint and all the polygons in the set.
      *         If the point is contained in any of the polygons, the distance is zero.
      */
-    SEG::ecoord SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest = nullptr ) const;
+    SEG::ecoord SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest = nullptr,
+                                 bool aUseBBoxCaches = false ) const;
 
     /**
      * Compute the minimum distance squared between aSegment and all the polygons in the set.
@@ -1344,10 +1383,12 @@ public:
      * @param  aSegmentWidth is the width of the segment; defaults to zero.
      * @param  aNearest [out] an optional pointer to be filled in with the point on the
      *                  polyset which is closest to aSegment.
+     * @param  aUseBBoxCaches see Contains().
      * @return  The minimum distance squared between aSegment and all the polygons in the set.
      *          If the point is contained in the polygon, the distance is zero.
      */
-    SEG::ecoord SquaredDistance( const SEG& aSegment, VECTOR2I* aNearest = nullptr ) const;
+    SEG::ecoord SquaredDistance( const SEG& aSegment, VECTOR2I* aNearest = nullptr,
+                                 bool aUseBBoxCaches = false ) const;
 
     /**
      * Check whether the \a aGlobalIndex-th vertex belongs to a hole.
@@ -1445,12 +1486,30 @@ private:
 
     MD5_HASH checksum() const;
 
+    ///< Hash of the \a aOutline-th outline's points (holes excluded).
+    MD5_HASH outlineChecksum( int aOutline ) const;
+
+    ///< Return the edge index for the outlines as of the last BuildBBoxCaches(), building it
+    ///< if needed, or nullptr if none of them are worth indexing.
+    std::shared_ptr<const POLY_EDGE_INDEX> edgeIndex() const;
+
 private:
     std::vector<POLYGON>                               m_polys;
     std::vector<std::unique_ptr<TRIANGULATED_POLYGON>> m_triangulatedPolys;
 
     bool     m_triangulationValid = false;
     MD5_HASH m_hash;
+
+    ///< Hash of each outline at the time of its partitioned triangulation (invalid if that
+    ///< failed), indexed like TRIANGULATED_POLYGON::GetSourceOutlineIndex()
+    std::vector<MD5_HASH> m_triangulatedOutlineHashes;
+
+    ///< Hash of the outlines as of the last BuildBBoxCaches(), which m_edgeIndex must match
+    mutable MD5_HASH m_edgeIndexHash;
+
+    ///< Edge buckets for Contains() and the distance queries; immutable, so shared by copies.
+    ///< Only accessed through std::atomic_load() and std::atomic_store() by edgeIndex().
+    mutable std::shared_ptr<const POLY_EDGE_INDEX> m_edgeIndex;
 };
 
 #endif // __SHAPE_POLY_SET_H
@@ -180,6 +180,9 @@ public:
         return true;
     }
 
+protected:
+    const VECTOR2I* GetPointArray() const override { return m_points.CPoints().data(); }
+
 private:
     // vertices
     SHAPE_LINE_CHAIN m_points;
@@ -0,0 +1,44 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file simd_target.h
+ * Vector instruction sets the compiler targets, for the code using intrinsics.
+ *
+ * Code using them defines its own opt-out macro and tests it along with the ones below, so the
+ * plain C++ version of that code can be built on any target, e.g.:
+ *
+ *     #if defined( KIMATH_TARGET_SSE2 ) && !defined( MY_CODE_NO_SIMD )
+ *     #include <emmintrin.h>
+ *     ...
+ */
+
+#ifndef SIMD_TARGET_H
+#define SIMD_TARGET_H
+
+// SSE2 is always available on x86-64; 32-bit x86 has it when asked for
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define KIMATH_TARGET_SSE2
+#endif
+
+#endif // SIMD_TARGET_H
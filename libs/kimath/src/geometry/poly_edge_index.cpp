@@ -0,0 +1,433 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <geometry/poly_edge_index.h>
+#include <geometry/polyline_kernels.h>
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+#include <math/util.h>
+
+
+// Contours with fewer points than this are cheaper to scan than to index
+static const int MIN_INDEXED_POINTS = 64;
+
+// Average number of edges per bucket, and the maximum number of buckets per contour
+static const int EDGES_PER_BUCKET = 8;
+static const int MAX_BUCKETS = 4096;
+
+// Give up on contours whose long edges would need more bucket entries than this (per point)
+static const int MAX_ENTRIES_PER_POINT = 16;
+
+
+/**
+ * Squared distance between the bounding boxes of \a aA - \a aB and \a aC - \a aD.  SEG's
+ * nearest points never leave a segment's extents, so this is a lower bound of the distances
+ * SEG computes.
+ */
+static inline SEG::ecoord bboxSquaredDistance( const VECTOR2I& aA, const VECTOR2I& aB,
+                                               const VECTOR2I& aC, const VECTOR2I& aD )
+{
+    SEG::ecoord dx = std::max<SEG::ecoord>( { 0,
+            SEG::ecoord( std::min( aA.x, aB.x ) ) - std::max( aC.x, aD.x ),
+            SEG::ecoord( std::min( aC.x, aD.x ) ) - std::max( aA.x, aB.x ) } );
+    SEG::ecoord dy = std::max<SEG::ecoord>( { 0,
+            SEG::ecoord( std::min( aA.y, aB.y ) ) - std::max( aC.y, aD.y ),
+            SEG::ecoord( std::min( aC.y, aD.y ) ) - std::max( aA.y, aB.y ) } );
+
+    return dx * dx + dy * dy;
+}
+
+
+int POLY_EDGE_INDEX::CONTOUR_BUCKETS::BucketOf( int64_t aY ) const
+{
+    int64_t bucket = ( aY - m_yMin ) / m_bucketHeight;
+
+    return (int) std::clamp<int64_t>( bucket, 0, BucketCount() - 1 );
+}
+
+
+POLY_EDGE_INDEX::POLY_EDGE_INDEX( const SHAPE_POLY_SET& aPolySet, const MD5_HASH& aHash ) :
+        m_hash( aHash )
+{
+    m_contours.resize( aPolySet.OutlineCount() );
+
+    for( int ii = 0; ii < aPolySet.OutlineCount(); ++ii )
+    {
+        const SHAPE_POLY_SET::POLYGON& poly = aPolySet.CPolygon( ii );
+
+        m_contours[ii].resize( poly.size() );
+
+        for( size_t jj = 0; jj < poly.size(); ++jj )
+        {
+            if( poly[jj].PointCount() >= MIN_INDEXED_POINTS )
+                buildContour( poly[jj], m_contours[ii][jj] );
+        }
+    }
+}
+
+
+bool POLY_EDGE_INDEX::HasIndexedContours() const
+{
+    for( const std::vector<CONTOUR_BUCKETS>& poly : m_contours )
+    {
+        for( const CONTOUR_BUCKETS& contour : poly )
+        {
+            if( contour.IsIndexed() )
+                return true;
+        }
+    }
+
+    return false;
+}
+
+
+void POLY_EDGE_INDEX::buildContour( const SHAPE_LINE_CHAIN& aChain, CONTOUR_BUCKETS& aBuckets )
+{
+    const std::vector<VECTOR2I>& pts = aChain.CPoints();
+    const size_t                 count = pts.size();
+
+    aBuckets.m_pointCount = count;
+
+    auto minmax = std::minmax_element( pts.begin(), pts.end(),
+                                       []( const VECTOR2I& a, const VECTOR2I& b )
+                                       {
+                                           return a.y < b.y;
+                                       } );
+
+    aBuckets.m_yMin = minmax.first->y;
+    aBuckets.m_yMax = minmax.second->y;
+
+    int     bucketCount = std::clamp<int>( count / EDGES_PER_BUCKET, 1, MAX_BUCKETS );
+    int64_t span = int64_t( aBuckets.m_yMax ) - aBuckets.m_yMin;
+
+    aBuckets.m_bucketHeight = span / bucketCount + 1;
+    aBuckets.m_bucketStart.assign( bucketCount + 1, 0 );
+
+    // First pass: count the entries of each bucket (shifted by one for the prefix sum)
+    size_t entries = 0;
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        const VECTOR2I& a = pts[i];
+        const VECTOR2I& b = pts[i + 1 == count ? 0 : i + 1];
+        int             first = aBuckets.BucketOf( std::min( a.y, b.y ) );
+        int             last = aBuckets.BucketOf( std::max( a.y, b.y ) );
+
+        for( int bucket = first; bucket <= last; ++bucket )
+            aBuckets.m_bucketStart[bucket + 1]++;
+
+        entries += last - first + 1;
+    }
+
+    if( entries > count * MAX_ENTRIES_PER_POINT )
+    {
+        aBuckets.m_bucketStart.clear();
+        return;
+    }
+
+    for( int bucket = 0; bucket < bucketCount; ++bucket )
+        aBuckets.m_bucketStart[bucket + 1] += aBuckets.m_bucketStart[bucket];
+
+    // Second pass: fill the buckets.  Edges end up in increasing order within each bucket.
+    std::vector<uint32_t> fill( aBuckets.m_bucketStart.begin(), aBuckets.m_bucketStart.end() - 1 );
+
+    aBuckets.m_edges.resize( entries );
+
+    for( size_t i = 0; i < count; ++i )
+    {
+        const VECTOR2I& a = pts[i];
+        const VECTOR2I& b = pts[i + 1 == count ? 0 : i + 1];
+        int             first = aBuckets.BucketOf( std::min( a.y, b.y ) );
+        int             last = aBuckets.BucketOf( std::max( a.y, b.y ) );
+
+        for( int bucket = first; bucket <= last; ++bucket )
+            aBuckets.m_edges[fill[bucket]++] = (uint32_t) i;
+    }
+}
+
+
+const POLY_EDGE_INDEX::CONTOUR_BUCKETS*
+POLY_EDGE_INDEX::indexedContour( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain ) const
+{
+    if( aPolygon < 0 || aPolygon >= (int) m_contours.size() || aContour < 0
+            || aContour >= (int) m_contours[aPolygon].size() )
+    {
+        return nullptr;
+    }
+
+    const CONTOUR_BUCKETS& buckets = m_contours[aPolygon][aContour];
+
+    // The edge numbers must stay within the chain even if the index is stale
+    if( !buckets.IsIndexed() || buckets.m_pointCount != aChain.CPoints().size() )
+        return nullptr;
+
+    return &buckets;
+}
+
+
+template <typename Visitor>
+void POLY_EDGE_INDEX::visitOutwards( const CONTOUR_BUCKETS& aBuckets, int64_t aYMin,
+                                     int64_t aYMax, Visitor aVisitor ) const
+{
+    auto verticalGap =
+            [&]( int aBucket ) -> SEG::ecoord
+            {
+                int64_t lo = aBuckets.m_yMin + aBucket * aBuckets.m_bucketHeight;
+                int64_t hi = lo + aBuckets.m_bucketHeight - 1;
+                int64_t gap = std::max<int64_t>( { 0, lo - aYMax, aYMin - hi } );
+
+                return gap * gap;
+            };
+
+    SEG::ecoord bound = std::numeric_limits<SEG::ecoord>::max();
+
+    auto visitBucket =
+            [&]( int aBucket )
+            {
+                for( uint32_t ii = aBuckets.m_bucketStart[aBucket];
+                     ii < aBuckets.m_bucketStart[aBucket + 1]; ++ii )
+                {
+                    bound = aVisitor( aBuckets.m_edges[ii] );
+                }
+            };
+
+    int below = aBuckets.BucketOf( aYMin );
+    int above = aBuckets.BucketOf( aYMax );
+
+    for( int bucket = below; bucket <= above; ++bucket )
+    {
+        if( verticalGap( bucket ) > bound )
+            break;
+
+        visitBucket( bucket );
+    }
+
+    below--;
+    above++;
+
+    while( below >= 0 || above < aBuckets.BucketCount() )
+    {
+        SEG::ecoord gapBelow = below >= 0 ? verticalGap( below )
+                                          : std::numeric_limits<SEG::ecoord>::max();
+        SEG::ecoord gapAbove = above < aBuckets.BucketCount()
+                                       ? verticalGap( above )
+                                       : std::numeric_limits<SEG::ecoord>::max();
+
+        // Ties must still be visited so that the lowest edge index wins, as in a linear scan
+        if( std::min( gapBelow, gapAbove ) > bound )
+            break;
+
+        if( gapBelow <= gapAbove )
+            visitBucket( below-- );
+        else
+            visitBucket( above++ );
+    }
+}
+
+
+bool POLY_EDGE_INDEX::PointInside( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                                   const VECTOR2I& aP ) const
+{
+    const CONTOUR_BUCKETS*       indexed = indexedContour( aPolygon, aContour, aChain );
+    const std::vector<VECTOR2I>& pts = aChain.CPoints();
+
+    if( !aChain.IsClosed() )
+        return false;
+
+    if( !indexed )
+        return PolylineContainsPoint( pts.data(), pts.size(), aP );
+
+    const CONTOUR_BUCKETS& buckets = *indexed;
+
+    if( aP.y < buckets.m_yMin || aP.y > buckets.m_yMax )
+        return false;
+
+    const size_t count = pts.size();
+    const int    bucket = buckets.BucketOf( aP.y );
+    bool         inside = false;
+
+    // Same crossing test as PolylineContainsPoint(), but only for the edges in aP's band
+    for( uint32_t ii = buckets.m_bucketStart[bucket]; ii < buckets.m_bucketStart[bucket + 1]; ++ii )
+    {
+        const uint32_t  edge = buckets.m_edges[ii];
+        const VECTOR2I& p1 = pts[edge];
+        const VECTOR2I& p2 = pts[edge + 1 == count ? 0 : edge + 1];
+
+        if( ( p1.y > aP.y ) != ( p2.y > aP.y ) )
+        {
+            const int d = rescale( p2.x - p1.x, aP.y - p1.y, p2.y - p1.y );
+
+            if( aP.x - p1.x < d )
+                inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+
+bool POLY_EDGE_INDEX::EdgeWithin( int aPolygon, int aContour, const SHAPE_LINE_CHAIN& aChain,
+                                  const VECTOR2I& aP, int aDist ) const
+{
+    const CONTOUR_BUCKETS*       indexed = indexedContour( aPolygon, aContour, aChain );
+    const std::vector<VECTOR2I>& pts = aChain.CPoints();
+
+    if( !indexed )
+        return PolylineEdgeWithin( pts.data(), pts.size(), aChain.IsClosed(), aP, aDist ) >= 0;
+
+    const CONTOUR_BUCKETS& buckets = *indexed;
+
+    // SEG::Distance() rounds, so anything beyond aDist + 0.5 can't match
+    const int64_t     reach = int64_t( aDist ) + 1;
+    const SEG::ecoord reject = reach * reach;
+
+    if( aP.y + reach < buckets.m_yMin || aP.y - reach > buckets.m_yMax )
+        return false;
+
+    const size_t count = pts.size();
+    const int    first = buckets.BucketOf( aP.y - reach );
+    const int    last = buckets.BucketOf( aP.y + reach );
+
+    for( uint32_t ii = buckets.m_bucketStart[first]; ii < buckets.m_bucketStart[last + 1]; ++ii )
+    {
+        const uint32_t  edge = buckets.m_edges[ii];
+        const VECTOR2I& a = pts[edge];
+        const VECTOR2I& b = pts[edge + 1 == count ? 0 : edge + 1];
+
+        if( a == aP || b == aP )
+            return true;
+
+        if( bboxSquaredDistance( a, b, aP, aP ) >= reject )
+            continue;
+
+        if( SEG( a, b ).Distance( aP ) <= aDist )
+            return true;
+    }
+
+    return false;
+}
+
+
+SEG::ecoord POLY_EDGE_INDEX::SquaredDistance( int aPolygon, int aContour,
+                                              const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP,
+                                              VECTOR2I* aNearest ) const
+{
+    const CONTOUR_BUCKETS*       indexed = indexedContour( aPolygon, aContour, aChain );
+    const std::vector<VECTOR2I>& pts = aChain.CPoints();
+
+    if( !indexed )
+    {
+        return PolylineSquaredDistance( pts.data(), pts.size(), aChain.IsClosed(), aP, 0,
+                                        aNearest );
+    }
+
+    const CONTOUR_BUCKETS& buckets = *indexed;
+
+    const size_t count = pts.size();
+    SEG::ecoord  best = VECTOR2I::ECOORD_MAX;
+    uint32_t     bestEdge = std::numeric_limits<uint32_t>::max();
+    VECTOR2I     bestPt;
+
+    visitOutwards( buckets, aP.y, aP.y,
+            [&]( uint32_t aEdge ) -> SEG::ecoord
+            {
+                const VECTOR2I& a = pts[aEdge];
+                const VECTOR2I& b = pts[aEdge + 1 == count ? 0 : aEdge + 1];
+
+                if( bboxSquaredDistance( a, b, aP, aP ) > best )
+                    return best;
+
+                VECTOR2I    pn = SEG( a, b ).NearestPoint( aP );
+                SEG::ecoord dist = ( pn - aP ).SquaredEuclideanNorm();
+
+                if( dist < best || ( dist == best && aEdge < bestEdge ) )
+                {
+                    best = dist;
+                    bestEdge = aEdge;
+                    bestPt = pn;
+                }
+
+                return best;
+            } );
+
+    if( aNearest && bestEdge < count )
+        *aNearest = bestPt;
+
+    return best;
+}
+
+
+SEG::ecoord POLY_EDGE_INDEX::SquaredDistance( int aPolygon, int aContour,
+                                              const SHAPE_LINE_CHAIN& aChain, const SEG& aSeg,
+                                              VECTOR2I* aNearest ) const
+{
+    const CONTOUR_BUCKETS*       indexed = indexedContour( aPolygon, aContour, aChain );
+    const std::vector<VECTOR2I>& pts = aChain.CPoints();
+    const size_t                 count = pts.size();
+    SEG::ecoord                  best = VECTOR2I::ECOORD_MAX;
+    uint32_t                     bestEdge = std::numeric_limits<uint32_t>::max();
+
+    auto visitor =
+            [&]( uint32_t aEdge ) -> SEG::ecoord
+            {
+                const VECTOR2I& a = pts[aEdge];
+                const VECTOR2I& b = pts[aEdge + 1 == count ? 0 : aEdge + 1];
+
+                if( bboxSquaredDistance( a, b, aSeg.A, aSeg.B ) > best )
+                    return best;
+
+                SEG::ecoord dist = SEG( a, b ).SquaredDistance( aSeg );
+
+                if( dist < best || ( dist == best && aEdge < bestEdge ) )
+                {
+                    best = dist;
+                    bestEdge = aEdge;
+                }
+
+                return best;
+            };
+
+    if( indexed )
+    {
+        visitOutwards( *indexed, std::min( aSeg.A.y, aSeg.B.y ), std::max( aSeg.A.y, aSeg.B.y ),
+                       visitor );
+    }
+    else
+    {
+        size_t segCount = aChain.IsClosed() ? count : ( count ? count - 1 : 0 );
+
+        for( uint32_t edge = 0; edge < segCount && best > 0; ++edge )
+            visitor( edge );
+    }
+
+    if( aNearest && bestEdge < count )
+    {
+        SEG edge( pts[bestEdge], pts[bestEdge + 1 == count ? 0 : bestEdge + 1] );
+        *aNearest = edge.NearestPoint( aSeg );
+    }
+
+    return best;
+}
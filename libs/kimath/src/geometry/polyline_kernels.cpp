@@ -0,0 +1,291 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <geometry/polyline_kernels.h>
+#include <math/simd_target.h>
+#include <math/util.h>
+
+#if defined( KIMATH_TARGET_SSE2 ) && !defined( POLYLINE_KERNELS_NO_SIMD )
+#define POLYLINE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+/**
+ * Squared distance from \a aP to the bounding box of segment \a aA - \a aB.
+ *
+ * SEG::NearestPoint() always returns a point within that box (its rounding never leaves the
+ * segment's extents), so this is a lower bound of the distance SEG would compute.
+ */
+static inline SEG::ecoord bboxSquaredDistance( const VECTOR2I& aA, const VECTOR2I& aB,
+                                               const VECTOR2I& aP )
+{
+    SEG::ecoord dx = std::max<SEG::ecoord>( { 0, SEG::ecoord( std::min( aA.x, aB.x ) ) - aP.x,
+                                              SEG::ecoord( aP.x ) - std::max( aA.x, aB.x ) } );
+    SEG::ecoord dy = std::max<SEG::ecoord>( { 0, SEG::ecoord( std::min( aA.y, aB.y ) ) - aP.y,
+                                              SEG::ecoord( aP.y ) - std::max( aA.y, aB.y ) } );
+
+    return dx * dx + dy * dy;
+}
+
+
+#ifdef POLYLINE_USE_SSE2
+
+/**
+ * Bounding box squared distances from (\a aPx, \a aPy) to the segments \a aPts[0] - \a aPts[1]
+ * and \a aPts[1] - \a aPts[2], computed in the two double lanes.
+ *
+ * The coordinate differences are exact in double precision and the squares are rounded, so
+ * the result is within a relative 1e-15 of the integer bboxSquaredDistance().
+ */
+static inline __m128d bboxSquaredDistance2( const VECTOR2I* aPts, __m128d aPx, __m128d aPy )
+{
+    // ( x0, x1, y0, y1 ) and ( x1, x2, y1, y2 )
+    const __m128i a = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*) aPts ),
+                                         _MM_SHUFFLE( 3, 1, 2, 0 ) );
+    const __m128i b = _mm_shuffle_epi32( _mm_loadu_si128( (const __m128i*) ( aPts + 1 ) ),
+                                         _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+    const __m128d ax = _mm_cvtepi32_pd( a );
+    const __m128d ay = _mm_cvtepi32_pd( _mm_srli_si128( a, 8 ) );
+    const __m128d bx = _mm_cvtepi32_pd( b );
+    const __m128d by = _mm_cvtepi32_pd( _mm_srli_si128( b, 8 ) );
+
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d dx = _mm_max_pd( zero, _mm_max_pd( _mm_sub_pd( _mm_min_pd( ax, bx ), aPx ),
+                                                     _mm_sub_pd( aPx, _mm_max_pd( ax, bx ) ) ) );
+    const __m128d dy = _mm_max_pd( zero, _mm_max_pd( _mm_sub_pd( _mm_min_pd( ay, by ), aPy ),
+                                                     _mm_sub_pd( aPy, _mm_max_pd( ay, by ) ) ) );
+
+    return _mm_add_pd( _mm_mul_pd( dx, dx ), _mm_mul_pd( dy, dy ) );
+}
+
+
+/**
+ * @return a two bit mask of the segments starting at \a aPts[0] and \a aPts[1] whose bounding
+ *         box may be nearer to \a aP than sqrt( \a aLimit ).  A segment left out of the mask
+ *         is guaranteed to have bboxSquaredDistance() >= \a aLimit.
+ */
+static inline int bboxMaybeNearer2( const VECTOR2I* aPts, __m128d aPx, __m128d aPy,
+                                    double aLimit )
+{
+    // Shrink the distances by more than the rounding errors of both sides of the comparison
+    const __m128d d = _mm_mul_pd( bboxSquaredDistance2( aPts, aPx, aPy ),
+                                  _mm_set1_pd( 1.0 - 1e-14 ) );
+
+    return _mm_movemask_pd( _mm_cmplt_pd( d, _mm_set1_pd( aLimit ) ) );
+}
+
+#endif
+
+
+/**
+ * Toggle \a aInside if the edge \a aP1 - \a aP2, which straddles the horizontal through
+ * \a aP, crosses it to the right of \a aP.
+ */
+static inline void toggleCrossing( const VECTOR2I& aP1, const VECTOR2I& aP2, const VECTOR2I& aP,
+                                   bool& aInside )
+{
+    const int d = rescale( aP2.x - aP1.x, aP.y - aP1.y, aP2.y - aP1.y );
+
+    if( aP.x - aP1.x < d )
+        aInside = !aInside;
+}
+
+
+bool PolylineContainsPoint( const VECTOR2I* aPts, size_t aCount, const VECTOR2I& aP )
+{
+    if( aCount < 3 )
+        return false;
+
+    bool   inside = false;
+    size_t i = 0;
+
+    /*
+     * Cast a ray in the positive x direction and count the crossings.  Only edges that
+     * straddle the ray's y need the (slow) intersection calculation, so test that first.
+     */
+#ifdef POLYLINE_USE_SSE2
+    // Find the vertices above the ray four at a time; the straddling edges are the ones whose
+    // end vertices differ.
+    const __m128i py = _mm_set1_epi32( aP.y );
+    int           prevAbove = aPts[aCount - 1].y > aP.y;
+
+    for( ; i + 4 <= aCount; i += 4 )
+    {
+        const __m128 lo = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i*) ( aPts + i ) ) );
+        const __m128 hi = _mm_castsi128_ps( _mm_loadu_si128( (const __m128i*) ( aPts + i + 2 ) ) );
+        const __m128i y = _mm_castps_si128( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+
+        const int above = _mm_movemask_ps( _mm_castsi128_ps( _mm_cmpgt_epi32( y, py ) ) );
+        const int straddle = ( above ^ ( ( above << 1 ) | prevAbove ) ) & 0xF;
+
+        prevAbove = above >> 3;
+
+        if( !straddle )
+            continue;
+
+        for( size_t k = 0; k < 4; ++k )
+        {
+            if( straddle & ( 1 << k ) )
+                toggleCrossing( aPts[i + k == 0 ? aCount - 1 : i + k - 1], aPts[i + k], aP, inside );
+        }
+    }
+#endif
+
+    const VECTOR2I* p1 = &aPts[i == 0 ? aCount - 1 : i - 1];
+
+    for( ; i < aCount; ++i )
+    {
+        const VECTOR2I* p2 = &aPts[i];
+
+        if( ( p1->y > aP.y ) != ( p2->y > aP.y ) )
+            toggleCrossing( *p1, *p2, aP, inside );
+
+        p1 = p2;
+    }
+
+    return inside;
+}
+
+
+SEG::ecoord PolylineSquaredDistance( const VECTOR2I* aPts, size_t aCount, bool aClosed,
+                                     const VECTOR2I& aP, SEG::ecoord aStopBelow,
+                                     VECTOR2I* aNearest, int* aSegment )
+{
+    SEG::ecoord best = VECTOR2I::ECOORD_MAX;
+    int         bestSeg = -1;
+    VECTOR2I    bestPt;
+    bool        done = false;
+
+    size_t segCount = aClosed ? aCount : ( aCount ? aCount - 1 : 0 );
+    size_t i = 0;
+
+    auto testSegment =
+            [&]( size_t aIdx )
+            {
+                const VECTOR2I& a = aPts[aIdx];
+                const VECTOR2I& b = aPts[aIdx + 1 == aCount ? 0 : aIdx + 1];
+
+                if( bboxSquaredDistance( a, b, aP ) >= best )
+                    return;
+
+                VECTOR2I    pn = SEG( a, b ).NearestPoint( aP );
+                SEG::ecoord dist = ( pn - aP ).SquaredEuclideanNorm();
+
+                if( dist < best )
+                {
+                    best = dist;
+                    bestSeg = aIdx;
+                    bestPt = pn;
+
+                    if( best == 0 || best < aStopBelow )
+                        done = true;
+                }
+            };
+
+#ifdef POLYLINE_USE_SSE2
+    // Reject two segments at a time on their bounding boxes; the ones left go through the
+    // exact test above, in order, so the result is the same as the plain loop's.
+    const __m128d px = _mm_set1_pd( aP.x );
+    const __m128d py = _mm_set1_pd( aP.y );
+
+    for( ; !done && i + 2 < aCount && i + 2 <= segCount; i += 2 )
+    {
+        const double limit = best == VECTOR2I::ECOORD_MAX ? std::numeric_limits<double>::infinity()
+                                                          : double( best );
+        const int    candidates = bboxMaybeNearer2( aPts + i, px, py, limit );
+
+        if( candidates & 1 )
+            testSegment( i );
+
+        if( ( candidates & 2 ) && !done )
+            testSegment( i + 1 );
+    }
+#endif
+
+    for( ; !done && i < segCount; ++i )
+        testSegment( i );
+
+    if( aNearest && bestSeg >= 0 )
+        *aNearest = bestPt;
+
+    if( aSegment )
+        *aSegment = bestSeg;
+
+    return best;
+}
+
+
+int PolylineEdgeWithin( const VECTOR2I* aPts, size_t aCount, bool aClosed, const VECTOR2I& aP,
+                        int aDist )
+{
+    size_t segCount = aClosed ? aCount : ( aCount ? aCount - 1 : 0 );
+    size_t i = 0;
+
+    // SEG::Distance() rounds, so anything beyond aDist + 0.5 can't match
+    SEG::ecoord reject = ( SEG::ecoord( aDist ) + 1 ) * ( SEG::ecoord( aDist ) + 1 );
+
+    auto testSegment =
+            [&]( size_t aIdx ) -> bool
+            {
+                const VECTOR2I& a = aPts[aIdx];
+                const VECTOR2I& b = aPts[aIdx + 1 == aCount ? 0 : aIdx + 1];
+
+                if( a == aP || b == aP )
+                    return true;
+
+                if( bboxSquaredDistance( a, b, aP ) >= reject )
+                    return false;
+
+                return SEG( a, b ).Distance( aP ) <= aDist;
+            };
+
+#ifdef POLYLINE_USE_SSE2
+    // A segment ending on aP has a zero bounding box distance, so it is never rejected here
+    const __m128d px = _mm_set1_pd( aP.x );
+    const __m128d py = _mm_set1_pd( aP.y );
+
+    for( ; i + 2 < aCount && i + 2 <= segCount; i += 2 )
+    {
+        const int candidates = bboxMaybeNearer2( aPts + i, px, py, double( reject ) );
+
+        if( ( candidates & 1 ) && testSegment( i ) )
+            return i;
+
+        if( ( candidates & 2 ) && testSegment( i + 1 ) )
+            return i + 1;
+    }
+#endif
+
+    for( ; i < segCount; ++i )
+    {
+        if( testSegment( i ) )
+            return i;
+    }
+
+    return -1;
+}
@@ -31,6 +31,7 @@
 
 #include <clipper.hpp>
 #include <core/kicad_algo.h> // for alg::run_on_pair
+#include <geometry/polyline_kernels.h>
 #include <geometry/seg.h>    // for SEG, OPT_VECTOR2I
 #include <geometry/shape_line_chain.h>
 #include <math/box2.h>       // for BOX2I
@@ -93,6 +94,9 @@ SHAPE_LINE_CHAIN::SHAPE_LINE_CHAIN( const ClipperLib::Path&             aPath,
     // Clipper might mess up the rotation of the indices such that an arc can be split between
     // the end point and wrap around to the start point. Lets fix the indices up now
     fixIndicesRotation();
+
+    // Clipper may also have cut arcs short or split them at intersections
+    trimArcsToPoints();
 }
 
 ClipperLib::Path SHAPE_LINE_CHAIN::convertToClipper( bool aRequiredOrientation,
@@ -150,6 +154,111 @@ void SHAPE_LINE_CHAIN::fixIndicesRotation()
 }
 
 
+void SHAPE_LINE_CHAIN::trimArcsToPoints()
+{
+    if( m_arcs.empty() )
+        return;
+
+    size_t                           numPoints = m_points.size();
+    size_t                           numArcs = m_arcs.size();
+    std::vector<std::vector<size_t>> arcRefs( numArcs );
+    std::vector<bool>                referenced( numArcs, false );
+
+    for( size_t ii = 0; ii < numPoints; ++ii )
+    {
+        alg::run_on_pair( m_shapes[ii],
+                [&]( ssize_t aShapeIndex )
+                {
+                    if( aShapeIndex != SHAPE_IS_PT )
+                        arcRefs[aShapeIndex].push_back( ii );
+                } );
+    }
+
+    for( size_t arcIdx = 0; arcIdx < numArcs; ++arcIdx )
+    {
+        const std::vector<size_t>& refs = arcRefs[arcIdx];
+
+        // Split the references into runs of consecutive points
+        std::vector<std::pair<size_t, size_t>> runs; // first and last reference of each run
+
+        for( size_t ii = 0; ii < refs.size(); ++ii )
+        {
+            if( runs.empty() || refs[ii] != refs[ii - 1] + 1 )
+                runs.emplace_back( ii, ii );
+            else
+                runs.back().second = ii;
+        }
+
+        // A run wrapping around the end of a closed chain is one run
+        if( m_closed && runs.size() > 1 && refs.front() == 0 && refs.back() == numPoints - 1 )
+        {
+            runs.front().first = runs.back().first;
+            runs.pop_back();
+        }
+
+        const SHAPE_ARC original = m_arcs[arcIdx];
+
+        for( size_t runIdx = 0; runIdx < runs.size(); ++runIdx )
+        {
+            size_t   first = runs[runIdx].first;
+            size_t   last = runs[runIdx].second;
+            size_t   runLength = ( last >= first ) ? last - first + 1
+                                                   : last + refs.size() - first + 1;
+            ssize_t  newIdx = arcIdx;
+
+            if( runLength < 2 )
+                newIdx = SHAPE_IS_PT;
+            else if( runIdx > 0 )
+                newIdx = m_arcs.size();
+
+            for( size_t ii = first; ; ii = ( ii + 1 ) % refs.size() )
+            {
+                alg::run_on_pair( m_shapes[refs[ii]],
+                        [&]( ssize_t& aShapeIndex )
+                        {
+                            if( aShapeIndex == static_cast<ssize_t>( arcIdx ) )
+                                aShapeIndex = newIdx;
+                        } );
+
+                if( ii == last )
+                    break;
+            }
+
+            if( newIdx == SHAPE_IS_PT )
+                continue;
+
+            const VECTOR2I& start = m_points[refs[first]];
+            const VECTOR2I& end = m_points[refs[last]];
+
+            if( newIdx != static_cast<ssize_t>( arcIdx ) )
+            {
+                m_arcs.push_back( original );
+                referenced.push_back( true );
+            }
+            else
+            {
+                referenced[arcIdx] = true;
+            }
+
+            if( start != original.GetP0() || end != original.GetP1() )
+                amendArc( newIdx, start, end );
+        }
+    }
+
+    for( std::pair<ssize_t, ssize_t>& sh : m_shapes )
+    {
+        if( sh.first == SHAPE_IS_PT && sh.second != SHAPE_IS_PT )
+            std::swap( sh.first, sh.second );
+    }
+
+    for( ssize_t arcIdx = m_arcs.size() - 1; arcIdx >= 0; --arcIdx )
+    {
+        if( !referenced[arcIdx] )
+            convertArc( arcIdx );
+    }
+}
+
+
 void SHAPE_LINE_CHAIN::mergeFirstLastPointIfNeeded()
 {
     if( m_closed )
@@ -316,23 +425,32 @@ bool SHAPE_LINE_CHAIN_BASE::Collide( const VECTOR2I& aP, int aClearance, int* aA
     SEG::ecoord clearance_sq = SEG::Square( aClearance );
     VECTOR2I nearest;
 
-    for( size_t i = 0; i < GetSegmentCount(); i++ )
+    if( const VECTOR2I* pts = GetPointArray() )
     {
-        const SEG& s = GetSegment( i );
-        VECTOR2I pn = s.NearestPoint( aP );
-        SEG::ecoord dist_sq = ( pn - aP ).SquaredEuclideanNorm();
-
-        if( dist_sq < closest_dist_sq )
+        // If we're not looking for aActual then any collision will do
+        closest_dist_sq = PolylineSquaredDistance( pts, GetPointCount(), IsClosed(), aP,
+                                                   aActual ? 0 : clearance_sq, &nearest );
+    }
+    else
+    {
+        for( size_t i = 0; i < GetSegmentCount(); i++ )
         {
-            nearest = pn;
-            closest_dist_sq = dist_sq;
+            const SEG& s = GetSegment( i );
+            VECTOR2I pn = s.NearestPoint( aP );
+            SEG::ecoord dist_sq = ( pn - aP ).SquaredEuclideanNorm();
 
-            if( closest_dist_sq == 0 )
-                break;
+            if( dist_sq < closest_dist_sq )
+            {
+                nearest = pn;
+                closest_dist_sq = dist_sq;
 
-            // If we're not looking for aActual then any collision will do
-            if( closest_dist_sq < clearance_sq && !aActual )
-                break;
+                if( closest_dist_sq == 0 )
+                    break;
+
+                // If we're not looking for aActual then any collision will do
+                if( closest_dist_sq < clearance_sq && !aActual )
+                    break;
+            }
         }
     }
 
@@ -804,6 +922,9 @@ SEG::ecoord SHAPE_LINE_CHAIN_BASE::SquaredDistance( const VECTOR2I& aP, bool aOu
     if( IsClosed() && PointInside( aP ) && !aOutlineOnly )
         return 0;
 
+    if( const VECTOR2I* pts = GetPointArray() )
+        return PolylineSquaredDistance( pts, GetPointCount(), IsClosed(), aP );
+
     for( size_t s = 0; s < GetSegmentCount(); s++ )
         d = std::min( d, GetSegment( s ).SquaredDistance( aP ) );
 
@@ -1543,6 +1664,16 @@ bool SHAPE_LINE_CHAIN_BASE::PointInside( const VECTOR2I& aPt, int aAccuracy,
 
     bool inside = false;
 
+    if( const VECTOR2I* pts = GetPointArray() )
+    {
+        inside = PolylineContainsPoint( pts, GetPointCount(), aPt );
+
+        if( aAccuracy <= 1 )
+            return inside;
+        else
+            return inside || PointOnEdge( aPt, aAccuracy );
+    }
+
     /*
      * To check for interior points, we draw a line in the positive x direction from
      * the point.  If it intersects an even number of segments, the point is outside the
@@ -1560,13 +1691,13 @@ bool SHAPE_LINE_CHAIN_BASE::PointInside( const VECTOR2I& aPt, int aAccuracy,
     {
         const auto p1 = GetPoint( i++ );
         const auto p2 = GetPoint( i == pointCount ? 0 : i );
-        const auto diff = p2 - p1;
 
-        if( diff.y != 0 )
+        if( ( p1.y > aPt.y ) != ( p2.y > aPt.y ) )
         {
-            const int d = rescale( diff.x, ( aPt.y - p1.y ), diff.y );
+            const auto diff = p2 - p1;
+            const int  d = rescale( diff.x, ( aPt.y - p1.y ), diff.y );
 
-            if( ( ( p1.y > aPt.y ) != ( p2.y > aPt.y ) ) && ( aPt.x - p1.x < d ) )
+            if( aPt.x - p1.x < d )
                 inside = !inside;
         }
     }
@@ -1598,6 +1729,9 @@ int SHAPE_LINE_CHAIN_BASE::EdgeContainingPoint( const VECTOR2I& aPt, int aAccura
 	    return ( hypot( dist.x, dist.y ) <= aAccuracy + 1 ) ? 0 : -1;
     }
 
+    if( const VECTOR2I* pts = GetPointArray() )
+        return PolylineEdgeWithin( pts, GetPointCount(), IsClosed(), aPt, aAccuracy + 1 );
+
     for( size_t i = 0; i < GetSegmentCount(); i++ )
     {
         const SEG s = GetSegment( i );
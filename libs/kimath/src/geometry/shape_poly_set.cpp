@@ -30,20 +30,24 @@
 
 #include <algorithm>
 #include <assert.h>                          // for assert
+#include <atomic>
 #include <cmath>                             // for sqrt, cos, hypot, isinf
 #include <cstdio>
+#include <future>
 #include <istream>                           // for operator<<, operator>>
 #include <limits>                            // for numeric_limits
 #include <map>
 #include <memory>
 #include <set>
 #include <string>                            // for char_traits, operator!=
+#include <thread>
 #include <type_traits>                       // for swap, move
 #include <unordered_set>
 #include <vector>
 
 #include <clipper.hpp>                       // for Clipper, PolyNode, Clipp...
 #include <geometry/geometry_utils.h>
+#include <geometry/poly_edge_index.h>
 #include <geometry/polygon_triangulation.h>
 #include <geometry/seg.h>                    // for SEG, OPT_VECTOR2I
 #include <geometry/shape.h>
@@ -55,8 +59,10 @@
 #include <md5_hash.h>
 #include <geometry/shape_segment.h>
 #include <geometry/shape_circle.h>
+#include <trigo.h>
 
 #include <wx/log.h>
+#include <wx/thread.h>
 
 
 SHAPE_POLY_SET::SHAPE_POLY_SET() :
@@ -86,7 +92,9 @@ SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_LINE_CHAIN& aOutline ) :
 
 SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther ) :
     SHAPE( aOther ),
-    m_polys( aOther.m_polys )
+    m_polys( aOther.m_polys ),
+    m_edgeIndexHash( aOther.m_edgeIndexHash ),
+    m_edgeIndex( aOther.m_edgeIndex )
 {
     if( aOther.IsTriangulationUpToDate() )
     {
@@ -98,6 +106,7 @@ SHAPE_POLY_SET::SHAPE_POLY_SET( const SHAPE_POLY_SET& aOther ) :
 
         m_hash = aOther.GetHash();
         m_triangulationValid = true;
+        m_triangulatedOutlineHashes = aOther.m_triangulatedOutlineHashes;
     }
     else
     {
@@ -739,7 +748,8 @@ void SHAPE_POLY_SET::InflateWithLinkedHoles( int aFactor, int aCircleSegmentsCou
 }
 
 
-void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegCount, CORNER_STRATEGY aCornerStrategy )
+void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegCount, CORNER_STRATEGY aCornerStrategy,
+                              bool aPreserveArcs )
 {
     using namespace ClipperLib;
     // A static table to avoid repetitive calculations of the coefficient
@@ -789,6 +799,9 @@ void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegCount, CORNER_STRATEGY
     std::vector<CLIPPER_Z_VALUE> zValues;
     std::vector<SHAPE_ARC>       arcBuffer;
 
+    // Clipper gives a Z of 0 to every vertex it creates, so make sure index 0 means "no arc"
+    zValues.emplace_back();
+
     for( const POLYGON& poly : m_polys )
     {
         for( size_t i = 0; i < poly.size(); i++ )
@@ -798,6 +811,23 @@ void SHAPE_POLY_SET::Inflate( int aAmount, int aCircleSegCount, CORNER_STRATEGY
         }
     }
 
+    if( aPreserveArcs )
+    {
+        c.ZFillRoundFunction(
+                [&]( const IntPoint& aStart, const IntPoint& aMid, const IntPoint& aEnd ) -> cInt
+                {
+                    CLIPPER_Z_VALUE zValue;
+                    zValue.m_FirstArcIdx = arcBuffer.size();
+
+                    arcBuffer.emplace_back( VECTOR2I( aStart.X, aStart.Y ),
+                                            VECTOR2I( aMid.X, aMid.Y ),
+                                            VECTOR2I( aEnd.X, aEnd.Y ), 0 );
+                    zValues.push_back( zValue );
+
+                    return zValues.size() - 1;
+                } );
+    }
+
     PolyTree solution;
 
     // Calculate the arc tolerance (arc error) from the seg count by circle. The seg count is
@@ -1671,6 +1701,9 @@ void SHAPE_POLY_SET::DeletePolygonAndTriangulationData( int aIdx, bool aUpdateHa
                 triangleSet->SetSourceOutlineIndex( triangleSet->GetSourceOutlineIndex() - 1 );
         }
 
+        if( aIdx < (int) m_triangulatedOutlineHashes.size() )
+            m_triangulatedOutlineHashes.erase( m_triangulatedOutlineHashes.begin() + aIdx );
+
         if( aUpdateHash )
             m_hash = checksum();
     }
@@ -1772,6 +1805,32 @@ void SHAPE_POLY_SET::BuildBBoxCaches() const
         for( int holeIdx = 0; holeIdx < HoleCount( polygonIdx ); holeIdx++ )
             CHole( polygonIdx, holeIdx ).GenerateBBoxCache();
     }
+
+    // The edge index is built by the first query needing it, for the outlines as they are
+    // now.  One built earlier (or shared by a copy) is kept if they haven't changed since.
+    m_edgeIndexHash = checksum();
+
+    if( m_edgeIndex && m_edgeIndex->GetHash() != m_edgeIndexHash )
+        m_edgeIndex.reset();
+}
+
+
+std::shared_ptr<const POLY_EDGE_INDEX> SHAPE_POLY_SET::edgeIndex() const
+{
+    // Queries run concurrently (e.g. from DRC); if several threads build the index at once,
+    // the last one built is kept and the others are freed once their query is done.
+    std::shared_ptr<const POLY_EDGE_INDEX> index = std::atomic_load( &m_edgeIndex );
+
+    if( !index || index->GetHash() != m_edgeIndexHash )
+    {
+        index = std::make_shared<POLY_EDGE_INDEX>( *this, m_edgeIndexHash );
+        std::atomic_store( &m_edgeIndex, index );
+    }
+
+    if( !index->HasIndexedContours() )
+        return nullptr;
+
+    return index;
 }
 
 
@@ -1834,17 +1893,36 @@ void SHAPE_POLY_SET::SetVertex( const VERTEX_INDEX& aIndex, const VECTOR2I& aPos
 bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, int aAccuracy,
                                      bool aUseBBoxCaches ) const
 {
+    // The edge index is only valid under the same no-editing contract as the bbox caches.  It
+    // checks the contour sizes and falls back on a linear scan if they have changed since.
+    std::shared_ptr<const POLY_EDGE_INDEX> index = aUseBBoxCaches ? edgeIndex() : nullptr;
+
+    auto pointInside =
+            [&]( int aContour, int aContourAccuracy, bool aUseBBoxCache ) -> bool
+            {
+                const SHAPE_LINE_CHAIN& chain = m_polys[aSubpolyIndex][aContour];
+
+                if( !index || !index->IsIndexed( aSubpolyIndex, aContour, chain ) )
+                    return chain.PointInside( aP, aContourAccuracy, aUseBBoxCache );
+
+                if( index->PointInside( aSubpolyIndex, aContour, chain, aP ) )
+                    return true;
+
+                // See SHAPE_LINE_CHAIN_BASE::PointInside() and PointOnEdge()
+                return aContourAccuracy > 1
+                        && index->EdgeWithin( aSubpolyIndex, aContour, chain, aP,
+                                              aContourAccuracy + 1 );
+            };
+
     // Check that the point is inside the outline
-    if( m_polys[aSubpolyIndex][0].PointInside( aP, aAccuracy ) )
+    if( pointInside( 0, aAccuracy, false ) )
     {
         // Check that the point is not in any of the holes
         for( int holeIdx = 0; holeIdx < HoleCount( aSubpolyIndex ); holeIdx++ )
         {
-            const SHAPE_LINE_CHAIN& hole = CHole( aSubpolyIndex, holeIdx );
-
             // If the point is inside a hole it is outside of the polygon.  Do not use aAccuracy
             // here as it's meaning would be inverted.
-            if( hole.PointInside( aP, 1, aUseBBoxCaches ) )
+            if( pointInside( holeIdx + 1, 1, aUseBBoxCaches ) )
                 return false;
         }
 
@@ -1857,43 +1935,76 @@ bool SHAPE_POLY_SET::containsSingle( const VECTOR2I& aP, int aSubpolyIndex, int
 
 void SHAPE_POLY_SET::Move( const VECTOR2I& aVector )
 {
+    // Triangles left over from before an edit must not be stamped with the new hash
+    bool triangulationUpToDate = IsTriangulationUpToDate();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
             path.Move( aVector );
     }
 
-    for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : m_triangulatedPolys )
-        tri->Move( aVector );
+    if( triangulationUpToDate )
+    {
+        for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : m_triangulatedPolys )
+            tri->Move( aVector );
 
-    m_hash = checksum();
+        m_hash = checksum();
+    }
+
+    // The outline hashes no longer describe the (moved) triangles
+    m_triangulatedOutlineHashes.clear();
+    m_edgeIndex.reset();
 }
 
 
 void SHAPE_POLY_SET::Mirror( bool aX, bool aY, const VECTOR2I& aRef )
 {
+    // See Move()
+    bool triangulationUpToDate = IsTriangulationUpToDate();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
             path.Mirror( aX, aY, aRef );
     }
 
-    if( m_triangulationValid )
-        CacheTriangulation();
+    // The triangles are transformed exactly like the contours, so they stay valid
+    if( triangulationUpToDate )
+    {
+        for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : m_triangulatedPolys )
+            tri->Mirror( aX, aY, aRef );
+
+        m_hash = checksum();
+    }
+
+    m_triangulatedOutlineHashes.clear();
+    m_edgeIndex.reset();
 }
 
 
 void SHAPE_POLY_SET::Rotate( const EDA_ANGLE& aAngle, const VECTOR2I& aCenter )
 {
+    // See Move()
+    bool triangulationUpToDate = IsTriangulationUpToDate();
+
     for( POLYGON& poly : m_polys )
     {
         for( SHAPE_LINE_CHAIN& path : poly )
             path.Rotate( aAngle, aCenter );
     }
 
-    // Don't re-cache if the triangulation is already invalid
-    if( m_triangulationValid )
-        CacheTriangulation();
+    // See Mirror()
+    if( triangulationUpToDate )
+    {
+        for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : m_triangulatedPolys )
+            tri->Rotate( aAngle, aCenter );
+
+        m_hash = checksum();
+    }
+
+    m_triangulatedOutlineHashes.clear();
+    m_edgeIndex.reset();
 }
 
 
@@ -1925,13 +2036,14 @@ SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::FilletPolygon( unsigned int aRadius, int
 
 
 SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( VECTOR2I aPoint, int aPolygonIndex,
-                                                      VECTOR2I* aNearest ) const
+                                                      VECTOR2I* aNearest,
+                                                      bool aUseBBoxCaches ) const
 {
     // We calculate the min dist between the segment and each outline segment.  However, if the
     // segment to test is inside the outline, and does not cross any edge, it can be seen outside
     // the polygon.  Therefore test if a segment end is inside (testing only one end is enough).
     // Use an accuracy of "1" to say that we don't care if it's exactly on the edge or not.
-    if( containsSingle( aPoint, aPolygonIndex, 1 ) )
+    if( containsSingle( aPoint, aPolygonIndex, 1, aUseBBoxCaches ) )
     {
         if( aNearest )
             *aNearest = aPoint;
@@ -1939,6 +2051,31 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( VECTOR2I aPoint, int aPoly
         return 0;
     }
 
+    std::shared_ptr<const POLY_EDGE_INDEX> index = aUseBBoxCaches ? edgeIndex() : nullptr;
+
+    if( index )
+    {
+        const POLYGON& poly = m_polys[aPolygonIndex];
+        SEG::ecoord    minDistance = VECTOR2I::ECOORD_MAX;
+        VECTOR2I       nearest;
+
+        for( int ii = 0; ii < (int) poly.size() && minDistance > 0; ii++ )
+        {
+            SEG::ecoord currentDistance = index->SquaredDistance( aPolygonIndex, ii, poly[ii],
+                                                                  aPoint, &nearest );
+
+            if( currentDistance < minDistance )
+            {
+                if( aNearest )
+                    *aNearest = nearest;
+
+                minDistance = currentDistance;
+            }
+        }
+
+        return minDistance;
+    }
+
     CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
 
     SEG::ecoord minDistance = (*iterator).SquaredDistance( aPoint );
@@ -1961,11 +2098,12 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( VECTOR2I aPoint, int aPoly
 
 
 SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( const SEG& aSegment, int aPolygonIndex,
-                                                      VECTOR2I* aNearest ) const
+                                                      VECTOR2I* aNearest,
+                                                      bool aUseBBoxCaches ) const
 {
     // Check if the segment is fully-contained.  If so, its midpoint is a good-enough nearest point.
-    if( containsSingle( aSegment.A, aPolygonIndex, 1 ) &&
-        containsSingle( aSegment.B, aPolygonIndex, 1 ) )
+    if( containsSingle( aSegment.A, aPolygonIndex, 1, aUseBBoxCaches ) &&
+        containsSingle( aSegment.B, aPolygonIndex, 1, aUseBBoxCaches ) )
     {
         if( aNearest )
             *aNearest = ( aSegment.A + aSegment.B ) / 2;
@@ -1973,6 +2111,31 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( const SEG& aSegment, int a
         return 0;
     }
 
+    std::shared_ptr<const POLY_EDGE_INDEX> index = aUseBBoxCaches ? edgeIndex() : nullptr;
+
+    if( index )
+    {
+        const POLYGON& poly = m_polys[aPolygonIndex];
+        SEG::ecoord    minDistance = VECTOR2I::ECOORD_MAX;
+        VECTOR2I       nearest;
+
+        for( int ii = 0; ii < (int) poly.size() && minDistance > 0; ii++ )
+        {
+            SEG::ecoord currentDistance = index->SquaredDistance( aPolygonIndex, ii, poly[ii],
+                                                                  aSegment, &nearest );
+
+            if( currentDistance < minDistance )
+            {
+                if( aNearest )
+                    *aNearest = nearest;
+
+                minDistance = currentDistance;
+            }
+        }
+
+        return minDistance < 0 ? 0 : minDistance;
+    }
+
     CONST_SEGMENT_ITERATOR iterator = CIterateSegmentsWithHoles( aPolygonIndex );
     SEG::ecoord            minDistance = (*iterator).SquaredDistance( aSegment );
 
@@ -1997,7 +2160,8 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistanceToPolygon( const SEG& aSegment, int a
 }
 
 
-SEG::ecoord SHAPE_POLY_SET::SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest ) const
+SEG::ecoord SHAPE_POLY_SET::SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest,
+                                             bool aUseBBoxCaches ) const
 {
     SEG::ecoord currentDistance_sq;
     SEG::ecoord minDistance_sq = VECTOR2I::ECOORD_MAX;
@@ -2007,7 +2171,8 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest
     for( unsigned int polygonIdx = 0; polygonIdx < m_polys.size(); polygonIdx++ )
     {
         currentDistance_sq = SquaredDistanceToPolygon( aPoint, polygonIdx,
-                                                       aNearest ? &nearest : nullptr );
+                                                       aNearest ? &nearest : nullptr,
+                                                       aUseBBoxCaches );
 
         if( currentDistance_sq < minDistance_sq )
         {
@@ -2022,7 +2187,8 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistance( VECTOR2I aPoint, VECTOR2I* aNearest
 }
 
 
-SEG::ecoord SHAPE_POLY_SET::SquaredDistance( const SEG& aSegment, VECTOR2I* aNearest ) const
+SEG::ecoord SHAPE_POLY_SET::SquaredDistance( const SEG& aSegment, VECTOR2I* aNearest,
+                                             bool aUseBBoxCaches ) const
 {
     SEG::ecoord currentDistance_sq;
     SEG::ecoord minDistance_sq = VECTOR2I::ECOORD_MAX;
@@ -2032,7 +2198,8 @@ SEG::ecoord SHAPE_POLY_SET::SquaredDistance( const SEG& aSegment, VECTOR2I* aNea
     for( unsigned int polygonIdx = 0; polygonIdx < m_polys.size(); polygonIdx++ )
     {
         currentDistance_sq = SquaredDistanceToPolygon( aSegment, polygonIdx,
-                                                       aNearest ? &nearest : nullptr );
+                                                       aNearest ? &nearest : nullptr,
+                                                       aUseBBoxCaches );
 
         if( currentDistance_sq < minDistance_sq )
         {
@@ -2082,6 +2249,134 @@ SHAPE_POLY_SET SHAPE_POLY_SET::Fillet( int aRadius, int aErrorMax )
 }
 
 
+static SHAPE_LINE_CHAIN decimateContour( const SHAPE_LINE_CHAIN& aContour, int aTolerance )
+{
+    const std::vector<VECTOR2I>& pts = aContour.CPoints();
+    size_t                       n = pts.size();
+    SHAPE_LINE_CHAIN             result;
+
+    if( n < 3 )
+        return result;
+
+    // Split the closed contour at the vertex farthest from the first one, and simplify both
+    // halves as open polylines
+    size_t  far = 0;
+    int64_t farDist = -1;
+
+    for( size_t ii = 1; ii < n; ii++ )
+    {
+        int64_t d = ( pts[ii] - pts[0] ).SquaredEuclideanNorm();
+
+        if( d > farDist )
+        {
+            far = ii;
+            farDist = d;
+        }
+    }
+
+    std::vector<bool>                     keep( n + 1, false );
+    std::vector<std::pair<size_t, size_t>> stack = { { 0, far }, { far, n } };
+    const double                          tol2 = (double) aTolerance * aTolerance;
+
+    keep[0] = keep[far] = keep[n] = true;
+
+    auto pt = [&]( size_t ii ) -> const VECTOR2I&
+              {
+                  return pts[ii % n];
+              };
+
+    while( !stack.empty() )
+    {
+        size_t first = stack.back().first;
+        size_t last = stack.back().second;
+        stack.pop_back();
+
+        if( last - first < 2 )
+            continue;
+
+        const VECTOR2I& a = pt( first );
+        VECTOR2D        ab = pt( last ) - a;
+        double          len2 = ab.x * ab.x + ab.y * ab.y;
+        double          worst = -1.0;
+        size_t          worstIdx = first;
+
+        for( size_t ii = first + 1; ii < last; ii++ )
+        {
+            VECTOR2D ap = pt( ii ) - a;
+            double   dot = ab.x * ap.x + ab.y * ap.y;
+            double   d2;
+
+            if( len2 == 0.0 || dot <= 0.0 )
+            {
+                d2 = ap.x * ap.x + ap.y * ap.y;
+            }
+            else if( dot >= len2 )
+            {
+                VECTOR2D bp = ap - ab;
+                d2 = bp.x * bp.x + bp.y * bp.y;
+            }
+            else
+            {
+                double cross = ab.x * ap.y - ab.y * ap.x;
+                d2 = cross * cross / len2;
+            }
+
+            if( d2 > worst )
+            {
+                worst = d2;
+                worstIdx = ii;
+            }
+        }
+
+        if( worst > tol2 )
+        {
+            keep[worstIdx] = true;
+            stack.emplace_back( first, worstIdx );
+            stack.emplace_back( worstIdx, last );
+        }
+    }
+
+    for( size_t ii = 0; ii < n; ii++ )
+    {
+        if( keep[ii] )
+            result.Append( pts[ii] );
+    }
+
+    result.SetClosed( true );
+
+    if( result.PointCount() < 3 )
+        result.Clear();
+
+    return result;
+}
+
+
+SHAPE_POLY_SET SHAPE_POLY_SET::Decimate( int aTolerance ) const
+{
+    SHAPE_POLY_SET decimated;
+
+    for( const POLYGON& poly : m_polys )
+    {
+        SHAPE_LINE_CHAIN outline = decimateContour( poly[0], aTolerance );
+
+        if( outline.PointCount() == 0 )
+            continue;
+
+        decimated.AddOutline( outline );
+
+        for( size_t ii = 1; ii < poly.size(); ii++ )
+        {
+            SHAPE_LINE_CHAIN hole = decimateContour( poly[ii], aTolerance );
+
+            if( hole.PointCount() )
+                decimated.AddHole( hole );
+        }
+    }
+
+    return decimated;
+}
+
+
 SHAPE_POLY_SET::POLYGON SHAPE_POLY_SET::chamferFilletPolygon( CORNER_MODE aMode,
                                                               unsigned int aDistance,
                                                               int aIndex, int aErrorMax )
@@ -2259,6 +2554,9 @@ SHAPE_POLY_SET &SHAPE_POLY_SET::operator=( const SHAPE_POLY_SET& aOther )
 
     m_hash = aOther.m_hash;
     m_triangulationValid = aOther.m_triangulationValid;
+    m_triangulatedOutlineHashes = aOther.m_triangulatedOutlineHashes;
+    m_edgeIndexHash = aOther.m_edgeIndexHash;
+    m_edgeIndex = aOther.m_edgeIndex;
 
     return *this;
 }
@@ -2287,6 +2585,51 @@ bool SHAPE_POLY_SET::IsTriangulationUpToDate() const
 }
 
 
+// Below this many points it is quicker to triangulate on a single thread
+static const size_t PARALLEL_TRIANGULATION_THRESHOLD = 20000;
+
+
+/**
+ * Call \a aFunc for each index in [0, \a aCount), from several threads if \a aParallel.
+ *
+ * Off the main thread the caller is already one of the workers of a parallel pass (the zone
+ * filler or BOARD::CacheTriangulation()), so the loop runs serially rather than starting
+ * another set of threads per worker.
+ */
+template <typename Func>
+static void parallelFor( size_t aCount, bool aParallel, Func aFunc )
+{
+    size_t parallelThreadCount = 1;
+
+    if( aParallel && wxThread::IsMain() )
+        parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(), aCount );
+
+    if( parallelThreadCount <= 1 )
+    {
+        for( size_t ii = 0; ii < aCount; ++ii )
+            aFunc( ii );
+
+        return;
+    }
+
+    std::atomic<size_t>            next( 0 );
+    std::vector<std::future<void>> returns( parallelThreadCount );
+
+    for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+    {
+        returns[ii] = std::async( std::launch::async,
+                [&]()
+                {
+                    for( size_t i = next.fetch_add( 1 ); i < aCount; i = next.fetch_add( 1 ) )
+                        aFunc( i );
+                } );
+    }
+
+    for( std::future<void>& ret : returns )
+        ret.get();
+}
+
+
 static SHAPE_POLY_SET partitionPolyIntoRegularCellGrid( const SHAPE_POLY_SET& aPoly, int aSize )
 {
     BOX2I bb = aPoly.BBox();
@@ -2356,7 +2699,7 @@ static SHAPE_POLY_SET partitionPolyIntoRegularCellGrid( const SHAPE_POLY_SET& aP
 }
 
 
-void SHAPE_POLY_SET::CacheTriangulation( bool aPartition )
+void SHAPE_POLY_SET::CacheTriangulation( bool aPartition, const SHAPE_POLY_SET* aHintData )
 {
     bool recalculate = !m_hash.IsValid();
     MD5_HASH hash;
@@ -2409,25 +2752,180 @@ void SHAPE_POLY_SET::CacheTriangulation( bool aPartition )
                 return triangulationValid;
             };
 
-    m_triangulatedPolys.clear();
-    m_triangulationValid = true;
-
     if( aPartition )
     {
+        using TRI_POLYS = std::vector<std::unique_ptr<TRIANGULATED_POLYGON>>;
+
+        std::vector<TRI_POLYS> outlineTris( OutlineCount() );
+        std::vector<MD5_HASH>  outlineHashes( OutlineCount() );
+        std::vector<int>       todo;
+
+        for( int ii = 0; ii < OutlineCount(); ++ii )
+            outlineHashes[ii] = outlineChecksum( ii );
+
+        // Outlines which haven't changed since they were last triangulated (here, or in the
+        // previous version of this set) keep their triangles.  Returns the new outline index
+        // for each of the old ones, or -1.
+        auto matchOutlines =
+                [&]( const std::vector<MD5_HASH>& aOldHashes ) -> std::vector<int>
+                {
+                    std::vector<int> claimedBy( aOldHashes.size(), -1 );
+
+                    for( int ii = 0; ii < OutlineCount() && !aOldHashes.empty(); ++ii )
+                    {
+                        if( !outlineTris[ii].empty() )
+                            continue;
+
+                        // Try the same index first; fills usually keep their outline order
+                        for( size_t jj = 0; jj < aOldHashes.size(); ++jj )
+                        {
+                            size_t old = ( ii + jj ) % aOldHashes.size();
+
+                            if( claimedBy[old] < 0 && aOldHashes[old].IsValid()
+                                    && aOldHashes[old] == outlineHashes[ii] )
+                            {
+                                claimedBy[old] = ii;
+                                break;
+                            }
+                        }
+                    }
+
+                    return claimedBy;
+                };
+
+        auto claimedOutline =
+                []( const std::vector<int>& aClaimedBy, const TRIANGULATED_POLYGON& aTri ) -> int
+                {
+                    int src = aTri.GetSourceOutlineIndex();
+
+                    if( src < 0 || src >= (int) aClaimedBy.size() )
+                        return -1;
+
+                    return aClaimedBy[src];
+                };
+
+        std::vector<int> claimedBy = matchOutlines( m_triangulatedOutlineHashes );
+
+        for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : m_triangulatedPolys )
+        {
+            int outline = claimedOutline( claimedBy, *tri );
+
+            if( outline >= 0 )
+            {
+                tri->SetSourceOutlineIndex( outline );
+                outlineTris[outline].push_back( std::move( tri ) );
+            }
+        }
+
+        if( aHintData )
+        {
+            claimedBy = matchOutlines( aHintData->m_triangulatedOutlineHashes );
+
+            for( const std::unique_ptr<TRIANGULATED_POLYGON>& tri : aHintData->m_triangulatedPolys )
+            {
+                int outline = claimedOutline( claimedBy, *tri );
+
+                if( outline >= 0 )
+                {
+                    TRI_POLYS& dest = outlineTris[outline];
+
+                    dest.push_back( std::make_unique<TRIANGULATED_POLYGON>( *tri ) );
+                    dest.back()->SetSourceOutlineIndex( outline );
+                }
+            }
+        }
+
+        m_triangulatedPolys.clear();
+        m_triangulatedOutlineHashes.clear();
+
+        for( int ii = 0; ii < OutlineCount(); ++ii )
+        {
+            if( outlineTris[ii].empty() )
+                todo.push_back( ii );
+        }
+
+        // The remaining outlines are partitioned into regularly-sized grids (1cm in Pcbnew)
+        // and the cells are triangulated independently
+        std::vector<SHAPE_POLY_SET> partitions( todo.size() );
+        size_t                      pointCount = 0;
+
+        for( int ii : todo )
+            pointCount += Outline( ii ).PointCount();
+
+        bool parallel = pointCount >= PARALLEL_TRIANGULATION_THRESHOLD;
+
+        parallelFor( todo.size(), parallel,
+                [&]( size_t aIdx )
+                {
+                    SHAPE_POLY_SET flattened( COutline( todo[aIdx] ) );
+                    flattened.ClearArcs();
+                    partitions[aIdx] = partitionPolyIntoRegularCellGrid( flattened, 1e7 );
+                } );
+
+        struct CELL
+        {
+            int            outline;
+            SHAPE_POLY_SET poly;
+            TRI_POLYS      tris;
+            bool           valid = false;
+        };
+
+        std::deque<CELL> cells;
+
+        for( size_t ii = 0; ii < todo.size(); ++ii )
+        {
+            for( int jj = 0; jj < partitions[ii].OutlineCount(); ++jj )
+            {
+                cells.emplace_back();
+                cells.back().outline = todo[ii];
+                cells.back().poly.AddOutline( partitions[ii].COutline( jj ) );
+            }
+        }
+
+        partitions.clear();
+
+        parallelFor( cells.size(), parallel,
+                [&]( size_t aIdx )
+                {
+                    CELL& cell = cells[aIdx];
+                    cell.valid = triangulate( cell.poly, cell.outline, cell.tris );
+                } );
+
+        std::vector<bool> outlineValid( OutlineCount(), true );
+
+        for( CELL& cell : cells )
+        {
+            outlineValid[cell.outline] = outlineValid[cell.outline] && cell.valid;
+
+            for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : cell.tris )
+            {
+                if( tri->GetTriangleCount() )
+                    outlineTris[cell.outline].push_back( std::move( tri ) );
+            }
+        }
+
+        m_triangulationValid = true;
+        m_triangulatedOutlineHashes.resize( OutlineCount() );
+
         for( int ii = 0; ii < OutlineCount(); ++ii )
         {
-            // This partitions into regularly-sized grids (1cm in Pcbnew)
-            SHAPE_POLY_SET flattened( Outline( ii ) );
-            flattened.ClearArcs();
-            SHAPE_POLY_SET partitions = partitionPolyIntoRegularCellGrid( flattened, 1e7 );
+            for( std::unique_ptr<TRIANGULATED_POLYGON>& tri : outlineTris[ii] )
+                m_triangulatedPolys.push_back( std::move( tri ) );
 
-            m_triangulationValid &= triangulate( partitions, ii, m_triangulatedPolys );
+            // Only remember the outlines that are worth reusing
+            if( outlineValid[ii] )
+                m_triangulatedOutlineHashes[ii] = outlineHashes[ii];
+            else
+                m_triangulationValid = false;
         }
     }
     else
     {
         SHAPE_POLY_SET tmpSet( *this );
 
+        m_triangulatedPolys.clear();
+        m_triangulatedOutlineHashes.clear();
+
         if( tmpSet.HasHoles() )
             tmpSet.Fracture( PM_FAST );
 
@@ -2439,6 +2937,25 @@ void SHAPE_POLY_SET::CacheTriangulation( bool aPartition )
 }
 
 
+MD5_HASH SHAPE_POLY_SET::outlineChecksum( int aOutline ) const
+{
+    MD5_HASH                hash;
+    const SHAPE_LINE_CHAIN& lc = COutline( aOutline );
+
+    hash.Hash( lc.PointCount() );
+
+    for( int i = 0; i < lc.PointCount(); i++ )
+    {
+        hash.Hash( lc.CPoint( i ).x );
+        hash.Hash( lc.CPoint( i ).y );
+    }
+
+    hash.Finalize();
+
+    return hash;
+}
+
+
 MD5_HASH SHAPE_POLY_SET::checksum() const
 {
     MD5_HASH hash;
@@ -2583,6 +3100,27 @@ SHAPE_POLY_SET::TRIANGULATED_POLYGON::~TRIANGULATED_POLYGON()
 }
 
 
+void SHAPE_POLY_SET::TRIANGULATED_POLYGON::Rotate( const EDA_ANGLE& aAngle,
+                                                   const VECTOR2I& aCenter )
+{
+    for( VECTOR2I& vertex : m_vertices )
+        RotatePoint( vertex, aCenter, aAngle );
+}
+
+
+void SHAPE_POLY_SET::TRIANGULATED_POLYGON::Mirror( bool aX, bool aY, const VECTOR2I& aRef )
+{
+    for( VECTOR2I& vertex : m_vertices )
+    {
+        if( aX )
+            vertex.x = -vertex.x + 2 * aRef.x;
+
+        if( aY )
+            vertex.y = -vertex.y + 2 * aRef.y;
+    }
+}
+
+
 const SHAPE_POLY_SET
 SHAPE_POLY_SET::BuildPolysetFromOrientedPaths( const std::vector<SHAPE_LINE_CHAIN>& aPaths,
                                                bool aReverseOrientation, bool aEvenOdd )
@@ -22,6 +22,7 @@
 
 #include <footprint_info_impl.h>
 
+#include <core/kicad_algo.h>
 #include <footprint.h>
 #include <footprint_info.h>
 #include <fp_lib_table.h>
@@ -36,9 +37,15 @@
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
 
+#include <set>
 #include <thread>
 
 
+// First line of the footprint info cache file.  Bump it whenever the file layout changes so
+// older caches are discarded instead of misread.
+static const wxChar FP_INFO_CACHE_HEADER[] = wxT( "fp-info-cache 2" );
+
+
 void FOOTPRINT_INFO_IMPL::load()
 {
     FP_LIB_TABLE* fptable = m_owner->GetTable();
@@ -118,16 +125,80 @@ void FOOTPRINT_LIST_IMPL::loader_job()
 bool FOOTPRINT_LIST_IMPL::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxString* aNickname,
                                               PROGRESS_REPORTER* aProgressReporter )
 {
-    long long int generatedTimestamp = aTable->GenerateTimestamp( aNickname );
+    std::vector<wxString> nicknames;
+
+    if( aNickname )
+        nicknames.push_back( *aNickname );
+    else
+        nicknames = aTable->GetLogicalLibs();
+
+    // Same sum as aTable->GenerateTimestamp( aNickname ), but the library timestamps are kept
+    // so that only the libraries which changed are read again.
+    std::map<wxString, long long> libTimestamps;
+    long long                     generatedTimestamp = 0;
+
+    for( const wxString& nickname : nicknames )
+    {
+        long long timestamp = aTable->GenerateTimestamp( &nickname );
+
+        libTimestamps[nickname] = timestamp;
+        generatedTimestamp += timestamp;
+    }
 
     if( generatedTimestamp == m_list_timestamp )
         return true;
 
+    std::set<wxString> listedLibs;
+
+    for( const std::unique_ptr<FOOTPRINT_INFO>& fpinfo : m_list )
+        listedLibs.insert( fpinfo->GetLibNickname() );
+
+    m_stale_libs.clear();
+
+    for( const wxString& nickname : nicknames )
+    {
+        auto it = m_lib_timestamps.find( nickname );
+
+        // A library with nothing in the list is read again in case the list was cleared
+        if( it == m_lib_timestamps.end() || it->second != libTimestamps[nickname]
+                || !listedLibs.count( nickname ) )
+        {
+            m_stale_libs.push_back( nickname );
+        }
+    }
+
+    std::set<wxString> staleLibs( m_stale_libs.begin(), m_stale_libs.end() );
+
+    // Drop the footprints of the libraries read again and of the libraries not requested
+    alg::delete_if( m_list,
+                    [&]( const std::unique_ptr<FOOTPRINT_INFO>& fpinfo )
+                    {
+                        wxString nickname = fpinfo->GetLibNickname();
+
+                        return staleLibs.count( nickname ) || !libTimestamps.count( nickname );
+                    } );
+
+    for( auto it = m_lib_timestamps.begin(); it != m_lib_timestamps.end(); )
+    {
+        if( staleLibs.count( it->first ) || !libTimestamps.count( it->first ) )
+            it = m_lib_timestamps.erase( it );
+        else
+            ++it;
+    }
+
+    m_errors.clear();
+
+    if( m_stale_libs.empty() )
+    {
+        m_list_timestamp = generatedTimestamp;
+        return true;
+    }
+
     m_progress_reporter = aProgressReporter;
 
     if( m_progress_reporter )
     {
-        m_progress_reporter->SetMaxProgress( m_queue_in.size() );
+        m_progress_reporter->SetMaxProgress( m_stale_libs.size() );
         m_progress_reporter->Report( _( "Fetching footprint libraries..." ) );
     }
 
@@ -136,7 +207,7 @@ bool FOOTPRINT_LIST_IMPL::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxStri
     FOOTPRINT_ASYNC_LOADER loader;
 
     loader.SetList( this );
-    loader.Start( aTable, aNickname );
+    loader.Start( aTable );
 
     while( !m_cancelled && (int)m_count_finished.load() < m_loader->m_total_libs )
     {
@@ -166,10 +237,17 @@ bool FOOTPRINT_LIST_IMPL::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxStri
     }
 
     if( m_cancelled )
+    {
         m_list_timestamp = 0;       // God knows what we got before we were canceled
+    }
     else
+    {
         m_list_timestamp = generatedTimestamp;
 
+        for( const wxString& nickname : m_stale_libs )
+            m_lib_timestamps[nickname] = libTimestamps[nickname];
+    }
+
     return m_errors.empty();
 }
 
@@ -180,10 +258,10 @@ void FOOTPRINT_LIST_IMPL::startWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     m_loader = aLoader;
     m_lib_table = aTable;
 
-    // Clear data before reading files
+    // Clear data before reading files.  The footprints of the libraries which are not read
+    // again were kept in m_list by ReadFootprintFiles().
     m_count_finished.store( 0 );
     m_errors.clear();
-    m_list.clear();
     m_threads.clear();
     m_queue_in.clear();
     m_queue_out.clear();
@@ -194,7 +272,7 @@ void FOOTPRINT_LIST_IMPL::startWorkers( FP_LIB_TABLE* aTable, wxString const* aN
     }
     else
     {
-        for( auto const& nickname : aTable->GetLogicalLibs() )
+        for( const wxString& nickname : m_stale_libs )
             m_queue_in.push( nickname );
     }
 
@@ -375,8 +453,18 @@ void FOOTPRINT_LIST_IMPL::WriteCacheToFile( const wxString& aFilePath )
         return;
     }
 
+    txtStream << FP_INFO_CACHE_HEADER << endl;
     txtStream << wxString::Format( wxT( "%lld" ), m_list_timestamp ) << endl;
 
+    // The timestamp of each library, so a change in one library only invalidates that library
+    txtStream << wxString::Format( wxT( "%u" ), (unsigned) m_lib_timestamps.size() ) << endl;
+
+    for( const std::pair<const wxString, long long>& lib : m_lib_timestamps )
+    {
+        txtStream << lib.first << endl;
+        txtStream << wxString::Format( wxT( "%lld" ), lib.second ) << endl;
+    }
+
     for( std::unique_ptr<FOOTPRINT_INFO>& fpinfo : m_list )
     {
         txtStream << fpinfo->GetLibNickname() << endl;
@@ -405,13 +493,28 @@ void FOOTPRINT_LIST_IMPL::ReadCacheFromFile( const wxString& aFilePath )
     wxTextFile cacheFile( aFilePath );
 
     m_list_timestamp = 0;
+    m_lib_timestamps.clear();
     m_list.clear();
 
     try
     {
-        if( cacheFile.Exists() && cacheFile.Open() )
+        // Caches written in an older layout are simply ignored
+        if( cacheFile.Exists() && cacheFile.Open()
+                && cacheFile.GetFirstLine() == FP_INFO_CACHE_HEADER )
         {
-            cacheFile.GetFirstLine().ToLongLong( &m_list_timestamp );
+            cacheFile.GetNextLine().ToLongLong( &m_list_timestamp );
+
+            unsigned long libCount = 0;
+            cacheFile.GetNextLine().ToULong( &libCount );
+
+            for( unsigned long ii = 0; ii < libCount; ++ii )
+            {
+                wxString  libNickname = cacheFile.GetNextLine();
+                long long libTimestamp = 0;
+
+                cacheFile.GetNextLine().ToLongLong( &libTimestamp );
+                m_lib_timestamps[libNickname] = libTimestamp;
+            }
 
             while( cacheFile.GetCurrentLine() + 6 < cacheFile.GetLineCount() )
             {
@@ -435,11 +538,15 @@ void FOOTPRINT_LIST_IMPL::ReadCacheFromFile( const wxString& aFilePath )
     {
         // whatever went wrong, invalidate the cache
         m_list_timestamp = 0;
+        m_lib_timestamps.clear();
     }
 
     // Sanity check: an empty list is very unlikely to be correct.
     if( m_list.size() == 0 )
+    {
         m_list_timestamp = 0;
+        m_lib_timestamps.clear();
+    }
 
     if( cacheFile.IsOpened() )
         cacheFile.Close();
@@ -22,6 +22,7 @@
 
 #include <atomic>
 #include <functional>
+#include <map>
 #include <memory>
 #include <thread>
 #include <vector>
@@ -119,6 +120,13 @@ private:
     SYNC_QUEUE<wxString>     m_queue_out;
     std::atomic_size_t       m_count_finished;
     long long                m_list_timestamp;
+
+    /// Timestamp of each library when its footprints were last read into the list.
+    std::map<wxString, long long> m_lib_timestamps;
+
+    /// Libraries which changed since they were last read, queued by startWorkers().
+    std::vector<wxString>         m_stale_libs;
+
     PROGRESS_REPORTER*       m_progress_reporter;
     std::atomic_bool         m_cancelled;
     std::mutex               m_join;
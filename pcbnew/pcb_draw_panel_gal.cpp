@@ -380,39 +380,45 @@ void PCB_DRAW_PANEL_GAL::SetTopLayer( PCB_LAYER_ID aLayer )
 
 
 void PCB_DRAW_PANEL_GAL::SyncLayersVisibility( const BOARD* aBoard )
+{
+    SyncLayersVisibility( m_view, aBoard );
+}
+
+
+void PCB_DRAW_PANEL_GAL::SyncLayersVisibility( KIGFX::VIEW* aView, const BOARD* aBoard )
 {
     // Load layer & elements visibility settings
     for( int i = 0; i < PCB_LAYER_ID_COUNT; ++i )
-        m_view->SetLayerVisible( i, aBoard->IsLayerVisible( PCB_LAYER_ID( i ) ) );
+        aView->SetLayerVisible( i, aBoard->IsLayerVisible( PCB_LAYER_ID( i ) ) );
 
     for( GAL_LAYER_ID i = GAL_LAYER_ID_START; i < GAL_LAYER_ID_END; ++i )
-        m_view->SetLayerVisible( i, aBoard->IsElementVisible( i ) );
+        aView->SetLayerVisible( i, aBoard->IsElementVisible( i ) );
 
     // Via layers controlled by dependencies
-    m_view->SetLayerVisible( LAYER_VIA_MICROVIA, true );
-    m_view->SetLayerVisible( LAYER_VIA_BBLIND, true );
-    m_view->SetLayerVisible( LAYER_VIA_THROUGH, true );
+    aView->SetLayerVisible( LAYER_VIA_MICROVIA, true );
+    aView->SetLayerVisible( LAYER_VIA_BBLIND, true );
+    aView->SetLayerVisible( LAYER_VIA_THROUGH, true );
 
     // Pad layers controlled by dependencies
-    m_view->SetLayerVisible( LAYER_PAD_FR, true );
-    m_view->SetLayerVisible( LAYER_PAD_BK, true );
+    aView->SetLayerVisible( LAYER_PAD_FR, true );
+    aView->SetLayerVisible( LAYER_PAD_BK, true );
 
     // Always enable netname layers, as their visibility is controlled by layer dependencies
     for( int i = NETNAMES_LAYER_ID_START; i < NETNAMES_LAYER_ID_END; ++i )
-        m_view->SetLayerVisible( i, true );
+        aView->SetLayerVisible( i, true );
 
     for( int i = LAYER_ZONE_START; i < LAYER_ZONE_END; i++ )
-        m_view->SetLayerVisible( i, true );
+        aView->SetLayerVisible( i, true );
 
     // Enable some layers that are GAL specific
-    m_view->SetLayerVisible( LAYER_PAD_PLATEDHOLES, true );
-    m_view->SetLayerVisible( LAYER_PAD_HOLEWALLS, true );
-    m_view->SetLayerVisible( LAYER_VIA_HOLES, true );
-    m_view->SetLayerVisible( LAYER_VIA_HOLEWALLS, true );
-    m_view->SetLayerVisible( LAYER_GP_OVERLAY, true );
-    m_view->SetLayerVisible( LAYER_SELECT_OVERLAY, true );
-    m_view->SetLayerVisible( LAYER_RATSNEST, true );
-    m_view->SetLayerVisible( LAYER_MARKER_SHADOWS, true );
+    aView->SetLayerVisible( LAYER_PAD_PLATEDHOLES, true );
+    aView->SetLayerVisible( LAYER_PAD_HOLEWALLS, true );
+    aView->SetLayerVisible( LAYER_VIA_HOLES, true );
+    aView->SetLayerVisible( LAYER_VIA_HOLEWALLS, true );
+    aView->SetLayerVisible( LAYER_GP_OVERLAY, true );
+    aView->SetLayerVisible( LAYER_SELECT_OVERLAY, true );
+    aView->SetLayerVisible( LAYER_RATSNEST, true );
+    aView->SetLayerVisible( LAYER_MARKER_SHADOWS, true );
 }
 
 
@@ -493,13 +499,19 @@ void PCB_DRAW_PANEL_GAL::OnShow()
 
 
 void PCB_DRAW_PANEL_GAL::setDefaultLayerOrder()
+{
+    SetDefaultLayerOrder( m_view );
+}
+
+
+void PCB_DRAW_PANEL_GAL::SetDefaultLayerOrder( KIGFX::VIEW* aView )
 {
     for( int i = 0; (unsigned) i < sizeof( GAL_LAYER_ORDER ) / sizeof( int ); ++i )
     {
         int layer = GAL_LAYER_ORDER[i];
         wxASSERT( layer < KIGFX::VIEW::VIEW_MAX_LAYERS );
 
-        m_view->SetLayerOrder( layer, i );
+        aView->SetLayerOrder( layer, i );
     }
 }
 
@@ -530,12 +542,18 @@ BOX2I PCB_DRAW_PANEL_GAL::GetDefaultViewBBox() const
 
 
 void PCB_DRAW_PANEL_GAL::setDefaultLayerDeps()
+{
+    SetDefaultLayerDeps( m_view, m_backend == GAL_TYPE_OPENGL );
+}
+
+
+void PCB_DRAW_PANEL_GAL::SetDefaultLayerDeps( KIGFX::VIEW* aView, bool aCached )
 {
     // caching makes no sense for Cairo and other software renderers
-    auto target = m_backend == GAL_TYPE_OPENGL ? KIGFX::TARGET_CACHED : KIGFX::TARGET_NONCACHED;
+    auto target = aCached ? KIGFX::TARGET_CACHED : KIGFX::TARGET_NONCACHED;
 
     for( int i = 0; i < KIGFX::VIEW::VIEW_MAX_LAYERS; i++ )
-        m_view->SetLayerTarget( i, target );
+        aView->SetLayerTarget( i, target );
 
     for( int i = 0; (unsigned) i < sizeof( GAL_LAYER_ORDER ) / sizeof( int ); ++i )
     {
@@ -545,73 +563,73 @@ void PCB_DRAW_PANEL_GAL::setDefaultLayerDeps()
         // Set layer display dependencies & targets
         if( IsCopperLayer( layer ) )
         {
-            m_view->SetRequired( ZONE_LAYER_FOR( layer ), layer );
-            m_view->SetRequired( GetNetnameLayer( layer ), layer );
+            aView->SetRequired( ZONE_LAYER_FOR( layer ), layer );
+            aView->SetRequired( GetNetnameLayer( layer ), layer );
         }
         else if( IsNonCopperLayer( layer ) )
         {
-            m_view->SetRequired( ZONE_LAYER_FOR( layer ), layer );
+            aView->SetRequired( ZONE_LAYER_FOR( layer ), layer );
         }
         else if( IsNetnameLayer( layer ) )
         {
-            m_view->SetLayerDisplayOnly( layer );
+            aView->SetLayerDisplayOnly( layer );
         }
     }
 
-    m_view->SetLayerTarget( LAYER_ANCHOR, KIGFX::TARGET_NONCACHED );
-    m_view->SetLayerDisplayOnly( LAYER_ANCHOR );
+    aView->SetLayerTarget( LAYER_ANCHOR, KIGFX::TARGET_NONCACHED );
+    aView->SetLayerDisplayOnly( LAYER_ANCHOR );
 
-    m_view->SetLayerTarget( LAYER_LOCKED_ITEM_SHADOW, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_LOCKED_ITEM_SHADOW );
+    aView->SetLayerTarget( LAYER_LOCKED_ITEM_SHADOW, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_LOCKED_ITEM_SHADOW );
 
     // Some more required layers settings
-    m_view->SetRequired( LAYER_VIA_NETNAMES, LAYER_VIAS );
-    m_view->SetRequired( LAYER_PAD_NETNAMES, LAYER_PADS );
+    aView->SetRequired( LAYER_VIA_NETNAMES, LAYER_VIAS );
+    aView->SetRequired( LAYER_PAD_NETNAMES, LAYER_PADS );
 
     // Holes can be independent of their host objects (cf: printing drill marks)
-    m_view->SetRequired( LAYER_VIA_HOLES, LAYER_VIAS );
-    m_view->SetRequired( LAYER_VIA_HOLEWALLS, LAYER_VIAS );
-    m_view->SetRequired( LAYER_PAD_PLATEDHOLES, LAYER_PADS );
-    m_view->SetRequired( LAYER_PAD_HOLEWALLS, LAYER_PADS );
-    m_view->SetRequired( LAYER_NON_PLATEDHOLES, LAYER_PADS );
+    aView->SetRequired( LAYER_VIA_HOLES, LAYER_VIAS );
+    aView->SetRequired( LAYER_VIA_HOLEWALLS, LAYER_VIAS );
+    aView->SetRequired( LAYER_PAD_PLATEDHOLES, LAYER_PADS );
+    aView->SetRequired( LAYER_PAD_HOLEWALLS, LAYER_PADS );
+    aView->SetRequired( LAYER_NON_PLATEDHOLES, LAYER_PADS );
 
     // Via visibility
-    m_view->SetRequired( LAYER_VIA_MICROVIA, LAYER_VIAS );
-    m_view->SetRequired( LAYER_VIA_BBLIND, LAYER_VIAS );
-    m_view->SetRequired( LAYER_VIA_THROUGH, LAYER_VIAS );
+    aView->SetRequired( LAYER_VIA_MICROVIA, LAYER_VIAS );
+    aView->SetRequired( LAYER_VIA_BBLIND, LAYER_VIAS );
+    aView->SetRequired( LAYER_VIA_THROUGH, LAYER_VIAS );
 
     // Pad visibility
-    m_view->SetRequired( LAYER_PADS_TH, LAYER_PADS );
-    m_view->SetRequired( LAYER_PAD_FR, LAYER_PADS );
-    m_view->SetRequired( LAYER_PAD_BK, LAYER_PADS );
+    aView->SetRequired( LAYER_PADS_TH, LAYER_PADS );
+    aView->SetRequired( LAYER_PAD_FR, LAYER_PADS );
+    aView->SetRequired( LAYER_PAD_BK, LAYER_PADS );
 
     // Front footprints
-    m_view->SetRequired( LAYER_PAD_FR, F_Cu );
-    m_view->SetRequired( LAYER_PAD_FR_NETNAMES, LAYER_PAD_FR );
+    aView->SetRequired( LAYER_PAD_FR, F_Cu );
+    aView->SetRequired( LAYER_PAD_FR_NETNAMES, LAYER_PAD_FR );
 
     // Back footprints
-    m_view->SetRequired( LAYER_PAD_BK, B_Cu );
-    m_view->SetRequired( LAYER_PAD_BK_NETNAMES, LAYER_PAD_BK );
-
-    m_view->SetLayerTarget( LAYER_SELECT_OVERLAY, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_SELECT_OVERLAY ) ;
-    m_view->SetLayerTarget( LAYER_GP_OVERLAY, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_GP_OVERLAY ) ;
-    m_view->SetLayerTarget( LAYER_RATSNEST, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_RATSNEST );
-
-    m_view->SetLayerTarget( LAYER_DRC_ERROR, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_DRC_ERROR );
-    m_view->SetLayerTarget( LAYER_DRC_WARNING, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_DRC_WARNING );
-    m_view->SetLayerTarget( LAYER_DRC_EXCLUSION, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_DRC_EXCLUSION );
-    m_view->SetLayerTarget( LAYER_MARKER_SHADOWS, KIGFX::TARGET_OVERLAY );
-    m_view->SetLayerDisplayOnly( LAYER_MARKER_SHADOWS );
-
-    m_view->SetLayerTarget( LAYER_DRAWINGSHEET, KIGFX::TARGET_NONCACHED );
-    m_view->SetLayerDisplayOnly( LAYER_DRAWINGSHEET ) ;
-    m_view->SetLayerDisplayOnly( LAYER_GRID );
+    aView->SetRequired( LAYER_PAD_BK, B_Cu );
+    aView->SetRequired( LAYER_PAD_BK_NETNAMES, LAYER_PAD_BK );
+
+    aView->SetLayerTarget( LAYER_SELECT_OVERLAY, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_SELECT_OVERLAY ) ;
+    aView->SetLayerTarget( LAYER_GP_OVERLAY, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_GP_OVERLAY ) ;
+    aView->SetLayerTarget( LAYER_RATSNEST, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_RATSNEST );
+
+    aView->SetLayerTarget( LAYER_DRC_ERROR, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_DRC_ERROR );
+    aView->SetLayerTarget( LAYER_DRC_WARNING, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_DRC_WARNING );
+    aView->SetLayerTarget( LAYER_DRC_EXCLUSION, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_DRC_EXCLUSION );
+    aView->SetLayerTarget( LAYER_MARKER_SHADOWS, KIGFX::TARGET_OVERLAY );
+    aView->SetLayerDisplayOnly( LAYER_MARKER_SHADOWS );
+
+    aView->SetLayerTarget( LAYER_DRAWINGSHEET, KIGFX::TARGET_NONCACHED );
+    aView->SetLayerDisplayOnly( LAYER_DRAWINGSHEET ) ;
+    aView->SetLayerDisplayOnly( LAYER_GRID );
 }
 
 
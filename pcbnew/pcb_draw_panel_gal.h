@@ -92,6 +92,24 @@ public:
      */
     void SyncLayersVisibility( const BOARD* aBoard );
 
+    /**
+     * Update "visibility" property of each layer of \a aView from \a aBoard.
+     *
+     * This and the two helpers below are also used to set up PCB views drawn without a panel
+     * (e.g. into an offscreen image) the way the board editor does.
+     */
+    static void SyncLayersVisibility( KIGFX::VIEW* aView, const BOARD* aBoard );
+
+    ///< Set the initial layer order of \a aView.
+    static void SetDefaultLayerOrder( KIGFX::VIEW* aView );
+
+    /**
+     * Set rendering targets & dependencies for the layers of \a aView.
+     *
+     * @param aCached is true for the GALs caching item geometry (OpenGL).
+     */
+    static void SetDefaultLayerDeps( KIGFX::VIEW* aView, bool aCached );
+
     ///< @copydoc EDA_DRAW_PANEL_GAL::GetMsgPanelInfo()
     void GetMsgPanelInfo( EDA_DRAW_FRAME* aFrame, std::vector<MSG_PANEL_ITEM>& aList ) override;
 
@@ -559,6 +559,37 @@ bool PCB_PAINTER::Draw( const VIEW_ITEM* aItem, int aLayer )
 }
 
 
+bool PCB_PAINTER::HasLodProxy( const VIEW_ITEM* aItem, int aLayer )
+{
+    // Below this, the full fill is cheap enough to draw at any zoom
+    const int LOD_MIN_POINT_COUNT = 2000;
+
+    const BOARD_ITEM* item = dynamic_cast<const BOARD_ITEM*>( aItem );
+
+    // Only copper planes have enough geometry to be worth it
+    if( !item || item->Type() != PCB_ZONE_T || !IsZoneLayer( aLayer ) )
+        return false;
+
+    if( m_pcbSettings.m_ZoneDisplayMode != ZONE_DISPLAY_MODE::SHOW_FILLED )
+        return false;
+
+    const ZONE*  zone = static_cast<const ZONE*>( item );
+    PCB_LAYER_ID layer = static_cast<PCB_LAYER_ID>( aLayer - LAYER_ZONE_START );
+
+    return zone->IsOnLayer( layer ) && zone->HasFilledPolysForLayer( layer )
+            && zone->GetFilledPolysList( layer )->FullPointCount() >= LOD_MIN_POINT_COUNT;
+}
+
+
+void PCB_PAINTER::DrawLodProxy( const VIEW_ITEM* aItem, int aLayer, int aTolerance )
+{
+    const BOARD_ITEM* item = dynamic_cast<const BOARD_ITEM*>( aItem );
+
+    if( item && item->Type() == PCB_ZONE_T )
+        draw( static_cast<const ZONE*>( item ), aLayer, aTolerance );
+}
+
+
 void PCB_PAINTER::draw( const PCB_TRACK* aTrack, int aLayer )
 {
     VECTOR2I start( aTrack->GetStart() );
@@ -2038,7 +2069,7 @@ void PCB_PAINTER::draw( const PCB_GROUP* aGroup, int aLayer )
 }
 
 
-void PCB_PAINTER::draw( const ZONE* aZone, int aLayer )
+void PCB_PAINTER::draw( const ZONE* aZone, int aLayer, int aFillTolerance )
 {
     /*
      * aLayer will be the virtual zone layer (LAYER_ZONE_START, ... in GAL_LAYER_ID)
@@ -2113,6 +2144,24 @@ void PCB_PAINTER::draw( const ZONE* aZone, int aLayer )
             m_gal->SetIsStroke( true );
         }
 
+        if( aFillTolerance > 0 )
+        {
+            // Simplified version of the fill, for when zoomed out (see DrawLodProxy())
+            SHAPE_POLY_SET proxy = polySet->Decimate( aFillTolerance );
+
+            if( m_gal->IsOpenGlEngine() )
+                proxy.CacheTriangulation();
+
+            // The decimated outlines may self-intersect: keep the full fill if they can't
+            // be triangulated
+            if( proxy.OutlineCount() && ( proxy.IsTriangulationUpToDate()
+                                          || !m_gal->IsOpenGlEngine() ) )
+            {
+                m_gal->DrawPolygon( proxy );
+                return;
+            }
+        }
+
         m_gal->DrawPolygon( *polySet, displayMode == ZONE_DISPLAY_MODE::SHOW_TRIANGULATION );
     }
 }
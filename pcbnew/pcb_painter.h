@@ -163,6 +163,12 @@ public:
     /// @copydoc PAINTER::Draw()
     virtual bool Draw( const VIEW_ITEM* aItem, int aLayer ) override;
 
+    /// @copydoc PAINTER::HasLodProxy()
+    virtual bool HasLodProxy( const VIEW_ITEM* aItem, int aLayer ) override;
+
+    /// @copydoc PAINTER::DrawLodProxy()
+    virtual void DrawLodProxy( const VIEW_ITEM* aItem, int aLayer, int aTolerance ) override;
+
 protected:
     // Drawing functions for various types of PCB-specific items
     void draw( const PCB_TRACK* aTrack, int aLayer );
@@ -176,7 +182,7 @@ protected:
     void draw( const FP_TEXTBOX* aText, int aLayer );
     void draw( const FOOTPRINT* aFootprint, int aLayer );
     void draw( const PCB_GROUP* aGroup, int aLayer );
-    void draw( const ZONE* aZone, int aLayer );
+    void draw( const ZONE* aZone, int aLayer, int aFillTolerance = 0 );
     void draw( const PCB_DIMENSION_BASE* aDimension, int aLayer );
     void draw( const PCB_TARGET* aTarget );
     void draw( const PCB_MARKER* aMarker, int aLayer );
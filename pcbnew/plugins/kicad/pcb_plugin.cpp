@@ -22,6 +22,10 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <atomic>
+#include <future>
+#include <thread>
+
 #include <advanced_config.h>
 #include <base_units.h>
 #include <board.h>
@@ -53,6 +57,7 @@
 #include <wildcards_and_files_ext.h>
 #include <wx/dir.h>
 #include <wx/log.h>
+#include <wx/thread.h>
 #include <wx_filename.h>
 #include <zone.h>
 #include <zones.h>
@@ -72,18 +77,42 @@ class FP_CACHE_ITEM
 {
     WX_FILENAME                m_filename;
     std::unique_ptr<FOOTPRINT> m_footprint;
+    long long                  m_modTime;     // Timestamp of the file when it was parsed
+    wxString                   m_error;       // Why the file failed to parse, if it did
 
 public:
     FP_CACHE_ITEM( FOOTPRINT* aFootprint, const WX_FILENAME& aFileName );
 
     const WX_FILENAME& GetFileName() const { return m_filename; }
+
+    /**
+     * @return the footprint, or nullptr if its file has not been parsed yet.
+     */
     const FOOTPRINT* GetFootprint()  const { return m_footprint.get(); }
+
+    /**
+     * Set the footprint parsed from the item's file and record the file timestamp.
+     */
+    void SetFootprint( FOOTPRINT* aFootprint )
+    {
+        m_footprint.reset( aFootprint );
+        m_modTime = m_filename.GetTimestamp();
+    }
+
+    long long GetModTime() const { return m_modTime; }
+
+    /**
+     * @return the error met parsing the item's file, or an empty string.
+     */
+    const wxString& GetError() const { return m_error; }
+    void SetError( const wxString& aError ) { m_error = aError; }
 };
 
 
 FP_CACHE_ITEM::FP_CACHE_ITEM( FOOTPRINT* aFootprint, const WX_FILENAME& aFileName ) :
         m_filename( aFileName ),
-        m_footprint( aFootprint )
+        m_footprint( aFootprint ),
+        m_modTime( 0 )
 { }
 
 
@@ -124,8 +153,33 @@ public:
      */
     void Save( FOOTPRINT* aFootprint = nullptr );
 
+    /**
+     * Index the footprint files of the library without parsing them.
+     *
+     * Footprints are parsed on demand by GetFootprint(), or all at once by LoadAll().  When
+     * the cache is reloaded, footprints whose files did not change since they were parsed are
+     * kept.
+     */
     void Load();
 
+    /**
+     * Parse all the footprints which have not been parsed yet, using several threads when
+     * called from the main thread.
+     *
+     * Footprints whose files fail to parse stay in the cache with their error (until the
+     * library is reloaded), and the errors of all of them are thrown together once all files
+     * have been read.
+     */
+    void LoadAll();
+
+    /**
+     * Return the footprint \a aFootprintName, parsing its file first if needed.
+     *
+     * @return the footprint or nullptr if the library has no such footprint.
+     * @throw IO_ERROR if the footprint file fails, or previously failed, to parse.
+     */
+    const FOOTPRINT* GetFootprint( const wxString& aFootprintName );
+
     void Remove( const wxString& aFootprintName );
 
     /**
@@ -152,6 +206,13 @@ public:
      * @return true if \a aPath is the same as the cache path.
      */
     bool IsPath( const wxString& aPath ) const;
+
+private:
+    /**
+     * Parse a single footprint file.  Safe to call from worker threads as long as the caller
+     * holds a #LOCALE_IO.
+     */
+    static FOOTPRINT* parseFootprint( const WX_FILENAME& aFileName );
 };
 
 
@@ -188,6 +249,13 @@ void FP_CACHE::Save( FOOTPRINT* aFootprint )
 
         WX_FILENAME fn = it->second->GetFileName();
 
+        // A footprint which was never parsed is still the same as its file
+        if( !it->second->GetFootprint() )
+        {
+            m_cache_timestamp += fn.GetTimestamp();
+            continue;
+        }
+
         wxString tempFileName =
 #ifdef USE_TMP_FILE
         wxFileName::CreateTempFileName( fn.GetPath() );
@@ -253,40 +321,146 @@ void FP_CACHE::Load()
     // the filename thereafter.
     WX_FILENAME fn( m_lib_raw_path, wxT( "dummyName" ) );
 
+    FOOTPRINT_MAP previous;
+    previous.swap( m_footprints );
+
     if( dir.GetFirst( &fullName, fileSpec ) )
     {
-        wxString cacheError;
-
         do
         {
             fn.SetFullName( fullName );
 
-            // Queue I/O errors so only files that fail to parse don't get loaded.
-            try
-            {
-                FILE_LINE_READER reader( fn.GetFullPath() );
-                PCB_PARSER       parser( &reader, nullptr, nullptr );
+            wxString                fpName = fn.GetName();
+            FOOTPRINT_MAP::iterator it = previous.find( fpName );
 
-                FOOTPRINT* footprint = (FOOTPRINT*) parser.Parse();
-                wxString   fpName = fn.GetName();
-
-                footprint->SetFPID( LIB_ID( wxEmptyString, fpName ) );
-                m_footprints.insert( fpName, new FP_CACHE_ITEM( footprint, fn ) );
+            // The files are only indexed here; see GetFootprint() and LoadAll()
+            if( it != previous.end() && it->second->GetFootprint()
+                    && it->second->GetModTime() == fn.GetTimestamp() )
+            {
+                m_footprints.transfer( it, previous );
             }
-            catch( const IO_ERROR& ioe )
+            else
             {
-                if( !cacheError.IsEmpty() )
-                    cacheError += wxT( "\n\n" );
-
-                cacheError += ioe.What();
+                m_footprints.insert( fpName, new FP_CACHE_ITEM( nullptr, fn ) );
             }
         } while( dir.GetNext( &fullName ) );
 
         m_cache_timestamp = GetTimestamp( m_lib_raw_path );
+    }
+}
+
+
+void FP_CACHE::LoadAll()
+{
+    std::vector<FP_CACHE_ITEM*> items;
+
+    for( FOOTPRINT_MAP::iterator it = m_footprints.begin(); it != m_footprints.end(); ++it )
+    {
+        if( !it->second->GetFootprint() && it->second->GetError().IsEmpty() )
+            items.push_back( it->second );
+    }
+
+    // We don't want to spin up a new thread for only a few footprints (overhead costs).
+    // Worker threads (eg: FOOTPRINT_LIST_IMPL's, which enumerate several libraries at once)
+    // already keep the cores busy.
+    size_t parallelThreadCount = std::min<size_t>( std::thread::hardware_concurrency(),
+                                                   ( items.size() + 3 ) / 4 );
+
+    if( !wxThread::IsMain() )
+        parallelThreadCount = 1;
+
+    std::atomic<size_t>              nextItem( 0 );
+    std::vector<std::future<size_t>> returns( parallelThreadCount );
+
+    auto parse_lambda =
+            [&]() -> size_t
+            {
+                for( size_t ii = nextItem++; ii < items.size(); ii = nextItem++ )
+                {
+                    // Keep I/O errors so only files that fail to parse don't get loaded.
+                    try
+                    {
+                        items[ii]->SetFootprint( parseFootprint( items[ii]->GetFileName() ) );
+                    }
+                    catch( const IO_ERROR& ioe )
+                    {
+                        items[ii]->SetError( ioe.What() );
+                    }
+                }
 
-        if( !cacheError.IsEmpty() )
-            THROW_IO_ERROR( cacheError );
+                return 1;
+            };
+
+    if( parallelThreadCount <= 1 )
+    {
+        parse_lambda();
+    }
+    else
+    {
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii] = std::async( std::launch::async, parse_lambda );
+
+        // Finalize the threads
+        for( size_t ii = 0; ii < parallelThreadCount; ++ii )
+            returns[ii].wait();
+    }
+
+    // Report the files which failed to parse here and in earlier GetFootprint() calls
+    wxString cacheError;
+
+    for( FOOTPRINT_MAP::iterator it = m_footprints.begin(); it != m_footprints.end(); ++it )
+    {
+        if( !it->second->GetError().IsEmpty() )
+        {
+            if( !cacheError.IsEmpty() )
+                cacheError += wxT( "\n\n" );
+
+            cacheError += it->second->GetError();
+        }
     }
+
+    if( !cacheError.IsEmpty() )
+        THROW_IO_ERROR( cacheError );
+}
+
+
+const FOOTPRINT* FP_CACHE::GetFootprint( const wxString& aFootprintName )
+{
+    FOOTPRINT_MAP::iterator it = m_footprints.find( aFootprintName );
+
+    if( it == m_footprints.end() )
+        return nullptr;
+
+    if( !it->second->GetError().IsEmpty() )
+        THROW_IO_ERROR( it->second->GetError() );
+
+    if( !it->second->GetFootprint() )
+    {
+        try
+        {
+            it->second->SetFootprint( parseFootprint( it->second->GetFileName() ) );
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            it->second->SetError( ioe.What() );
+            throw;
+        }
+    }
+
+    return it->second->GetFootprint();
+}
+
+
+FOOTPRINT* FP_CACHE::parseFootprint( const WX_FILENAME& aFileName )
+{
+    FILE_LINE_READER reader( aFileName.GetFullPath() );
+    PCB_PARSER       parser( &reader, nullptr, nullptr );
+
+    FOOTPRINT* footprint = (FOOTPRINT*) parser.Parse();
+
+    footprint->SetFPID( LIB_ID( wxEmptyString, aFileName.GetName() ) );
+
+    return footprint;
 }
 
 
@@ -2338,13 +2512,18 @@ void PCB_PLUGIN::init( const PROPERTIES* aProperties )
 
 void PCB_PLUGIN::validateCache( const wxString& aLibraryPath, bool checkModified )
 {
-    if( !m_cache || !m_cache->IsPath( aLibraryPath ) || ( checkModified && m_cache->IsModified() ) )
+    if( !m_cache || !m_cache->IsPath( aLibraryPath ) )
     {
         // a spectacular episode in memory management:
         delete m_cache;
         m_cache = new FP_CACHE( this, aLibraryPath );
         m_cache->Load();
     }
+    else if( checkModified && m_cache->IsModified() )
+    {
+        // Re-index the library; only the footprint files which changed will be parsed again
+        m_cache->Load();
+    }
 }
 
 
@@ -2360,6 +2539,10 @@ void PCB_PLUGIN::FootprintEnumerate( wxArrayString& aFootprintNames, const wxStr
     try
     {
         validateCache( aLibPath );
+
+        // Enumeration is followed by a GetEnumeratedFootprint() for every footprint, and only
+        // footprints which parse are listed, so parse the whole library now.
+        m_cache->LoadAll();
     }
     catch( const IO_ERROR& ioe )
     {
@@ -2370,7 +2553,10 @@ void PCB_PLUGIN::FootprintEnumerate( wxArrayString& aFootprintNames, const wxStr
     // the library.
 
     for( const auto& footprint : m_cache->GetFootprints() )
-        aFootprintNames.Add( footprint.first );
+    {
+        if( footprint.second->GetFootprint() )
+            aFootprintNames.Add( footprint.first );
+    }
 
     if( !errorMsg.IsEmpty() && !aBestEfforts )
         THROW_IO_ERROR( errorMsg );
@@ -2389,19 +2575,16 @@ const FOOTPRINT* PCB_PLUGIN::getFootprint( const wxString& aLibraryPath,
     try
     {
         validateCache( aLibraryPath, checkModified );
+
+        // Only this footprint is parsed, not the whole library
+        return m_cache->GetFootprint( aFootprintName );
     }
     catch( const IO_ERROR& )
     {
         // do nothing with the error
     }
 
-    FOOTPRINT_MAP& footprints = m_cache->GetFootprints();
-    FOOTPRINT_MAP::const_iterator it = footprints.find( aFootprintName );
-
-    if( it == footprints.end() )
-        return nullptr;
-
-    return it->second->GetFootprint();
+    return nullptr;
 }
 
 
@@ -35,6 +35,7 @@
 #endif
 
 #include <ratsnest/ratsnest_data.h>
+#include <ratsnest/ratsnest_triangulation.h>
 #include <functional>
 using namespace std::placeholders;
 
@@ -42,8 +43,6 @@ using namespace std::placeholders;
 #include <cassert>
 #include <limits>
 
-#include <delaunator.hpp>
-
 class disjoint_set
 {
 
@@ -107,167 +106,50 @@ private:
 };
 
 
-void RN_NET::kruskalMST( std::vector<CN_EDGE>& aEdges,
-                         const std::set< std::pair<KIID, KIID> >& aExclusions )
+/**
+ * A candidate ratsnest edge between two nodes, identified by their tags.  Much cheaper to sort
+ * than a CN_EDGE.
+ */
+struct RN_NET::MST_EDGE
 {
-    disjoint_set dset( m_nodes.size() );
-
-    m_rnEdges.clear();
-
-    int i = 0;
+    unsigned weight;
+    int      source;
+    int      target;
 
-    for( const std::shared_ptr<CN_ANCHOR>& node : m_nodes )
-        node->SetTag( i++ );
-
-    for( CN_EDGE& tmp : aEdges )
-    {
-        const std::shared_ptr<CN_ANCHOR>&  source = tmp.GetSourceNode();
-        const std::shared_ptr<CN_ANCHOR>&  target = tmp.GetTargetNode();
-
-        if( dset.unite( source->GetTag(), target->GetTag() ) )
-        {
-            if( tmp.GetWeight() > 0 )
-            {
-                std::pair<KIID, KIID> ids = { source->Parent()->m_Uuid, target->Parent()->m_Uuid };
-                tmp.SetVisible( aExclusions.count( ids ) == 0 );
-
-                m_rnEdges.push_back( tmp );
-            }
-        }
-    }
-}
+    bool operator<( const MST_EDGE& aOther ) const { return weight < aOther.weight; }
+};
 
 
-class RN_NET::TRIANGULATOR_STATE
+void RN_NET::kruskalMST( const std::vector<MST_EDGE>& aEdges,
+                         const std::vector<std::shared_ptr<CN_ANCHOR>>& aNodes,
+                         const std::set< std::pair<KIID, KIID> >& aExclusions )
 {
-private:
-    std::multiset<std::shared_ptr<CN_ANCHOR>, CN_PTR_CMP> m_allNodes;
-
-
-    // Checks if all nodes in aNodes lie on a single line. Requires the nodes to
-    // have unique coordinates!
-    bool areNodesColinear( const std::vector<std::shared_ptr<CN_ANCHOR>>& aNodes ) const
-    {
-        if ( aNodes.size() <= 2 )
-            return true;
+    disjoint_set dset( aNodes.size() );
 
-        const VECTOR2I p0( aNodes[0]->Pos() );
-        const VECTOR2I v0( aNodes[1]->Pos() - p0 );
-
-        for( unsigned i = 2; i < aNodes.size(); i++ )
-        {
-            const VECTOR2I v1 = aNodes[i]->Pos() - p0;
-
-            if( v0.Cross( v1 ) != 0 )
-                return false;
-        }
-
-        return true;
-    }
-
-public:
-
-    void Clear()
-    {
-        m_allNodes.clear();
-    }
-
-    void AddNode( std::shared_ptr<CN_ANCHOR> aNode )
-    {
-        m_allNodes.insert( aNode );
-    }
+    m_rnEdges.clear();
 
-    void Triangulate( std::vector<CN_EDGE>& mstEdges )
+    for( const MST_EDGE& tmp : aEdges )
     {
-        std::vector<double>                                    node_pts;
-        std::vector<std::shared_ptr<CN_ANCHOR>>                anchors;
-        std::vector< std::vector<std::shared_ptr<CN_ANCHOR>> > anchorChains( m_allNodes.size() );
-
-        node_pts.reserve( 2 * m_allNodes.size() );
-        anchors.reserve( m_allNodes.size() );
-
-        auto addEdge =
-                [&]( const std::shared_ptr<CN_ANCHOR>& src, const std::shared_ptr<CN_ANCHOR>& dst )
-                {
-                    mstEdges.emplace_back( src, dst, src->Dist( *dst ) );
-                };
-
-        std::shared_ptr<CN_ANCHOR> prev = nullptr;
-
-        for( const std::shared_ptr<CN_ANCHOR>& n : m_allNodes )
-        {
-            if( !prev || prev->Pos() != n->Pos() )
-            {
-                node_pts.push_back( n->Pos().x );
-                node_pts.push_back( n->Pos().y );
-                anchors.push_back( n );
-                prev = n;
-            }
-
-            anchorChains[anchors.size() - 1].push_back( n );
-        }
-
-        if( anchors.size() < 2 )
-        {
-            return;
-        }
-        else if( areNodesColinear( anchors ) )
-        {
-            // special case: all nodes are on the same line - there's no
-            // triangulation for such set. In this case, we sort along any coordinate
-            // and chain the nodes together.
-            for( size_t i = 0; i < anchors.size() - 1; i++ )
-                addEdge( anchors[i], anchors[i + 1] );
-        }
-        else
+        if( dset.unite( tmp.source, tmp.target ) )
         {
-            delaunator::Delaunator delaunator( node_pts );
-            auto& triangles = delaunator.triangles;
-
-            for( size_t i = 0; i < triangles.size(); i += 3 )
-            {
-                addEdge( anchors[triangles[i]],     anchors[triangles[i + 1]] );
-                addEdge( anchors[triangles[i + 1]], anchors[triangles[i + 2]] );
-                addEdge( anchors[triangles[i + 2]], anchors[triangles[i]]     );
-            }
-
-            for( size_t i = 0; i < delaunator.halfedges.size(); i++ )
+            if( tmp.weight > 0 )
             {
-                if( delaunator.halfedges[i] == delaunator::INVALID_INDEX )
-                    continue;
+                const std::shared_ptr<CN_ANCHOR>& source = aNodes[tmp.source];
+                const std::shared_ptr<CN_ANCHOR>& target = aNodes[tmp.target];
 
-                addEdge( anchors[triangles[i]], anchors[triangles[delaunator.halfedges[i]]] );
-            }
-        }
-
-        for( size_t i = 0; i < anchorChains.size(); i++ )
-        {
-            std::vector<std::shared_ptr<CN_ANCHOR>>& chain = anchorChains[i];
-
-            if( chain.size() < 2 )
-                continue;
-
-            std::sort( chain.begin(), chain.end(),
-                    [] ( const std::shared_ptr<CN_ANCHOR>& a, const std::shared_ptr<CN_ANCHOR>& b )
-                    {
-                        return a->GetCluster().get() < b->GetCluster().get();
-                    } );
+                std::pair<KIID, KIID> ids = { source->Parent()->m_Uuid, target->Parent()->m_Uuid };
 
-            for( unsigned int j = 1; j < chain.size(); j++ )
-            {
-                const std::shared_ptr<CN_ANCHOR>& prevNode = chain[j - 1];
-                const std::shared_ptr<CN_ANCHOR>& curNode  = chain[j];
-                int weight = prevNode->GetCluster() != curNode->GetCluster() ? 1 : 0;
-                mstEdges.emplace_back( prevNode, curNode, weight );
+                m_rnEdges.emplace_back( source, target, tmp.weight );
+                m_rnEdges.back().SetVisible( aExclusions.count( ids ) == 0 );
             }
         }
     }
-};
+}
 
 
 RN_NET::RN_NET() : m_dirty( true )
 {
-    m_triangulator.reset( new TRIANGULATOR_STATE );
+    m_triangulator.reset( new RN_TRIANGULATION );
 }
 
 
@@ -308,39 +190,93 @@ void RN_NET::compute( const std::set< std::pair<KIID, KIID> >& aExclusions )
     }
 
 
-    m_triangulator->Clear();
+    // m_nodes is sorted by position; tag the nodes in that order and collect the unique
+    // positions
+    std::vector<std::shared_ptr<CN_ANCHOR>> nodes;
+    std::vector<VECTOR2I>                   positions;
+    std::vector<int>                        firstAtPosition;
+
+    nodes.reserve( m_nodes.size() );
 
     for( const std::shared_ptr<CN_ANCHOR>& n : m_nodes )
-        m_triangulator->AddNode( n );
+    {
+        n->SetTag( nodes.size() );
 
-    std::vector<CN_EDGE> triangEdges;
-    triangEdges.reserve( m_nodes.size() + m_boardEdges.size() );
+        if( positions.empty() || positions.back() != n->Pos() )
+        {
+            positions.push_back( n->Pos() );
+            firstAtPosition.push_back( nodes.size() );
+        }
+
+        nodes.push_back( n );
+    }
+
+    firstAtPosition.push_back( nodes.size() );
+
+    std::vector<std::pair<int, int>> triangEdges;
+    std::vector<MST_EDGE>            edges;
 
 #ifdef PROFILE
     PROF_COUNTER cnt("triangulate");
 #endif
-    m_triangulator->Triangulate( triangEdges );
+    m_triangulator->Triangulate( positions, triangEdges );
 #ifdef PROFILE
     cnt.Show();
 #endif
 
+    edges.reserve( triangEdges.size() + m_nodes.size() + m_boardEdges.size() );
+
+    for( const std::pair<int, int>& e : triangEdges )
+    {
+        int source = firstAtPosition[e.first];
+        int target = firstAtPosition[e.second];
+
+        edges.push_back( { nodes[source]->Dist( *nodes[target] ), source, target } );
+    }
+
+    // Chain the nodes sharing a position, at no cost if they're in the same cluster
+    for( size_t i = 0; i + 1 < firstAtPosition.size(); i++ )
+    {
+        if( firstAtPosition[i + 1] - firstAtPosition[i] < 2 )
+            continue;
+
+        std::vector<int> chain;
+
+        for( int tag = firstAtPosition[i]; tag < firstAtPosition[i + 1]; tag++ )
+            chain.push_back( tag );
+
+        std::sort( chain.begin(), chain.end(),
+                [&]( int a, int b )
+                {
+                    return nodes[a]->GetCluster().get() < nodes[b]->GetCluster().get();
+                } );
+
+        for( size_t j = 1; j < chain.size(); j++ )
+        {
+            int weight = nodes[chain[j - 1]]->GetCluster() != nodes[chain[j]]->GetCluster() ? 1 : 0;
+            edges.push_back( { (unsigned) weight, chain[j - 1], chain[j] } );
+        }
+    }
+
     for( const CN_EDGE& e : m_boardEdges )
-        triangEdges.emplace_back( e );
+    {
+        edges.push_back( { e.GetWeight(), e.GetSourceNode()->GetTag(),
+                           e.GetTargetNode()->GetTag() } );
+    }
 
-    std::sort( triangEdges.begin(), triangEdges.end() );
+    std::sort( edges.begin(), edges.end() );
 
 // Get the minimal spanning tree
 #ifdef PROFILE
     PROF_COUNTER cnt2("mst");
 #endif
-    kruskalMST( triangEdges, aExclusions );
+    kruskalMST( edges, nodes, aExclusions );
 #ifdef PROFILE
     cnt2.Show();
 #endif
 }
 
 
-
 void RN_NET::Update( const std::set< std::pair<KIID, KIID> >& aExclusions )
 {
     compute( aExclusions );
@@ -43,6 +43,7 @@
 class BOARD_ITEM;
 class BOARD_CONNECTED_ITEM;
 class CN_CLUSTER;
+class RN_TRIANGULATION;
 
 struct CN_PTR_CMP
 {
@@ -96,8 +97,11 @@ protected:
     ///< Recompute ratsnest from scratch.
     void compute( const std::set< std::pair<KIID, KIID> >& aExclusions );
 
+    struct MST_EDGE;
+
     ///< Compute the minimum spanning tree using Kruskal's algorithm
-    void kruskalMST( std::vector<CN_EDGE>& aEdges,
+    void kruskalMST( const std::vector<MST_EDGE>& aEdges,
+                     const std::vector<std::shared_ptr<CN_ANCHOR>>& aNodes,
                      const std::set< std::pair<KIID, KIID> >& aExclusions );
 
     ///< Vector of nodes
@@ -112,9 +116,8 @@ protected:
     ///< Flag indicating necessity of recalculation of ratsnest for a net.
     bool m_dirty;
 
-    class TRIANGULATOR_STATE;
-
-    std::shared_ptr<TRIANGULATOR_STATE> m_triangulator;
+    ///< Kept between updates so that small edits only re-triangulate locally
+    std::shared_ptr<RN_TRIANGULATION> m_triangulator;
 };
 
 #endif /* RATSNEST_DATA_H */
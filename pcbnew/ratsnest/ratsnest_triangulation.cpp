@@ -0,0 +1,474 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <ratsnest/ratsnest_triangulation.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <delaunator.hpp>
+
+
+static bool posLess( const VECTOR2I& a, const VECTOR2I& b )
+{
+    return a.x < b.x || ( a.x == b.x && a.y < b.y );
+}
+
+
+static uint64_t edgeKey( int a, int b )
+{
+    return ( uint64_t( uint32_t( a ) ) << 32 ) | uint32_t( b );
+}
+
+
+// Checks if all nodes in aNodes lie on a single line. Requires the nodes to
+// have unique coordinates!
+static bool arePointsColinear( const std::vector<VECTOR2I>& aPoints )
+{
+    if ( aPoints.size() <= 2 )
+        return true;
+
+    const VECTOR2I p0( aPoints[0] );
+    const VECTOR2I v0( aPoints[1] - p0 );
+
+    for( unsigned i = 2; i < aPoints.size(); i++ )
+    {
+        const VECTOR2I v1 = aPoints[i] - p0;
+
+        if( v0.Cross( v1 ) != 0 )
+            return false;
+    }
+
+    return true;
+}
+
+
+int RN_TRIANGULATION::allocSlot( const VECTOR2I& aPos )
+{
+    int slot;
+
+    if( m_freeSlots.empty() )
+    {
+        slot = m_slotPos.size();
+        m_slotPos.push_back( aPos );
+        m_slotOnHull.push_back( false );
+    }
+    else
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_slotPos[slot] = aPos;
+        m_slotOnHull[slot] = false;
+    }
+
+    return slot;
+}
+
+
+bool RN_TRIANGULATION::delaunay( const std::vector<int>& aSlots,
+                                 std::vector<TRIANGLE>& aTriangles,
+                                 std::vector<int>* aHull ) const
+{
+    std::vector<VECTOR2I> pts;
+    std::vector<double>   coords;
+
+    pts.reserve( aSlots.size() );
+    coords.reserve( 2 * aSlots.size() );
+
+    for( int slot : aSlots )
+    {
+        pts.push_back( m_slotPos[slot] );
+        coords.push_back( m_slotPos[slot].x );
+        coords.push_back( m_slotPos[slot].y );
+    }
+
+    if( arePointsColinear( pts ) )
+        return false;
+
+    delaunator::Delaunator delaunator( coords );
+    const std::vector<size_t>& triangles = delaunator.triangles;
+
+    for( size_t i = 0; i + 2 < triangles.size(); i += 3 )
+    {
+        TRIANGLE t = { aSlots[triangles[i]], aSlots[triangles[i + 1]],
+                       aSlots[triangles[i + 2]] };
+
+        if( orient( t[0], t[1], t[2] ) < 0 )
+            std::swap( t[1], t[2] );
+
+        aTriangles.push_back( t );
+    }
+
+    if( aHull )
+    {
+        size_t e = delaunator.hull_start;
+
+        do
+        {
+            aHull->push_back( aSlots[e] );
+            e = delaunator.hull_next[e];
+        } while( e != delaunator.hull_start );
+
+        double area = 0.0;
+
+        for( size_t i = 0; i < aHull->size(); i++ )
+        {
+            const VECTOR2I& a = m_slotPos[( *aHull )[i]];
+            const VECTOR2I& b = m_slotPos[( *aHull )[( i + 1 ) % aHull->size()]];
+            area += (double) a.x * b.y - (double) b.x * a.y;
+        }
+
+        if( area < 0 )
+            std::reverse( aHull->begin(), aHull->end() );
+    }
+
+    return true;
+}
+
+
+bool RN_TRIANGULATION::strictlyInsideHull( const VECTOR2I& aP ) const
+{
+    for( size_t i = 0; i < m_hull.size(); i++ )
+    {
+        const VECTOR2I& a = m_slotPos[m_hull[i]];
+        const VECTOR2I& b = m_slotPos[m_hull[( i + 1 ) % m_hull.size()]];
+
+        if( ( b - a ).Cross( aP - a ) <= 0 )
+            return false;
+    }
+
+    return true;
+}
+
+
+bool RN_TRIANGULATION::patch( const std::vector<int>& aRemoved, const std::vector<int>& aAdded )
+{
+    std::vector<bool> dead( m_slotPos.size(), false );
+
+    for( int slot : aRemoved )
+    {
+        // Removing a hull point changes the hull; we don't handle that here
+        if( m_slotOnHull[slot] )
+            return false;
+
+        dead[slot] = true;
+    }
+
+    for( int slot : aAdded )
+    {
+        if( !strictlyInsideHull( m_slotPos[slot] ) )
+            return false;
+    }
+
+    // aAdded is sorted by x (as is m_sortedSlots)
+    auto inCircle =
+            [&]( const TRIANGLE& t ) -> bool
+            {
+                const VECTOR2I& a = m_slotPos[t[0]];
+                const VECTOR2I& b = m_slotPos[t[1]];
+                const VECTOR2I& c = m_slotPos[t[2]];
+
+                double bx = (double) b.x - a.x, by = (double) b.y - a.y;
+                double cx = (double) c.x - a.x, cy = (double) c.y - a.y;
+                double d = 2.0 * ( bx * cy - by * cx );
+
+                if( d == 0.0 )
+                    return true;
+
+                double b2 = bx * bx + by * by;
+                double c2 = cx * cx + cy * cy;
+                double ox = ( cy * b2 - by * c2 ) / d;
+                double oy = ( bx * c2 - cx * b2 ) / d;
+                double r = std::sqrt( ox * ox + oy * oy ) * ( 1.0 + 1e-9 ) + 1.0;
+
+                auto first = std::lower_bound( aAdded.begin(), aAdded.end(), a.x + ox - r,
+                        [&]( int slot, double x )
+                        {
+                            return m_slotPos[slot].x < x;
+                        } );
+
+                for( auto it = first; it != aAdded.end(); ++it )
+                {
+                    const VECTOR2I& p = m_slotPos[*it];
+
+                    if( p.x > a.x + ox + r )
+                        break;
+
+                    // In-circle determinant (negative inside for CCW triangles)
+                    double px = (double) p.x - a.x, py = (double) p.y - a.y;
+                    double p2 = px * px + py * py;
+                    double det = bx * ( cy * p2 - c2 * py ) - by * ( cx * p2 - c2 * px )
+                                 + b2 * ( cx * py - cy * px );
+
+                    if( det < 0.0 )
+                        return true;
+                }
+
+                return false;
+            };
+
+    std::vector<TRIANGLE> kept;
+    std::vector<TRIANGLE> cavity;
+
+    for( const TRIANGLE& t : m_triangles )
+    {
+        if( dead[t[0]] || dead[t[1]] || dead[t[2]] || ( !aAdded.empty() && inCircle( t ) ) )
+            cavity.push_back( t );
+        else
+            kept.push_back( t );
+    }
+
+    if( cavity.empty() )
+        return false;
+
+    std::unordered_set<uint64_t> cavityEdges;
+    std::unordered_set<uint64_t> boundary;
+    std::vector<int>             localSlots( aAdded );
+    std::unordered_set<int>      seen( aAdded.begin(), aAdded.end() );
+    double                       cavityArea = 0.0;
+
+    for( const TRIANGLE& t : cavity )
+    {
+        for( int i = 0; i < 3; i++ )
+            cavityEdges.insert( edgeKey( t[i], t[( i + 1 ) % 3] ) );
+
+        cavityArea += doubleArea( t );
+    }
+
+    for( const TRIANGLE& t : cavity )
+    {
+        for( int i = 0; i < 3; i++ )
+        {
+            int a = t[i];
+            int b = t[( i + 1 ) % 3];
+
+            if( !dead[a] && seen.insert( a ).second )
+                localSlots.push_back( a );
+
+            if( cavityEdges.count( edgeKey( b, a ) ) )
+                continue;
+
+            // A boundary edge on a removed point means the point was on the hull
+            if( dead[a] || dead[b] )
+                return false;
+
+            boundary.insert( edgeKey( a, b ) );
+        }
+    }
+
+    std::vector<TRIANGLE> local;
+
+    if( !delaunay( localSlots, local, nullptr ) )
+        return false;
+
+    std::unordered_map<uint64_t, size_t> localEdges;
+
+    for( size_t ii = 0; ii < local.size(); ii++ )
+    {
+        for( int i = 0; i < 3; i++ )
+            localEdges[edgeKey( local[ii][i], local[ii][( i + 1 ) % 3] )] = ii;
+    }
+
+    // Flood the local triangulation from the inside of the cavity's boundary
+    std::vector<bool>   inside( local.size(), false );
+    std::vector<size_t> stack;
+
+    for( uint64_t edge : boundary )
+    {
+        auto it = localEdges.find( edge );
+
+        if( it == localEdges.end() )
+            return false;
+
+        if( !inside[it->second] )
+        {
+            inside[it->second] = true;
+            stack.push_back( it->second );
+        }
+    }
+
+    double filledArea = 0.0;
+
+    while( !stack.empty() )
+    {
+        const TRIANGLE& t = local[stack.back()];
+        stack.pop_back();
+
+        filledArea += doubleArea( t );
+
+        for( int i = 0; i < 3; i++ )
+        {
+            int a = t[i];
+            int b = t[( i + 1 ) % 3];
+
+            if( boundary.count( edgeKey( a, b ) ) )
+                continue;
+
+            auto it = localEdges.find( edgeKey( b, a ) );
+
+            // Leaked out of the local triangulation without crossing the boundary
+            if( it == localEdges.end() )
+                return false;
+
+            if( !inside[it->second] )
+            {
+                inside[it->second] = true;
+                stack.push_back( it->second );
+            }
+        }
+    }
+
+    // The patch must exactly fill the cavity
+    if( std::abs( filledArea - cavityArea ) > 1e-9 * cavityArea )
+        return false;
+
+    for( size_t ii = 0; ii < local.size(); ii++ )
+    {
+        if( inside[ii] )
+            kept.push_back( local[ii] );
+    }
+
+    m_triangles = std::move( kept );
+    return true;
+}
+
+
+void RN_TRIANGULATION::Clear()
+{
+    m_slotPos.clear();
+    m_slotOnHull.clear();
+    m_freeSlots.clear();
+    m_sortedSlots.clear();
+    m_hull.clear();
+    m_triangles.clear();
+    m_valid = false;
+    m_patched = false;
+}
+
+
+void RN_TRIANGULATION::Triangulate( const std::vector<VECTOR2I>& aPoints,
+                                    std::vector<std::pair<int, int>>& aEdges )
+{
+    if( aPoints.size() < 2 )
+    {
+        Clear();
+        return;
+    }
+    else if( arePointsColinear( aPoints ) )
+    {
+        // special case: all nodes are on the same line - there's no
+        // triangulation for such set. In this case, we sort along any coordinate
+        // and chain the nodes together.
+        Clear();
+
+        for( size_t i = 0; i < aPoints.size() - 1; i++ )
+            aEdges.emplace_back( i, i + 1 );
+
+        return;
+    }
+
+    // Compare with the previous positions
+    std::vector<int> pointSlot( aPoints.size(), -1 );
+    std::vector<int> removed;
+    std::vector<int> added;
+    size_t           ii = 0;
+
+    for( const std::pair<VECTOR2I, int>& old : m_sortedSlots )
+    {
+        while( ii < aPoints.size() && posLess( aPoints[ii], old.first ) )
+            ii++;
+
+        if( ii < aPoints.size() && aPoints[ii] == old.first )
+            pointSlot[ii++] = old.second;
+        else
+            removed.push_back( old.second );
+    }
+
+    size_t changes = removed.size();
+
+    for( int slot : pointSlot )
+        changes += ( slot < 0 );
+
+    bool patched = false;
+
+    // Beyond a handful of changes a fresh triangulation is quicker
+    if( m_valid && changes * 8 <= aPoints.size() )
+    {
+        for( size_t jj = 0; jj < aPoints.size(); jj++ )
+        {
+            if( pointSlot[jj] < 0 )
+            {
+                pointSlot[jj] = allocSlot( aPoints[jj] );
+                added.push_back( pointSlot[jj] );
+            }
+        }
+
+        patched = changes == 0 || patch( removed, added );
+
+        // Sanity check: a triangulation of n points with h of them on the hull
+        // always has 2n - h - 2 triangles
+        if( patched && m_triangles.size() + m_hull.size() + 2 != 2 * aPoints.size() )
+            patched = false;
+
+        if( patched )
+            m_freeSlots.insert( m_freeSlots.end(), removed.begin(), removed.end() );
+    }
+
+    m_patched = patched;
+
+    if( !patched )
+    {
+        Clear();
+
+        std::vector<int> slots;
+
+        for( size_t jj = 0; jj < aPoints.size(); jj++ )
+        {
+            pointSlot[jj] = allocSlot( aPoints[jj] );
+            slots.push_back( pointSlot[jj] );
+        }
+
+        m_valid = delaunay( slots, m_triangles, &m_hull );
+
+        for( int slot : m_hull )
+            m_slotOnHull[slot] = true;
+    }
+
+    m_sortedSlots.clear();
+
+    std::vector<int> slotPoint( m_slotPos.size(), -1 );
+
+    for( size_t jj = 0; jj < aPoints.size(); jj++ )
+    {
+        m_sortedSlots.emplace_back( aPoints[jj], pointSlot[jj] );
+        slotPoint[pointSlot[jj]] = jj;
+    }
+
+    for( const TRIANGLE& t : m_triangles )
+    {
+        aEdges.emplace_back( slotPoint[t[0]], slotPoint[t[1]] );
+        aEdges.emplace_back( slotPoint[t[1]], slotPoint[t[2]] );
+        aEdges.emplace_back( slotPoint[t[2]], slotPoint[t[0]] );
+    }
+}
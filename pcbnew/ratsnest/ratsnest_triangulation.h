@@ -0,0 +1,105 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef RATSNEST_TRIANGULATION_H
+#define RATSNEST_TRIANGULATION_H
+
+#include <array>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include <math/vector2d.h>
+
+/**
+ * Delaunay triangulation of a net's anchor positions, kept between updates.
+ *
+ * Points are held in stable slots so that the triangles of one update can be carried over to
+ * the next.  When only a few points were added or removed (eg: a footprint was moved), only the
+ * triangles whose circumcircle contains a new point or which have a removed vertex are thrown
+ * away, and the hole they leave is re-triangulated from its own vertices.  Anything that can't
+ * be patched up that way (hull changes, degenerate cases, large edits) falls back to a full
+ * triangulation.
+ */
+class RN_TRIANGULATION
+{
+public:
+    void Clear();
+
+    /**
+     * Triangulate a set of unique positions, sorted in CN_PTR_CMP order.
+     *
+     * @param aEdges receives the triangulation's edges as pairs of indices into aPoints (an edge
+     *               may be listed twice).
+     */
+    void Triangulate( const std::vector<VECTOR2I>& aPoints,
+                      std::vector<std::pair<int, int>>& aEdges );
+
+    ///< Return true if the last Triangulate() updated the previous triangulation locally.
+    bool WasPatched() const { return m_patched; }
+
+private:
+    typedef std::array<int, 3> TRIANGLE;     ///< Slots, in counter-clockwise order
+
+    VECTOR2I::extended_type orient( int a, int b, int c ) const
+    {
+        return ( m_slotPos[b] - m_slotPos[a] ).Cross( m_slotPos[c] - m_slotPos[a] );
+    }
+
+    double doubleArea( const TRIANGLE& t ) const
+    {
+        return std::abs( (double) orient( t[0], t[1], t[2] ) );
+    }
+
+    int allocSlot( const VECTOR2I& aPos );
+
+    /**
+     * Triangulate aSlots from scratch.
+     *
+     * @param aTriangles receives the triangles in counter-clockwise order.
+     * @param aHull if not null, receives the convex hull in counter-clockwise order.
+     * @return false if there is no triangulation (ie: the points are colinear).
+     */
+    bool delaunay( const std::vector<int>& aSlots, std::vector<TRIANGLE>& aTriangles,
+                   std::vector<int>* aHull ) const;
+
+    bool strictlyInsideHull( const VECTOR2I& aP ) const;
+
+    /**
+     * Replace the triangles touched by the removed and added slots by a local triangulation.
+     *
+     * @return false if that couldn't be done, in which case the state is unchanged.
+     */
+    bool patch( const std::vector<int>& aRemoved, const std::vector<int>& aAdded );
+
+    std::vector<VECTOR2I>                 m_slotPos;
+    std::vector<bool>                     m_slotOnHull;
+    std::vector<int>                      m_freeSlots;
+    std::vector<std::pair<VECTOR2I, int>> m_sortedSlots;    ///< Live slots in CN_PTR_CMP order
+    std::vector<int>                      m_hull;           ///< Counter-clockwise
+    std::vector<TRIANGLE>                 m_triangles;
+    bool                                  m_valid = false;
+    bool                                  m_patched = false;
+};
+
+#endif // RATSNEST_TRIANGULATION_H
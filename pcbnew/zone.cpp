@@ -992,17 +992,33 @@ void ZONE::SwapData( BOARD_ITEM* aImage )
 
 void ZONE::CacheTriangulation( PCB_LAYER_ID aLayer )
 {
+    auto cacheFill =
+            [&]( PCB_LAYER_ID aFillLayer, SHAPE_POLY_SET& aFill )
+            {
+                auto hint = m_fillTriangulationHints.find( aFillLayer );
+
+                if( hint != m_fillTriangulationHints.end() )
+                {
+                    aFill.CacheTriangulation( true, hint->second.get() );
+                    m_fillTriangulationHints.erase( hint );
+                }
+                else
+                {
+                    aFill.CacheTriangulation();
+                }
+            };
+
     if( aLayer == UNDEFINED_LAYER )
     {
         for( std::pair<const PCB_LAYER_ID, std::shared_ptr<SHAPE_POLY_SET>>& pair : m_FilledPolysList )
-            pair.second->CacheTriangulation();
+            cacheFill( pair.first, *pair.second );
 
         m_Poly->CacheTriangulation( false );
     }
     else
     {
         if( m_FilledPolysList.count( aLayer ) )
-            m_FilledPolysList[ aLayer ]->CacheTriangulation();
+            cacheFill( aLayer, *m_FilledPolysList[ aLayer ] );
     }
 }
 
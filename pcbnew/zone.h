@@ -660,6 +660,16 @@ public:
      */
     void SetFilledPolysList( PCB_LAYER_ID aLayer, const SHAPE_POLY_SET& aPolysList )
     {
+        auto prev = m_FilledPolysList.find( aLayer );
+
+        // A refill usually leaves most outlines unchanged, so keep the previous fill for
+        // CacheTriangulation() to take their triangles from
+        if( prev != m_FilledPolysList.end() && prev->second
+                && prev->second->TriangulatedPolyCount() )
+        {
+            m_fillTriangulationHints[aLayer] = prev->second;
+        }
+
         m_FilledPolysList[aLayer] = std::make_shared<SHAPE_POLY_SET>( aPolysList );
     }
 
@@ -917,6 +927,10 @@ protected:
      */
     std::map<PCB_LAYER_ID, std::shared_ptr<SHAPE_POLY_SET>> m_FilledPolysList;
 
+    /// Previous fills replaced by SetFilledPolysList(), until their triangles have been
+    /// reused by CacheTriangulation()
+    std::map<PCB_LAYER_ID, std::shared_ptr<SHAPE_POLY_SET>> m_fillTriangulationHints;
+
     /// Temp variables used while filling
     EDA_RECT                               m_bboxCache;
     std::map<PCB_LAYER_ID, bool>           m_fillFlags;
@@ -0,0 +1,170 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <iostream>
+#include <string>
+
+#include <wx/cmdline.h>
+
+#include <board.h>
+#include <reporter.h>
+#include <settings/color_settings.h>
+#include <3d_canvas/board_adapter.h>
+#include <3d_rendering/raytracing/render_3d_raytrace.h>
+#include <3d_rendering/track_ball.h>
+#include <3d_viewer/eda_3d_viewer_settings.h>
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "W", "width", _( "image width in pixels (default 1024)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "H", "height", _( "image height in pixels (default 768)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "t", "tile", _( "tile size in pixels (default 64)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "j", "threads", _( "number of threads (default all the cores)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "x", "rotate-x", _( "camera rotation around X in degrees" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE },
+    { wxCMD_LINE_OPTION, "z", "rotate-z", _( "camera rotation around Z in degrees" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE },
+    { wxCMD_LINE_OPTION, "Z", "zoom", _( "zoom factor (default 1)" ).mb_str(),
+            wxCMD_LINE_VAL_DOUBLE },
+    { wxCMD_LINE_SWITCH, "c", "cad", _( "render in CAD mode instead of realistic mode" ).mb_str(),
+            wxCMD_LINE_VAL_NONE },
+    { wxCMD_LINE_OPTION, "o", "output", _( "output PNG file (default board.png)" ).mb_str(),
+            wxCMD_LINE_VAL_STRING },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "input board" ).mb_str(), wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum RENDER_3D_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    RENDER_FAILED
+};
+
+
+int render_3d_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "This program renders a board with the 3D raytracer into a PNG "
+                               "file, without any OpenGL context, and reports the time taken by "
+                               "each phase.  3D models are not rendered." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    RT_OFFSCREEN_SETTINGS settings;
+    long                  width = settings.m_Size.x;
+    long                  height = settings.m_Size.y;
+    long                  tileSize = settings.m_TileSize;
+    long                  threadCount = settings.m_ThreadCount;
+    double                rotateX = 0.0;
+    double                rotateZ = 0.0;
+    double                zoom = 1.0;
+    wxString              outputFile = wxT( "board.png" );
+
+    cl_parser.Found( "width", &width );
+    cl_parser.Found( "height", &height );
+    cl_parser.Found( "tile", &tileSize );
+    cl_parser.Found( "threads", &threadCount );
+    cl_parser.Found( "rotate-x", &rotateX );
+    cl_parser.Found( "rotate-z", &rotateZ );
+    cl_parser.Found( "zoom", &zoom );
+    cl_parser.Found( "output", &outputFile );
+
+    if( width <= 0 || height <= 0 || tileSize <= 0 || threadCount < 0 || zoom <= 0.0 )
+    {
+        std::cerr << "Invalid render settings" << std::endl;
+        return KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    settings.m_Size = wxSize( width, height );
+    settings.m_TileSize = tileSize;
+    settings.m_ThreadCount = threadCount;
+
+    std::string filename;
+
+    if( cl_parser.GetParamCount() )
+        filename = cl_parser.GetParam( 0 ).ToStdString();
+
+    std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !board )
+        return LOAD_FAILED;
+
+    // The default settings and colors, as there is no settings manager here
+    EDA_3D_VIEWER_SETTINGS cfg;
+    COLOR_SETTINGS         colors;
+
+    cfg.ResetToDefaults();
+    cfg.m_Render.realistic = !cl_parser.Found( "cad" );
+    colors.ResetToDefaults();
+
+    // No 3D model cache is set, so the footprint models are skipped
+    BOARD_ADAPTER adapter;
+
+    adapter.SetBoard( board.get() );
+    adapter.SetColorSettings( &colors );
+    adapter.m_Cfg = &cfg;
+
+    TRACK_BALL         camera( 2 * RANGE_SCALE_3D );
+    RENDER_3D_RAYTRACE renderer( nullptr, adapter, camera );
+
+    camera.RotateX( glm::radians( (float) rotateX ) );
+    camera.RotateZ( glm::radians( (float) rotateZ ) );
+
+    camera.Zoom( (float) zoom );
+
+    if( !renderer.RenderToFile( outputFile, settings, &STDOUT_REPORTER::GetInstance(),
+                                &STDOUT_REPORTER::GetInstance() ) )
+    {
+        std::cerr << "Can't render " << outputFile << std::endl;
+        return RENDER_FAILED;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "render_3d",
+        "Render a board with the 3D raytracer into a PNG file",
+        render_3d_main_func,
+} );
@@ -0,0 +1,349 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <pcbnew_utils/board_file_utils.h>
+
+#include <qa_utils/utility_registry.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <wx/cmdline.h>
+
+#include <board.h>
+#include <footprint.h>
+#include <pcb_display_options.h>
+#include <pcb_draw_panel_gal.h>
+#include <pcb_marker.h>
+#include <pcb_painter.h>
+#include <pcb_track.h>
+#include <pcb_view.h>
+#include <profile.h>
+#include <zone.h>
+#include <settings/color_settings.h>
+#include <gal/cairo/cairo_image_gal.h>
+
+
+/**
+ * One step of a pan/zoom script.  Each step is followed by a redraw.
+ *
+ * fit             show the whole board
+ * zoom <factor>   zoom in (factor > 1) or out, around the view center
+ * pan <dx> <dy>   move by a fraction of the view size
+ */
+struct VIEW_STEP
+{
+    std::string command;
+    double      x = 0.0;
+    double      y = 0.0;
+};
+
+
+static std::vector<VIEW_STEP> defaultScript()
+{
+    std::vector<VIEW_STEP> script = { { "fit" } };
+
+    for( int ii = 0; ii < 6; ii++ )
+        script.push_back( { "zoom", 1.5 } );
+
+    for( int ii = 0; ii < 8; ii++ )
+        script.push_back( { "pan", ii < 4 ? 0.25 : -0.25, ii % 2 ? 0.25 : -0.25 } );
+
+    for( int ii = 0; ii < 6; ii++ )
+        script.push_back( { "zoom", 1.0 / 1.5 } );
+
+    for( int ii = 0; ii < 4; ii++ )
+        script.push_back( { "pan", 0.1, 0.0 } );
+
+    return script;
+}
+
+
+static bool readScript( const std::string& aFileName, std::vector<VIEW_STEP>& aScript )
+{
+    std::ifstream file( aFileName );
+
+    if( !file )
+        return false;
+
+    std::string line;
+
+    while( std::getline( file, line ) )
+    {
+        std::istringstream stream( line );
+        VIEW_STEP          step;
+
+        if( !( stream >> step.command ) || step.command[0] == '#' )
+            continue;
+
+        if( step.command == "zoom" && !( stream >> step.x ) )
+            return false;
+        else if( step.command == "pan" && !( stream >> step.x >> step.y ) )
+            return false;
+        else if( step.command != "fit" && step.command != "zoom" && step.command != "pan" )
+            return false;
+
+        aScript.push_back( step );
+    }
+
+    return true;
+}
+
+
+/**
+ * A PCB painter which counts what it draws, so the frame times can be put against the number
+ * of items the view actually painted rather than the number lying in the viewport.
+ */
+class COUNTING_PCB_PAINTER : public KIGFX::PCB_PAINTER
+{
+public:
+    COUNTING_PCB_PAINTER( KIGFX::GAL* aGal ) :
+            KIGFX::PCB_PAINTER( aGal ),
+            m_drawnLayers( 0 )
+    {}
+
+    bool Draw( const KIGFX::VIEW_ITEM* aItem, int aLayer ) override
+    {
+        bool drawn = KIGFX::PCB_PAINTER::Draw( aItem, aLayer );
+
+        if( drawn )
+        {
+            m_drawnItems.insert( aItem );
+            m_drawnLayers++;
+        }
+
+        return drawn;
+    }
+
+    void ResetCounts()
+    {
+        m_drawnItems.clear();
+        m_drawnLayers = 0;
+    }
+
+    size_t DrawnItems() const { return m_drawnItems.size(); }
+    size_t DrawnLayers() const { return m_drawnLayers; }
+
+private:
+    std::unordered_set<const KIGFX::VIEW_ITEM*> m_drawnItems;  ///< Distinct items drawn
+    size_t                                      m_drawnLayers; ///< Item layers drawn
+};
+
+
+static const wxCmdLineEntryDesc g_cmdLineDesc[] = {
+    { wxCMD_LINE_SWITCH, "h", "help", _( "displays help on the command line parameters" ).mb_str(),
+            wxCMD_LINE_VAL_NONE, wxCMD_LINE_OPTION_HELP },
+    { wxCMD_LINE_OPTION, "W", "width", _( "image width in pixels (default 1920)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "H", "height", _( "image height in pixels (default 1080)" ).mb_str(),
+            wxCMD_LINE_VAL_NUMBER },
+    { wxCMD_LINE_OPTION, "s", "script", _( "pan/zoom script file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING },
+    { wxCMD_LINE_OPTION, "o", "output", _( "save the last frame to this PNG file" ).mb_str(),
+            wxCMD_LINE_VAL_STRING },
+    { wxCMD_LINE_PARAM, nullptr, nullptr, _( "input board" ).mb_str(), wxCMD_LINE_VAL_STRING,
+            wxCMD_LINE_PARAM_OPTIONAL },
+    { wxCMD_LINE_NONE }
+};
+
+
+enum RENDER_BENCHMARK_RET_CODES
+{
+    LOAD_FAILED = KI_TEST::RET_CODES::TOOL_SPECIFIC,
+    BAD_SCRIPT,
+    SAVE_FAILED
+};
+
+
+int render_benchmark_main_func( int argc, char** argv )
+{
+    wxMessageOutput::Set( new wxMessageOutputStderr );
+    wxCmdLineParser cl_parser( argc, argv );
+    cl_parser.SetDesc( g_cmdLineDesc );
+    cl_parser.AddUsageText( _( "This program draws a board with the Cairo GAL into an offscreen "
+                               "image, following a pan/zoom script, and reports the time taken "
+                               "by each frame." ) );
+
+    int cmd_parsed_ok = cl_parser.Parse();
+
+    if( cmd_parsed_ok != 0 )
+    {
+        // Help and invalid input both stop here
+        return ( cmd_parsed_ok == -1 ) ? KI_TEST::RET_CODES::OK : KI_TEST::RET_CODES::BAD_CMDLINE;
+    }
+
+    long     width = 1920;
+    long     height = 1080;
+    wxString scriptFile;
+    wxString outputFile;
+
+    cl_parser.Found( "width", &width );
+    cl_parser.Found( "height", &height );
+
+    std::vector<VIEW_STEP> script;
+
+    if( cl_parser.Found( "script", &scriptFile ) )
+    {
+        if( !readScript( scriptFile.ToStdString(), script ) || script.empty() )
+        {
+            std::cerr << "Can't read script " << scriptFile << std::endl;
+            return BAD_SCRIPT;
+        }
+    }
+    else
+    {
+        script = defaultScript();
+    }
+
+    std::string filename;
+
+    if( cl_parser.GetParamCount() )
+        filename = cl_parser.GetParam( 0 ).ToStdString();
+
+    std::unique_ptr<BOARD> board = KI_TEST::ReadBoardFromFileOrStream( filename );
+
+    if( !board )
+        return LOAD_FAILED;
+
+    KIGFX::GAL_DISPLAY_OPTIONS options;
+    KIGFX::CAIRO_IMAGE_GAL     gal( options, VECTOR2I( width, height ) );
+    COUNTING_PCB_PAINTER       painter( &gal );
+    KIGFX::PCB_VIEW            view;
+
+    view.SetGAL( &gal );
+    view.SetPainter( &painter );
+
+    // Set the view up as the board editor does, with the default colors and display options
+    // as there is no settings manager here.  Cairo doesn't cache item geometry.
+    COLOR_SETTINGS colors;
+
+    colors.ResetToDefaults();
+    painter.GetSettings()->LoadColors( &colors );
+    view.UpdateDisplayOptions( PCB_DISPLAY_OPTIONS() );
+
+    PCB_DRAW_PANEL_GAL::SetDefaultLayerOrder( &view );
+    PCB_DRAW_PANEL_GAL::SetDefaultLayerDeps( &view, false );
+    PCB_DRAW_PANEL_GAL::SyncLayersVisibility( &view, board.get() );
+
+    PROF_TIMER loadTimer;
+
+    // The ratsnest is left out: it is an overlay, and needs the pcbnew settings
+    board->CacheTriangulation();
+
+    for( BOARD_ITEM* drawing : board->Drawings() )
+        view.Add( drawing );
+
+    for( PCB_TRACK* track : board->Tracks() )
+        view.Add( track );
+
+    for( FOOTPRINT* footprint : board->Footprints() )
+        view.Add( footprint );
+
+    for( PCB_MARKER* marker : board->Markers() )
+        view.Add( marker );
+
+    for( ZONE* zone : board->Zones() )
+        view.Add( zone );
+
+    std::cout << "Added items to view: " << loadTimer.msecs() << " ms" << std::endl;
+
+    const BOX2I boardBox = board->GetBoundingBox();
+    std::vector<double> frameTimes;
+
+    for( size_t ii = 0; ii < script.size(); ii++ )
+    {
+        const VIEW_STEP& step = script[ii];
+
+        if( step.command == "fit" )
+        {
+            view.SetViewport( BOX2D( boardBox.GetOrigin(), boardBox.GetSize() ) );
+        }
+        else if( step.command == "zoom" )
+        {
+            view.SetScale( view.GetScale() * step.x );
+        }
+        else if( step.command == "pan" )
+        {
+            BOX2D viewport = view.GetViewport();
+            view.SetCenter( view.GetCenter() + VECTOR2D( viewport.GetWidth() * step.x,
+                                                         viewport.GetHeight() * step.y ) );
+        }
+
+        PROF_TIMER frameTimer;
+
+        painter.ResetCounts();
+        view.UpdateItems();
+
+        {
+            KIGFX::GAL_DRAWING_CONTEXT ctx( &gal );
+
+            gal.SetClearColor( painter.GetSettings()->GetBackgroundColor() );
+            gal.ClearScreen();
+            view.ClearTargets();
+            view.Redraw();
+        }
+
+        frameTimes.push_back( frameTimer.msecs() );
+
+        std::cout << "Frame " << ii << " (" << step.command << "): " << frameTimes.back()
+                  << " ms, " << painter.DrawnItems() << " items drawn ("
+                  << painter.DrawnLayers() << " item layers)" << std::endl;
+    }
+
+    double total = 0.0;
+
+    for( double t : frameTimes )
+        total += t;
+
+    // The first frame includes caching the geometry of every item
+    std::cout << "First frame: " << frameTimes.front() << " ms" << std::endl;
+
+    if( frameTimes.size() > 1 )
+    {
+        auto minmax = std::minmax_element( frameTimes.begin() + 1, frameTimes.end() );
+
+        std::cout << "Next frames: min " << *minmax.first << " ms, average "
+                  << ( total - frameTimes.front() ) / ( frameTimes.size() - 1 ) << " ms, max "
+                  << *minmax.second << " ms" << std::endl;
+    }
+
+    if( cl_parser.Found( "output", &outputFile ) && !gal.SaveAsPng( outputFile.ToStdString() ) )
+    {
+        std::cerr << "Can't write " << outputFile << std::endl;
+        return SAVE_FAILED;
+    }
+
+    return KI_TEST::RET_CODES::OK;
+}
+
+
+static bool registered = UTILITY_REGISTRY::Register( {
+        "render_benchmark",
+        "Measure the time taken to draw a board while panning and zooming",
+        render_benchmark_main_func,
+} );
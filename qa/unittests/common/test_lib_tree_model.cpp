@@ -0,0 +1,262 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the searching of LIB_TREE_NODE trees
+ */
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <wx/tokenzr.h>
+
+#include <eda_pattern_match.h>
+#include <lib_tree_item.h>
+
+// Code under test
+#include <lib_tree_model.h>
+
+
+class TEST_LIB_TREE_ITEM : public LIB_TREE_ITEM
+{
+public:
+    TEST_LIB_TREE_ITEM( const wxString& aLib, const wxString& aName, const wxString& aDesc,
+                        const wxString& aKeywords ) :
+            m_lib( aLib ),
+            m_name( aName ),
+            m_desc( aDesc ),
+            m_keywords( aKeywords )
+    {
+    }
+
+    LIB_ID   GetLibId() const override { return LIB_ID( m_lib, m_name ); }
+    wxString GetName() const override { return m_name; }
+    wxString GetLibNickname() const override { return m_lib; }
+    wxString GetDescription() override { return m_desc; }
+    wxString GetSearchText() override { return m_keywords + wxT( " " ) + m_desc; }
+
+    wxString m_lib;
+    wxString m_name;
+    wxString m_desc;
+    wxString m_keywords;
+};
+
+
+class TEST_LIB_TREE_MODEL_FIXTURE
+{
+public:
+    TEST_LIB_TREE_MODEL_FIXTURE()
+    {
+        const wxString libs[] = { wxT( "Device" ), wxT( "Amplifier_Operational" ),
+                                  wxT( "Timer" ) };
+        const wxString names[] = { wxT( "R" ), wxT( "R_Small" ), wxT( "C" ), wxT( "C_Polarized" ),
+                                   wxT( "LM358" ), wxT( "LM324" ), wxT( "TL072" ),
+                                   wxT( "NE555" ), wxT( "ICM7555" ), wxT( "Resonator" ) };
+        const wxString descs[] = { wxT( "Resistor" ), wxT( "Resistor, small symbol" ),
+                                   wxT( "Unpolarized capacitor" ),
+                                   wxT( "Polarized capacitor" ),
+                                   wxT( "Low-Power, Dual Operational Amplifiers, DIP-8" ),
+                                   wxT( "Low-Power, Quad Operational Amplifiers, DIP-14" ),
+                                   wxT( "Dual Low-Noise JFET-Input Operational Amplifiers" ),
+                                   wxT( "Precision Timers, 555 compatible" ),
+                                   wxT( "CMOS General Purpose Timer, 555 compatible" ),
+                                   wxT( "Three pin ceramic resonator" ) };
+        const wxString keywords[] = { wxT( "R res resistor" ), wxT( "R resistor" ),
+                                      wxT( "cap capacitor" ), wxT( "cap capacitor elec" ),
+                                      wxT( "dual opamp" ), wxT( "quad opamp" ),
+                                      wxT( "dual opamp" ), wxT( "single timer 555" ),
+                                      wxT( "single timer 555" ), wxT( "ceramic resonator" ) };
+
+        // Every library gets every item, with a library specific suffix for some of them
+        for( const wxString& lib : libs )
+        {
+            for( size_t ii = 0; ii < sizeof( names ) / sizeof( names[0] ); ii++ )
+            {
+                wxString name = names[ii];
+
+                if( ii % 3 == 0 )
+                    name += wxT( "_" ) + lib.Left( 3 );
+
+                m_items.emplace_back( std::make_unique<TEST_LIB_TREE_ITEM>(
+                        lib, name, descs[ii], keywords[ii] ) );
+            }
+        }
+
+        buildTree( m_indexed );
+        buildTree( m_reference );
+    }
+
+    void buildTree( LIB_TREE_NODE_ROOT& aTree )
+    {
+        LIB_TREE_NODE_LIB* lib = nullptr;
+
+        for( const std::unique_ptr<TEST_LIB_TREE_ITEM>& item : m_items )
+        {
+            if( !lib || lib->m_Name != item->m_lib )
+                lib = &aTree.AddLib( item->m_lib, wxEmptyString );
+
+            lib->AddItem( item.get() );
+        }
+    }
+
+    /**
+     * Score both trees against \a aSearch the way LIB_TREE_MODEL_ADAPTER does, the reference
+     * one through a scan of every item, and check the scores are the same.
+     */
+    void checkSearch( const wxString& aSearch )
+    {
+        BOOST_TEST_CONTEXT( "search '" << aSearch << "'" )
+        {
+            m_indexed.ResetScore();
+            m_reference.ResetScore();
+
+            wxStringTokenizer tokenizer( aSearch );
+
+            while( tokenizer.HasMoreTokens() )
+            {
+                wxString lib;
+                wxString term = tokenizer.GetNextToken().Lower();
+
+                if( term.Contains( ":" ) )
+                {
+                    lib = term.BeforeFirst( ':' );
+                    term = term.AfterFirst( ':' );
+                }
+
+                EDA_COMBINED_MATCHER matcher( term );
+                m_indexed.UpdateScore( matcher, lib );
+
+                EDA_COMBINED_MATCHER refMatcher( term );
+
+                for( std::unique_ptr<LIB_TREE_NODE>& child : m_reference.m_Children )
+                    child->UpdateScore( refMatcher, lib );
+            }
+
+            BOOST_REQUIRE_EQUAL( m_indexed.m_Children.size(), m_reference.m_Children.size() );
+
+            for( size_t ii = 0; ii < m_indexed.m_Children.size(); ii++ )
+            {
+                LIB_TREE_NODE* lib = m_indexed.m_Children[ii].get();
+                LIB_TREE_NODE* refLib = m_reference.m_Children[ii].get();
+
+                BOOST_CHECK_EQUAL( lib->m_Score, refLib->m_Score );
+                BOOST_REQUIRE_EQUAL( lib->m_Children.size(), refLib->m_Children.size() );
+
+                for( size_t jj = 0; jj < lib->m_Children.size(); jj++ )
+                {
+                    BOOST_TEST_CONTEXT( "item " << lib->m_Children[jj]->m_Name )
+                    {
+                        BOOST_CHECK_EQUAL( lib->m_Children[jj]->m_Score,
+                                           refLib->m_Children[jj]->m_Score );
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<TEST_LIB_TREE_ITEM>> m_items;
+    LIB_TREE_NODE_ROOT                               m_indexed;
+    LIB_TREE_NODE_ROOT                               m_reference;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( LibTreeModel, TEST_LIB_TREE_MODEL_FIXTURE )
+
+
+/**
+ * Literal terms are narrowed down through the trigram index.
+ */
+BOOST_AUTO_TEST_CASE( LiteralTermsMatchLinearSearch )
+{
+    for( const wxString& search : { wxT( "resistor" ), wxT( "res" ), wxT( "resonator" ),
+                                    wxT( "lm3" ), wxT( "lm358" ), wxT( "opamp dual" ),
+                                    wxT( "555" ), wxT( "timer" ), wxT( "device" ),
+                                    wxT( "amplifier_operational" ), wxT( "_dev" ),
+                                    wxT( "low-power" ), wxT( "nothing" ),
+                                    wxT( "device:cap" ), wxT( "timer:555" ) } )
+    {
+        checkSearch( search );
+    }
+
+    // As typed, one character at a time, which reuses the candidates of the previous terms
+    wxString typed;
+
+    for( wxUniChar c : wxString( wxT( "capacitor" ) ) )
+    {
+        typed += c;
+        checkSearch( typed );
+    }
+}
+
+
+/**
+ * Terms the matchers may interpret, and terms too short for the index, are scored on every
+ * item.
+ */
+BOOST_AUTO_TEST_CASE( NonLiteralTermsMatchLinearSearch )
+{
+    for( const wxString& search : { wxT( "r" ), wxT( "lm" ), wxT( "lm*" ), wxT( "ne5?5" ),
+                                    wxT( "/^c/" ), wxT( "r.*small" ), wxT( "dip-8 (dual)" ),
+                                    wxT( "pin>2" ), wxT( "c_pol" ) } )
+    {
+        checkSearch( search );
+    }
+}
+
+
+/**
+ * Adding, updating and removing nodes rebuilds the index of their own tree.
+ */
+BOOST_AUTO_TEST_CASE( IndexFollowsTreeChanges )
+{
+    checkSearch( wxT( "resistor" ) );
+
+    // Device:C now matches
+    m_items[2]->m_desc = wxT( "Not a resistor" );
+
+    for( LIB_TREE_NODE_ROOT* tree : { &m_indexed, &m_reference } )
+    {
+        LIB_TREE_NODE* node = tree->m_Children[0]->m_Children[2].get();
+        static_cast<LIB_TREE_NODE_LIB_ID*>( node )->Update( m_items[2].get() );
+    }
+
+    checkSearch( wxT( "resistor" ) );
+    BOOST_CHECK_GT( m_indexed.m_Children[0]->m_Children[2]->m_Score, 0 );
+
+    // Libraries are removed by deleting their node
+    m_items.emplace_back( std::make_unique<TEST_LIB_TREE_ITEM>( wxT( "Extra" ),
+                                                                wxT( "Resistor_Array" ),
+                                                                wxEmptyString, wxEmptyString ) );
+
+    for( LIB_TREE_NODE_ROOT* tree : { &m_indexed, &m_reference } )
+    {
+        tree->m_Children.erase( tree->m_Children.begin() );
+        tree->AddLib( wxT( "Extra" ), wxEmptyString ).AddItem( m_items.back().get() );
+    }
+
+    checkSearch( wxT( "resistor" ) );
+    checkSearch( wxT( "extra" ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,133 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <font/glyph.h>
+#include <trigo.h>
+
+
+/**
+ * Collect the triangle vertices a glyph draws.
+ */
+static std::vector<VECTOR2I> drawnVertices( const KIFONT::OUTLINE_GLYPH& aGlyph )
+{
+    std::vector<VECTOR2I> vertices;
+
+    aGlyph.Triangulate(
+            [&]( const VECTOR2I& aPt1, const VECTOR2I& aPt2, const VECTOR2I& aPt3 )
+            {
+                vertices.push_back( aPt1 );
+                vertices.push_back( aPt2 );
+                vertices.push_back( aPt3 );
+            } );
+
+    return vertices;
+}
+
+
+static std::shared_ptr<KIFONT::OUTLINE_GLYPH> sharedGlyph()
+{
+    std::shared_ptr<KIFONT::OUTLINE_GLYPH> glyph = std::make_shared<KIFONT::OUTLINE_GLYPH>();
+    SHAPE_LINE_CHAIN                       outline( { { 0, 0 }, { 1000, 0 }, { 1000, 2000 },
+                                                      { 0, 2000 } } );
+
+    outline.SetClosed( true );
+    glyph->AddOutline( outline );
+    glyph->CacheTriangulation( false );
+
+    return glyph;
+}
+
+
+BOOST_AUTO_TEST_SUITE( OutlineGlyph )
+
+
+/**
+ * A glyph drawn from a shared glyph must draw its triangles transformed the same way as its
+ * own outlines.
+ */
+BOOST_AUTO_TEST_CASE( DrawSourceTransform )
+{
+    std::shared_ptr<KIFONT::OUTLINE_GLYPH> source = sharedGlyph();
+    std::vector<VECTOR2I>                  sourceVertices = drawnVertices( *source );
+
+    const VECTOR2D  offset( 5000.5, -300.25 );
+    const VECTOR2I  origin( 4000, 1000 );
+    const EDA_ANGLE angle( 30.0, DEGREES_T );
+
+    for( bool mirror : { false, true } )
+    {
+        KIFONT::OUTLINE_GLYPH glyph;
+
+        glyph.SetDrawSource( source, offset, mirror, angle, origin );
+        glyph.Move( VECTOR2I( 10, 20 ) );
+
+        std::vector<VECTOR2I> vertices = drawnVertices( glyph );
+
+        BOOST_REQUIRE_EQUAL( vertices.size(), sourceVertices.size() );
+
+        for( size_t ii = 0; ii < vertices.size(); ++ii )
+        {
+            VECTOR2D expected = VECTOR2D( sourceVertices[ii] ) + offset;
+
+            if( mirror )
+                expected.x = origin.x - ( expected.x - origin.x );
+
+            RotatePoint( expected, origin, angle );
+            expected += VECTOR2D( 10, 20 );
+
+            BOOST_CHECK_LE( ( VECTOR2D( vertices[ii] ) - expected ).EuclideanNorm(), 1.5 );
+        }
+
+        // Copies, as kept by the text render caches, draw the same
+        KIFONT::OUTLINE_GLYPH copy( glyph );
+
+        BOOST_CHECK( drawnVertices( copy ) == vertices );
+    }
+}
+
+
+/**
+ * Rotating or mirroring a glyph after the fact drops the shared glyph, and draws its own
+ * outlines.
+ */
+BOOST_AUTO_TEST_CASE( DrawSourceDropped )
+{
+    std::shared_ptr<KIFONT::OUTLINE_GLYPH> source = sharedGlyph();
+    KIFONT::OUTLINE_GLYPH                  glyph;
+    SHAPE_LINE_CHAIN                       outline( { { 0, 0 }, { 10, 0 }, { 0, 10 } } );
+
+    outline.SetClosed( true );
+    glyph.AddOutline( outline );
+    glyph.SetDrawSource( source, VECTOR2D( 0, 0 ), false, ANGLE_0, VECTOR2I( 0, 0 ) );
+
+    BOOST_CHECK_EQUAL( drawnVertices( glyph ).size(), drawnVertices( *source ).size() );
+
+    glyph.Rotate( ANGLE_90 );
+
+    BOOST_CHECK_EQUAL( drawnVertices( glyph ).size(), 3u );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
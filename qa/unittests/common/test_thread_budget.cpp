@@ -0,0 +1,66 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <thread_budget.h>
+
+
+BOOST_AUTO_TEST_SUITE( ThreadBudget )
+
+
+/**
+ * Nested budgets share the threads of the process rather than each getting one per core.
+ */
+BOOST_AUTO_TEST_CASE( Nested )
+{
+    size_t total = THREAD_BUDGET::GetTotal();
+
+    BOOST_REQUIRE_GE( total, 1 );
+
+    {
+        THREAD_BUDGET outer( total + 4 );
+
+        BOOST_CHECK_EQUAL( outer.GetCount(), total );
+
+        THREAD_BUDGET inner( 2 );
+
+        BOOST_CHECK_EQUAL( inner.GetCount(), 0 );
+
+        outer.Release();
+
+        BOOST_CHECK_EQUAL( outer.GetCount(), 0 );
+
+        THREAD_BUDGET again( 1 );
+
+        BOOST_CHECK_EQUAL( again.GetCount(), 1 );
+    }
+
+    // Everything is returned once the budgets are gone
+    THREAD_BUDGET all( total );
+
+    BOOST_CHECK_EQUAL( all.GetCount(), total );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,286 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the binary cache of s-expression symbol libraries
+ */
+
+#include <boost/filesystem.hpp>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <lib_symbol.h>
+#include <richio.h>
+#include <eeschema/sch_plugins/kicad/sch_sexpr_lib_plugin_cache.h>
+#include <eeschema/sch_plugins/kicad/sch_sexpr_parser.h>
+
+// Code under test
+#include <eeschema/sch_plugins/kicad/sch_sexpr_lib_binary_cache.h>
+
+
+/**
+ * A library using every kind of item the cache stores.
+ */
+static const std::string s_library = R"LIB(
+(kicad_symbol_lib (version 20220331) (generator kicad_symbol_editor)
+  (symbol "Amp" (pin_names (offset 0.508)) (in_bom yes) (on_board yes)
+    (property "Reference" "U" (id 0) (at 0 5.08 0)
+      (effects (font (size 1.27 1.27)) (justify left))
+    )
+    (property "Value" "Amp" (id 1) (at 0 -5.08 0)
+      (effects (font (size 1.27 1.27) italic) (justify left))
+    )
+    (property "Footprint" "Package_SO:SOIC-8" (id 2) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "Datasheet" "~" (id 3) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "ki_keywords" "amplifier opamp" (id 4) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "ki_description" "An operational amplifier" (id 5) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "ki_fp_filters" "SOIC*3.9x4.9mm*P1.27mm* DIP*W7.62mm*" (id 6) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "Vendor" "ACME" (id 7) (at 2.54 7.62 90)
+      (effects (font (size 1 1) bold) (justify right bottom))
+    )
+    (symbol "Amp_0_1"
+      (polyline
+        (pts (xy -5.08 5.08) (xy 5.08 0) (xy -5.08 -5.08) (xy -5.08 5.08))
+        (stroke (width 0.254) (type default) (color 0 0 0 0))
+        (fill (type background))
+      )
+      (rectangle (start -1 -1) (end 1 1)
+        (stroke (width 0) (type dash) (color 255 0 0 1))
+        (fill (type color) (color 0 255 0 0.5))
+      )
+      (circle (center 2 2) (radius 0.5)
+        (stroke (width 0.1) (type default) (color 0 0 0 0))
+        (fill (type outline))
+      )
+      (arc (start 0 1.27) (mid 1.27 0) (end 0 -1.27)
+        (stroke (width 0) (type default) (color 0 0 0 0))
+        (fill (type none))
+      )
+      (bezier (pts (xy -2 0) (xy -1 2) (xy 1 -2) (xy 2 0))
+        (stroke (width 0) (type dot) (color 0 0 0 0))
+        (fill (type none))
+      )
+      (text "~{OUT}" (at 1.27 -2.54 900)
+        (effects (font (size 0.8 0.8)))
+      )
+      (text_box "Multi\nline"
+        (at -4 4 0) (size 3 2)
+        (stroke (width 0) (type default) (color 0 0 0 0))
+        (fill (type none))
+        (effects (font (size 0.5 0.5)) (justify left top))
+      )
+    )
+    (symbol "Amp_1_1"
+      (pin input line (at -7.62 2.54 0) (length 2.54)
+        (name "+" (effects (font (size 1.27 1.27))))
+        (number "3" (effects (font (size 1.27 1.27))))
+      )
+      (pin input inverted (at -7.62 -2.54 0) (length 2.54)
+        (name "-" (effects (font (size 1.27 1.27))))
+        (number "2" (effects (font (size 1.27 1.27))))
+        (alternate "INV" input line)
+        (alternate "CLK" input clock)
+      )
+      (pin output line (at 7.62 0 180) (length 2.54) hide
+        (name "~" (effects (font (size 1 1))))
+        (number "1" (effects (font (size 1 1))))
+      )
+    )
+    (symbol "Amp_2_1"
+      (pin power_in line (at 0 7.62 270) (length 2.54)
+        (name "V+" (effects (font (size 1.27 1.27))))
+        (number "8" (effects (font (size 1.27 1.27))))
+      )
+    )
+  )
+  (symbol "Amp_Dual" (extends "Amp")
+    (property "Reference" "U" (id 0) (at 0 5.08 0)
+      (effects (font (size 1.27 1.27)) (justify left))
+    )
+    (property "Value" "Amp_Dual" (id 1) (at 0 -5.08 0)
+      (effects (font (size 1.27 1.27)) (justify left))
+    )
+    (property "Footprint" "" (id 2) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "Datasheet" "" (id 3) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+  )
+  (symbol "GND" (power) (pin_names (offset 0)) (in_bom no) (on_board no)
+    (property "Reference" "#PWR" (id 0) (at 0 -6.35 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "Value" "GND" (id 1) (at 0 -3.81 0)
+      (effects (font (size 1.27 1.27)))
+    )
+    (property "Footprint" "" (id 2) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (property "Datasheet" "" (id 3) (at 0 0 0)
+      (effects (font (size 1.27 1.27)) hide)
+    )
+    (symbol "GND_0_1"
+      (polyline
+        (pts (xy 0 0) (xy 0 -1.27) (xy 1.27 -1.27) (xy 0 -2.54) (xy -1.27 -1.27) (xy 0 -1.27))
+        (stroke (width 0) (type default) (color 0 0 0 0))
+        (fill (type none))
+      )
+    )
+    (symbol "GND_1_1"
+      (pin power_in line (at 0 0 270) (length 0) hide
+        (name "GND" (effects (font (size 1.27 1.27))))
+        (number "1" (effects (font (size 1.27 1.27))))
+      )
+    )
+  )
+)
+)LIB";
+
+
+struct SEXPR_LIB_BINARY_CACHE_FIXTURE
+{
+    SEXPR_LIB_BINARY_CACHE_FIXTURE()
+    {
+        m_cacheDir = boost::filesystem::temp_directory_path() / "sexpr_lib_binary_cache_tst";
+        boost::filesystem::remove_all( m_cacheDir );
+    }
+
+    ~SEXPR_LIB_BINARY_CACHE_FIXTURE()
+    {
+        for( LIB_SYMBOL* symbol : m_parsed )
+            delete symbol;
+
+        boost::filesystem::remove_all( m_cacheDir );
+    }
+
+    /**
+     * Parse the symbols of \a aText the way SCH_SEXPR_PLUGIN_CACHE does before writing the
+     * cache, that is without resolving the inheritance of derived symbols.
+     */
+    void parse( const std::string& aText )
+    {
+        std::vector<LIB_SYMBOL_SPAN> spans;
+        size_t                       headerEnd = 0;
+
+        BOOST_REQUIRE( SCH_SEXPR_PLUGIN_CACHE::SplitLibSymbols( aText, headerEnd, spans ) );
+
+        STRING_LINE_READER headerReader( aText.substr( 0, headerEnd ), "header" );
+        SCH_SEXPR_PARSER   headerParser( &headerReader );
+        int                version = headerParser.ParseLibHeader();
+
+        for( const LIB_SYMBOL_SPAN& span : spans )
+        {
+            STRING_LINE_READER reader( aText.substr( span.m_Start, span.m_End - span.m_Start ),
+                                       "symbol" );
+            SCH_SEXPR_PARSER   parser( &reader );
+            wxString           parentName;
+
+            m_parsed.push_back( parser.ParseLibSymbol( version, parentName ) );
+            m_parentNames.push_back( parentName );
+        }
+    }
+
+    wxString cacheDir() const { return wxString( m_cacheDir.string() ); }
+
+    boost::filesystem::path  m_cacheDir;
+    std::vector<LIB_SYMBOL*> m_parsed;
+    std::vector<wxString>    m_parentNames;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SchSexprLibBinaryCache, SEXPR_LIB_BINARY_CACHE_FIXTURE )
+
+
+/**
+ * Symbols read back from the cache are the same as the parsed ones.
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    parse( s_library );
+    BOOST_REQUIRE_EQUAL( m_parsed.size(), 3u );
+
+    SCH_SEXPR_LIB_BINARY_CACHE writeCache( wxT( "/lib/test.kicad_sym" ), s_library, cacheDir() );
+    writeCache.Write( m_parsed, m_parentNames );
+
+    SCH_SEXPR_LIB_BINARY_CACHE readCache( wxT( "/lib/test.kicad_sym" ), s_library, cacheDir() );
+    std::vector<LIB_SYMBOL*>   cached;
+    std::vector<wxString>      cachedParentNames;
+
+    BOOST_REQUIRE( readCache.Read( cached, cachedParentNames ) );
+    BOOST_REQUIRE_EQUAL( cached.size(), m_parsed.size() );
+    BOOST_REQUIRE_EQUAL( cachedParentNames.size(), m_parentNames.size() );
+
+    for( size_t ii = 0; ii < cached.size(); ++ii )
+    {
+        std::unique_ptr<LIB_SYMBOL> symbol( cached[ii] );
+
+        BOOST_TEST_CONTEXT( "symbol " << m_parsed[ii]->GetName() )
+        {
+            BOOST_CHECK_EQUAL( symbol->Compare( *m_parsed[ii] ), 0 );
+            BOOST_CHECK_EQUAL( cachedParentNames[ii], m_parentNames[ii] );
+        }
+    }
+
+    BOOST_CHECK_EQUAL( cachedParentNames[1], wxT( "Amp" ) );
+}
+
+
+/**
+ * The cache is not used for another library content or another library.
+ */
+BOOST_AUTO_TEST_CASE( Invalidation )
+{
+    parse( s_library );
+
+    SCH_SEXPR_LIB_BINARY_CACHE writeCache( wxT( "/lib/test.kicad_sym" ), s_library, cacheDir() );
+    writeCache.Write( m_parsed, m_parentNames );
+
+    std::vector<LIB_SYMBOL*> cached;
+    std::vector<wxString>    cachedParentNames;
+    std::string              edited = s_library;
+
+    edited.replace( edited.find( "ACME" ), 4, "Acme" );
+
+    SCH_SEXPR_LIB_BINARY_CACHE editedCache( wxT( "/lib/test.kicad_sym" ), edited, cacheDir() );
+    BOOST_CHECK( !editedCache.Read( cached, cachedParentNames ) );
+    BOOST_CHECK( cached.empty() );
+
+    SCH_SEXPR_LIB_BINARY_CACHE otherCache( wxT( "/lib/other.kicad_sym" ), s_library, cacheDir() );
+    BOOST_CHECK( !otherCache.Read( cached, cachedParentNames ) );
+    BOOST_CHECK( cached.empty() );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
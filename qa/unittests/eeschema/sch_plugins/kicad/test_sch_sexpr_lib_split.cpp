@@ -0,0 +1,193 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the splitting of symbol library files into symbols, ahead of their parsing
+ */
+
+#include <optional>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+// Code under test
+#include <eeschema/sch_plugins/kicad/sch_sexpr_lib_plugin_cache.h>
+
+
+struct SEXPR_LIB_SPLIT_FIXTURE
+{
+    /**
+     * Split \a aText and return the text of its symbols, or nothing if it can't be split.
+     */
+    std::optional<std::vector<std::string>> split( const std::string& aText )
+    {
+        std::vector<LIB_SYMBOL_SPAN> spans;
+
+        m_headerEnd = 0;
+
+        if( !SCH_SEXPR_PLUGIN_CACHE::SplitLibSymbols( aText, m_headerEnd, spans ) )
+            return std::nullopt;
+
+        std::vector<std::string> symbols;
+
+        for( const LIB_SYMBOL_SPAN& span : spans )
+        {
+            BOOST_REQUIRE_LT( span.m_Start, span.m_End );
+            BOOST_REQUIRE_LE( span.m_End, aText.size() );
+            BOOST_CHECK_EQUAL( aText[span.m_Start], '(' );
+            BOOST_CHECK_EQUAL( aText[span.m_End - 1], ')' );
+
+            // The reported position must be that of the opening parenthesis
+            size_t lineStart = 0;
+
+            for( unsigned ii = 0; ii < span.m_Line; ++ii )
+                lineStart = aText.find( '\n', lineStart ) + 1;
+
+            BOOST_CHECK_EQUAL( lineStart + span.m_Column, span.m_Start );
+
+            symbols.push_back( aText.substr( span.m_Start, span.m_End - span.m_Start ) );
+        }
+
+        return symbols;
+    }
+
+    size_t m_headerEnd = 0;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SchSexprLibSplit, SEXPR_LIB_SPLIT_FIXTURE )
+
+
+BOOST_AUTO_TEST_CASE( Basic )
+{
+    const std::string text = "(kicad_symbol_lib (version 20220914) (generator kicad_symbol_editor)\n"
+                             "  (symbol \"A\" (in_bom yes)\n"
+                             "    (symbol \"A_0_1\" (rectangle (start 0 0) (end 1 1)))\n"
+                             "  )\n"
+                             "  (symbol \"B\" (extends \"A\"))\n"
+                             ")\n";
+
+    auto symbols = split( text );
+
+    BOOST_REQUIRE( symbols );
+    BOOST_REQUIRE_EQUAL( symbols->size(), 2u );
+    BOOST_CHECK_EQUAL( m_headerEnd, text.find( "(symbol \"A\"" ) );
+    BOOST_CHECK_EQUAL( symbols->at( 0 ).substr( 0, 12 ), "(symbol \"A\" " );
+    BOOST_CHECK_EQUAL( symbols->at( 1 ), "(symbol \"B\" (extends \"A\"))" );
+}
+
+
+/**
+ * Parentheses within strings don't count.
+ */
+BOOST_AUTO_TEST_CASE( ParensInStrings )
+{
+    const std::string text = "(kicad_symbol_lib (version 20220914) (generator \"(gen)\")\n"
+                             "  (symbol \"A(\" (property \"Value\" \"))((\" (id 1)))\n"
+                             "  (symbol \")B\" (property \"Value\" \"(\" (id 1)))\n"
+                             ")\n";
+
+    auto symbols = split( text );
+
+    BOOST_REQUIRE( symbols );
+    BOOST_REQUIRE_EQUAL( symbols->size(), 2u );
+    BOOST_CHECK_EQUAL( symbols->at( 0 ),
+                       "(symbol \"A(\" (property \"Value\" \"))((\" (id 1)))" );
+    BOOST_CHECK_EQUAL( symbols->at( 1 ), "(symbol \")B\" (property \"Value\" \"(\" (id 1)))" );
+}
+
+
+/**
+ * Escaped quotes don't end strings, but escaped backslashes do not escape the quote after them.
+ */
+BOOST_AUTO_TEST_CASE( EscapedQuotes )
+{
+    const std::string text = "(kicad_symbol_lib (version 20220914) (generator kicad_symbol_editor)\n"
+                             "  (symbol \"A\" (property \"Value\" \"a \\\") b\" (id 1)))\n"
+                             "  (symbol \"B\\\\\" (property \"Value\" \"c\\\\\" (id 1)))\n"
+                             ")\n";
+
+    auto symbols = split( text );
+
+    BOOST_REQUIRE( symbols );
+    BOOST_REQUIRE_EQUAL( symbols->size(), 2u );
+    BOOST_CHECK_EQUAL( symbols->at( 0 ),
+                       "(symbol \"A\" (property \"Value\" \"a \\\") b\" (id 1)))" );
+    BOOST_CHECK_EQUAL( symbols->at( 1 ),
+                       "(symbol \"B\\\\\" (property \"Value\" \"c\\\\\" (id 1)))" );
+}
+
+
+/**
+ * Comment lines are skipped the way the lexer skips them, at any depth.  A '#' elsewhere is
+ * part of a token.
+ */
+BOOST_AUTO_TEST_CASE( Comments )
+{
+    const std::string text = "# A library (with a comment\n"
+                             "(kicad_symbol_lib (version 20220914) (generator kicad_symbol_editor)\n"
+                             "  # before the symbols )\n"
+                             "  (symbol \"#PWR\" (power)\n"
+                             "    # (symbol \"nested\"\n"
+                             "    (property \"Reference\" \"#PWR\" (id 0))\n"
+                             "  )\n"
+                             "\t# between symbols ((\n"
+                             "  (symbol \"B\" (property \"Value\" \"# not a comment (\" (id 1)))\n"
+                             ")\n"
+                             "# trailing comment )\n";
+
+    auto symbols = split( text );
+
+    BOOST_REQUIRE( symbols );
+    BOOST_REQUIRE_EQUAL( symbols->size(), 2u );
+    BOOST_CHECK_EQUAL( m_headerEnd, text.find( "(symbol \"#PWR\"" ) );
+    BOOST_CHECK_EQUAL( symbols->at( 0 ).substr( 0, 15 ), "(symbol \"#PWR\" " );
+    BOOST_CHECK_EQUAL( symbols->at( 1 ),
+                       "(symbol \"B\" (property \"Value\" \"# not a comment (\" (id 1)))" );
+}
+
+
+/**
+ * Files the splitter doesn't understand are left to the sequential parser.
+ */
+BOOST_AUTO_TEST_CASE( Rejected )
+{
+    // Unbalanced
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1)\n  (symbol \"A\" (x)\n" ) );
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1)\n  (symbol \"A\"))))\n" ) );
+
+    // Unterminated string
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1)\n  (symbol \"A)\n)\n" ) );
+
+    // Something other than a symbol after the first symbol
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1)\n  (symbol \"A\")\n  (foo)\n)\n" ) );
+
+    // Content after the library
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1)\n  (symbol \"A\")\n) x\n" ) );
+
+    // No symbols
+    BOOST_CHECK( !split( "(kicad_symbol_lib (version 1) (generator x))\n" ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,325 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Regression tests for annotation and back annotation, which look references up through
+ * indices rather than by scanning the reference lists
+ */
+
+#include <map>
+#include <set>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+#include "eeschema_test_utils.h"
+
+// Code under test
+#include <reporter.h>
+#include <sch_reference_list.h>
+#include <sch_sheet_path.h>
+#include <sch_symbol.h>
+#include <tools/backannotate.h>
+
+
+/**
+ * A reporter keeping the messages of each severity.
+ */
+class TEST_REPORTER : public REPORTER
+{
+public:
+    REPORTER& Report( const wxString& aText, SEVERITY aSeverity ) override
+    {
+        m_messages[aSeverity].push_back( aText );
+        return *this;
+    }
+
+    bool HasMessage() const override { return !m_messages.empty(); }
+
+    size_t Count( SEVERITY aSeverity ) const
+    {
+        auto it = m_messages.find( aSeverity );
+        return it == m_messages.end() ? 0 : it->second.size();
+    }
+
+    std::map<SEVERITY, std::vector<wxString>> m_messages;
+};
+
+
+class TEST_ANNOTATION_FIXTURE : public KI_TEST::SCHEMATIC_TEST_FIXTURE
+{
+protected:
+    /**
+     * The references of the (non power) symbols, split into prefix and number.
+     */
+    SCH_REFERENCE_LIST getReferences()
+    {
+        SCH_REFERENCE_LIST refs;
+
+        m_schematic.GetSheets().GetSymbols( refs, false );
+        refs.SplitReferences();
+
+        return refs;
+    }
+
+    /**
+     * Annotate the symbols without a reference number, incrementally, as the annotation
+     * dialog does.
+     */
+    void annotate( const SCH_MULTI_UNIT_REFERENCE_MAP& aLockedUnits )
+    {
+        SCH_REFERENCE_LIST refs;
+
+        m_schematic.GetSheets().GetSymbols( refs, false );
+        refs.SplitReferences();
+        refs.SortByXCoordinate();
+        refs.Annotate( false, 0, 1, aLockedUnits, SCH_REFERENCE_LIST() );
+
+        for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+            refs[ii].Annotate();
+    }
+
+    ///< Check there are no unannotated symbols, duplicates or mismatched units
+    void checkAnnotation()
+    {
+        SCH_REFERENCE_LIST refs;
+
+        m_schematic.GetSheets().GetSymbols( refs, false );
+
+        int errors = refs.CheckAnnotation(
+                []( ERCE_T aType, const wxString& aMsg, SCH_REFERENCE* aItemA,
+                    SCH_REFERENCE* aItemB )
+                {
+                    BOOST_TEST_MESSAGE( aMsg );
+                } );
+
+        BOOST_CHECK_EQUAL( errors, 0 );
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( Annotation, TEST_ANNOTATION_FIXTURE )
+
+
+/**
+ * Annotating a schematic from scratch must number each prefix 1..n without gaps, and keep
+ * the units of each multi-unit package under one reference.
+ */
+BOOST_AUTO_TEST_CASE( ReannotateAll )
+{
+    loadSchematic( "complex_hierarchy" );
+
+    SCH_MULTI_UNIT_REFERENCE_MAP lockedUnits;
+    SCH_REFERENCE_LIST           refs = getReferences();
+
+    m_schematic.GetSheets().GetMultiUnitSymbols( lockedUnits );
+    BOOST_REQUIRE( !lockedUnits.empty() );
+
+    for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+        refs[ii].GetSymbol()->ClearAnnotation( &refs[ii].GetSheetPath(), false );
+
+    annotate( lockedUnits );
+    checkAnnotation();
+
+    refs = getReferences();
+
+    std::map<wxString, std::set<wxString>> numbersByPrefix;
+
+    for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+        numbersByPrefix[refs[ii].GetRef()].insert( refs[ii].GetRefNumber() );
+
+    for( const std::pair<const wxString, std::set<wxString>>& prefix : numbersByPrefix )
+    {
+        for( size_t number = 1; number <= prefix.second.size(); ++number )
+        {
+            BOOST_CHECK_MESSAGE( prefix.second.count( wxString::Format( "%zu", number ) ),
+                                 prefix.first << number << " is not used" );
+        }
+    }
+
+    // The units annotated together before must still share a reference
+    for( const std::pair<const wxString, SCH_REFERENCE_LIST>& package : lockedUnits )
+    {
+        const SCH_REFERENCE_LIST& units = package.second;
+        const SCH_REFERENCE&      first = units[0];
+        wxString                  ref = first.GetSymbol()->GetRef( &first.GetSheetPath() );
+
+        for( size_t ii = 1; ii < units.GetCount(); ++ii )
+        {
+            BOOST_CHECK_EQUAL( units[ii].GetSymbol()->GetRef( &units[ii].GetSheetPath() ),
+                               ref );
+        }
+    }
+}
+
+
+/**
+ * Annotating only the symbols which lost their reference must keep every other reference,
+ * and fill the lowest free numbers of each prefix.
+ */
+BOOST_AUTO_TEST_CASE( KeepExistingReferences )
+{
+    loadSchematic( "complex_hierarchy" );
+
+    SCH_MULTI_UNIT_REFERENCE_MAP  lockedUnits;
+    SCH_REFERENCE_LIST            refs = getReferences();
+    std::map<wxString, wxString>  kept;
+    std::map<wxString, int>       clearedByPrefix;
+    std::map<wxString, std::set<long>> usedByPrefix;
+
+    m_schematic.GetSheets().GetMultiUnitSymbols( lockedUnits );
+
+    for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+    {
+        SCH_REFERENCE& ref = refs[ii];
+
+        // Clear every third single unit symbol
+        if( ref.GetSymbol()->GetUnitCount() == 1 && ii % 3 == 0 )
+        {
+            ref.GetSymbol()->ClearAnnotation( &ref.GetSheetPath(), false );
+            clearedByPrefix[ref.GetRef()]++;
+        }
+        else
+        {
+            long number;
+
+            kept[ref.GetPath()] = ref.GetSymbol()->GetRef( &ref.GetSheetPath() );
+
+            if( ref.GetRefNumber().ToLong( &number ) )
+                usedByPrefix[ref.GetRef()].insert( number );
+        }
+    }
+
+    BOOST_REQUIRE( !clearedByPrefix.empty() );
+
+    annotate( lockedUnits );
+    checkAnnotation();
+
+    refs = getReferences();
+
+    std::map<wxString, std::set<long>> newByPrefix;
+
+    for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+    {
+        SCH_REFERENCE& ref = refs[ii];
+        auto           it = kept.find( ref.GetPath() );
+        long           number;
+
+        if( it != kept.end() )
+            BOOST_CHECK_EQUAL( ref.GetSymbol()->GetRef( &ref.GetSheetPath() ), it->second );
+        else if( ref.GetRefNumber().ToLong( &number ) )
+            newByPrefix[ref.GetRef()].insert( number );
+    }
+
+    for( const std::pair<const wxString, int>& prefix : clearedByPrefix )
+    {
+        const std::set<long>& used = usedByPrefix[prefix.first];
+        std::set<long>        expected;
+
+        for( long number = 1; (int) expected.size() < prefix.second; ++number )
+        {
+            if( !used.count( number ) )
+                expected.insert( number );
+        }
+
+        BOOST_CHECK_MESSAGE( newByPrefix[prefix.first] == expected,
+                             prefix.first << " didn't get the lowest free numbers" );
+    }
+}
+
+
+/**
+ * Back annotation must find the symbols of each footprint by path and by reference, with all
+ * the units of multi-unit packages.
+ */
+BOOST_AUTO_TEST_CASE( BackAnnotate )
+{
+    loadSchematic( "complex_hierarchy" );
+
+    SCH_REFERENCE_LIST refs;
+
+    m_schematic.GetSheets().GetSymbols( refs, false );
+
+    for( bool byReference : { false, true } )
+    {
+        // One footprint per package, with a new footprint; every other package also gets a
+        // new value
+        std::set<wxString> packages;
+        std::set<wxString> newValues;
+        std::string        netlist = "(pcb_netlist\n";
+        size_t             expectedFootprintChanges = 0;
+        size_t             expectedValueChanges = 0;
+
+        for( size_t ii = 0; ii < refs.GetCount(); ++ii )
+        {
+            const SCH_REFERENCE& ref = refs[ii];
+            wxString             refDes = ref.GetSymbol()->GetRef( &ref.GetSheetPath() );
+
+            if( packages.insert( refDes ).second )
+            {
+                wxString value = ref.GetValue();
+
+                if( packages.size() % 2 )
+                {
+                    value += wxT( "_new" );
+                    newValues.insert( refDes );
+                }
+
+                netlist += wxString::Format( "(ref \"%s\" (fpid \"Test:%s\") (value \"%s\") "
+                                             "(timestamp \"%s\"))\n",
+                                             refDes, refDes, value, ref.GetPath() ).ToStdString();
+            }
+
+            expectedFootprintChanges++;
+
+            if( newValues.count( refDes ) )
+                expectedValueChanges++;
+        }
+
+        netlist += "(ref \"X1\" (fpid \"Test:X1\") (value \"X\") (timestamp \"/nowhere\")))\n";
+
+        TEST_REPORTER reporter;
+        BACK_ANNOTATE backAnno( &m_schematic, reporter, byReference, true, true, false );
+
+        BOOST_REQUIRE( backAnno.BackAnnotateSymbols( netlist ) );
+
+        size_t footprintChanges = 0;
+        size_t valueChanges = 0;
+
+        for( const wxString& msg : reporter.m_messages[RPT_SEVERITY_ACTION] )
+        {
+            if( msg.Contains( wxT( "footprint assignment" ) ) )
+                footprintChanges++;
+            else if( msg.Contains( wxT( "value from" ) ) )
+                valueChanges++;
+        }
+
+        BOOST_CHECK_EQUAL( footprintChanges, expectedFootprintChanges );
+        BOOST_CHECK_EQUAL( valueChanges, expectedValueChanges );
+
+        // The footprint without a symbol
+        BOOST_CHECK_EQUAL( reporter.Count( RPT_SEVERITY_ERROR ), 1 );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,117 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the pin-to-pin ERC test, which tests the nets on several threads
+ */
+
+#include <algorithm>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+#include "eeschema_test_utils.h"
+
+// Code under test
+#include <erc.h>
+#include <erc_settings.h>
+#include <sch_marker.h>
+#include <sch_screen.h>
+
+
+class TEST_ERC_PIN_TO_PIN_FIXTURE : public KI_TEST::SCHEMATIC_TEST_FIXTURE
+{
+protected:
+    /**
+     * Run the pin-to-pin test and describe the markers it added, sorted as the RTree of the
+     * screens doesn't keep them in insertion order.
+     */
+    std::vector<wxString> runTest( bool aParallel )
+    {
+        SCH_SCREENS screens( m_schematic.Root() );
+        ERC_TESTER  tester( &m_schematic );
+
+        screens.DeleteAllMarkers( MARKER_BASE::MARKER_ERC, true );
+
+        int                   errors = tester.TestPinToPin( aParallel );
+        std::vector<wxString> markers;
+
+        for( SCH_SCREEN* screen = screens.GetFirst(); screen; screen = screens.GetNext() )
+        {
+            for( SCH_ITEM* item : screen->Items().OfType( SCH_MARKER_T ) )
+            {
+                SCH_MARKER*              marker = static_cast<SCH_MARKER*>( item );
+                std::shared_ptr<RC_ITEM> rcItem = marker->GetRCItem();
+
+                markers.push_back( wxString::Format( wxT( "%s %d %d,%d %s %s %s" ),
+                                                     screen->GetFileName(),
+                                                     rcItem->GetErrorCode(),
+                                                     marker->GetPosition().x,
+                                                     marker->GetPosition().y,
+                                                     rcItem->GetMainItemID().AsString(),
+                                                     rcItem->GetAuxItemID().AsString(),
+                                                     rcItem->GetErrorMessage() ) );
+            }
+        }
+
+        BOOST_CHECK_EQUAL( errors, (int) markers.size() );
+
+        std::sort( markers.begin(), markers.end() );
+
+        return markers;
+    }
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ErcPinToPin, TEST_ERC_PIN_TO_PIN_FIXTURE )
+
+
+/**
+ * The nets tested on several threads must give the same markers, messages included, as when
+ * tested on the calling thread.
+ */
+BOOST_AUTO_TEST_CASE( SerialParallel )
+{
+    loadSchematic( "video" );
+
+    // Make sure there are plenty of pin-to-pin markers, with their pin type names
+    m_schematic.ErcSettings().SetPinMapValue( ELECTRICAL_PINTYPE::PT_PASSIVE,
+                                              ELECTRICAL_PINTYPE::PT_PASSIVE,
+                                              PIN_ERROR::WARNING );
+
+    std::vector<wxString> serial = runTest( false );
+
+    BOOST_REQUIRE( !serial.empty() );
+
+    for( int ii = 0; ii < 3; ++ii )
+    {
+        std::vector<wxString> parallel = runTest( true );
+
+        BOOST_REQUIRE_EQUAL( parallel.size(), serial.size() );
+
+        for( size_t jj = 0; jj < serial.size(); ++jj )
+            BOOST_CHECK_EQUAL( parallel[jj], serial[jj] );
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
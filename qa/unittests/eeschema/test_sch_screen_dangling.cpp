@@ -0,0 +1,157 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the incremental dangling end test of SCH_SCREEN
+ */
+
+#include <random>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+// Code under test
+#include <sch_label.h>
+#include <sch_line.h>
+#include <sch_screen.h>
+
+
+class TEST_SCH_SCREEN_DANGLING_FIXTURE
+{
+public:
+    TEST_SCH_SCREEN_DANGLING_FIXTURE() :
+            m_rng( 1234 )
+    {
+    }
+
+    VECTOR2I randomPoint()
+    {
+        // A coarse grid, so that end points often meet
+        std::uniform_int_distribution<int> coord( 0, 15 );
+
+        return VECTOR2I( coord( m_rng ) * GRID, coord( m_rng ) * GRID );
+    }
+
+    /**
+     * Run a full test and return the number of items it changed, ie: that the previous test
+     * left in a wrong state.
+     */
+    int countStaleItems()
+    {
+        int                              changed = 0;
+        std::function<void( SCH_ITEM* )> handler = [&]( SCH_ITEM* ) { changed++; };
+
+        m_screen.TestDanglingEnds( nullptr, &handler );
+        return changed;
+    }
+
+    static constexpr int GRID = 2540;
+
+    SCH_SCREEN              m_screen;
+    std::vector<SCH_LINE*>  m_wires;
+    std::vector<SCH_LABEL*> m_labels;
+    std::mt19937            m_rng;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( SchScreenDangling, TEST_SCH_SCREEN_DANGLING_FIXTURE )
+
+
+/**
+ * Moving items through Remove()/Append() or Update() then running the incremental test
+ * must leave every item in the state a full test gives.
+ */
+BOOST_AUTO_TEST_CASE( IncrementalMatchesFull )
+{
+    for( int ii = 0; ii < 200; ii++ )
+    {
+        SCH_LINE* wire = new SCH_LINE( randomPoint(), LAYER_WIRE );
+        wire->SetEndPoint( randomPoint() );
+        m_screen.Append( wire );
+        m_wires.push_back( wire );
+    }
+
+    for( int ii = 0; ii < 50; ii++ )
+    {
+        SCH_LABEL* label = new SCH_LABEL( randomPoint(), wxString::Format( "N%d", ii ) );
+        m_screen.Append( label );
+        m_labels.push_back( label );
+    }
+
+    m_screen.TestDanglingEnds();
+
+    std::uniform_int_distribution<size_t> pickWire( 0, m_wires.size() - 1 );
+    std::uniform_int_distribution<size_t> pickLabel( 0, m_labels.size() - 1 );
+
+    // The last batch has more changes than the screen keeps track of individually
+    for( int batchSize : { 1, 3, 10, 40, 400 } )
+    {
+        BOOST_TEST_CONTEXT( "batch of " << batchSize )
+        {
+            for( int ii = 0; ii < batchSize; ii++ )
+            {
+                SCH_LINE*  wire = m_wires[ pickWire( m_rng ) ];
+                SCH_LABEL* label = m_labels[ pickLabel( m_rng ) ];
+
+                m_screen.Remove( wire );
+                wire->SetStartPoint( randomPoint() );
+                m_screen.Append( wire );
+
+                label->SetPosition( randomPoint() );
+                m_screen.Update( label );
+            }
+
+            m_screen.TestDanglingEnds( nullptr, nullptr, true );
+            BOOST_CHECK_EQUAL( countStaleItems(), 0 );
+        }
+    }
+}
+
+
+/**
+ * Deleted items must no longer be seen as connecting their neighbours.
+ */
+BOOST_AUTO_TEST_CASE( RemovalUpdatesNeighbours )
+{
+    SCH_LINE* a = new SCH_LINE( VECTOR2I( 0, 0 ), LAYER_WIRE );
+    a->SetEndPoint( VECTOR2I( 10 * GRID, 0 ) );
+
+    SCH_LINE* b = new SCH_LINE( VECTOR2I( 10 * GRID, 0 ), LAYER_WIRE );
+    b->SetEndPoint( VECTOR2I( 10 * GRID, 10 * GRID ) );
+
+    m_screen.Append( a );
+    m_screen.Append( b );
+    m_screen.TestDanglingEnds();
+
+    BOOST_CHECK( !a->IsEndDangling() );
+    BOOST_CHECK( !b->IsStartDangling() );
+
+    m_screen.DeleteItem( b );
+    m_screen.TestDanglingEnds( nullptr, nullptr, true );
+
+    BOOST_CHECK( a->IsEndDangling() );
+    BOOST_CHECK_EQUAL( countStaleItems(), 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
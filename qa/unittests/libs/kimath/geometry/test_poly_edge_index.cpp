@@ -0,0 +1,179 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cmath>
+#include <random>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+/**
+ * A closed, star-like contour of \a aCount points around \a aCenter.
+ */
+static SHAPE_LINE_CHAIN wobblyRing( std::mt19937& aRng, const VECTOR2I& aCenter, int aRadius,
+                                    int aCount )
+{
+    std::uniform_real_distribution<double> wobble( 0.7, 1.0 );
+    SHAPE_LINE_CHAIN                       chain;
+
+    for( int i = 0; i < aCount; i++ )
+    {
+        double angle = 2.0 * M_PI * i / aCount;
+        double r = aRadius * wobble( aRng );
+
+        chain.Append( aCenter.x + KiROUND( r * cos( angle ) ),
+                      aCenter.y + KiROUND( r * sin( angle ) ) );
+    }
+
+    chain.SetClosed( true );
+    return chain;
+}
+
+
+BOOST_AUTO_TEST_SUITE( PolyEdgeIndex )
+
+
+/**
+ * The indexed queries (enabled by BuildBBoxCaches()) must give the same answers as the
+ * linear scans.
+ */
+BOOST_AUTO_TEST_CASE( MatchesLinearScan )
+{
+    std::mt19937                       rng( 4321 );
+    std::uniform_int_distribution<int> coord( -1200000, 1200000 );
+
+    SHAPE_POLY_SET polySet;
+
+    // An indexed outline with an indexed hole and a hole too small to be indexed
+    polySet.AddOutline( wobblyRing( rng, { 0, 0 }, 1000000, 500 ) );
+    polySet.AddHole( wobblyRing( rng, { 200000, 0 }, 300000, 100 ) );
+    polySet.AddHole( wobblyRing( rng, { -400000, -200000 }, 100000, 8 ) );
+
+    // A second polygon, overlapping the first one's bounding box
+    polySet.AddOutline( wobblyRing( rng, { 900000, 900000 }, 400000, 200 ) );
+
+    SHAPE_POLY_SET indexed( polySet );
+    indexed.BuildBBoxCaches();
+
+    for( int q = 0; q < 5000; q++ )
+    {
+        VECTOR2I p( coord( rng ), coord( rng ) );
+        VECTOR2I p2( coord( rng ), coord( rng ) );
+
+        // Hit some vertices exactly too
+        if( q % 10 == 0 )
+            p = polySet.CVertex( q % polySet.TotalVertices() );
+
+        // ...and some short segments
+        if( q % 3 == 0 )
+            p2 = p + VECTOR2I( 1000, -500 );
+
+        BOOST_TEST_CONTEXT( "query " << q << " at " << p )
+        {
+            for( int accuracy : { 0, 1, 5000 } )
+            {
+                BOOST_CHECK_EQUAL( indexed.Contains( p, -1, accuracy, true ),
+                                   polySet.Contains( p, -1, accuracy ) );
+            }
+
+            VECTOR2I    nearest;
+            SEG::ecoord dist = indexed.SquaredDistance( p, &nearest, true );
+
+            BOOST_CHECK_EQUAL( dist, polySet.SquaredDistance( p ) );
+            BOOST_CHECK_EQUAL( ( nearest - p ).SquaredEuclideanNorm(), dist );
+
+            BOOST_CHECK_EQUAL( indexed.SquaredDistance( SEG( p, p2 ), nullptr, true ),
+                               polySet.SquaredDistance( SEG( p, p2 ) ) );
+        }
+    }
+}
+
+
+/**
+ * BuildBBoxCaches() must not reuse an index built for different outlines.
+ */
+BOOST_AUTO_TEST_CASE( RebuiltAfterEdit )
+{
+    std::mt19937   rng( 99 );
+    SHAPE_POLY_SET polySet;
+
+    polySet.AddOutline( wobblyRing( rng, { 0, 0 }, 1000000, 200 ) );
+    polySet.CacheTriangulation();
+    polySet.BuildBBoxCaches();
+
+    BOOST_CHECK( polySet.Contains( { 0, 0 }, -1, 0, true ) );
+
+    polySet.Move( { 5000000, 0 } );
+    polySet.BuildBBoxCaches();
+
+    BOOST_CHECK( !polySet.Contains( { 0, 0 }, -1, 0, true ) );
+    BOOST_CHECK( polySet.Contains( { 5000000, 0 }, -1, 0, true ) );
+
+    polySet.SetVertex( 0, { 8000000, 0 } );
+    polySet.BuildBBoxCaches();
+
+    BOOST_CHECK( polySet.Contains( { 7000000, 0 }, -1, 0, true ) );
+}
+
+
+/**
+ * Queries through an index that predates an edit (without a new BuildBBoxCaches()) must stay
+ * within the edited polygons, and give the linear results for the contours that changed size
+ * or were added.
+ */
+BOOST_AUTO_TEST_CASE( StaleIndexFallsBack )
+{
+    std::mt19937                       rng( 1357 );
+    std::uniform_int_distribution<int> coord( -1200000, 1200000 );
+    SHAPE_POLY_SET                     polySet;
+
+    polySet.AddOutline( wobblyRing( rng, { 0, 0 }, 1000000, 300 ) );
+    polySet.BuildBBoxCaches();
+
+    polySet.Append( 1100000, 0, 0 );
+    polySet.AddHole( wobblyRing( rng, { 0, 0 }, 300000, 100 ) );
+    polySet.AddOutline( wobblyRing( rng, { 0, 0 }, 100000, 100 ) );
+
+    SHAPE_POLY_SET linear( polySet );
+
+    for( int q = 0; q < 1000; q++ )
+    {
+        VECTOR2I p( coord( rng ), coord( rng ) );
+        VECTOR2I p2 = p + VECTOR2I( 20000, 10000 );
+
+        BOOST_TEST_CONTEXT( "query " << q << " at " << p )
+        {
+            BOOST_CHECK_EQUAL( polySet.Contains( p, -1, 0, true ), linear.Contains( p ) );
+            BOOST_CHECK_EQUAL( polySet.SquaredDistance( p, nullptr, true ),
+                               linear.SquaredDistance( p ) );
+            BOOST_CHECK_EQUAL( polySet.SquaredDistance( SEG( p, p2 ), nullptr, true ),
+                               linear.SquaredDistance( SEG( p, p2 ) ) );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,162 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <random>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <geometry/polyline_kernels.h>
+#include <geometry/shape_line_chain.h>
+#include <math/util.h>
+
+
+/**
+ * Reference implementations, written in terms of SEG as the generic
+ * SHAPE_LINE_CHAIN_BASE code does.
+ */
+static bool refContains( const std::vector<VECTOR2I>& aPts, const VECTOR2I& aP )
+{
+    bool inside = false;
+
+    for( size_t i = 0; i < aPts.size(); i++ )
+    {
+        const VECTOR2I& p1 = aPts[i];
+        const VECTOR2I& p2 = aPts[( i + 1 ) % aPts.size()];
+        const VECTOR2I  diff = p2 - p1;
+
+        if( diff.y != 0 )
+        {
+            const int d = rescale( diff.x, ( aP.y - p1.y ), diff.y );
+
+            if( ( ( p1.y > aP.y ) != ( p2.y > aP.y ) ) && ( aP.x - p1.x < d ) )
+                inside = !inside;
+        }
+    }
+
+    return inside;
+}
+
+
+static SEG::ecoord refSquaredDistance( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP )
+{
+    SEG::ecoord d = VECTOR2I::ECOORD_MAX;
+
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+        d = std::min( d, aChain.CSegment( s ).SquaredDistance( aP ) );
+
+    return d;
+}
+
+
+static int refEdgeWithin( const SHAPE_LINE_CHAIN& aChain, const VECTOR2I& aP, int aDist )
+{
+    for( int s = 0; s < aChain.SegmentCount(); s++ )
+    {
+        const SEG seg = aChain.CSegment( s );
+
+        if( seg.A == aP || seg.B == aP || seg.Distance( aP ) <= aDist )
+            return s;
+    }
+
+    return -1;
+}
+
+
+/**
+ * Compare the kernels with the SEG based reference on random polylines and points with
+ * coordinates up to \a aRange
+ */
+static void checkRandomPolylines( int aRange, unsigned aSeed )
+{
+    std::mt19937                       rng( aSeed );
+    std::uniform_int_distribution<int> coord( -aRange, aRange );
+    std::uniform_int_distribution<int> count( 1, 40 );
+
+    for( int iter = 0; iter < 200; iter++ )
+    {
+        std::vector<VECTOR2I> pts;
+        int                   n = count( rng );
+
+        for( int i = 0; i < n; i++ )
+            pts.emplace_back( coord( rng ), coord( rng ) );
+
+        for( bool closed : { false, true } )
+        {
+            SHAPE_LINE_CHAIN chain( pts, closed );
+
+            // Append() may have dropped duplicate points
+            const std::vector<VECTOR2I>& cpts = chain.CPoints();
+
+            for( int q = 0; q < 20; q++ )
+            {
+                VECTOR2I p( coord( rng ), coord( rng ) );
+
+                // Hit some vertices exactly too
+                if( q % 5 == 0 )
+                    p = cpts[q % cpts.size()];
+
+                BOOST_TEST_CONTEXT( "iter " << iter << " closed " << closed << " query " << q )
+                {
+                    if( closed && cpts.size() >= 3 )
+                    {
+                        BOOST_CHECK_EQUAL( PolylineContainsPoint( cpts.data(), cpts.size(), p ),
+                                           refContains( cpts, p ) );
+                    }
+
+                    BOOST_CHECK_EQUAL( PolylineSquaredDistance( cpts.data(), cpts.size(), closed,
+                                                                p ),
+                                       refSquaredDistance( chain, p ) );
+
+                    for( int dist : { 0, aRange / 100, aRange / 5 } )
+                    {
+                        BOOST_CHECK_EQUAL( PolylineEdgeWithin( cpts.data(), cpts.size(), closed,
+                                                               p, dist ),
+                                           refEdgeWithin( chain, p, dist ) );
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE( PolylineKernels )
+
+
+BOOST_AUTO_TEST_CASE( MatchesReference )
+{
+    checkRandomPolylines( 100000, 1234 );
+}
+
+
+/**
+ * Coordinates of a large board, where the squared distances no longer fit the
+ * mantissa of the double precision bounding box test
+ */
+BOOST_AUTO_TEST_CASE( MatchesReferenceLargeCoords )
+{
+    checkRandomPolylines( 300000000, 4321 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
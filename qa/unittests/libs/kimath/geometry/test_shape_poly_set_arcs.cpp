@@ -170,4 +170,70 @@ BOOST_AUTO_TEST_CASE( TestClearArcs )
     }
 }
 
+
+/**
+ * Test SHAPE_POLY_SET::Inflate keeping the rounded corners as arcs
+ */
+BOOST_AUTO_TEST_CASE( TestInflatePreserveArcs )
+{
+    const int amount = 100000;
+    const int segCount = 32;
+
+    struct TEST_CASE
+    {
+        std::string    m_name;
+        int            m_amount;
+        SHAPE_POLY_SET m_poly;
+        size_t         m_expectedArcs;
+    };
+
+    SHAPE_POLY_SET square;
+    square.NewOutline();
+    square.Append( 0, 0 );
+    square.Append( 1000000, 0 );
+    square.Append( 1000000, 1000000 );
+    square.Append( 0, 1000000 );
+
+    SHAPE_POLY_SET lShape;
+    lShape.NewOutline();
+    lShape.Append( 0, 0 );
+    lShape.Append( 2000000, 0 );
+    lShape.Append( 2000000, 1000000 );
+    lShape.Append( 1000000, 1000000 );
+    lShape.Append( 1000000, 2000000 );
+    lShape.Append( 0, 2000000 );
+
+    std::vector<TEST_CASE> cases = {
+        { "Inflate square", amount, square, 4 },
+        { "Deflate L shape", -amount, lShape, 1 }, // only the reflex corner is rounded
+    };
+
+    for( const TEST_CASE& c : cases )
+    {
+        BOOST_TEST_CONTEXT( c.m_name )
+        {
+            SHAPE_POLY_SET withArcs = c.m_poly;
+            SHAPE_POLY_SET withoutArcs = c.m_poly;
+
+            withArcs.Inflate( c.m_amount, segCount, SHAPE_POLY_SET::ROUND_ALL_CORNERS, true );
+            withoutArcs.Inflate( c.m_amount, segCount, SHAPE_POLY_SET::ROUND_ALL_CORNERS );
+
+            BOOST_CHECK( GEOM_TEST::IsPolySetValid( withArcs ) );
+            BOOST_CHECK_EQUAL( withoutArcs.ArcCount(), 0 );
+            BOOST_CHECK_EQUAL( withArcs.Area(), withoutArcs.Area() );
+
+            std::vector<SHAPE_ARC> arcs;
+            withArcs.GetArcs( arcs );
+
+            BOOST_REQUIRE_EQUAL( arcs.size(), c.m_expectedArcs );
+
+            for( const SHAPE_ARC& arc : arcs )
+            {
+                BOOST_CHECK_CLOSE( arc.GetRadius(), std::abs( c.m_amount ), 0.01 );
+                BOOST_CHECK_CLOSE( std::abs( arc.GetCentralAngle().AsDegrees() ), 90.0, 0.01 );
+            }
+        }
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
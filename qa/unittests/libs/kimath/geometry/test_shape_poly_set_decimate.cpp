@@ -0,0 +1,92 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cmath>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+static SHAPE_LINE_CHAIN circle( const VECTOR2I& aCenter, int aRadius, int aPoints )
+{
+    SHAPE_LINE_CHAIN chain;
+
+    for( int ii = 0; ii < aPoints; ii++ )
+    {
+        double angle = 2.0 * M_PI * ii / aPoints;
+        chain.Append( aCenter.x + KiROUND( aRadius * cos( angle ) ),
+                      aCenter.y + KiROUND( aRadius * sin( angle ) ) );
+    }
+
+    chain.SetClosed( true );
+    return chain;
+}
+
+
+BOOST_AUTO_TEST_SUITE( PolySetDecimate )
+
+
+BOOST_AUTO_TEST_CASE( StaysWithinTolerance )
+{
+    const int      tolerance = 10000;
+    SHAPE_POLY_SET polySet;
+
+    polySet.AddOutline( circle( { 0, 0 }, 10000000, 2000 ) );
+    polySet.AddHole( circle( { 0, 0 }, 5000000, 1000 ) );
+
+    SHAPE_POLY_SET decimated = polySet.Decimate( tolerance );
+
+    BOOST_REQUIRE_EQUAL( decimated.OutlineCount(), 1 );
+    BOOST_REQUIRE_EQUAL( decimated.HoleCount( 0 ), 1 );
+    BOOST_CHECK_LT( decimated.FullPointCount(), polySet.FullPointCount() / 4 );
+
+    SHAPE_POLY_SET::VERTEX_INDEX dummy;
+
+    // Every original vertex is within the tolerance of the decimated contours...
+    for( auto it = polySet.CIterateWithHoles(); it; it++ )
+        BOOST_CHECK( decimated.CollideEdge( *it, dummy, tolerance + 1 ) );
+
+    // ... and the kept vertices are original ones
+    for( auto it = decimated.CIterateWithHoles(); it; it++ )
+        BOOST_CHECK( polySet.CollideVertex( *it, dummy, 0 ) );
+}
+
+
+BOOST_AUTO_TEST_CASE( DropsCollapsedContours )
+{
+    SHAPE_POLY_SET polySet;
+
+    polySet.AddOutline( circle( { 0, 0 }, 10000000, 100 ) );
+    polySet.AddOutline( circle( { 50000000, 0 }, 1000, 100 ) );
+    polySet.AddHole( circle( { 0, 0 }, 500, 50 ), 0 );
+
+    SHAPE_POLY_SET decimated = polySet.Decimate( 10000 );
+
+    BOOST_CHECK_EQUAL( decimated.OutlineCount(), 1 );
+    BOOST_CHECK_EQUAL( decimated.HoleCount( 0 ), 0 );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,276 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <cmath>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <geometry/shape_line_chain.h>
+#include <geometry/shape_poly_set.h>
+
+
+/**
+ * A set of \a aCount disjoint, wavy-edged outlines of about 4cm x 1cm (in nm), each with
+ * \a aPoints points.
+ */
+static SHAPE_POLY_SET wavyStrips( int aCount, int aPoints )
+{
+    SHAPE_POLY_SET polySet;
+
+    for( int ii = 0; ii < aCount; ii++ )
+    {
+        SHAPE_LINE_CHAIN strip;
+        int              y0 = ii * 20000000;
+        int              half = aPoints / 2;
+
+        for( int jj = 0; jj < half; jj++ )
+        {
+            int x = 40000000LL * jj / ( half - 1 );
+            strip.Append( x, y0 + KiROUND( 500000 * sin( jj * 0.3 ) ) );
+        }
+
+        for( int jj = half - 1; jj >= 0; jj-- )
+        {
+            int x = 40000000LL * jj / ( half - 1 );
+            strip.Append( x, y0 + 10000000 + KiROUND( 500000 * cos( jj * 0.2 ) ) );
+        }
+
+        strip.SetClosed( true );
+        polySet.AddOutline( strip );
+    }
+
+    return polySet;
+}
+
+
+static double triangulatedArea( const SHAPE_POLY_SET& aPolySet, int aOutline )
+{
+    double area = 0.0;
+
+    for( unsigned ii = 0; ii < aPolySet.TriangulatedPolyCount(); ii++ )
+    {
+        const SHAPE_POLY_SET::TRIANGULATED_POLYGON* tri = aPolySet.TriangulatedPolygon( ii );
+
+        if( tri->GetSourceOutlineIndex() != aOutline )
+            continue;
+
+        for( size_t jj = 0; jj < tri->GetTriangleCount(); jj++ )
+        {
+            VECTOR2I a, b, c;
+            tri->GetTriangle( jj, a, b, c );
+            area += std::abs( VECTOR2D( b - a ).Cross( VECTOR2D( c - a ) ) ) / 2.0;
+        }
+    }
+
+    return area;
+}
+
+
+static std::vector<const SHAPE_POLY_SET::TRIANGULATED_POLYGON*>
+triangulationOf( const SHAPE_POLY_SET& aPolySet, int aOutline )
+{
+    std::vector<const SHAPE_POLY_SET::TRIANGULATED_POLYGON*> tris;
+
+    for( unsigned ii = 0; ii < aPolySet.TriangulatedPolyCount(); ii++ )
+    {
+        if( aPolySet.TriangulatedPolygon( ii )->GetSourceOutlineIndex() == aOutline )
+            tris.push_back( aPolySet.TriangulatedPolygon( ii ) );
+    }
+
+    return tris;
+}
+
+
+static void checkCovers( const SHAPE_POLY_SET& aPolySet )
+{
+    BOOST_REQUIRE( aPolySet.IsTriangulationUpToDate() );
+
+    for( int ii = 0; ii < aPolySet.OutlineCount(); ii++ )
+    {
+        BOOST_TEST_CONTEXT( "outline " << ii )
+        {
+            double expected = std::abs( aPolySet.COutline( ii ).Area() );
+
+            BOOST_CHECK_CLOSE( triangulatedArea( aPolySet, ii ), expected, 0.001 );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE( ShapePolySetTriangulation )
+
+
+/**
+ * Large sets are partitioned and triangulated on several threads; the result must still
+ * cover each outline exactly.
+ */
+BOOST_AUTO_TEST_CASE( ParallelPartitions )
+{
+    SHAPE_POLY_SET polySet = wavyStrips( 12, 4000 );
+
+    polySet.CacheTriangulation();
+    checkCovers( polySet );
+
+    // Each strip spans several 1cm cells
+    BOOST_CHECK_GT( polySet.TriangulatedPolyCount(), 12 );
+}
+
+
+/**
+ * Editing one outline must only re-triangulate that outline.
+ */
+BOOST_AUTO_TEST_CASE( KeepsUnchangedOutlines )
+{
+    SHAPE_POLY_SET polySet = wavyStrips( 4, 200 );
+
+    polySet.CacheTriangulation();
+
+    auto nudge =
+            [&]( int aOutline )
+            {
+                SHAPE_POLY_SET::VERTEX_INDEX index;
+                index.m_polygon = aOutline;
+                index.m_contour = 0;
+                index.m_vertex = 10;
+
+                polySet.SetVertex( index, polySet.CVertex( index ) + VECTOR2I( 0, -100000 ) );
+            };
+
+    auto before0 = triangulationOf( polySet, 0 );
+    auto before3 = triangulationOf( polySet, 3 );
+
+    nudge( 2 );
+    polySet.CacheTriangulation();
+    checkCovers( polySet );
+
+    // Same objects, not just equal ones
+    BOOST_CHECK( triangulationOf( polySet, 0 ) == before0 );
+    BOOST_CHECK( triangulationOf( polySet, 3 ) == before3 );
+
+    // Removing an outline renumbers the others but keeps their triangles
+    polySet.DeletePolygonAndTriangulationData( 1 );
+    nudge( 0 );
+    polySet.CacheTriangulation();
+    checkCovers( polySet );
+
+    BOOST_CHECK( triangulationOf( polySet, 2 ) == before3 );
+}
+
+
+/**
+ * Triangles can be carried over from a previous version of the set (eg: a zone refill).
+ */
+BOOST_AUTO_TEST_CASE( ReusesHintData )
+{
+    SHAPE_POLY_SET previous = wavyStrips( 3, 200 );
+    previous.CacheTriangulation();
+
+    // Same outlines in a different order, plus a new one
+    SHAPE_POLY_SET refill;
+    refill.AddOutline( previous.COutline( 2 ) );
+    refill.AddOutline( previous.COutline( 0 ) );
+    refill.AddOutline( wavyStrips( 4, 100 ).COutline( 3 ) );
+
+    refill.CacheTriangulation( true, &previous );
+    checkCovers( refill );
+
+    auto reused = triangulationOf( refill, 0 );
+    auto original = triangulationOf( previous, 2 );
+
+    BOOST_REQUIRE_EQUAL( reused.size(), original.size() );
+
+    for( size_t ii = 0; ii < reused.size(); ii++ )
+    {
+        BOOST_REQUIRE_EQUAL( reused[ii]->GetTriangleCount(), original[ii]->GetTriangleCount() );
+
+        for( size_t jj = 0; jj < reused[ii]->GetTriangleCount(); jj++ )
+        {
+            VECTOR2I a, b, c, d, e, f;
+            reused[ii]->GetTriangle( jj, a, b, c );
+            original[ii]->GetTriangle( jj, d, e, f );
+
+            BOOST_CHECK( a == d && b == e && c == f );
+        }
+    }
+
+    // The previous version is left as it was
+    BOOST_CHECK_EQUAL( triangulationOf( previous, 2 ).size(), original.size() );
+}
+
+
+/**
+ * Rotating or mirroring a set transforms its triangles rather than re-triangulating.
+ */
+BOOST_AUTO_TEST_CASE( TransformsKeepTriangulation )
+{
+    SHAPE_POLY_SET polySet = wavyStrips( 2, 200 );
+
+    polySet.CacheTriangulation();
+
+    auto before = triangulationOf( polySet, 1 );
+
+    polySet.Rotate( EDA_ANGLE( 30.0, DEGREES_T ), VECTOR2I( 1000000, 2000000 ) );
+    checkCovers( polySet );
+
+    polySet.Mirror( true, false, VECTOR2I( 5000000, 0 ) );
+    checkCovers( polySet );
+
+    // Still up to date, so this must not rebuild anything
+    polySet.CacheTriangulation();
+    BOOST_CHECK( triangulationOf( polySet, 1 ) == before );
+}
+
+
+/**
+ * A triangulation that was already out of date before a transform must not be revalidated
+ * by it.
+ */
+BOOST_AUTO_TEST_CASE( TransformsKeepStaleTriangulationStale )
+{
+    for( int transform = 0; transform < 3; transform++ )
+    {
+        BOOST_TEST_CONTEXT( "transform " << transform )
+        {
+            SHAPE_POLY_SET polySet = wavyStrips( 2, 200 );
+
+            polySet.CacheTriangulation();
+            polySet.SetVertex( 0, polySet.CVertex( 0 ) + VECTOR2I( 0, -3000000 ) );
+            BOOST_REQUIRE( !polySet.IsTriangulationUpToDate() );
+
+            if( transform == 0 )
+                polySet.Move( VECTOR2I( 1000000, 0 ) );
+            else if( transform == 1 )
+                polySet.Rotate( EDA_ANGLE( 30.0, DEGREES_T ), VECTOR2I( 1000000, 2000000 ) );
+            else
+                polySet.Mirror( true, false, VECTOR2I( 5000000, 0 ) );
+
+            BOOST_CHECK( !polySet.IsTriangulationUpToDate() );
+
+            polySet.CacheTriangulation();
+            checkCovers( polySet );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,245 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the binary cache of the render data of 3D models
+ */
+
+#include <boost/filesystem.hpp>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <plugins/3dapi/c3dmodel.h>
+#include <plugins/3dapi/ifsg_api.h>
+
+// Code under test
+#include <3d_cache/3d_mesh_cache.h>
+
+
+struct MESH_CACHE_FIXTURE
+{
+    MESH_CACHE_FIXTURE()
+    {
+        m_cacheDir = boost::filesystem::temp_directory_path() / "3d_mesh_cache_tst";
+        boost::filesystem::remove_all( m_cacheDir );
+        boost::filesystem::create_directories( m_cacheDir );
+
+        for( int ii = 0; ii < 20; ++ii )
+            m_sha1sum[ii] = (unsigned char) ( ii * 13 );
+
+        m_model = S3D::New3DModel();
+
+        // materials with a distinct value in every field
+        m_model->m_MaterialsSize = 2;
+        m_model->m_Materials = new SMATERIAL[2];
+
+        for( unsigned int ii = 0; ii < 2; ++ii )
+        {
+            SMATERIAL& mat = m_model->m_Materials[ii];
+            float      base = ii * 20.0f;
+
+            mat.m_Ambient = SFVEC3F( base + 0.1f, base + 0.2f, base + 0.3f );
+            mat.m_Diffuse = SFVEC3F( base + 1.1f, base + 1.2f, base + 1.3f );
+            mat.m_Emissive = SFVEC3F( base + 2.1f, base + 2.2f, base + 2.3f );
+            mat.m_Specular = SFVEC3F( base + 3.1f, base + 3.2f, base + 3.3f );
+            mat.m_Shininess = base + 4.1f;
+            mat.m_Transparency = base + 5.1f;
+        }
+
+        // one mesh with every optional array, one with none of them
+        m_model->m_MeshesSize = 2;
+        m_model->m_Meshes = new SMESH[2];
+
+        for( unsigned int ii = 0; ii < 2; ++ii )
+        {
+            SMESH&       mesh = m_model->m_Meshes[ii];
+            unsigned int vertexCount = 4 + ii;
+
+            S3D::Init3DMesh( mesh );
+            mesh.m_VertexSize = vertexCount;
+            mesh.m_MaterialIdx = 1 - ii;
+            mesh.m_Positions = new SFVEC3F[vertexCount];
+
+            for( unsigned int jj = 0; jj < vertexCount; ++jj )
+            {
+                float t = (float) jj;
+
+                mesh.m_Positions[jj] = SFVEC3F( t, t * 0.5f + ii, -t );
+            }
+
+            if( ii == 0 )
+            {
+                mesh.m_Normals = new SFVEC3F[vertexCount];
+                mesh.m_Texcoords = new SFVEC2F[vertexCount];
+                mesh.m_Color = new SFVEC3F[vertexCount];
+
+                for( unsigned int jj = 0; jj < vertexCount; ++jj )
+                {
+                    float t = (float) jj;
+
+                    mesh.m_Normals[jj] = SFVEC3F( 0.0f, t * 0.25f, 1.0f );
+                    mesh.m_Texcoords[jj] = SFVEC2F( t * 0.125f, 1.0f - t * 0.125f );
+                    mesh.m_Color[jj] = SFVEC3F( t * 0.2f, 0.5f, 1.0f - t * 0.2f );
+                }
+            }
+
+            mesh.m_FaceIdxSize = 3 * ( vertexCount - 2 );
+            mesh.m_FaceIdx = new unsigned int[mesh.m_FaceIdxSize];
+
+            // a fan of triangles around the first vertex
+            for( unsigned int jj = 0; jj < vertexCount - 2; ++jj )
+            {
+                mesh.m_FaceIdx[3 * jj] = 0;
+                mesh.m_FaceIdx[3 * jj + 1] = jj + 1;
+                mesh.m_FaceIdx[3 * jj + 2] = jj + 2;
+            }
+        }
+    }
+
+    ~MESH_CACHE_FIXTURE()
+    {
+        S3D::Destroy3DModel( &m_model );
+        boost::filesystem::remove_all( m_cacheDir );
+    }
+
+    wxString cacheFile() const
+    {
+        return wxString( ( m_cacheDir / "model.3dm" ).string() );
+    }
+
+    boost::filesystem::path m_cacheDir;
+    unsigned char           m_sha1sum[20];
+    S3DMODEL*               m_model;
+};
+
+
+static void checkVec( const SFVEC3F& aActual, const SFVEC3F& aExpected )
+{
+    BOOST_CHECK_EQUAL( aActual.x, aExpected.x );
+    BOOST_CHECK_EQUAL( aActual.y, aExpected.y );
+    BOOST_CHECK_EQUAL( aActual.z, aExpected.z );
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( S3DMeshCache, MESH_CACHE_FIXTURE )
+
+
+/**
+ * A model read back from the cache has the same materials and meshes as the one written.
+ */
+BOOST_AUTO_TEST_CASE( RoundTrip )
+{
+    S3D_MESH_CACHE cache( cacheFile(), m_sha1sum );
+
+    BOOST_REQUIRE( cache.Write( *m_model, "PLUGIN:1.0" ) );
+
+    std::string pluginInfo;
+    S3DMODEL*   model = cache.Read( pluginInfo );
+
+    BOOST_REQUIRE( model );
+    BOOST_CHECK_EQUAL( pluginInfo, "PLUGIN:1.0" );
+
+    BOOST_REQUIRE_EQUAL( model->m_MaterialsSize, m_model->m_MaterialsSize );
+
+    for( unsigned int ii = 0; ii < model->m_MaterialsSize; ++ii )
+    {
+        const SMATERIAL& actual = model->m_Materials[ii];
+        const SMATERIAL& expected = m_model->m_Materials[ii];
+
+        BOOST_TEST_CONTEXT( "material " << ii )
+        {
+            checkVec( actual.m_Ambient, expected.m_Ambient );
+            checkVec( actual.m_Diffuse, expected.m_Diffuse );
+            checkVec( actual.m_Emissive, expected.m_Emissive );
+            checkVec( actual.m_Specular, expected.m_Specular );
+            BOOST_CHECK_EQUAL( actual.m_Shininess, expected.m_Shininess );
+            BOOST_CHECK_EQUAL( actual.m_Transparency, expected.m_Transparency );
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL( model->m_MeshesSize, m_model->m_MeshesSize );
+
+    for( unsigned int ii = 0; ii < model->m_MeshesSize; ++ii )
+    {
+        const SMESH& actual = model->m_Meshes[ii];
+        const SMESH& expected = m_model->m_Meshes[ii];
+
+        BOOST_TEST_CONTEXT( "mesh " << ii )
+        {
+            BOOST_REQUIRE_EQUAL( actual.m_VertexSize, expected.m_VertexSize );
+            BOOST_REQUIRE_EQUAL( actual.m_FaceIdxSize, expected.m_FaceIdxSize );
+            BOOST_CHECK_EQUAL( actual.m_MaterialIdx, expected.m_MaterialIdx );
+
+            BOOST_REQUIRE( actual.m_Positions );
+            BOOST_CHECK_EQUAL( actual.m_Normals != nullptr, expected.m_Normals != nullptr );
+            BOOST_CHECK_EQUAL( actual.m_Texcoords != nullptr, expected.m_Texcoords != nullptr );
+            BOOST_CHECK_EQUAL( actual.m_Color != nullptr, expected.m_Color != nullptr );
+
+            for( unsigned int jj = 0; jj < actual.m_VertexSize; ++jj )
+            {
+                checkVec( actual.m_Positions[jj], expected.m_Positions[jj] );
+
+                if( actual.m_Normals && expected.m_Normals )
+                    checkVec( actual.m_Normals[jj], expected.m_Normals[jj] );
+
+                if( actual.m_Texcoords && expected.m_Texcoords )
+                {
+                    BOOST_CHECK_EQUAL( actual.m_Texcoords[jj].x, expected.m_Texcoords[jj].x );
+                    BOOST_CHECK_EQUAL( actual.m_Texcoords[jj].y, expected.m_Texcoords[jj].y );
+                }
+
+                if( actual.m_Color && expected.m_Color )
+                    checkVec( actual.m_Color[jj], expected.m_Color[jj] );
+            }
+
+            BOOST_CHECK_EQUAL_COLLECTIONS( actual.m_FaceIdx,
+                                           actual.m_FaceIdx + actual.m_FaceIdxSize,
+                                           expected.m_FaceIdx,
+                                           expected.m_FaceIdx + expected.m_FaceIdxSize );
+        }
+    }
+
+    S3D::Destroy3DModel( &model );
+}
+
+
+/**
+ * The cache is not used for another model file content.
+ */
+BOOST_AUTO_TEST_CASE( Stale )
+{
+    S3D_MESH_CACHE cache( cacheFile(), m_sha1sum );
+
+    BOOST_REQUIRE( cache.Write( *m_model, "PLUGIN:1.0" ) );
+
+    m_sha1sum[0] ^= 0xff;
+
+    S3D_MESH_CACHE otherCache( cacheFile(), m_sha1sum );
+    std::string    pluginInfo;
+
+    BOOST_CHECK( otherCache.Read( pluginInfo ) == nullptr );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,446 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the four wide ray tests and the four wide BVH of the raytracer, checked
+ * against brute force loops.
+ *
+ * This file is also built with BVH_NO_SIMD to check the plain C++ version of the ray tests.
+ * The BVH itself is only checked in the default build, as the 3D viewer library it comes from
+ * is built without BVH_NO_SIMD.
+ */
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+
+#include <3d_rendering/raytracing/accelerators/container_3d.h>
+#include <3d_rendering/raytracing/hitinfo.h>
+#include <3d_rendering/raytracing/ray.h>
+#include <3d_rendering/raytracing/shapes3D/triangle_3d.h>
+
+// Code under test
+#include <3d_rendering/raytracing/accelerators/bvh_simd.h>
+
+#ifndef BVH_NO_SIMD
+#include <3d_rendering/raytracing/accelerators/bvh_pbrt.h>
+#endif
+
+
+struct BVH_SIMD_FIXTURE
+{
+    BVH_SIMD_FIXTURE() :
+            m_rng( 0x4b1cad )
+    {}
+
+    float random( float aMin, float aMax )
+    {
+        return std::uniform_real_distribution<float>( aMin, aMax )( m_rng );
+    }
+
+    SFVEC3F randomPoint( float aSize )
+    {
+        return SFVEC3F( random( -aSize, aSize ), random( -aSize, aSize ),
+                        random( -aSize, aSize ) );
+    }
+
+    /**
+     * @return a random triangle of about \a aSize around \a aCenter, flat in Z if \a aFlat.
+     */
+    TRIANGLE* randomTriangle( const SFVEC3F& aCenter, float aSize, bool aFlat )
+    {
+        SFVEC3F v[3];
+
+        for( SFVEC3F& vertex : v )
+        {
+            vertex = aCenter + randomPoint( aSize );
+
+            if( aFlat )
+                vertex.z = aCenter.z;
+        }
+
+        return new TRIANGLE( v[0], v[1], v[2] );
+    }
+
+    /**
+     * @return a ray hitting a random point of \a aTriangle, from its front side.  The ray makes
+     *         an angle from 1e-7 to about 0.1 radians with the triangle plane when \a aGrazing,
+     *         and a random one otherwise.
+     */
+    RAY rayToTriangle( const TRIANGLE& aTriangle, bool aGrazing )
+    {
+        const SFVEC3F& v0 = aTriangle.GetVertex( 0 );
+        const SFVEC3F& v1 = aTriangle.GetVertex( 1 );
+        const SFVEC3F& v2 = aTriangle.GetVertex( 2 );
+
+        // Points on the edges are the hardest to get right
+        float a = random( 0.0f, 1.0f );
+        float b = random( 0.0f, 1.0f );
+
+        if( a + b > 1.0f )
+        {
+            a = 1.0f - a;
+            b = 1.0f - b;
+        }
+
+        if( random( 0.0f, 1.0f ) < 0.2f )
+            a = 0.0f;
+
+        const SFVEC3F target = v0 + a * ( v1 - v0 ) + b * ( v2 - v0 );
+
+        // The triangle normal as computed by TRIANGLE, facing the rays it doesn't cull
+        const SFVEC3F normal = glm::normalize( glm::cross( v2 - v0, v1 - v0 ) );
+        SFVEC3F       dir;
+
+        if( aGrazing )
+        {
+            const SFVEC3F inPlane = glm::normalize( v1 - v0 );
+            const float   angle = std::pow( 10.0f, random( -7.0f, -1.0f ) );
+
+            dir = glm::normalize( inPlane - angle * normal );
+        }
+        else
+        {
+            dir = glm::normalize( randomPoint( 1.0f ) );
+
+            if( glm::dot( dir, normal ) > 0.0f )
+                dir = -dir;
+        }
+
+        RAY ray;
+        ray.Init( target - std::pow( 10.0f, random( -2.0f, 1.0f ) ) * dir, dir );
+        return ray;
+    }
+
+    std::mt19937 m_rng;
+};
+
+
+/**
+ * Intersect a ray with a box in double precision.
+ *
+ * @return 1 if the ray hits the box before \a aMaxT, 0 if it doesn't, -1 if it is too close to
+ *         call in single precision.
+ */
+static int referenceBBox( const RAY& aRay, const float aMin[3], const float aMax[3],
+                          double aMaxT )
+{
+    double nearT = -std::numeric_limits<double>::infinity();
+    double farT = std::numeric_limits<double>::infinity();
+
+    for( int axis = 0; axis < 3; ++axis )
+    {
+        const double origin = aRay.m_Origin[axis];
+        const double dir = aRay.m_Dir[axis];
+
+        // A ray lying on a face is inside the slab
+        if( dir == 0.0 )
+        {
+            if( origin < aMin[axis] || origin > aMax[axis] )
+                return 0;
+
+            continue;
+        }
+
+        double t0 = ( aMin[axis] - origin ) / dir;
+        double t1 = ( aMax[axis] - origin ) / dir;
+
+        if( t0 > t1 )
+            std::swap( t0, t1 );
+
+        nearT = std::max( nearT, t0 );
+        farT = std::min( farT, t1 );
+    }
+
+    const double margin = std::min( { std::abs( farT - nearT ), std::abs( farT ),
+                                      std::abs( aMaxT - nearT ) } );
+
+    if( margin < 1e-4 )
+        return -1;
+
+    return nearT <= farT && farT >= 0.0 && nearT < aMaxT;
+}
+
+
+BOOST_FIXTURE_TEST_SUITE( BvhSimd, BVH_SIMD_FIXTURE )
+
+
+/**
+ * IntersectBBox4 gives the same hits as a double precision slab test, for one ray against four
+ * boxes, including rays parallel to or lying on a face and rays grazing a face.
+ */
+BOOST_AUTO_TEST_CASE( BBox4 )
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    for( int ii = 0; ii < 20000; ++ii )
+    {
+        float bounds[6][4];
+
+        for( int lane = 0; lane < 4; ++lane )
+        {
+            for( int axis = 0; axis < 3; ++axis )
+            {
+                const float center = random( -1.0f, 1.0f );
+
+                // The last box is flat, as the bounds of a board layer
+                const float extent = ( lane == 3 && axis == 2 ) ? 0.0f : random( 0.0f, 0.5f );
+
+                bounds[axis][lane] = center - extent;
+                bounds[axis + 3][lane] = center + extent;
+            }
+        }
+
+        SFVEC3F origin = randomPoint( 2.0f );
+        SFVEC3F dir = randomPoint( 1.0f );
+        const int axis = ii % 3;
+
+        switch( ii % 4 )
+        {
+        case 0:
+            // Parallel to a face, with both signs of zero
+            dir[axis] = ( ii % 8 ) ? 0.0f : -0.0f;
+            break;
+
+        case 1:
+            // Lying on a face of the first box
+            origin[axis] = ( ii % 8 ) < 4 ? bounds[axis][0] : bounds[axis + 3][0];
+            dir[axis] = 0.0f;
+            break;
+
+        case 2:
+            // Grazing the top face of the flat box
+            origin.z = bounds[5][3] + random( 0.0f, 1e-3f );
+            dir.z = -std::pow( 10.0f, random( -7.0f, -1.0f ) );
+            break;
+
+        default:
+            break;
+        }
+
+        if( dir == SFVEC3F( 0.0f ) )
+            continue;
+
+        RAY ray;
+        ray.Init( origin, dir );
+
+        const float maxT = ( ii % 2 ) ? infinity : random( 0.0f, 4.0f );
+        RAY4        ray4( ray );
+        VFLOAT4     nearT;
+
+        const int hits = IntersectBBox4( ray4, VLoad( bounds[0] ), VLoad( bounds[1] ),
+                                         VLoad( bounds[2] ), VLoad( bounds[3] ),
+                                         VLoad( bounds[4] ), VLoad( bounds[5] ), VSet( maxT ),
+                                         nearT );
+
+        for( int lane = 0; lane < 4; ++lane )
+        {
+            const float boxMin[3] = { bounds[0][lane], bounds[1][lane], bounds[2][lane] };
+            const float boxMax[3] = { bounds[3][lane], bounds[4][lane], bounds[5][lane] };
+            const int   expected = referenceBBox( ray, boxMin, boxMax, maxT );
+
+            if( expected >= 0 )
+            {
+                BOOST_CHECK_MESSAGE( ( ( hits >> lane ) & 1 ) == expected,
+                                     "ray " << ii << " box " << lane );
+            }
+        }
+    }
+}
+
+
+/**
+ * IntersectTriangle4 never rejects a ray that TRIANGLE::Intersect hits, for one ray against four
+ * triangles of very different sizes, including at grazing angles.
+ */
+BOOST_AUTO_TEST_CASE( Triangle4 )
+{
+    const float infinity = std::numeric_limits<float>::infinity();
+
+    for( int ii = 0; ii < 20000; ++ii )
+    {
+        std::unique_ptr<TRIANGLE> triangles[4];
+        float                     v0[3][4], e1[3][4], e2[3][4];
+
+        for( int lane = 0; lane < 4; ++lane )
+        {
+            triangles[lane].reset( randomTriangle( randomPoint( 4.0f ),
+                                                   std::pow( 10.0f, random( -3.0f, 0.0f ) ),
+                                                   lane == 3 ) );
+
+            for( int axis = 0; axis < 3; ++axis )
+            {
+                const float vertex0 = triangles[lane]->GetVertex( 0 )[axis];
+
+                v0[axis][lane] = vertex0;
+                e1[axis][lane] = triangles[lane]->GetVertex( 1 )[axis] - vertex0;
+                e2[axis][lane] = triangles[lane]->GetVertex( 2 )[axis] - vertex0;
+            }
+        }
+
+        const RAY ray = rayToTriangle( *triangles[ii % 4], ii % 2 );
+        RAY4      ray4( ray );
+
+        const int hits = IntersectTriangle4( ray4, VLoad( v0[0] ), VLoad( v0[1] ),
+                                             VLoad( v0[2] ), VLoad( e1[0] ), VLoad( e1[1] ),
+                                             VLoad( e1[2] ), VLoad( e2[0] ), VLoad( e2[1] ),
+                                             VLoad( e2[2] ), VSet( infinity ) );
+
+        for( int lane = 0; lane < 4; ++lane )
+        {
+            HITINFO hitInfo;
+            hitInfo.m_tHit = infinity;
+
+            if( triangles[lane]->Intersect( ray, hitInfo ) )
+            {
+                BOOST_CHECK_MESSAGE( ( hits >> lane ) & 1,
+                                     "ray " << ii << " triangle " << lane );
+            }
+        }
+    }
+}
+
+
+/**
+ * IntersectTriangle4 rejects rays going away from the triangles.
+ */
+BOOST_AUTO_TEST_CASE( Triangle4Misses )
+{
+    for( int ii = 0; ii < 1000; ++ii )
+    {
+        std::unique_ptr<TRIANGLE> triangle( randomTriangle( randomPoint( 4.0f ), 1.0f, false ) );
+
+        const SFVEC3F& v0 = triangle->GetVertex( 0 );
+        const SFVEC3F  e1 = triangle->GetVertex( 1 ) - v0;
+        const SFVEC3F  e2 = triangle->GetVertex( 2 ) - v0;
+        const SFVEC3F  normal = glm::normalize( glm::cross( e1, e2 ) );
+
+        RAY ray;
+        ray.Init( v0 + ( e1 + e2 ) * 0.25f + normal * random( 0.01f, 1.0f ), normal );
+
+        RAY4 ray4( ray );
+
+        const int hits = IntersectTriangle4( ray4, VSet( v0.x ), VSet( v0.y ), VSet( v0.z ),
+                                             VSet( e1.x ), VSet( e1.y ), VSet( e1.z ),
+                                             VSet( e2.x ), VSet( e2.y ), VSet( e2.z ),
+                                             VSet( std::numeric_limits<float>::infinity() ) );
+
+        BOOST_CHECK_EQUAL( hits, 0 );
+    }
+}
+
+
+#ifndef BVH_NO_SIMD
+
+/**
+ * BVH_PBRT finds the same nearest hits and shadow hits as a loop over all the triangles, for
+ * every split method, including rays grazing a flat patch of triangles as a board surface.
+ */
+BOOST_AUTO_TEST_CASE( WideBVH )
+{
+    CONTAINER_3D triangles;
+
+    for( int ii = 0; ii < 1000; ++ii )
+        triangles.Add( randomTriangle( randomPoint( 1.0f ), 0.2f, ii % 4 == 0 ) );
+
+    // A flat grid, facing up
+    const float gridZ = 0.25f;
+
+    for( int x = 0; x < 20; ++x )
+    {
+        for( int y = 0; y < 20; ++y )
+        {
+            const SFVEC3F corner( -1.0f + x * 0.1f, -1.0f + y * 0.1f, gridZ );
+            const SFVEC3F dx( 0.1f, 0.0f, 0.0f );
+            const SFVEC3F dy( 0.0f, 0.1f, 0.0f );
+
+            triangles.Add( new TRIANGLE( corner, corner + dx + dy, corner + dx ) );
+            triangles.Add( new TRIANGLE( corner, corner + dy, corner + dx + dy ) );
+        }
+    }
+
+    std::vector<RAY> rays;
+
+    for( int ii = 0; ii < 4000; ++ii )
+    {
+        RAY ray;
+
+        if( ii % 2 )
+        {
+            const SFVEC3F origin = randomPoint( 3.0f );
+            ray.Init( origin, glm::normalize( randomPoint( 1.0f ) - origin ) );
+        }
+        else
+        {
+            // Grazing the grid, or running along it for the last ones
+            const SFVEC3F origin( random( -2.0f, 2.0f ), random( -2.0f, 2.0f ),
+                                  gridZ + ( ii % 10 ? random( 0.0f, 1e-2f ) : 0.0f ) );
+            const float   slope = ii % 10 ? std::pow( 10.0f, random( -7.0f, -1.0f ) ) : 0.0f;
+
+            ray.Init( origin, glm::normalize( SFVEC3F( random( -1.0f, 1.0f ),
+                                                       random( -1.0f, 1.0f ), -slope ) ) );
+        }
+
+        rays.push_back( ray );
+    }
+
+    for( SPLITMETHOD method : { SPLITMETHOD::MIDDLE, SPLITMETHOD::EQUALCOUNTS, SPLITMETHOD::SAH,
+                                SPLITMETHOD::HLBVH } )
+    {
+        BVH_PBRT bvh( triangles, 4, method );
+
+        for( size_t ii = 0; ii < rays.size(); ++ii )
+        {
+            BOOST_TEST_CONTEXT( "split method " << (int) method << ", ray " << ii )
+            {
+                HITINFO expected;
+                HITINFO actual;
+
+                expected.m_tHit = std::numeric_limits<float>::infinity();
+                actual.m_tHit = std::numeric_limits<float>::infinity();
+
+                const bool expectedHit = triangles.Intersect( rays[ii], expected );
+
+                BOOST_CHECK_EQUAL( bvh.Intersect( rays[ii], actual ), expectedHit );
+
+                if( expectedHit )
+                    BOOST_CHECK_EQUAL( actual.m_tHit, expected.m_tHit );
+
+                const float maxDistance = random( 0.0f, 4.0f );
+
+                BOOST_CHECK_EQUAL( bvh.IntersectP( rays[ii], maxDistance ),
+                                   triangles.IntersectP( rays[ii], maxDistance ) );
+            }
+        }
+    }
+}
+
+#endif
+
+
+BOOST_AUTO_TEST_SUITE_END()
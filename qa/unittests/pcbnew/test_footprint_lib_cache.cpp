@@ -0,0 +1,147 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the lazy loading of .pretty footprint libraries by PCB_PLUGIN
+ */
+
+#include <ctime>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <footprint.h>
+#include <pcbnew/plugins/kicad/pcb_plugin.h>
+
+
+struct FOOTPRINT_LIB_CACHE_FIXTURE
+{
+    FOOTPRINT_LIB_CACHE_FIXTURE()
+    {
+        m_libPath = boost::filesystem::temp_directory_path() / "fp_lib_cache_tst.pretty";
+
+        boost::filesystem::remove_all( m_libPath );
+        boost::filesystem::create_directory( m_libPath );
+
+        for( const char* name : { "A", "B", "C" } )
+        {
+            writeFile( name, std::string( "(footprint \"" ) + name
+                                     + "\" (version 20211014) (generator pcbnew)"
+                                       " (layer \"F.Cu\"))\n" );
+        }
+
+        writeFile( "Broken", "(footprint \"Broken\" (layer\n" );
+    }
+
+    ~FOOTPRINT_LIB_CACHE_FIXTURE()
+    {
+        boost::filesystem::remove_all( m_libPath );
+    }
+
+    void writeFile( const std::string& aName, const std::string& aContents )
+    {
+        std::ofstream file( ( m_libPath / ( aName + ".kicad_mod" ) ).string() );
+        file << aContents;
+    }
+
+    wxString libPath() const { return wxString( m_libPath.string() ); }
+
+    boost::filesystem::path m_libPath;
+    PCB_PLUGIN              m_plugin;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( FootprintLibCache, FOOTPRINT_LIB_CACHE_FIXTURE )
+
+
+/**
+ * A footprint loads even if another file of its library is broken.
+ */
+BOOST_AUTO_TEST_CASE( LoadsSingleFootprint )
+{
+    std::unique_ptr<FOOTPRINT> footprint( m_plugin.FootprintLoad( libPath(), "B" ) );
+
+    BOOST_REQUIRE( footprint );
+    BOOST_CHECK_EQUAL( wxString( footprint->GetFPID().GetLibItemName() ), wxT( "B" ) );
+
+    BOOST_CHECK( !m_plugin.FootprintLoad( libPath(), "Broken" ) );
+    BOOST_CHECK( !m_plugin.FootprintLoad( libPath(), "Missing" ) );
+
+    // Still available after the failures
+    footprint.reset( m_plugin.FootprintLoad( libPath(), "A" ) );
+    BOOST_CHECK( footprint );
+}
+
+
+/**
+ * Enumeration lists the footprints which parse and reports the others, including those which
+ * already failed to load on their own.
+ */
+BOOST_AUTO_TEST_CASE( EnumerateReportsErrors )
+{
+    BOOST_CHECK( !m_plugin.FootprintLoad( libPath(), "Broken" ) );
+
+    wxArrayString names;
+
+    BOOST_CHECK_THROW( m_plugin.FootprintEnumerate( names, libPath(), false ), IO_ERROR );
+
+    names.clear();
+    BOOST_CHECK_NO_THROW( m_plugin.FootprintEnumerate( names, libPath(), true ) );
+
+    names.Sort();
+    BOOST_REQUIRE_EQUAL( names.GetCount(), 3u );
+    BOOST_CHECK_EQUAL( names[0], wxT( "A" ) );
+    BOOST_CHECK_EQUAL( names[1], wxT( "B" ) );
+    BOOST_CHECK_EQUAL( names[2], wxT( "C" ) );
+
+    // Enumerated footprints are served from the cache
+    BOOST_CHECK( m_plugin.GetEnumeratedFootprint( libPath(), "C" ) );
+    BOOST_CHECK( !m_plugin.GetEnumeratedFootprint( libPath(), "Broken" ) );
+}
+
+
+/**
+ * Fixing a broken file makes it load on the next enumeration.
+ */
+BOOST_AUTO_TEST_CASE( ReloadsFixedFootprint )
+{
+    wxArrayString names;
+
+    BOOST_CHECK_THROW( m_plugin.FootprintEnumerate( names, libPath(), false ), IO_ERROR );
+
+    writeFile( "Broken", "(footprint \"Broken\" (layer \"F.Cu\"))\n" );
+
+    // Make sure the library timestamp changes
+    boost::filesystem::last_write_time( m_libPath / "Broken.kicad_mod",
+                                        std::time( nullptr ) + 10 );
+
+    names.clear();
+    BOOST_CHECK_NO_THROW( m_plugin.FootprintEnumerate( names, libPath(), false ) );
+    BOOST_CHECK_EQUAL( names.GetCount(), 4u );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
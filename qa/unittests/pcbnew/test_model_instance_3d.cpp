@@ -0,0 +1,248 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file
+ * Test suite for the instancing of 3D models in the raytracer, checked against transformed
+ * copies of the model triangles as the raytracer used to create them.
+ */
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <3d_rendering/raytracing/hitinfo.h>
+#include <3d_rendering/raytracing/ray.h>
+#include <3d_rendering/raytracing/shapes3D/triangle_3d.h>
+
+// Code under test
+#include <3d_rendering/raytracing/shapes3D/model_instance_3d.h>
+
+
+struct MODEL_INSTANCE_FIXTURE
+{
+    static constexpr int GRID = 4;
+
+    MODEL_INSTANCE_FIXTURE() :
+            m_rng( 0x3d1a57 )
+    {
+        // A gently sloped height field of GRID x GRID quads facing +Z, so rays coming from
+        // above hit a single triangle.
+        auto vertex =
+                []( int x, int y )
+                {
+                    return SFVEC3F( x, y, 0.25f * std::sin( x * 0.7f + y * 1.3f ) );
+                };
+
+        for( int y = 0; y < GRID; ++y )
+        {
+            for( int x = 0; x < GRID; ++x )
+            {
+                m_vertices.push_back( { vertex( x, y ), vertex( x + 1, y + 1 ),
+                                        vertex( x + 1, y ) } );
+                m_vertices.push_back( { vertex( x, y ), vertex( x, y + 1 ),
+                                        vertex( x + 1, y + 1 ) } );
+            }
+        }
+
+        for( const std::vector<SFVEC3F>& v : m_vertices )
+        {
+            TRIANGLE* triangle = new TRIANGLE( v[0], v[1], v[2] );
+
+            m_triangles.push_back( triangle );
+            m_mesh.Add( triangle );
+        }
+
+        m_mesh.Build();
+    }
+
+    float random( float aMin, float aMax )
+    {
+        return std::uniform_real_distribution<float>( aMin, aMax )( m_rng );
+    }
+
+    /**
+     * @return a rotation about a random axis, with a non uniform scale and a translation.
+     */
+    glm::mat4 randomMatrix()
+    {
+        glm::mat4 matrix( 1.0f );
+
+        matrix = glm::translate( matrix, SFVEC3F( random( -50.0f, 50.0f ),
+                                                  random( -50.0f, 50.0f ),
+                                                  random( -5.0f, 5.0f ) ) );
+        matrix = glm::rotate( matrix, random( -3.0f, 3.0f ),
+                              glm::normalize( SFVEC3F( random( -1.0f, 1.0f ),
+                                                       random( -1.0f, 1.0f ),
+                                                       random( 0.1f, 1.0f ) ) ) );
+        matrix = glm::scale( matrix, SFVEC3F( random( 0.5f, 2.0f ), random( 0.5f, 2.0f ),
+                                              random( 0.5f, 2.0f ) ) );
+        return matrix;
+    }
+
+    /**
+     * @return a ray from above the height field, in model space, to the inside of the
+     *         triangle \a aIndex.
+     */
+    RAY rayToTriangle( size_t aIndex )
+    {
+        const std::vector<SFVEC3F>& v = m_vertices[aIndex];
+
+        // Keep away from the edges, where either neighbour may be reported
+        float a = random( 0.1f, 0.8f );
+        float b = random( 0.1f, 0.9f - a );
+
+        const SFVEC3F target = v[0] + a * ( v[1] - v[0] ) + b * ( v[2] - v[0] );
+        const SFVEC3F dir = glm::normalize( SFVEC3F( random( -0.2f, 0.2f ),
+                                                     random( -0.2f, 0.2f ), -1.0f ) );
+
+        RAY ray;
+        ray.Init( target - random( 1.0f, 10.0f ) * dir, dir );
+        return ray;
+    }
+
+    static RAY transform( const RAY& aRay, const glm::mat4& aMatrix )
+    {
+        RAY ray;
+        ray.Init( SFVEC3F( aMatrix * glm::vec4( aRay.m_Origin, 1.0f ) ),
+                  glm::normalize( SFVEC3F( aMatrix * glm::vec4( aRay.m_Dir, 0.0f ) ) ) );
+        return ray;
+    }
+
+    std::mt19937                      m_rng;
+    std::vector<std::vector<SFVEC3F>> m_vertices;
+    std::vector<const TRIANGLE*>      m_triangles;    ///< Owned by m_mesh
+    MODEL_MESH_3D                     m_mesh;
+};
+
+
+BOOST_FIXTURE_TEST_SUITE( ModelInstance3D, MODEL_INSTANCE_FIXTURE )
+
+
+/**
+ * An instance gives the same hits as copies of the model triangles transformed to world space.
+ */
+BOOST_AUTO_TEST_CASE( MatchesTransformedTriangles )
+{
+    for( int matrixIdx = 0; matrixIdx < 8; ++matrixIdx )
+    {
+        const glm::mat4   matrix = randomMatrix();
+        MODEL_INSTANCE_3D instance( &m_mesh, matrix );
+
+        std::vector<std::unique_ptr<TRIANGLE>> copies;
+
+        for( const std::vector<SFVEC3F>& v : m_vertices )
+        {
+            copies.push_back( std::make_unique<TRIANGLE>(
+                    SFVEC3F( matrix * glm::vec4( v[0], 1.0f ) ),
+                    SFVEC3F( matrix * glm::vec4( v[1], 1.0f ) ),
+                    SFVEC3F( matrix * glm::vec4( v[2], 1.0f ) ) ) );
+        }
+
+        for( int rayIdx = 0; rayIdx < 200; ++rayIdx )
+        {
+            const size_t target = rayIdx % m_vertices.size();
+            const RAY    ray = transform( rayToTriangle( target ), matrix );
+
+            HITINFO expected;
+            size_t  expectedIdx = copies.size();
+
+            expected.m_tHit = std::numeric_limits<float>::infinity();
+
+            for( size_t ii = 0; ii < copies.size(); ++ii )
+            {
+                if( copies[ii]->Intersect( ray, expected ) )
+                    expectedIdx = ii;
+            }
+
+            BOOST_TEST_CONTEXT( "matrix " << matrixIdx << ", ray " << rayIdx )
+            {
+                BOOST_REQUIRE_EQUAL( expectedIdx, target );
+
+                HITINFO actual;
+                actual.m_tHit = std::numeric_limits<float>::infinity();
+
+                BOOST_REQUIRE( instance.Intersect( ray, actual ) );
+
+                BOOST_CHECK( actual.pHitObject == &instance );
+                BOOST_CHECK( actual.pHitSurface == m_triangles[target] );
+                BOOST_CHECK( instance.GetHitSurface( actual ) == m_triangles[target] );
+                BOOST_CHECK_CLOSE( actual.m_tHit, expected.m_tHit, 0.01 );
+                BOOST_CHECK_GT( glm::dot( actual.m_HitNormal, expected.m_HitNormal ), 0.9999f );
+
+                BOOST_CHECK( instance.IntersectP( ray, expected.m_tHit * 1.01f ) );
+                BOOST_CHECK( !instance.IntersectP( ray, expected.m_tHit * 0.99f ) );
+            }
+        }
+    }
+}
+
+
+/**
+ * The triangles of an instance are different surfaces, so the raytracer doesn't interpolate the
+ * shading between hits on different triangles of a model.
+ */
+BOOST_AUTO_TEST_CASE( SameSurface )
+{
+    const glm::mat4   matrix = randomMatrix();
+    MODEL_INSTANCE_3D instance( &m_mesh, matrix );
+
+    auto hit =
+            [&]( size_t aTriangle )
+            {
+                HITINFO hitInfo;
+                hitInfo.m_tHit = std::numeric_limits<float>::infinity();
+
+                BOOST_REQUIRE( instance.Intersect( transform( rayToTriangle( aTriangle ), matrix ),
+                                                   hitInfo ) );
+                return hitInfo;
+            };
+
+    const HITINFO first = hit( 0 );
+    const HITINFO sameTriangle = hit( 0 );
+    const HITINFO neighbour = hit( 1 );
+
+    BOOST_CHECK( first.pHitObject == neighbour.pHitObject );
+    BOOST_CHECK( OBJECT_3D::IsSameSurface( first, sameTriangle ) );
+    BOOST_CHECK( !OBJECT_3D::IsSameSurface( first, neighbour ) );
+
+    // Plain objects are their own surface
+    HITINFO plainA;
+    HITINFO plainB;
+
+    plainA.m_tHit = std::numeric_limits<float>::infinity();
+    plainB.m_tHit = std::numeric_limits<float>::infinity();
+
+    BOOST_REQUIRE( m_triangles[0]->Intersect( rayToTriangle( 0 ), plainA ) );
+    BOOST_REQUIRE( m_triangles[0]->Intersect( rayToTriangle( 0 ), plainB ) );
+    BOOST_CHECK( OBJECT_3D::IsSameSurface( plainA, plainB ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,279 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2022 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
+
+#include <qa_utils/wx_utils/unit_test_utils.h>
+
+#include <ratsnest/ratsnest_triangulation.h>
+
+
+typedef std::vector<std::pair<int, int>> EDGES;
+
+
+/**
+ * Sort and deduplicate \a aPoints into the order RN_TRIANGULATION::Triangulate() expects.
+ */
+static void normalize( std::vector<VECTOR2I>& aPoints )
+{
+    std::sort( aPoints.begin(), aPoints.end(),
+               []( const VECTOR2I& a, const VECTOR2I& b )
+               {
+                   return a.x < b.x || ( a.x == b.x && a.y < b.y );
+               } );
+
+    aPoints.erase( std::unique( aPoints.begin(), aPoints.end() ), aPoints.end() );
+}
+
+
+static std::set<std::pair<int, int>> edgeSet( const EDGES& aEdges )
+{
+    std::set<std::pair<int, int>> edges;
+
+    for( const std::pair<int, int>& e : aEdges )
+        edges.emplace( std::min( e.first, e.second ), std::max( e.first, e.second ) );
+
+    return edges;
+}
+
+
+/**
+ * Total length of the minimum spanning tree of \a aEdges, or -1 if they don't connect all
+ * of \a aPoints.
+ */
+static double mstLength( const std::vector<VECTOR2I>& aPoints, const EDGES& aEdges )
+{
+    std::vector<std::pair<double, std::pair<int, int>>> weighted;
+
+    for( const std::pair<int, int>& e : aEdges )
+        weighted.push_back( { ( aPoints[e.first] - aPoints[e.second] ).EuclideanNorm(), e } );
+
+    std::sort( weighted.begin(), weighted.end() );
+
+    std::vector<int> parent( aPoints.size() );
+    std::iota( parent.begin(), parent.end(), 0 );
+
+    auto find =
+            [&]( int aNode )
+            {
+                while( parent[aNode] != aNode )
+                    aNode = parent[aNode] = parent[parent[aNode]];
+
+                return aNode;
+            };
+
+    double length = 0.0;
+    size_t joined = 0;
+
+    for( const std::pair<double, std::pair<int, int>>& e : weighted )
+    {
+        int a = find( e.second.first );
+        int b = find( e.second.second );
+
+        if( a != b )
+        {
+            parent[a] = b;
+            length += e.first;
+            joined++;
+        }
+    }
+
+    return joined + 1 == aPoints.size() ? length : -1.0;
+}
+
+
+/**
+ * Move a cluster of up to 20 points (a footprint) and sometimes add or delete a point, as
+ * editing a board does between ratsnest updates.
+ */
+static void editPoints( std::mt19937& aRng, std::vector<VECTOR2I>& aPoints, int aStep,
+                        bool aGrid )
+{
+    auto randomPoint =
+            [&]()
+            {
+                if( aGrid )
+                    return VECTOR2I( ( aRng() % 60 ) * 1000, ( aRng() % 60 ) * 1000 );
+                else
+                    return VECTOR2I( aRng() % 1000000, aRng() % 1000000 );
+            };
+
+    VECTOR2I center = aPoints[aRng() % aPoints.size()];
+    VECTOR2I delta;
+    double   radius;
+
+    if( aGrid )
+    {
+        delta = VECTOR2I( ( (int) ( aRng() % 5 ) - 2 ) * 1000, ( (int) ( aRng() % 5 ) - 2 ) * 1000 );
+        radius = 3000;
+    }
+    else
+    {
+        delta = VECTOR2I( (int) ( aRng() % 20001 ) - 10000, (int) ( aRng() % 20001 ) - 10000 );
+        radius = 30000;
+    }
+
+    int moved = 0;
+
+    for( VECTOR2I& p : aPoints )
+    {
+        if( moved < 20 && ( p - center ).EuclideanNorm() < radius )
+        {
+            p += delta;
+            moved++;
+        }
+    }
+
+    if( aStep % 7 == 3 )
+        aPoints.erase( aPoints.begin() + aRng() % aPoints.size() );
+
+    if( aStep % 5 == 2 )
+        aPoints.push_back( randomPoint() );
+
+    normalize( aPoints );
+}
+
+
+BOOST_AUTO_TEST_SUITE( RatsnestTriangulation )
+
+
+/**
+ * Points in general position have a unique Delaunay triangulation, so the incrementally
+ * updated one must be exactly the same as a fresh one.
+ */
+BOOST_AUTO_TEST_CASE( IncrementalMatchesFull )
+{
+    std::mt19937 rng( 7 );
+    int          patchCount = 0;
+
+    for( int trial = 0; trial < 20; trial++ )
+    {
+        std::vector<VECTOR2I> points;
+        int                   count = 50 + rng() % 2000;
+
+        for( int i = 0; i < count; i++ )
+            points.emplace_back( rng() % 1000000, rng() % 1000000 );
+
+        normalize( points );
+
+        RN_TRIANGULATION incremental;
+
+        for( int step = 0; step < 30; step++ )
+        {
+            BOOST_TEST_CONTEXT( "trial " << trial << " step " << step )
+            {
+                EDGES            incEdges;
+                EDGES            fullEdges;
+                RN_TRIANGULATION full;
+
+                incremental.Triangulate( points, incEdges );
+                full.Triangulate( points, fullEdges );
+
+                patchCount += incremental.WasPatched();
+
+                BOOST_CHECK( edgeSet( incEdges ) == edgeSet( fullEdges ) );
+            }
+
+            editPoints( rng, points, step, false );
+        }
+    }
+
+    // Most of the edits are small enough to be patched
+    BOOST_CHECK_GT( patchCount, 20 * 29 / 2 );
+}
+
+
+/**
+ * Points on a grid have many equally valid triangulations, but they must all give the same
+ * minimum spanning tree length.
+ */
+BOOST_AUTO_TEST_CASE( IncrementalGridMatchesFullMst )
+{
+    std::mt19937 rng( 11 );
+    int          patchCount = 0;
+
+    for( int trial = 0; trial < 20; trial++ )
+    {
+        std::vector<VECTOR2I> points;
+        int                   count = 50 + rng() % 2000;
+
+        for( int i = 0; i < count; i++ )
+            points.emplace_back( ( rng() % 60 ) * 1000, ( rng() % 60 ) * 1000 );
+
+        normalize( points );
+
+        RN_TRIANGULATION incremental;
+
+        for( int step = 0; step < 30; step++ )
+        {
+            BOOST_TEST_CONTEXT( "trial " << trial << " step " << step )
+            {
+                EDGES            incEdges;
+                EDGES            fullEdges;
+                RN_TRIANGULATION full;
+
+                incremental.Triangulate( points, incEdges );
+                full.Triangulate( points, fullEdges );
+
+                patchCount += incremental.WasPatched();
+
+                double incLength = mstLength( points, incEdges );
+                double fullLength = mstLength( points, fullEdges );
+
+                BOOST_CHECK_GE( incLength, 0.0 );
+                BOOST_CHECK_CLOSE( incLength, fullLength, 1e-6 );
+            }
+
+            editPoints( rng, points, step, true );
+        }
+    }
+
+    BOOST_CHECK_GT( patchCount, 0 );
+}
+
+
+/**
+ * Colinear points have no triangulation; they are chained instead, also after an update
+ * from a proper triangulation.
+ */
+BOOST_AUTO_TEST_CASE( ColinearFallback )
+{
+    RN_TRIANGULATION      triangulation;
+    std::vector<VECTOR2I> points = { { 0, 0 }, { 0, 1000 }, { 1000, 0 }, { 1000, 1000 } };
+    EDGES                 edges;
+
+    triangulation.Triangulate( points, edges );
+    BOOST_CHECK_EQUAL( edgeSet( edges ).size(), 5 );
+
+    points = { { 0, 0 }, { 1000, 0 }, { 2000, 0 }, { 3000, 0 } };
+    edges.clear();
+
+    triangulation.Triangulate( points, edges );
+    BOOST_CHECK( edgeSet( edges ) == ( std::set<std::pair<int, int>>{ { 0, 1 }, { 1, 2 }, { 2, 3 } } ) );
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4949,6 +4949,16 @@ void ClipperOffset::Clear()
 
 // ------------------------------------------------------------------------------
 
+#ifdef use_xyz
+void ClipperOffset::ZFillRoundFunction( ZFillRoundCallback zFillFunc )
+{
+    m_ZFillRound = zFillFunc;
+}
+
+
+// ------------------------------------------------------------------------------
+#endif
+
 void ClipperOffset::AddPath( const Path& path, JoinType joinType, EndType endType )
 {
     int highI = (int) path.size() - 1;
@@ -5445,6 +5455,10 @@ void ClipperOffset::DoRound( int j, int k )
     double steps = m_StepsPerRad * std::fabs( a );
     int    takenSteps = std::max((int) std::floor( steps ), 1 );
 
+#ifdef use_xyz
+    size_t firstIdx = m_destPoly.size();
+#endif
+
     double X = m_normals[k].X, Y = m_normals[k].Y, X2;
 
     for( int i = 0; i < takenSteps; ++i )
@@ -5466,6 +5480,23 @@ void ClipperOffset::DoRound( int j, int k )
 
     m_destPoly.emplace_back( Round( m_srcPoly[j].X + m_normals[j].X * m_delta ),
                              Round( m_srcPoly[j].Y + m_normals[j].Y * m_delta ) );
+
+#ifdef use_xyz
+    // A join of only two points is a chord, not an arc
+    if( m_ZFillRound && m_destPoly.size() - firstIdx > 2 )
+    {
+        double   sinH = std::sin( a / 2 ), cosH = std::cos( a / 2 );
+        IntPoint mid( Round( m_srcPoly[j].X
+                             + ( m_normals[k].X * cosH - m_normals[k].Y * sinH ) * m_delta ),
+                      Round( m_srcPoly[j].Y
+                             + ( m_normals[k].X * sinH + m_normals[k].Y * cosH ) * m_delta ) );
+
+        cInt z = m_ZFillRound( m_destPoly[firstIdx], mid, m_destPoly.back() );
+
+        for( size_t i = firstIdx; i < m_destPoly.size(); ++i )
+            m_destPoly[i].Z = z;
+    }
+#endif
 }
 
 
@@ -145,6 +145,11 @@ struct DoublePoint
 #ifdef use_xyz
 typedef std::function<void( IntPoint& e1bot, IntPoint& e1top, IntPoint& e2bot, IntPoint& e2top,
                             IntPoint& pt )> ZFillCallback;
+
+// Called by ClipperOffset for each rounded join with the join's start, middle and end points.
+// The returned value is used as the Z of every vertex emitted for that join.
+typedef std::function<cInt( const IntPoint& start, const IntPoint& mid, const IntPoint& end )>
+        ZFillRoundCallback;
 #endif
 
 enum InitOptions
@@ -418,6 +423,12 @@ public:
     void    Execute( PolyTree& solution, double delta );
     void    Clear();
 
+    // set the callback function for z value filling on rounded joins (otherwise Z is 0)
+#ifdef use_xyz
+    void ZFillRoundFunction( ZFillRoundCallback zFillFunc );
+
+#endif
+
     double MiterLimit;
     JoinType MiterFallback;
     double ArcTolerance;
@@ -431,6 +442,9 @@ private:
     double m_miterLim, m_StepsPerRad;
     IntPoint m_lowest;
     PolyNode m_polyNodes;
+#ifdef use_xyz
+    ZFillRoundCallback m_ZFillRound;
+#endif
 
     void    FixOrientations();
     void    DoOffset( double delta );